@@ -0,0 +1,432 @@
+/**
+ * @file A429Database.cpp
+ * @brief A compiled, memory mapped form of the ARINC 429 specification sheets (.a429db).
+ */
+
+#include "A429Database.hpp"
+#include "LabelIndex.hpp"
+
+#include <fstream>
+#include <cstring>
+
+/**
+ * The first 8 bytes of every database
+ */
+static const char MAGIC[8] = { 'A', '4', '2', '9', 'D', 'B', '\0', '\0' };
+
+/**
+ * The number of 12 bit equipment IDs
+ */
+static const OwUInt32 EQUIPMENT_IDS = 4096;
+
+/**
+ * The CRC-32 of each byte, for the reflected polynomial 0xEDB88320
+ */
+static const OwUInt32 CRC_TABLE[256] =
+{
+	0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F,
+	0xE963A535, 0x9E6495A3, 0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988,
+	0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91, 0x1DB71064, 0x6AB020F2,
+	0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
+	0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9,
+	0xFA0F3D63, 0x8D080DF5, 0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172,
+	0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B, 0x35B5A8FA, 0x42B2986C,
+	0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
+	0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423,
+	0xCFBA9599, 0xB8BDA50F, 0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924,
+	0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D, 0x76DC4190, 0x01DB7106,
+	0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
+	0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D,
+	0x91646C97, 0xE6635C01, 0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E,
+	0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457, 0x65B0D9C6, 0x12B7E950,
+	0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
+	0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7,
+	0xA4D1C46D, 0xD3D6F4FB, 0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0,
+	0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9, 0x5005713C, 0x270241AA,
+	0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
+	0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81,
+	0xB7BD5C3B, 0xC0BA6CAD, 0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A,
+	0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683, 0xE3630B12, 0x94643B84,
+	0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
+	0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB,
+	0x196C3671, 0x6E6B06E7, 0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC,
+	0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5, 0xD6D6A3E8, 0xA1D1937E,
+	0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
+	0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55,
+	0x316E8EEF, 0x4669BE79, 0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236,
+	0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F, 0xC5BA3BBE, 0xB2BD0B28,
+	0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
+	0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F,
+	0x72076785, 0x05005713, 0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38,
+	0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21, 0x86D3D2D4, 0xF1D4E242,
+	0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
+	0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69,
+	0x616BFFD3, 0x166CCF45, 0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2,
+	0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB, 0xAED16A4A, 0xD9D65ADC,
+	0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
+	0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693,
+	0x54DE5729, 0x23D967BF, 0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
+	0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
+};
+
+/**
+ * Rounds an offset up to the next 8 byte boundary
+ */
+static OwUInt32 align8( OwUInt32 aOffset )
+{
+	return (aOffset + 7) & ~(OwUInt32)7;
+}
+
+/**
+ * Checks that a section lies inside the file
+ */
+static bool sectionFits( OwUInt32 aOffset, OwUInt64 aCount, size_t aRecordSize, size_t aFileSize )
+{
+	return aOffset % 8 == 0 && aOffset <= aFileSize && aCount * aRecordSize <= aFileSize - aOffset;
+}
+
+A429Database::A429Database()
+	: header(NULL)
+	, equipmentRecords(NULL)
+	, transmissionRecords(NULL)
+	, dataRecords(NULL)
+	, bcdRecords(NULL)
+	, linkRecords(NULL)
+	, equipmentIndex(NULL)
+	, wildcardIndex(NULL)
+	, indexSlots(NULL)
+	, strings(NULL)
+{
+}
+
+const A429Database::DataRecord A429Database::EMPTY_DATA = A429Database::DataRecord();
+
+bool A429Database::open( const std::string& aFile )
+{
+	close();
+	if( !file.open( aFile ) || file.size() < sizeof(Header) )
+	{
+		close();
+		return false;
+	}
+
+	const Header* candidate = (const Header*)file.data();
+	if( memcmp( candidate->magic, MAGIC, sizeof(MAGIC) ) != 0 || candidate->byteOrder != 0x01020304 || candidate->version != VERSION || candidate->fileSize != file.size() )
+	{
+		close();
+		return false;
+	}
+
+	//Make sure every section is inside the file before anything is read from it
+	size_t size = file.size();
+	bool valid = sectionFits( candidate->equipmentOffset, candidate->equipmentCount, sizeof(EquipmentRecord), size )
+		&& sectionFits( candidate->transmissionOffset, candidate->transmissionCount, sizeof(TransmissionRecord), size )
+		&& sectionFits( candidate->dataOffset, (OwUInt64)candidate->bnrCount + candidate->bcdCount, sizeof(DataRecord), size )
+		&& sectionFits( candidate->linkOffset, candidate->linkCount, sizeof(OwUInt32), size )
+		&& sectionFits( candidate->equipmentIndexOffset, EQUIPMENT_IDS, sizeof(OwUInt32), size )
+		&& sectionFits( candidate->wildcardIndexOffset, 256, sizeof(OwUInt32), size )
+		&& sectionFits( candidate->indexOffset, candidate->indexCapacity, sizeof(IndexSlot), size )
+		&& sectionFits( candidate->stringTableOffset, candidate->stringTableSize, 1, size )
+		&& candidate->indexCapacity != 0 && (candidate->indexCapacity & (candidate->indexCapacity - 1)) == 0
+		&& candidate->stringTableSize != 0 && file.data()[candidate->stringTableOffset + candidate->stringTableSize - 1] == '\0';
+	if( !valid )
+	{
+		close();
+		return false;
+	}
+
+	header = candidate;
+	equipmentRecords = (const EquipmentRecord*)(file.data() + header->equipmentOffset);
+	transmissionRecords = (const TransmissionRecord*)(file.data() + header->transmissionOffset);
+	dataRecords = (const DataRecord*)(file.data() + header->dataOffset);
+	bcdRecords = dataRecords + header->bnrCount;
+	linkRecords = (const OwUInt32*)(file.data() + header->linkOffset);
+	equipmentIndex = (const OwUInt32*)(file.data() + header->equipmentIndexOffset);
+	wildcardIndex = (const OwUInt32*)(file.data() + header->wildcardIndexOffset);
+	indexSlots = (const IndexSlot*)(file.data() + header->indexOffset);
+	strings = file.data() + header->stringTableOffset;
+	if( !referencesValid() )
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @returns true if a reference is to one of aCount records, or is NONE when that is allowed
+ */
+static bool referenceFits( OwUInt32 aReference, OwUInt32 aCount, bool aNoneAllowed )
+{
+	return aReference < aCount || (aNoneAllowed && aReference == A429Database::NONE);
+}
+
+bool A429Database::referencesValid() const
+{
+	//Every reference between records, and every string offset, so nothing read later is out of bounds
+	const OwUInt32 stringTableSize = header->stringTableSize;
+	for( OwUInt32 i = 0; i < header->equipmentCount; ++i )
+	{
+		const EquipmentRecord& record = equipmentRecords[i];
+		if( record.type >= stringTableSize || (OwUInt64)record.firstLink + record.linkCount > header->linkCount )
+		{
+			return false;
+		}
+	}
+	for( OwUInt32 i = 0; i < header->transmissionCount; ++i )
+	{
+		const TransmissionRecord& record = transmissionRecords[i];
+		if( record.parameter >= stringTableSize || !referenceFits( record.bnrData, header->bnrCount, true ) || !referenceFits( record.bcdData, header->bcdCount, true ) )
+		{
+			return false;
+		}
+	}
+	for( OwUInt64 i = 0; i < (OwUInt64)header->bnrCount + header->bcdCount; ++i )
+	{
+		const DataRecord& record = i < header->bnrCount ? bnr( (OwUInt32)i ) : bcd( (OwUInt32)(i - header->bnrCount) );
+		if( record.units >= stringTableSize || record.range >= stringTableSize || record.posSense >= stringTableSize
+			|| record.resolution >= stringTableSize || record.minTransitInterval >= stringTableSize || record.maxTransitInterval >= stringTableSize )
+		{
+			return false;
+		}
+	}
+	for( OwUInt32 i = 0; i < header->linkCount; ++i )
+	{
+		if( !referenceFits( linkRecords[i], header->transmissionCount, false ) )
+		{
+			return false;
+		}
+	}
+	for( OwUInt32 i = 0; i < EQUIPMENT_IDS; ++i )
+	{
+		if( !referenceFits( equipmentIndex[i], header->equipmentCount, true ) )
+		{
+			return false;
+		}
+	}
+	for( OwUInt32 i = 0; i < 256; ++i )
+	{
+		if( !referenceFits( wildcardIndex[i], header->transmissionCount, true ) )
+		{
+			return false;
+		}
+	}
+	//findTransmission stops probing at an empty slot, so there must be one
+	bool hasEmptySlot = false;
+	for( OwUInt32 i = 0; i < header->indexCapacity; ++i )
+	{
+		if( indexSlots[i].key == NONE )
+		{
+			hasEmptySlot = true;
+		}
+		else if( !referenceFits( indexSlots[i].transmission, header->transmissionCount, false ) )
+		{
+			return false;
+		}
+	}
+	return hasEmptySlot;
+}
+
+void A429Database::close()
+{
+	file.close();
+	header = NULL;
+	equipmentRecords = NULL;
+	transmissionRecords = NULL;
+	dataRecords = NULL;
+	bcdRecords = NULL;
+	linkRecords = NULL;
+	equipmentIndex = NULL;
+	wildcardIndex = NULL;
+	indexSlots = NULL;
+	strings = NULL;
+}
+
+bool A429Database::verify() const
+{
+	if( header == NULL )
+	{
+		return false;
+	}
+	return checksum( file.data() + sizeof(Header), file.size() - sizeof(Header) ) == header->checksum;
+}
+
+OwUInt32 A429Database::findEquipment( OwUInt16 aEquipmentId ) const
+{
+	if( aEquipmentId >= EQUIPMENT_IDS )
+	{
+		return NONE;
+	}
+	return equipmentIndex[aEquipmentId];
+}
+
+OwUInt32 A429Database::findTransmission( OwUInt16 aEquipmentId, OwUInt8 aLabel ) const
+{
+	if( findEquipment( aEquipmentId ) == NONE )
+	{
+		return NONE;
+	}
+	OwUInt32 key = LabelIndex<OwUInt32>::makeKey( aEquipmentId, aLabel );
+	size_t mask = header->indexCapacity - 1;
+	for( size_t i = LabelIndex<OwUInt32>::homeSlot( key, mask ); indexSlots[i].key != NONE; i = (i + 1) & mask )
+	{
+		if( indexSlots[i].key == key )
+		{
+			return indexSlots[i].transmission;
+		}
+	}
+	return wildcardIndex[aLabel];
+}
+
+OwUInt32 A429Database::checksum( const char* aData, size_t aSize )
+{
+	OwUInt32 crc = 0xFFFFFFFF;
+	for( size_t i = 0; i < aSize; ++i )
+	{
+		crc = CRC_TABLE[(crc ^ (OwUInt8)aData[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc ^ 0xFFFFFFFF;
+}
+
+A429DatabaseBuilder::A429DatabaseBuilder()
+	: equipmentIndex(EQUIPMENT_IDS, (OwUInt32)A429Database::NONE)
+	, wildcardIndex(256, (OwUInt32)A429Database::NONE)
+{
+	addString( "" );	//Offset 0 is the empty string
+}
+
+OwUInt32 A429DatabaseBuilder::addString( const std::string& aString )
+{
+	std::map<std::string, OwUInt32>::iterator found = stringOffsets.find( aString );
+	if( found != stringOffsets.end() )
+	{
+		return found->second;
+	}
+	OwUInt32 offset = (OwUInt32)strings.size();
+	strings.append( aString.c_str(), strlen( aString.c_str() ) );	//A string with an embedded '\0' is cut short, like any C string
+	strings.push_back( '\0' );
+	stringOffsets[aString] = offset;
+	return offset;
+}
+
+OwUInt32 A429DatabaseBuilder::addEquipment( OwInt16 aId, const std::string& aType, const std::vector<OwUInt32>& aTransmissions )
+{
+	A429Database::EquipmentRecord record;
+	record.id = aId;
+	record.reserved = 0;
+	record.type = addString( aType );
+	record.firstLink = (OwUInt32)linkRecords.size();
+	record.linkCount = (OwUInt32)aTransmissions.size();
+	linkRecords.insert( linkRecords.end(), aTransmissions.begin(), aTransmissions.end() );
+	equipmentRecords.push_back( record );
+
+	OwUInt32 index = (OwUInt32)equipmentRecords.size() - 1;
+	if( aId >= 0 && (OwUInt32)aId < EQUIPMENT_IDS && equipmentIndex[aId] == A429Database::NONE )
+	{
+		equipmentIndex[aId] = index;	//The first entry for an ID wins
+	}
+	return index;
+}
+
+OwUInt32 A429DatabaseBuilder::addTransmission( const A429Database::TransmissionRecord& aRecord )
+{
+	transmissionRecords.push_back( aRecord );
+	return (OwUInt32)transmissionRecords.size() - 1;
+}
+
+OwUInt32 A429DatabaseBuilder::addBnr( const A429Database::DataRecord& aRecord )
+{
+	bnrRecords.push_back( aRecord );
+	return (OwUInt32)bnrRecords.size() - 1;
+}
+
+OwUInt32 A429DatabaseBuilder::addBcd( const A429Database::DataRecord& aRecord )
+{
+	bcdRecords.push_back( aRecord );
+	return (OwUInt32)bcdRecords.size() - 1;
+}
+
+void A429DatabaseBuilder::indexTransmission( OwUInt16 aEquipmentId, OwUInt8 aLabel, OwUInt32 aTransmission )
+{
+	indexEntries.insert( std::make_pair( LabelIndex<OwUInt32>::makeKey( aEquipmentId, aLabel ), aTransmission ) );	//Keeps the first
+}
+
+void A429DatabaseBuilder::indexWildcard( OwUInt8 aLabel, OwUInt32 aTransmission )
+{
+	if( wildcardIndex[aLabel] == A429Database::NONE )
+	{
+		wildcardIndex[aLabel] = aTransmission;
+	}
+}
+
+/**
+ * Appends the bytes of a section to the image, padded to an 8 byte boundary
+ * @returns the offset of the section
+ */
+static OwUInt32 appendSection( std::vector<char>& aImage, const void* aData, size_t aSize )
+{
+	OwUInt32 offset = (OwUInt32)aImage.size();
+	aImage.insert( aImage.end(), (const char*)aData, (const char*)aData + aSize );
+	aImage.resize( align8( (OwUInt32)aImage.size() ), '\0' );
+	return offset;
+}
+
+bool A429DatabaseBuilder::write( const std::string& aFile ) const
+{
+	//Lay the index out at no more than half full, so probes stay short
+	OwUInt32 capacity = 64;
+	while( capacity < indexEntries.size() * 2 )
+	{
+		capacity *= 2;
+	}
+	A429Database::IndexSlot empty;
+	empty.key = A429Database::NONE;
+	empty.transmission = A429Database::NONE;
+	std::vector<A429Database::IndexSlot> slots( capacity, empty );
+	for( std::map<OwUInt32, OwUInt32>::const_iterator it = indexEntries.begin(); it != indexEntries.end(); ++it )
+	{
+		size_t i = LabelIndex<OwUInt32>::homeSlot( it->first, capacity - 1 );
+		while( slots[i].key != A429Database::NONE )
+		{
+			i = (i + 1) & (capacity - 1);
+		}
+		slots[i].key = it->first;
+		slots[i].transmission = it->second;
+	}
+
+	A429Database::Header header;
+	memset( &header, 0, sizeof(header) );
+	memcpy( header.magic, MAGIC, sizeof(MAGIC) );
+	header.byteOrder = 0x01020304;
+	header.version = A429Database::VERSION;
+	header.equipmentCount = (OwUInt32)equipmentRecords.size();
+	header.transmissionCount = (OwUInt32)transmissionRecords.size();
+	header.bnrCount = (OwUInt32)bnrRecords.size();
+	header.bcdCount = (OwUInt32)bcdRecords.size();
+	header.linkCount = (OwUInt32)linkRecords.size();
+	header.indexCapacity = capacity;
+	header.stringTableSize = (OwUInt32)strings.size();
+
+	std::vector<char> image( sizeof(header), '\0' );
+	//&v[0] isn't valid on an empty vector, so sections pass their first element only when they have one
+	header.equipmentOffset = appendSection( image, equipmentRecords.empty() ? NULL : &equipmentRecords[0], equipmentRecords.size() * sizeof(A429Database::EquipmentRecord) );
+	header.transmissionOffset = appendSection( image, transmissionRecords.empty() ? NULL : &transmissionRecords[0], transmissionRecords.size() * sizeof(A429Database::TransmissionRecord) );
+	header.dataOffset = appendSection( image, bnrRecords.empty() ? NULL : &bnrRecords[0], bnrRecords.size() * sizeof(A429Database::DataRecord) );
+	appendSection( image, bcdRecords.empty() ? NULL : &bcdRecords[0], bcdRecords.size() * sizeof(A429Database::DataRecord) );	//DataRecord is a multiple of 8 bytes, so this follows on directly
+	header.linkOffset = appendSection( image, linkRecords.empty() ? NULL : &linkRecords[0], linkRecords.size() * sizeof(OwUInt32) );
+	header.equipmentIndexOffset = appendSection( image, &equipmentIndex[0], equipmentIndex.size() * sizeof(OwUInt32) );
+	header.wildcardIndexOffset = appendSection( image, &wildcardIndex[0], wildcardIndex.size() * sizeof(OwUInt32) );
+	header.indexOffset = appendSection( image, &slots[0], slots.size() * sizeof(A429Database::IndexSlot) );
+	header.stringTableOffset = appendSection( image, strings.data(), strings.size() );
+	header.fileSize = (OwUInt32)image.size();
+	header.checksum = A429Database::checksum( &image[sizeof(header)], image.size() - sizeof(header) );
+	memcpy( &image[0], &header, sizeof(header) );
+
+	std::ofstream output( aFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+	if( !output )
+	{
+		return false;
+	}
+	output.write( &image[0], (std::streamsize)image.size() );
+	return output.good();
+}
@@ -0,0 +1,409 @@
+/**
+ * @file A429Database.hpp
+ * @brief A compiled, memory mapped form of the ARINC 429 specification sheets (.a429db).
+ */
+
+#ifndef A429_DATABASE_HPP
+#define A429_DATABASE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+
+#include <Owl429/definitions>
+
+#include "MappedFile.hpp"
+
+/**
+ * A read-only view of a .a429db file. The file is mapped and used in place:
+ * opening it checks the header, the section bounds and that every reference and
+ * string offset is in range, but not the checksum, and processes that open the
+ * same file share its pages.
+ *
+ * The file is little endian and made of fixed size records. Each section starts
+ * on an 8 byte boundary:
+ *  - Header
+ *  - EquipmentRecord[equipmentCount]
+ *  - TransmissionRecord[transmissionCount]
+ *  - DataRecord[bnrCount], then DataRecord[bcdCount]
+ *  - OwUInt32[linkCount], the transmissions of each equipment. The wildcard transmissions,
+ *    those with the equipment ID 0xFFFF, belong to every equipment and aren't repeated here
+ *  - OwUInt32[4096], the equipment of each 12 bit ID
+ *  - OwUInt32[256], the wildcard transmission of each label
+ *  - IndexSlot[indexCapacity], the (equipment ID, label) index
+ *  - the string table, null terminated strings referred to by offset
+ */
+class A429Database
+{
+public:
+
+	/**
+	 * The format version this code reads and writes
+	 */
+	enum { VERSION = 3 };
+
+	/**
+	 * What record references hold when there is no record
+	 */
+	static const OwUInt32 NONE = 0xFFFFFFFF;
+
+	/**
+	 * The flags of TransmissionRecord::types
+	 */
+	enum TypeFlags
+	{
+		TYPE_BNR = 0x01,
+		TYPE_BCD = 0x02,
+		TYPE_DISC = 0x04,
+		TYPE_SAL = 0x08
+	};
+
+	/**
+	 * The start of the file
+	 */
+	typedef struct Header
+	{
+		/**
+		 * @brief "A429DB" then two '\0'
+		 */
+		char magic[8];
+		/**
+		 * @brief 0x01020304 as written by the compiling machine, to reject the wrong byte order
+		 */
+		OwUInt32 byteOrder;
+		/**
+		 * @brief The format version
+		 */
+		OwUInt32 version;
+		/**
+		 * @brief The size of the whole file in bytes
+		 */
+		OwUInt32 fileSize;
+		/**
+		 * @brief The CRC-32 of everything after the header
+		 */
+		OwUInt32 checksum;
+		OwUInt32 equipmentCount;
+		OwUInt32 transmissionCount;
+		OwUInt32 bnrCount;
+		OwUInt32 bcdCount;
+		OwUInt32 linkCount;
+		OwUInt32 indexCapacity;
+		OwUInt32 stringTableSize;
+		/**
+		 * @brief The byte offsets of the sections from the start of the file
+		 */
+		OwUInt32 equipmentOffset;
+		OwUInt32 transmissionOffset;
+		OwUInt32 dataOffset;
+		OwUInt32 linkOffset;
+		OwUInt32 equipmentIndexOffset;
+		OwUInt32 wildcardIndexOffset;
+		OwUInt32 indexOffset;
+		OwUInt32 stringTableOffset;
+		OwUInt32 reserved;
+	} Header;
+
+	/**
+	 * An equipment
+	 */
+	typedef struct EquipmentRecord
+	{
+		/**
+		 * @brief The 12 bit identifier for the equipment
+		 */
+		OwInt16 id;
+		OwUInt16 reserved;
+		/**
+		 * @brief The string offset of the type of the equipment
+		 */
+		OwUInt32 type;
+		/**
+		 * @brief The first entry of the link section that belongs to the equipment
+		 */
+		OwUInt32 firstLink;
+		/**
+		 * @brief The number of transmissions of the equipment
+		 */
+		OwUInt32 linkCount;
+	} EquipmentRecord;
+
+	/**
+	 * A row of the LabelIDs sheet
+	 */
+	typedef struct TransmissionRecord
+	{
+		/**
+		 * @brief The label
+		 */
+		OwInt16 codeNo;
+		/**
+		 * @brief The Transmission Order Bit Position
+		 */
+		OwUInt8 transmissionOrderBitPosition;
+		/**
+		 * @brief The TypeFlags of the data
+		 */
+		OwUInt8 types;
+		/**
+		 * @brief The string offset of the parameter
+		 */
+		OwUInt32 parameter;
+		/**
+		 * @brief The bnr record, or NONE
+		 */
+		OwUInt32 bnrData;
+		/**
+		 * @brief The bcd record, or NONE
+		 */
+		OwUInt32 bcdData;
+		/**
+		 * @brief The equipment ID of the row, or 0xFFFF for a wildcard
+		 */
+		OwUInt16 equipmentId;
+		OwUInt16 reserved;
+	} TransmissionRecord;
+
+	/**
+	 * A row of the BnrData or BcdData sheet. The strings are string offsets
+	 */
+	typedef struct DataRecord
+	{
+		OwUInt32 units;
+		OwUInt32 range;
+		OwUInt32 posSense;
+		OwUInt32 resolution;
+		OwUInt32 minTransitInterval;
+		OwUInt32 maxTransitInterval;
+		double rate;
+		OwUInt16 maxTransportDelay;
+		OwUInt8 sigBits;
+		OwUInt8 isPeriod;
+		/**
+		 * @brief The equipment ID and label the row was given for
+		 */
+		OwUInt16 equipmentId;
+		OwUInt8 label;
+		OwUInt8 reserved;
+	} DataRecord;
+
+	/**
+	 * A slot of the (equipment ID, label) index
+	 */
+	typedef struct IndexSlot
+	{
+		/**
+		 * @brief The key, as made by LabelIndex::makeKey, or NONE if the slot is empty
+		 */
+		OwUInt32 key;
+		/**
+		 * @brief The transmission record
+		 */
+		OwUInt32 transmission;
+	} IndexSlot;
+
+	A429Database();
+
+	/**
+	 * Maps a .a429db file and checks its header, section bounds and references
+	 * @returns false if the file couldn't be mapped or isn't a valid database of this version
+	 */
+	bool open( const std::string& aFile );
+
+	/**
+	 * Unmaps the file
+	 */
+	void close();
+
+	/**
+	 * @returns true if a database is open
+	 */
+	bool isOpen() const
+	{
+		return header != NULL;
+	}
+
+	/**
+	 * Checks the checksum. This reads the whole file, so open() leaves it to the caller
+	 * @returns true if the contents match the checksum in the header
+	 */
+	bool verify() const;
+
+	OwUInt32 equipmentCount() const			{ return header->equipmentCount; }
+	OwUInt32 transmissionCount() const		{ return header->transmissionCount; }
+	OwUInt32 bnrCount() const				{ return header->bnrCount; }
+	OwUInt32 bcdCount() const				{ return header->bcdCount; }
+
+	const EquipmentRecord& equipment( OwUInt32 aIndex ) const			{ return equipmentRecords[aIndex]; }
+	const TransmissionRecord& transmission( OwUInt32 aIndex ) const		{ return transmissionRecords[aIndex]; }
+
+	/**
+	 * @returns a BNR or BCD record, or an empty one if aIndex isn't below bnrCount or bcdCount
+	 */
+	const DataRecord& bnr( OwUInt32 aIndex ) const
+	{
+		return aIndex < header->bnrCount ? dataRecords[aIndex] : EMPTY_DATA;
+	}
+	const DataRecord& bcd( OwUInt32 aIndex ) const
+	{
+		return aIndex < header->bcdCount ? bcdRecords[aIndex] : EMPTY_DATA;
+	}
+
+	/**
+	 * @returns the transmission records of an equipment, linkCount of them
+	 */
+	const OwUInt32* links( const EquipmentRecord& aEquipment ) const
+	{
+		return linkRecords + aEquipment.firstLink;
+	}
+
+	/**
+	 * @returns the wildcard transmission record of a label, or NONE
+	 */
+	OwUInt32 wildcard( OwUInt8 aLabel ) const
+	{
+		return wildcardIndex[aLabel];
+	}
+
+	/**
+	 * @returns the number of slots in the (equipment ID, label) index
+	 */
+	OwUInt32 indexCapacity() const
+	{
+		return header->indexCapacity;
+	}
+
+	/**
+	 * @returns a slot of the (equipment ID, label) index. Empty slots have a key of NONE
+	 */
+	const IndexSlot& indexSlot( OwUInt32 aSlot ) const
+	{
+		return indexSlots[aSlot];
+	}
+
+	/**
+	 * @returns the string at an offset of the string table
+	 */
+	const char* string( OwUInt32 aOffset ) const
+	{
+		return strings + aOffset;
+	}
+
+	/**
+	 * @returns the first equipment record with the ID, or NONE
+	 */
+	OwUInt32 findEquipment( OwUInt16 aEquipmentId ) const;
+
+	/**
+	 * Looks up the transmission of a label by an equipment, the same way as LoadedCSV::findTransmission
+	 * @returns the transmission record, or NONE
+	 */
+	OwUInt32 findTransmission( OwUInt16 aEquipmentId, OwUInt8 aLabel ) const;
+
+	/**
+	 * Computes the CRC-32 (IEEE 802.3) of a buffer
+	 */
+	static OwUInt32 checksum( const char* aData, size_t aSize );
+
+private:
+
+	/**
+	 * Checks that every record reference and string offset of the open file is in range,
+	 * and that the index has an empty slot to stop lookups at
+	 */
+	bool referencesValid() const;
+
+	/**
+	 * What bnr and bcd return for a record that isn't there
+	 */
+	static const DataRecord EMPTY_DATA;
+
+	MappedFile file;
+	const Header* header;
+	const EquipmentRecord* equipmentRecords;
+	const TransmissionRecord* transmissionRecords;
+	const DataRecord* dataRecords;
+	const DataRecord* bcdRecords;
+	const OwUInt32* linkRecords;
+	const OwUInt32* equipmentIndex;
+	const OwUInt32* wildcardIndex;
+	const IndexSlot* indexSlots;
+	const char* strings;
+};
+
+/**
+ * Collects the records of a database and writes them out as a .a429db file.
+ * Records refer to each other by their position in their section, in the
+ * order they were added.
+ */
+class A429DatabaseBuilder
+{
+public:
+
+	A429DatabaseBuilder();
+
+	/**
+	 * Adds a string to the string table. Each distinct string is only stored once
+	 * @returns the offset of the string
+	 */
+	OwUInt32 addString( const std::string& aString );
+
+	/**
+	 * Adds an equipment whose transmissions are the given records
+	 * @returns the equipment record
+	 */
+	OwUInt32 addEquipment( OwInt16 aId, const std::string& aType, const std::vector<OwUInt32>& aTransmissions );
+
+	/**
+	 * @returns the transmission record
+	 */
+	OwUInt32 addTransmission( const A429Database::TransmissionRecord& aRecord );
+
+	/**
+	 * @returns the bnr record
+	 */
+	OwUInt32 addBnr( const A429Database::DataRecord& aRecord );
+
+	/**
+	 * @returns the bcd record
+	 */
+	OwUInt32 addBcd( const A429Database::DataRecord& aRecord );
+
+	/**
+	 * Indexes a transmission under an equipment and label. The first one added for a key is kept
+	 */
+	void indexTransmission( OwUInt16 aEquipmentId, OwUInt8 aLabel, OwUInt32 aTransmission );
+
+	/**
+	 * Makes a transmission the wildcard of its label, if the label doesn't have one yet
+	 */
+	void indexWildcard( OwUInt8 aLabel, OwUInt32 aTransmission );
+
+	/**
+	 * Writes the database
+	 * @returns false if the file couldn't be written
+	 */
+	bool write( const std::string& aFile ) const;
+
+private:
+
+	std::vector<A429Database::EquipmentRecord> equipmentRecords;
+	std::vector<A429Database::TransmissionRecord> transmissionRecords;
+	std::vector<A429Database::DataRecord> bnrRecords;
+	std::vector<A429Database::DataRecord> bcdRecords;
+	std::vector<OwUInt32> linkRecords;
+	std::vector<OwUInt32> equipmentIndex;
+	std::vector<OwUInt32> wildcardIndex;
+	/**
+	 * @brief The index entries by key. They are laid out in slots by write()
+	 */
+	std::map<OwUInt32, OwUInt32> indexEntries;
+	std::string strings;
+	/**
+	 * @brief Where each string already in the table is
+	 */
+	std::map<std::string, OwUInt32> stringOffsets;
+};
+
+#endif
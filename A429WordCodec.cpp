@@ -0,0 +1,401 @@
+/**
+ * @file A429WordCodec.cpp
+ * @brief Decodes and encodes the data of ARINC 429 words as described by the specification sheets.
+ */
+
+#include "A429WordCodec.hpp"
+
+#include <cmath>
+#include <cstdlib>
+
+/**
+ * The sign/status matrix values of BNR words
+ */
+static const OwUInt8 BNR_FAILURE_WARNING = 0;
+static const OwUInt8 BNR_NO_COMPUTED_DATA = 1;
+static const OwUInt8 BNR_FUNCTIONAL_TEST = 2;
+static const OwUInt8 BNR_NORMAL = 3;
+
+/**
+ * The sign/status matrix values of BCD words
+ */
+static const OwUInt8 BCD_PLUS = 0;
+static const OwUInt8 BCD_NO_COMPUTED_DATA = 1;
+static const OwUInt8 BCD_FUNCTIONAL_TEST = 2;
+static const OwUInt8 BCD_MINUS = 3;
+
+/**
+ * The largest number of BCD digits in the data field
+ */
+static const int MAX_BCD_DIGITS = 5;
+
+/**
+ * The powers of ten the BCD digits of a word are scaled down by, by the number of unused digits
+ */
+static const double BCD_UNUSED_SCALE[MAX_BCD_DIGITS] = { 1, 10, 100, 1000, 10000 };
+
+/**
+ * The largest number of significant BNR bits, leaving bit 29 for the sign. Past
+ * SDI_BNR_BITS they run into the SDI bits, 9-10
+ */
+static const int MAX_BNR_BITS = 20;
+static const int SDI_BNR_BITS = 18;
+
+bool A429WordCodec::sdiIsData( const Descriptor& aDescriptor )
+{
+	return aDescriptor.format == FORMAT_BNR && aDescriptor.sigBits > SDI_BNR_BITS;
+}
+
+bool A429WordCodec::parityValid( OwUInt32 aWord )
+{
+	aWord ^= aWord >> 16;
+	aWord ^= aWord >> 8;
+	aWord ^= aWord >> 4;
+	aWord ^= aWord >> 2;
+	aWord ^= aWord >> 1;
+	return (aWord & 1) != 0;
+}
+
+OwUInt32 A429WordCodec::withParity( OwUInt32 aWord )
+{
+	aWord &= 0x7FFFFFFF;
+	return parityValid( aWord ) ? aWord : aWord | 0x80000000;
+}
+
+bool A429WordCodec::parseScale( const std::string& aText, double& aValue )
+{
+	//Skip what surrounds the number: spaces, and the plus/minus sign, which the sheets export as '?'
+	size_t start = aText.find_first_not_of( " ?+\xB1" );
+	if( start == std::string::npos )
+	{
+		return false;
+	}
+	const char* begin = aText.c_str() + start;
+	char* end;
+	aValue = strtod( begin, &end );
+	return end != begin;
+}
+
+bool A429WordCodec::parseRange( const std::string& aText, double& aLow, double& aHigh )
+{
+	const char* text = aText.c_str();
+	bool plusMinus = false;
+	while( *text == '?' || *text == '+' || *text == '\xB1' || *text == ' ' )	//The plus/minus sign is exported as '?'
+	{
+		plusMinus = plusMinus || *text == '?' || *text == '\xB1';
+		++text;
+	}
+	char* end;
+	double first = strtod( text, &end );
+	if( end == text )
+	{
+		return false;
+	}
+	text = end;
+
+	//A second bound follows "to", or a '-' that isn't the sign of the first
+	const char* next = text;
+	while( *next == ' ' )
+	{
+		++next;
+	}
+	bool bounds = false;
+	if( next[0] == 't' && next[1] == 'o' )
+	{
+		next += 2;
+		bounds = true;
+	}
+	else if( *next == '-' || *next == '+' )
+	{
+		next += *next == '-' ? 1 : 0;
+		bounds = true;
+	}
+	double second = 0;
+	if( bounds && !plusMinus )
+	{
+		second = strtod( next, &end );
+		if( end == next )
+		{
+			return false;
+		}
+		text = end;
+	}
+
+	//Units may follow, but no more numbers
+	for( ; *text != '\0'; ++text )
+	{
+		if( *text >= '0' && *text <= '9' )
+		{
+			return false;
+		}
+	}
+
+	if( plusMinus )
+	{
+		aLow = -fabs( first );
+		aHigh = fabs( first );
+	}
+	else if( bounds )
+	{
+		aLow = first < second ? first : second;
+		aHigh = first < second ? second : first;
+	}
+	else
+	{
+		aLow = first < 0 ? first : 0;
+		aHigh = first < 0 ? 0 : first;
+	}
+	return true;
+}
+
+bool A429WordCodec::describe( Format aFormat, const std::string& aRange, const std::string& aResolution, OwUInt8 aSigBits, Descriptor& aDescriptor )
+{
+	aDescriptor.format = aFormat;
+	aDescriptor.sigBits = aSigBits;
+	aDescriptor.lsb = 0;
+
+	double low;
+	double high;
+	double resolution;
+	bool hasRange = parseRange( aRange, low, high ) && high > 0 && (low == 0 || low == -high);
+	double range = high;
+	bool hasResolution = parseScale( aResolution, resolution ) && resolution > 0;
+
+	if( aFormat == FORMAT_BNR )
+	{
+		if( aSigBits == 0 || aSigBits > MAX_BNR_BITS )
+		{
+			return false;
+		}
+		if( hasRange )
+		{
+			aDescriptor.lsb = ldexp( range, -(int)aSigBits );	//The resolution column is rounded, the range is exact
+		}
+		else if( hasResolution )
+		{
+			aDescriptor.lsb = resolution;
+		}
+	}
+	else
+	{
+		if( aSigBits == 0 || aSigBits > MAX_BCD_DIGITS )
+		{
+			return false;
+		}
+		if( hasResolution )
+		{
+			aDescriptor.lsb = resolution;
+		}
+	}
+	return aDescriptor.lsb > 0;
+}
+
+A429WordCodec::Status A429WordCodec::statusOf( OwUInt8 aSsm, Format aFormat )
+{
+	if( aFormat == FORMAT_BNR )
+	{
+		static const Status bnrStatus[4] = { STATUS_FAILURE_WARNING, STATUS_NO_COMPUTED_DATA, STATUS_FUNCTIONAL_TEST, STATUS_NORMAL };
+		return bnrStatus[aSsm & 3];
+	}
+	static const Status bcdStatus[4] = { STATUS_NORMAL, STATUS_NO_COMPUTED_DATA, STATUS_FUNCTIONAL_TEST, STATUS_NORMAL };
+	return bcdStatus[aSsm & 3];
+}
+
+OwUInt8 A429WordCodec::ssmOf( Status aStatus, Format aFormat, bool aNegative )
+{
+	switch( aStatus )
+	{
+	case STATUS_NO_COMPUTED_DATA:
+		return aFormat == FORMAT_BNR ? BNR_NO_COMPUTED_DATA : BCD_NO_COMPUTED_DATA;
+	case STATUS_FUNCTIONAL_TEST:
+		return aFormat == FORMAT_BNR ? BNR_FUNCTIONAL_TEST : BCD_FUNCTIONAL_TEST;
+	case STATUS_FAILURE_WARNING:
+		return aFormat == FORMAT_BNR ? BNR_FAILURE_WARNING : BCD_NO_COMPUTED_DATA;	//BCD has no failure warning, so the data is flagged as not computed
+	default:
+		if( aFormat == FORMAT_BNR )
+		{
+			return BNR_NORMAL;
+		}
+		return aNegative ? BCD_MINUS : BCD_PLUS;
+	}
+}
+
+double A429WordCodec::decodeBnr( OwUInt32 aWord, const Descriptor& aDescriptor )
+{
+	//Move the sign, bit 29, to the top so that an arithmetic shift sign extends the significant bits
+	OwInt32 data = (OwInt32)(aWord << 3) >> (31 - aDescriptor.sigBits);
+	return data * aDescriptor.lsb;
+}
+
+double A429WordCodec::decodeBcd( OwUInt32 aWord, const Descriptor& aDescriptor )
+{
+	//The most significant digit only has three bits, the rest have four
+	OwUInt32 digits = (aWord >> 26) & 0x7;
+	for( int digit = 1, shift = 22; digit < aDescriptor.sigBits; ++digit, shift -= 4 )
+	{
+		digits = digits * 10 + ((aWord >> shift) & 0xF);
+	}
+	double value = digits * aDescriptor.lsb;
+	return ssm( aWord ) == BCD_MINUS ? -value : value;
+}
+
+OwUInt32 A429WordCodec::encodeBnr( double aValue, const Descriptor& aDescriptor )
+{
+	double scaled = floor( aValue / aDescriptor.lsb + 0.5 );
+	double limit = ldexp( 1.0, aDescriptor.sigBits );
+	if( scaled > limit - 1 )
+	{
+		scaled = limit - 1;
+	}
+	else if( scaled < -limit )
+	{
+		scaled = -limit;
+	}
+	OwUInt32 data = (OwUInt32)(OwInt32)scaled;
+	//Put the significant bits and the sign below bit 29, and drop everything above it
+	return (data << (28 - aDescriptor.sigBits)) & 0x1FFFFF00;
+}
+
+OwUInt32 A429WordCodec::encodeBcd( double aValue, const Descriptor& aDescriptor )
+{
+	double scaled = floor( fabs( aValue ) / aDescriptor.lsb + 0.5 );
+	OwUInt32 limit = 7;	//The most significant digit is at most 7
+	for( int digit = 1; digit < aDescriptor.sigBits; ++digit )
+	{
+		limit = limit * 10 + 9;
+	}
+	OwUInt32 digits = scaled > limit ? limit : (OwUInt32)scaled;
+
+	//The least significant digit goes in the lowest slot the word has digits for
+	OwUInt32 data = 0;
+	for( int shift = 26 - 4 * (aDescriptor.sigBits - 1); shift <= 26; shift += 4 )
+	{
+		data |= (digits % 10) << shift;
+		digits /= 10;
+	}
+	return data;
+}
+
+A429WordCodec::Decoded A429WordCodec::decode( OwUInt32 aWord, const Descriptor& aDescriptor )
+{
+	Decoded decoded;
+	decoded.label = label( aWord );
+	decoded.sdi = sdiIsData( aDescriptor ) ? 0 : sdi( aWord );
+	decoded.ssm = ssm( aWord );
+	decoded.status = statusOf( decoded.ssm, aDescriptor.format );
+	decoded.parityValid = parityValid( aWord );
+	decoded.value = aDescriptor.format == FORMAT_BNR ? decodeBnr( aWord, aDescriptor ) : decodeBcd( aWord, aDescriptor );
+	return decoded;
+}
+
+OwUInt32 A429WordCodec::encode( double aValue, OwUInt8 aLabel, OwUInt8 aSdi, Status aStatus, const Descriptor& aDescriptor )
+{
+	OwUInt32 data = aDescriptor.format == FORMAT_BNR ? encodeBnr( aValue, aDescriptor ) : encodeBcd( aValue, aDescriptor );
+	OwUInt32 sdiBits = sdiIsData( aDescriptor ) ? 0 : (OwUInt32)(aSdi & 0x3) << 8;
+	OwUInt32 word = aLabel | sdiBits | data | ((OwUInt32)ssmOf( aStatus, aDescriptor.format, aValue < 0 ) << 29);
+	return withParity( word );
+}
+
+void A429WordCodec::decodeValues( const OwUInt32* aWords, size_t aCount, const Descriptor& aDescriptor, double* aValues )
+{
+	if( aDescriptor.format == FORMAT_BNR )
+	{
+		//Branch free, so the compiler can vectorize it
+		const int shift = 31 - aDescriptor.sigBits;
+		const double lsb = aDescriptor.lsb;
+		for( size_t i = 0; i < aCount; ++i )
+		{
+			aValues[i] = ((OwInt32)(aWords[i] << 3) >> shift) * lsb;
+		}
+	}
+	else
+	{
+		//Branch free as well: every digit slot is read, with the unused ones masked off, and the
+		//result scaled down by the slots that aren't used. The division is exact, so this gives
+		//the same values as decodeBcd()
+		const int unused = MAX_BCD_DIGITS - aDescriptor.sigBits;
+		const OwUInt32 mask = 0x1FFFFC00 & ~((1u << (10 + 4 * unused)) - 1);
+		const double scale = BCD_UNUSED_SCALE[unused];
+		const double lsb = aDescriptor.lsb;
+		for( size_t i = 0; i < aCount; ++i )
+		{
+			OwUInt32 data = aWords[i] & mask;
+			OwInt32 digits = (OwInt32)((data >> 26) & 0x7) * 10000 + (OwInt32)((data >> 22) & 0xF) * 1000
+				+ (OwInt32)((data >> 18) & 0xF) * 100 + (OwInt32)((data >> 14) & 0xF) * 10 + (OwInt32)((data >> 10) & 0xF);
+			double sign = ((aWords[i] >> 29) & 0x3) == BCD_MINUS ? -1.0 : 1.0;
+			aValues[i] = digits / scale * lsb * sign;
+		}
+	}
+}
+
+void A429WordCodec::decode( const OwUInt32* aWords, size_t aCount, const Descriptor& aDescriptor, Decoded* aDecoded )
+{
+	for( size_t i = 0; i < aCount; ++i )
+	{
+		aDecoded[i] = decode( aWords[i], aDescriptor );
+	}
+}
+
+void A429WordCodec::encode( const double* aValues, size_t aCount, OwUInt8 aLabel, OwUInt8 aSdi, Status aStatus, const Descriptor& aDescriptor, OwUInt32* aWords )
+{
+	for( size_t i = 0; i < aCount; ++i )
+	{
+		aWords[i] = encode( aValues[i], aLabel, aSdi, aStatus, aDescriptor );
+	}
+}
+
+/**
+ * A sample program that decodes and encodes BCD words laid out by hand on the ARINC 429 grid,
+ * so that the digits are checked against the standard rather than against encode().
+ *
+ * @return 0 for success or 1 on error.
+ */
+int sample_WordCodec()
+{
+	typedef struct BcdCase
+	{
+		OwUInt8 digits;
+		OwUInt32 data;
+		double value;
+	} BcdCase;
+
+	//The first digit in bits 27-29, the rest in bits 23-26, 19-22, 15-18 and 11-14
+	const BcdCase cases[] =
+	{
+		{ 3, (3u << 26) | (5u << 22) | (9u << 18), 359 },	//Wind Speed, 0-799
+		{ 4, 7u << 26, 7000 },	//Ground Speed, 0-7000
+		{ 4, (1u << 26) | (2u << 22) | (3u << 18) | (4u << 14), 1234 },
+		{ 5, (7u << 26) | (9u << 22) | (9u << 18) | (9u << 14) | (9u << 10), 79999 },
+		{ 1, 6u << 26, 6 }
+	};
+
+	int result = 0;
+	for( size_t i = 0; i < sizeof( cases ) / sizeof( cases[0] ); ++i )
+	{
+		A429WordCodec::Descriptor descriptor;
+		descriptor.format = A429WordCodec::FORMAT_BCD;
+		descriptor.sigBits = cases[i].digits;
+		descriptor.lsb = 1;
+
+		OwUInt32 word = A429WordCodec::withParity( 0x12 | cases[i].data );
+		OwUInt32 minus = A429WordCodec::withParity( 0x12 | cases[i].data | ((OwUInt32)BCD_MINUS << 29) );
+		if( A429WordCodec::decode( word, descriptor ).value != cases[i].value
+			|| A429WordCodec::decode( minus, descriptor ).value != -cases[i].value
+			|| A429WordCodec::encode( cases[i].value, 0x12, 0, A429WordCodec::STATUS_NORMAL, descriptor ) != word
+			|| A429WordCodec::encode( -cases[i].value, 0x12, 0, A429WordCodec::STATUS_NORMAL, descriptor ) != minus )
+		{
+			result = 1;
+		}
+	}
+
+	//Values past the top of the field are capped at 7 in the first digit
+	A429WordCodec::Descriptor groundSpeed;
+	groundSpeed.format = A429WordCodec::FORMAT_BCD;
+	groundSpeed.sigBits = 4;
+	groundSpeed.lsb = 1;
+	if( A429WordCodec::decode( A429WordCodec::encode( 9000, 0x12, 0, A429WordCodec::STATUS_NORMAL, groundSpeed ), groundSpeed ).value != 7999 )
+	{
+		result = 1;
+	}
+	return result;
+}
@@ -0,0 +1,188 @@
+/**
+ * @file A429WordCodec.hpp
+ * @brief Decodes and encodes the data of ARINC 429 words as described by the specification sheets.
+ */
+
+#ifndef A429_WORD_CODEC_HPP
+#define A429_WORD_CODEC_HPP
+
+#include <string>
+#include <cstddef>
+
+#include <Owl429/definitions>
+
+/**
+ * Converts between 32 bit ARINC 429 words and engineering values.
+ *
+ * Bits are numbered 1 to 32 from the least significant:
+ *  - 1-8 label
+ *  - 9-10 SDI
+ *  - 11-29 data. BNR data is two's complement with the sign in bit 29 and the most
+ *    significant bit in bit 28. BNR data with 19 or 20 significant bits, such as Present
+ *    Position Lat/Long, carries on into bits 10 and 9 in place of the SDI. BCD digits always sit on the same grid: the most
+ *    significant in the three bits 27-29, then four bits each at 23-26, 19-22, 15-18 and
+ *    11-14. A word with fewer than five digits leaves the bits under its last one unused
+ *  - 30-31 SSM
+ *  - 32 odd parity
+ */
+class A429WordCodec
+{
+public:
+
+	/**
+	 * How the data field is encoded
+	 */
+	enum Format
+	{
+		FORMAT_BNR,
+		FORMAT_BCD
+	};
+
+	/**
+	 * The sign/status matrix, as a status. The sign of BCD data is taken out of it
+	 */
+	enum Status
+	{
+		STATUS_NORMAL,
+		STATUS_NO_COMPUTED_DATA,
+		STATUS_FUNCTIONAL_TEST,
+		STATUS_FAILURE_WARNING
+	};
+
+	/**
+	 * Everything needed to decode the data of a label
+	 */
+	typedef struct Descriptor
+	{
+		/**
+		 * @brief How the data field is encoded
+		 */
+		Format format;
+		/**
+		 * @brief The number of significant bits (BNR) or digits (BCD)
+		 */
+		OwUInt8 sigBits;
+		/**
+		 * @brief The value of the least significant bit (BNR) or digit (BCD)
+		 */
+		double lsb;
+	} Descriptor;
+
+	/**
+	 * A decoded word
+	 */
+	typedef struct Decoded
+	{
+		/**
+		 * @brief The engineering value
+		 */
+		double value;
+		OwUInt8 label;
+		/**
+		 * @brief The SDI, or 0 when its bits are data
+		 */
+		OwUInt8 sdi;
+		/**
+		 * @brief The raw sign/status matrix
+		 */
+		OwUInt8 ssm;
+		Status status;
+		/**
+		 * @brief Denotes whether or not the word has odd parity
+		 */
+		bool parityValid;
+	} Decoded;
+
+	static OwUInt8 label( OwUInt32 aWord )	{ return (OwUInt8)(aWord & 0xFF); }
+	static OwUInt8 sdi( OwUInt32 aWord )	{ return (OwUInt8)((aWord >> 8) & 0x3); }
+	static OwUInt8 ssm( OwUInt32 aWord )	{ return (OwUInt8)((aWord >> 29) & 0x3); }
+
+	/**
+	 * @returns true if the data of the label takes up the SDI bits, for BNR data with more than 18 significant bits
+	 */
+	static bool sdiIsData( const Descriptor& aDescriptor );
+
+	/**
+	 * @returns true if the word has an odd number of set bits
+	 */
+	static bool parityValid( OwUInt32 aWord );
+
+	/**
+	 * @returns the word with bit 32 set so that it has odd parity
+	 */
+	static OwUInt32 withParity( OwUInt32 aWord );
+
+	/**
+	 * Builds a descriptor from the columns of a BNR or BCD sheet row.
+	 * The value of the least significant bit of BNR data is the range over 2^sigBits,
+	 * falling back to the resolution when the range isn't a scale: a single number,
+	 * or bounds of 0 to X or -X to X.
+	 * @returns false if the row doesn't describe a decodable value
+	 */
+	static bool describe( Format aFormat, const std::string& aRange, const std::string& aResolution, OwUInt8 aSigBits, Descriptor& aDescriptor );
+
+	/**
+	 * Parses a range or resolution column, such as " ?  512" or "0.1", ignoring the
+	 * spaces and plus/minus signs around it
+	 * @returns false if it doesn't start with a number
+	 */
+	static bool parseScale( const std::string& aText, double& aValue );
+
+	/**
+	 * Parses a range column: a scale such as " ?  512" or "100", or bounds such as
+	 * "0-256" or "-55 to 125". Text after the number is allowed if it has no digits, as in "32 Sec"
+	 * @param aLow the lower bound. -aHigh for a plus/minus scale, 0 for a plain one
+	 * @param aHigh the upper bound
+	 * @returns false if the column isn't one of those
+	 */
+	static bool parseRange( const std::string& aText, double& aLow, double& aHigh );
+
+	/**
+	 * Decodes a word
+	 */
+	static Decoded decode( OwUInt32 aWord, const Descriptor& aDescriptor );
+
+	/**
+	 * Encodes a value, clamping it to what the data field can hold
+	 * @param aSdi the SDI. It is ignored when sdiIsData()
+	 * @param aStatus the status. For BCD data the sign of the value takes precedence when the status is STATUS_NORMAL
+	 */
+	static OwUInt32 encode( double aValue, OwUInt8 aLabel, OwUInt8 aSdi, Status aStatus, const Descriptor& aDescriptor );
+
+	/**
+	 * Decodes the engineering values of many words of the same label
+	 * @param aValues where to store the aCount values
+	 */
+	static void decodeValues( const OwUInt32* aWords, size_t aCount, const Descriptor& aDescriptor, double* aValues );
+
+	/**
+	 * Decodes many words of the same label
+	 * @param aDecoded where to store the aCount results
+	 */
+	static void decode( const OwUInt32* aWords, size_t aCount, const Descriptor& aDescriptor, Decoded* aDecoded );
+
+	/**
+	 * Encodes many values of the same label, with odd parity
+	 * @param aWords where to store the aCount words
+	 */
+	static void encode( const double* aValues, size_t aCount, OwUInt8 aLabel, OwUInt8 aSdi, Status aStatus, const Descriptor& aDescriptor, OwUInt32* aWords );
+
+private:
+
+	/**
+	 * Converts an SSM to a status for the format
+	 */
+	static Status statusOf( OwUInt8 aSsm, Format aFormat );
+
+	/**
+	 * Converts a status to an SSM for the format
+	 */
+	static OwUInt8 ssmOf( Status aStatus, Format aFormat, bool aNegative );
+
+	static double decodeBnr( OwUInt32 aWord, const Descriptor& aDescriptor );
+	static double decodeBcd( OwUInt32 aWord, const Descriptor& aDescriptor );
+	static OwUInt32 encodeBnr( double aValue, const Descriptor& aDescriptor );
+	static OwUInt32 encodeBcd( double aValue, const Descriptor& aDescriptor );
+};
+
+#endif
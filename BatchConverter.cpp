@@ -0,0 +1,481 @@
+/**
+ * @file BatchConverter.cpp
+ * @brief Converts the specification sheets of several revisions to Xml channel configurations at once.
+ */
+
+#include "BatchConverter.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "FileUtil.hpp"
+#include "LoadedCSV.hpp"
+#include "RevisionDiff.hpp"
+#include "ScheduleAnalyzer.hpp"
+#include "SpecValidator.hpp"
+#include "Stopwatch.hpp"
+
+const char* const BatchConverter::MANIFEST_FILE = "a429manifest.txt";
+const char* const BatchConverter::STATS_FILE = "LoadStats.json";
+const char* const BatchConverter::BUS_LOAD_FILE = "BusLoad.json";
+const char* const BatchConverter::VALIDATION_FILE = "Validation.json";
+const char* const BatchConverter::CHANGES_FILE = "Changes.json";
+
+/**
+ * The ends of the names of the four sheets of a set
+ */
+static const char* const EQUIPMENT_SHEET = "EquipmentIDs.csv";
+static const char* const TRANSMISSION_SHEET = "LabelIDs.csv";
+static const char* const BNR_SHEET = "BnrData.csv";
+static const char* const BCD_SHEET = "BcdData.csv";
+
+BatchConverter::BatchConverter()
+	: threadCount(0)
+	, incremental(false)
+	, writeStats(false)
+	, writeBusLoad(false)
+	, writeValidation(false)
+	, streamingXml(false)
+	, verifyXml(false)
+	, exportFormat(ChannelExporter::FORMAT_XML)
+{
+}
+
+void BatchConverter::setThreadCount( unsigned aThreadCount )
+{
+	threadCount = aThreadCount;
+}
+
+void BatchConverter::setSchemaFile( const std::string& aSchemaFile )
+{
+	schemaFile = aSchemaFile;
+}
+
+void BatchConverter::setIncremental( bool aIncremental )
+{
+	incremental = aIncremental;
+}
+
+void BatchConverter::setWriteStats( bool aWriteStats )
+{
+	writeStats = aWriteStats;
+}
+
+void BatchConverter::setWriteBusLoad( bool aWriteBusLoad )
+{
+	writeBusLoad = aWriteBusLoad;
+}
+
+void BatchConverter::setWriteValidation( bool aWriteValidation )
+{
+	writeValidation = aWriteValidation;
+}
+
+void BatchConverter::setBaseline( const std::string& aSheetPrefix )
+{
+	baselinePrefix = aSheetPrefix;
+}
+
+void BatchConverter::setStreamingXml( bool aStreamingXml )
+{
+	streamingXml = aStreamingXml;
+}
+
+void BatchConverter::setExportFormat( ChannelExporter::Format aFormat )
+{
+	exportFormat = aFormat;
+}
+
+void BatchConverter::setVerifyXml( bool aVerifyXml )
+{
+	verifyXml = aVerifyXml;
+}
+
+bool BatchConverter::findSheets( const std::string& aDirectory, std::vector<std::string>& aPrefixes )
+{
+	aPrefixes.clear();
+	std::vector<std::string> names;
+	if( !FileUtil::listDirectory( aDirectory, names ) )
+	{
+		return false;
+	}
+
+	const size_t suffixLength = strlen( EQUIPMENT_SHEET );
+	for( size_t i = 0; i < names.size(); ++i )
+	{
+		const std::string& name = names[i];
+		if( name.size() < suffixLength || name.compare( name.size() - suffixLength, suffixLength, EQUIPMENT_SHEET ) != 0 )
+		{
+			continue;
+		}
+
+		//Only take sets with all four sheets. The names are sorted, so search them
+		std::string prefix = name.substr( 0, name.size() - suffixLength );
+		if( std::binary_search( names.begin(), names.end(), prefix + TRANSMISSION_SHEET )
+			&& std::binary_search( names.begin(), names.end(), prefix + BNR_SHEET )
+			&& std::binary_search( names.begin(), names.end(), prefix + BCD_SHEET ) )
+		{
+			aPrefixes.push_back( prefix );
+		}
+	}
+	return true;
+}
+
+bool BatchConverter::addRevision( const std::string& aSheetDirectory, const std::string& aOutputDirectory )
+{
+	std::vector<std::string> prefixes;
+	if( !findSheets( aSheetDirectory, prefixes ) || prefixes.empty() )
+	{
+		return false;
+	}
+
+	for( size_t i = 0; i < prefixes.size(); ++i )
+	{
+		Revision revision;
+		revision.sheetPrefix = FileUtil::joinPath( aSheetDirectory, prefixes[i] );
+		revision.outputDirectory = aOutputDirectory;
+		if( prefixes.size() > 1 )
+		{
+			//Name the subdirectory after the prefix, without the separator it ends in
+			std::string name = prefixes[i];
+			while( !name.empty() && (name[name.size() - 1] == '-' || name[name.size() - 1] == '_' || name[name.size() - 1] == ' ') )
+			{
+				name.erase( name.size() - 1 );
+			}
+			revision.outputDirectory = FileUtil::joinPath( aOutputDirectory, name.empty() ? "sheets" : name );
+		}
+		revision.succeeded = false;
+		revision.time = 0;
+		revisionList.push_back( revision );
+	}
+	return true;
+}
+
+bool BatchConverter::run()
+{
+	if( revisionList.empty() )
+	{
+		return true;
+	}
+
+	//Convert as many revisions at once as there are threads, and give each the threads left over
+	unsigned totalThreads = threadCount == 0 ? WorkerPool::hardwareConcurrency() : threadCount;
+	unsigned concurrent = totalThreads < revisionList.size() ? totalThreads : (unsigned)revisionList.size();
+	unsigned perRevision = totalThreads / concurrent;
+
+	std::vector<RevisionTask> tasks;
+	tasks.reserve( revisionList.size() );
+	TaskGraph graph;
+	for( size_t i = 0; i < revisionList.size(); ++i )
+	{
+		tasks.push_back( RevisionTask( *this, revisionList[i], perRevision ) );
+		graph.add( &tasks.back() );
+	}
+	WorkerPool pool( concurrent );
+	pool.run( graph );
+
+	bool succeeded = true;
+	for( size_t i = 0; i < revisionList.size(); ++i )
+	{
+		succeeded = succeeded && revisionList[i].succeeded;
+	}
+	return succeeded;
+}
+
+void BatchConverter::convert( Revision& aRevision, unsigned aThreadCount ) const
+{
+	Stopwatch stopwatch;
+	aRevision.succeeded = false;
+	if( !FileUtil::makeDirectory( aRevision.outputDirectory ) )
+	{
+		aRevision.error = "The output directory could not be created";
+		return;
+	}
+
+	LoadedCSV loaded;
+	if( !schemaFile.empty() )
+	{
+		loaded.setSchemaFile( schemaFile );
+	}
+	loaded.load( aRevision.sheetPrefix + EQUIPMENT_SHEET, aRevision.sheetPrefix + TRANSMISSION_SHEET,
+		aRevision.sheetPrefix + BNR_SHEET, aRevision.sheetPrefix + BCD_SHEET, aThreadCount );
+
+	//A sheet that couldn't be read leaves the rest unlinked, so don't write anything from it
+	aRevision.stats = loaded.stats();
+	const LoadStats::SheetStats* sheets[] = { &aRevision.stats.equipment, &aRevision.stats.transmissions, &aRevision.stats.bnr, &aRevision.stats.bcd };
+	for( size_t i = 0; i < sizeof(sheets) / sizeof(sheets[0]); ++i )
+	{
+		if( !sheets[i]->error.empty() )
+		{
+			aRevision.error = sheets[i]->error;
+			aRevision.time = stopwatch.elapsed();
+			return;
+		}
+	}
+
+	std::vector<SpecValidator::Finding> findings;
+	if( writeValidation )
+	{
+		loaded.validate( findings, aThreadCount );
+	}
+
+	loaded.setOutputDirectory( aRevision.outputDirectory );
+	loaded.setStreamingXml( streamingXml );
+	loaded.setExportFormat( exportFormat );
+	if( incremental )
+	{
+		loaded.saveChanged( FileUtil::joinPath( aRevision.outputDirectory, MANIFEST_FILE ), aThreadCount );
+	}
+	else
+	{
+		loaded.save( aThreadCount );
+	}
+	aRevision.stats = loaded.stats();
+
+	if( verifyXml )
+	{
+		//Report the first equipment that differs and how many did
+		const SpecStore& store = loaded.spec();
+		OwUInt32 differing = 0;
+		std::string firstDifference;
+		for( OwUInt32 i = 0; i < store.equipmentCount(); ++i )
+		{
+			std::string difference;
+			if( !loaded.verifyXml( store.equipmentAt( i ), difference ) )
+			{
+				if( differing++ == 0 )
+				{
+					firstDifference = LoadedCSV::fileNameOf( store.equipmentAt( i ) ) + ": " + difference;
+				}
+			}
+		}
+		if( differing != 0 )
+		{
+			std::ostringstream error;
+			error << differing << " of " << store.equipmentCount() << " equipment differ from Xml429, first " << firstDifference;
+			aRevision.error = error.str();
+		}
+	}
+	if( writeStats )
+	{
+		std::ofstream stats( FileUtil::joinPath( aRevision.outputDirectory, STATS_FILE ).c_str() );
+		aRevision.stats.writeJson( stats );
+		stats.close();
+		if( stats.fail() )
+		{
+			aRevision.error = std::string( "The stats could not be written to " ) + STATS_FILE;
+		}
+	}
+	if( writeBusLoad )
+	{
+		ScheduleAnalyzer analyzer;
+		std::vector<ScheduleAnalyzer::EquipmentSchedule> schedules;
+		analyzer.analyzeAll( loaded.spec(), schedules );
+		std::ofstream busLoad( FileUtil::joinPath( aRevision.outputDirectory, BUS_LOAD_FILE ).c_str() );
+		ScheduleAnalyzer::writeJson( busLoad, loaded.spec(), schedules, false );
+		busLoad.close();
+		if( busLoad.fail() )
+		{
+			aRevision.error = std::string( "The bus load could not be written to " ) + BUS_LOAD_FILE;
+		}
+	}
+	if( writeValidation )
+	{
+		std::ofstream validation( FileUtil::joinPath( aRevision.outputDirectory, VALIDATION_FILE ).c_str() );
+		SpecValidator::writeJson( validation, loaded.spec(), findings );
+		validation.close();
+		if( validation.fail() )
+		{
+			aRevision.error = std::string( "The validation could not be written to " ) + VALIDATION_FILE;
+		}
+	}
+	if( !baselinePrefix.empty() )
+	{
+		LoadedCSV baseline;
+		baseline.load( baselinePrefix + EQUIPMENT_SHEET, baselinePrefix + TRANSMISSION_SHEET,
+			baselinePrefix + BNR_SHEET, baselinePrefix + BCD_SHEET, aThreadCount );
+		LoadStats baselineStats = baseline.stats();
+		if( !baselineStats.equipment.error.empty() || !baselineStats.transmissions.error.empty()
+			|| !baselineStats.bnr.error.empty() || !baselineStats.bcd.error.empty() )
+		{
+			aRevision.error = "The baseline sheets could not be read";
+		}
+		else
+		{
+			RevisionDiff diff;
+			RevisionDiff::Difference difference;
+			diff.compare( baseline.spec(), loaded.spec(), difference );
+			std::ofstream changes( FileUtil::joinPath( aRevision.outputDirectory, CHANGES_FILE ).c_str() );
+			RevisionDiff::writeJson( changes, baseline.spec(), loaded.spec(), difference );
+			changes.close();
+			if( changes.fail() )
+			{
+				aRevision.error = std::string( "The changes could not be written to " ) + CHANGES_FILE;
+			}
+		}
+	}
+	if( aRevision.stats.filesFailed != 0 && aRevision.error.empty() )
+	{
+		aRevision.error = "Some files could not be saved";
+	}
+	if( aRevision.stats.manifestFailed && aRevision.error.empty() )
+	{
+		aRevision.error = std::string( "The manifest could not be written to " ) + MANIFEST_FILE;
+	}
+	aRevision.succeeded = aRevision.error.empty();
+	aRevision.time = stopwatch.elapsed();
+}
+
+void BatchConverter::printUsage( const char* aProgram )
+{
+	std::cerr << "Usage: " << aProgram << " [options] <sheet directory> <output directory> [<sheet directory> <output directory> ...]\n"
+		<< "Converts each directory of ARINC 429 specification sheets to Xml channel configurations.\n"
+		<< "The revisions are converted concurrently.\n"
+		<< "\n"
+		<< "  -j <count>       the threads to use, 0 for one per core (default 0)\n"
+		<< "  -s <file>        the Xml schema to save against\n"
+		<< "  -c               only rewrite the files whose equipment changed since the last run\n"
+		<< "  -t               write " << STATS_FILE << " to each output directory\n"
+		<< "  -l               write the transmit schedule and bus load of each equipment to " << BUS_LOAD_FILE << "\n"
+		<< "  -g               check the sheets against each other, writing what doesn't fit to " << VALIDATION_FILE << "\n"
+		<< "  -d <sheets>      compare with the earlier sheets at this path up to " << EQUIPMENT_SHEET << ",\n"
+		<< "                   writing what changed and the equipment it affects to " << CHANGES_FILE << "\n"
+		<< "  -x               stream the Xml instead of building it through Xml429. Unverified: its\n"
+		<< "                   layout is written by hand and not yet checked against the SDK's\n"
+		<< "  -f <format>      write xml, binary (.a429ch) or json files (default xml)\n"
+		<< "  -v               check that the streamed Xml of every equipment matches Xml429's, which\n"
+		<< "                   needs the SDK\n"
+		<< "  -h               show this help\n";
+}
+
+int BatchConverter::main( int argc, char* argv[] )
+{
+	const char* program = argc > 0 ? argv[0] : "a429DataLabelsConverter";
+	BatchConverter converter;
+	std::vector<std::string> directories;
+	for( int i = 1; i < argc; ++i )
+	{
+		std::string argument( argv[i] );
+		if( argument == "-h" || argument == "--help" )
+		{
+			printUsage( program );
+			return 0;
+		}
+		else if( argument.compare( 0, 2, "-j" ) == 0 )
+		{
+			//Both "-j 4" and "-j4"
+			std::string count = argument.size() > 2 ? argument.substr( 2 ) : (i + 1 < argc ? std::string( argv[++i] ) : std::string());
+			char* end = NULL;
+			long threads = strtol( count.c_str(), &end, 10 );
+			if( count.empty() || *end != '\0' || threads < 0 )
+			{
+				std::cerr << program << ": -j needs a thread count\n";
+				return 2;
+			}
+			converter.setThreadCount( (unsigned)threads );
+		}
+		else if( argument == "-s" )
+		{
+			if( i + 1 >= argc )
+			{
+				std::cerr << program << ": -s needs a schema file\n";
+				return 2;
+			}
+			converter.setSchemaFile( argv[++i] );
+		}
+		else if( argument == "-c" )
+		{
+			converter.setIncremental( true );
+		}
+		else if( argument == "-t" )
+		{
+			converter.setWriteStats( true );
+		}
+		else if( argument == "-l" )
+		{
+			converter.setWriteBusLoad( true );
+		}
+		else if( argument == "-g" )
+		{
+			converter.setWriteValidation( true );
+		}
+		else if( argument == "-d" )
+		{
+			if( i + 1 >= argc )
+			{
+				std::cerr << program << ": -d needs the path of the earlier sheets\n";
+				return 2;
+			}
+			converter.setBaseline( argv[++i] );
+		}
+		else if( argument == "-f" )
+		{
+			ChannelExporter::Format format;
+			if( i + 1 >= argc || !ChannelExporter::formatOf( argv[++i], format ) )
+			{
+				std::cerr << program << ": -f needs xml, binary or json\n";
+				return 2;
+			}
+			converter.setExportFormat( format );
+		}
+		else if( argument == "-x" )
+		{
+			converter.setStreamingXml( true );
+		}
+		else if( argument == "-v" )
+		{
+			converter.setVerifyXml( true );
+		}
+		else if( argument.size() > 1 && argument[0] == '-' )
+		{
+			std::cerr << program << ": unknown option " << argument << "\n";
+			printUsage( program );
+			return 2;
+		}
+		else
+		{
+			directories.push_back( argument );
+		}
+	}
+	if( directories.empty() || directories.size() % 2 != 0 )
+	{
+		printUsage( program );
+		return 2;
+	}
+
+	for( size_t i = 0; i < directories.size(); i += 2 )
+	{
+		if( !converter.addRevision( directories[i], directories[i + 1] ) )
+		{
+			std::cerr << program << ": " << directories[i] << " holds no complete set of sheets\n";
+			return 1;
+		}
+	}
+
+	bool succeeded = converter.run();
+
+	//Report in the order given, whatever order they finished in
+	for( size_t i = 0; i < converter.revisions().size(); ++i )
+	{
+		const Revision& revision = converter.revisions()[i];
+		const LoadStats& stats = revision.stats;
+		std::cout << revision.sheetPrefix << " -> " << revision.outputDirectory << ": ";
+		if( revision.succeeded )
+		{
+			std::cout << stats.filesWritten << " files written, " << stats.filesUnchanged << " unchanged, "
+				<< LoadStats::totalSkipped( stats.equipment ) + LoadStats::totalSkipped( stats.transmissions )
+					+ LoadStats::totalSkipped( stats.bnr ) + LoadStats::totalSkipped( stats.bcd ) << " rows skipped, "
+				<< stats.exportWarnings << " warnings";
+		}
+		else
+		{
+			std::cout << "FAILED: " << revision.error;
+		}
+		std::cout << " (" << revision.time / 1000000 << " ms)\n";
+	}
+	return succeeded ? 0 : 1;
+}
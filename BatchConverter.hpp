@@ -0,0 +1,221 @@
+/**
+ * @file BatchConverter.hpp
+ * @brief Converts the specification sheets of several revisions to Xml channel configurations at once.
+ */
+
+#ifndef A429_BATCH_CONVERTER_HPP
+#define A429_BATCH_CONVERTER_HPP
+
+#include <string>
+#include <vector>
+
+#include <Owl429/definitions>
+
+#include "ChannelExporter.hpp"
+#include "LoadStats.hpp"
+#include "WorkerPool.hpp"
+
+/**
+ * Loads the sheets of each revision and saves its Xml to its own directory.
+ * The revisions are converted concurrently, and the threads left over are
+ * shared out to load and save each one. Used by the command line of main().
+ */
+class BatchConverter
+{
+public:
+
+	/**
+	 * A set of sheets to convert, and how it went
+	 */
+	typedef struct Revision
+	{
+		/**
+		 * @brief The sheets' path up to "EquipmentIDs.csv", such as "specs/ARINC429P1-18-"
+		 */
+		std::string sheetPrefix;
+		/**
+		 * @brief Where the Xml is written
+		 */
+		std::string outputDirectory;
+		/**
+		 * @brief True if the sheets were loaded and every file was written
+		 */
+		bool succeeded;
+		/**
+		 * @brief Why the revision failed, or empty
+		 */
+		std::string error;
+		/**
+		 * @brief What loading and saving did
+		 */
+		LoadStats stats;
+		/**
+		 * @brief The nanoseconds the whole revision took
+		 */
+		OwUInt64 time;
+	} Revision;
+
+	/**
+	 * The name of the manifest setIncremental keeps in each output directory
+	 */
+	static const char* const MANIFEST_FILE;
+
+	/**
+	 * The name of the file setWriteStats writes in each output directory
+	 */
+	static const char* const STATS_FILE;
+
+	/**
+	 * The name of the file setWriteBusLoad writes in each output directory
+	 */
+	static const char* const BUS_LOAD_FILE;
+
+	/**
+	 * The name of the file setWriteValidation writes in each output directory
+	 */
+	static const char* const VALIDATION_FILE;
+
+	/**
+	 * The name of the file setBaseline writes in each output directory
+	 */
+	static const char* const CHANGES_FILE;
+
+	BatchConverter();
+
+	/**
+	 * @param aThreadCount the threads shared by every revision. 0 uses one per core
+	 */
+	void setThreadCount( unsigned aThreadCount );
+
+	/**
+	 * Sets the schema the Xml is saved against, instead of LoadedCSV's default
+	 */
+	void setSchemaFile( const std::string& aSchemaFile );
+
+	/**
+	 * Only rewrites the files whose equipment changed since the last run, see LoadedCSV::saveChanged
+	 */
+	void setIncremental( bool aIncremental );
+
+	/**
+	 * Writes the LoadStats of each revision to STATS_FILE in its output directory
+	 */
+	void setWriteStats( bool aWriteStats );
+
+	/**
+	 * Writes the ScheduleAnalyzer schedules of each revision to BUS_LOAD_FILE in its output directory
+	 */
+	void setWriteBusLoad( bool aWriteBusLoad );
+
+	/**
+	 * Checks the sheets of each revision against each other, writing the SpecValidator findings
+	 * to VALIDATION_FILE in its output directory
+	 */
+	void setWriteValidation( bool aWriteValidation );
+
+	/**
+	 * Compares each revision with the sheets of an earlier one, writing the RevisionDiff changes
+	 * and the equipment they affect to CHANGES_FILE in its output directory
+	 * @param aSheetPrefix the earlier sheets' path up to "EquipmentIDs.csv", or empty not to compare
+	 */
+	void setBaseline( const std::string& aSheetPrefix );
+
+	/**
+	 * Streams the Xml with ChannelXml instead of saving it through Xml429, see LoadedCSV::setStreamingXml
+	 */
+	void setStreamingXml( bool aStreamingXml );
+
+	/**
+	 * Chooses the backend the equipment are written with, see LoadedCSV::setExportFormat
+	 */
+	void setExportFormat( ChannelExporter::Format aFormat );
+
+	/**
+	 * Checks every equipment of each revision with LoadedCSV::verifyXml after it is saved.
+	 * A revision with an equipment that differs fails
+	 */
+	void setVerifyXml( bool aVerifyXml );
+
+	/**
+	 * Adds the sheets in a directory. The sheets are found by their names ending in
+	 * EquipmentIDs.csv, LabelIDs.csv, BnrData.csv and BcdData.csv after a common prefix.
+	 * If the directory holds several sets, each is written to a subdirectory of
+	 * aOutputDirectory named after its prefix
+	 * @returns false if the directory holds no complete set of sheets
+	 */
+	bool addRevision( const std::string& aSheetDirectory, const std::string& aOutputDirectory );
+
+	/**
+	 * Converts every revision added
+	 * @returns true if every revision succeeded
+	 */
+	bool run();
+
+	/**
+	 * @returns the revisions, in the order they were added
+	 */
+	const std::vector<Revision>& revisions() const
+	{
+		return revisionList;
+	}
+
+	/**
+	 * Finds the complete sets of sheets in a directory
+	 * @param aPrefixes cleared, then filled with the file name prefix of each set, sorted
+	 * @returns false if the directory couldn't be read
+	 */
+	static bool findSheets( const std::string& aDirectory, std::vector<std::string>& aPrefixes );
+
+	/**
+	 * Runs the command line converter. See the usage it prints for the arguments
+	 * @returns 0 if everything was converted, 1 if a revision failed, 2 for bad arguments
+	 */
+	static int main( int argc, char* argv[] );
+
+private:
+
+	/**
+	 * Converts one revision for run()
+	 */
+	class RevisionTask : public WorkerTask
+	{
+	public:
+		RevisionTask( const BatchConverter& aConverter, Revision& aRevision, unsigned aThreadCount )
+			: converter(&aConverter)
+			, revision(&aRevision)
+			, threadCount(aThreadCount)
+		{
+		}
+
+		void run()
+		{
+			converter->convert( *revision, threadCount );
+		}
+
+	private:
+		const BatchConverter* converter;
+		Revision* revision;
+		unsigned threadCount;
+	};
+
+	/**
+	 * Loads and saves a revision, and fills in how it went
+	 */
+	void convert( Revision& aRevision, unsigned aThreadCount ) const;
+
+	static void printUsage( const char* aProgram );
+
+	unsigned threadCount;
+	std::string schemaFile;
+	bool incremental;
+	bool writeStats;
+	bool writeBusLoad;
+	bool writeValidation;
+	std::string baselinePrefix;
+	bool streamingXml;
+	bool verifyXml;
+	ChannelExporter::Format exportFormat;
+	std::vector<Revision> revisionList;
+};
+
+#endif
@@ -0,0 +1,170 @@
+/**
+ * @file CaptureDecoder.cpp
+ * @brief Decodes files of captured ARINC 429 words in bounded memory.
+ */
+
+#include "CaptureDecoder.hpp"
+
+#include <fstream>
+#include <cstring>
+
+#include "MappedFile.hpp"
+#include "WordKernels.hpp"
+
+/**
+ * The words handled at a time when checking or normalizing a whole file
+ */
+static const size_t KERNEL_BLOCK = 4096;
+
+/**
+ * Reads a little endian integer of aSize bytes
+ */
+static OwUInt64 readLittleEndian( const char* aData, int aSize )
+{
+	OwUInt64 value = 0;
+	for( int i = aSize - 1; i >= 0; --i )
+	{
+		value = (value << 8) | (OwUInt8)aData[i];
+	}
+	return value;
+}
+
+CaptureDecoder::CaptureDecoder( const LabelDispatchTable& aTable, size_t aBatchSize )
+	: table(aTable)
+	, batch(aBatchSize == 0 ? 1 : aBatchSize)
+	, buffer(batch.size() * RECORD_SIZE)
+{
+}
+
+size_t CaptureDecoder::decode( const char* aData, size_t aCount, CaptureSink& aSink )
+{
+	size_t done = 0;
+	while( done < aCount )
+	{
+		size_t count = aCount - done < batch.size() ? aCount - done : batch.size();
+		const char* record = aData + done * RECORD_SIZE;
+		for( size_t i = 0; i < count; ++i, record += RECORD_SIZE )
+		{
+			decode( readLittleEndian( record, 8 ), (OwUInt32)readLittleEndian( record + 8, 4 ), batch[i] );
+		}
+		aSink.onRecords( &batch[0], count );
+		done += count;
+	}
+	return done;
+}
+
+bool CaptureDecoder::decodeFile( const std::string& aFile, CaptureSink& aSink )
+{
+	std::ifstream input( aFile.c_str(), std::ios::in | std::ios::binary );
+	if( !input )
+	{
+		return false;
+	}
+	while( input )
+	{
+		input.read( &buffer[0], (std::streamsize)buffer.size() );
+		size_t count = (size_t)input.gcount() / RECORD_SIZE;
+		if( count == 0 )
+		{
+			break;
+		}
+		decode( &buffer[0], count, aSink );
+	}
+	return !input.bad();
+}
+
+/**
+ * Copies the words out of capture records
+ */
+static void gatherWords( const char* aRecords, size_t aCount, OwUInt32* aWords )
+{
+	for( size_t i = 0; i < aCount; ++i, aRecords += CaptureDecoder::RECORD_SIZE )
+	{
+		aWords[i] = (OwUInt32)readLittleEndian( aRecords + 8, 4 );
+	}
+}
+
+/**
+ * Copies words back into capture records
+ */
+static void scatterWords( const OwUInt32* aWords, size_t aCount, char* aRecords )
+{
+	for( size_t i = 0; i < aCount; ++i, aRecords += CaptureDecoder::RECORD_SIZE )
+	{
+		for( int j = 0; j < 4; ++j )
+		{
+			aRecords[8 + j] = (char)(aWords[i] >> (8 * j));
+		}
+	}
+}
+
+void CaptureDecoder::appendRecord( std::vector<char>& aBuffer, OwUInt64 aTimestamp, OwUInt32 aWord )
+{
+	for( int i = 0; i < 8; ++i )
+	{
+		aBuffer.push_back( (char)(aTimestamp >> (8 * i)) );
+	}
+	for( int i = 0; i < 4; ++i )
+	{
+		aBuffer.push_back( (char)(aWord >> (8 * i)) );
+	}
+}
+
+bool CaptureDecoder::checkFile( const std::string& aFile, CaptureCheck& aCheck )
+{
+	aCheck.records = 0;
+	aCheck.parityErrors = 0;
+	aCheck.trailingBytes = 0;
+	MappedFile file;
+	if( !file.open( aFile ) )
+	{
+		return false;
+	}
+	size_t count = file.size() / RECORD_SIZE;
+	std::vector<OwUInt32> words( KERNEL_BLOCK );
+	for( size_t done = 0; done < count; done += KERNEL_BLOCK )
+	{
+		size_t block = count - done < KERNEL_BLOCK ? count - done : KERNEL_BLOCK;
+		gatherWords( file.data() + done * RECORD_SIZE, block, &words[0] );
+		aCheck.parityErrors += WordKernels::checkParity( &words[0], block, NULL );
+	}
+	aCheck.records = count;
+	aCheck.trailingBytes = file.size() % RECORD_SIZE;
+	return true;
+}
+
+bool CaptureDecoder::normalizeFile( const std::string& aFrom, const std::string& aTo, bool aReverseLabels, bool aSetParity )
+{
+	MappedFile file;
+	if( !file.open( aFrom ) )
+	{
+		return false;
+	}
+	std::ofstream output( aTo.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+	if( !output )
+	{
+		return false;
+	}
+	size_t count = file.size() / RECORD_SIZE;
+	std::vector<OwUInt32> words( KERNEL_BLOCK );
+	std::vector<char> records( KERNEL_BLOCK * RECORD_SIZE );
+	for( size_t done = 0; done < count && output; done += KERNEL_BLOCK )
+	{
+		size_t block = count - done < KERNEL_BLOCK ? count - done : KERNEL_BLOCK;
+		const char* from = file.data() + done * RECORD_SIZE;
+		memcpy( &records[0], from, block * RECORD_SIZE );
+		gatherWords( from, block, &words[0] );
+		if( aReverseLabels )
+		{
+			WordKernels::reverseLabels( &words[0], block );
+		}
+		if( aSetParity )
+		{
+			WordKernels::setParity( &words[0], block );
+		}
+		scatterWords( &words[0], block, &records[0] );
+		output.write( &records[0], (std::streamsize)(block * RECORD_SIZE) );
+	}
+	output.close();
+	return !output.fail();
+}
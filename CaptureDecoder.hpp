@@ -0,0 +1,173 @@
+/**
+ * @file CaptureDecoder.hpp
+ * @brief Decodes files of captured ARINC 429 words in bounded memory.
+ */
+
+#ifndef A429_CAPTURE_DECODER_HPP
+#define A429_CAPTURE_DECODER_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include <Owl429/definitions>
+
+#include "A429WordCodec.hpp"
+#include "LabelDispatchTable.hpp"
+
+/**
+ * A decoded word of a capture
+ */
+typedef struct DecodedRecord
+{
+	/**
+	 * @brief The timestamp of the word, as captured
+	 */
+	OwUInt64 timestamp;
+	/**
+	 * @brief The engineering value, or 0 if the label isn't known
+	 */
+	double value;
+	/**
+	 * @brief The raw word
+	 */
+	OwUInt32 word;
+	/**
+	 * @brief The descriptor the word was decoded with, or LabelDispatchTable::NO_ENTRY
+	 */
+	OwUInt16 descriptor;
+	OwUInt8 label;
+	OwUInt8 sdi;
+	A429WordCodec::Status status;
+	/**
+	 * @brief Denotes whether or not the word has odd parity
+	 */
+	bool parityValid;
+} DecodedRecord;
+
+/**
+ * What checking a capture found
+ */
+typedef struct CaptureCheck
+{
+	OwUInt64 records;
+	/**
+	 * @brief The words without odd parity
+	 */
+	OwUInt64 parityErrors;
+	/**
+	 * @brief The bytes of a partial record at the end, which aren't checked
+	 */
+	size_t trailingBytes;
+} CaptureCheck;
+
+/**
+ * Receives the decoded words of a capture, a batch at a time
+ */
+class CaptureSink
+{
+public:
+	virtual ~CaptureSink() {}
+
+	/**
+	 * Called with each batch of decoded words, in capture order.
+	 * The records are only valid during the call
+	 */
+	virtual void onRecords( const DecodedRecord* aRecords, size_t aCount ) = 0;
+};
+
+/**
+ * Decodes captured words using a LabelDispatchTable.
+ *
+ * A capture file is a sequence of 12 byte little endian records: a 64 bit
+ * timestamp followed by the 32 bit word. The file is read a batch at a time,
+ * so memory use doesn't depend on its size.
+ */
+class CaptureDecoder
+{
+public:
+
+	/**
+	 * The size of a capture record in bytes
+	 */
+	enum { RECORD_SIZE = 12 };
+
+	/**
+	 * @param aTable the decoders of the bus. It is not copied, so it must outlive the decoder
+	 * @param aBatchSize the number of words read and decoded at a time
+	 */
+	explicit CaptureDecoder( const LabelDispatchTable& aTable, size_t aBatchSize = 4096 );
+
+	/**
+	 * Decodes one word
+	 */
+	void decode( OwUInt64 aTimestamp, OwUInt32 aWord, DecodedRecord& aRecord ) const
+	{
+		aRecord.timestamp = aTimestamp;
+		aRecord.word = aWord;
+		aRecord.label = A429WordCodec::label( aWord );
+		aRecord.sdi = A429WordCodec::sdi( aWord );
+		aRecord.parityValid = A429WordCodec::parityValid( aWord );
+		aRecord.descriptor = table.lookup( aWord );
+		if( aRecord.descriptor == LabelDispatchTable::NO_ENTRY )
+		{
+			aRecord.value = 0;
+			aRecord.status = A429WordCodec::STATUS_NO_COMPUTED_DATA;
+			return;
+		}
+		A429WordCodec::Decoded decoded = A429WordCodec::decode( aWord, table.descriptor( aRecord.descriptor ) );
+		aRecord.sdi = decoded.sdi;
+		aRecord.value = decoded.value;
+		aRecord.status = decoded.status;
+	}
+
+	/**
+	 * Decodes capture records held in memory
+	 * @param aData the records, aCount * RECORD_SIZE bytes
+	 * @returns the number of records decoded
+	 */
+	size_t decode( const char* aData, size_t aCount, CaptureSink& aSink );
+
+	/**
+	 * Decodes a capture file
+	 * @param aFile the file to decode
+	 * @param aSink what to send the decoded words to
+	 * @returns false if the file couldn't be read. A partial record at the end is ignored
+	 */
+	bool decodeFile( const std::string& aFile, CaptureSink& aSink );
+
+	/**
+	 * Appends a capture record to a buffer, for writing captures
+	 */
+	static void appendRecord( std::vector<char>& aBuffer, OwUInt64 aTimestamp, OwUInt32 aWord );
+
+	/**
+	 * Checks the parity of every word of a capture file without decoding them, using WordKernels
+	 * @returns false if the file couldn't be read
+	 */
+	static bool checkFile( const std::string& aFile, CaptureCheck& aCheck );
+
+	/**
+	 * Writes a copy of a capture file with its words normalized. The timestamps are copied as
+	 * they are, and a partial record at the end is dropped
+	 * @param aReverseLabels reverse the bit order of each label, for captures of words stored
+	 *        in the order their bits arrived
+	 * @param aSetParity set the parity bit of each word to give it odd parity
+	 * @returns false if either file couldn't be opened, or the copy couldn't be written
+	 */
+	static bool normalizeFile( const std::string& aFrom, const std::string& aTo, bool aReverseLabels, bool aSetParity );
+
+private:
+
+	const LabelDispatchTable& table;
+	/**
+	 * @brief The decoded words of the batch being decoded
+	 */
+	std::vector<DecodedRecord> batch;
+	/**
+	 * @brief The raw records of the batch being read
+	 */
+	std::vector<char> buffer;
+};
+
+#endif
@@ -0,0 +1,224 @@
+/**
+ * @file ChannelBinary.cpp
+ * @brief A binary channel configuration that simulators map and read in place (.a429ch).
+ */
+
+#include "ChannelBinary.hpp"
+
+#include <cstring>
+
+const char* const ChannelBinary::BINARY_EXTENSION = ".a429ch";
+
+/**
+ * The first 8 bytes of every file
+ */
+static const char MAGIC[8] = { 'A', '4', '2', '9', 'C', 'H', '\0', '\0' };
+
+/**
+ * Rounds an offset up to the next 8 byte boundary
+ */
+static OwUInt32 align8( OwUInt32 aOffset )
+{
+	return (aOffset + 7) & ~(OwUInt32)7;
+}
+
+/**
+ * Checks that a section lies inside the file
+ */
+static bool sectionFits( OwUInt32 aOffset, OwUInt32 aCount, size_t aRecordSize, size_t aFileSize )
+{
+	return aOffset % 8 == 0 && aOffset <= aFileSize && (OwUInt64)aCount * aRecordSize <= aFileSize - aOffset;
+}
+
+ChannelBinary::ChannelBinary()
+{
+}
+
+const char* ChannelBinary::extension() const
+{
+	return BINARY_EXTENSION;
+}
+
+OwUInt32 ChannelBinary::addString( std::string& aDocument, OwUInt32 aTableOffset, const char* aString, size_t aLength )
+{
+	if( aDocument.size() % 2 != 0 )
+	{
+		aDocument.push_back( '\0' );
+	}
+	OwUInt32 offset = (OwUInt32)aDocument.size() - aTableOffset;
+	OwUInt16 length = (OwUInt16)(aLength > 0xFFFF ? 0xFFFF : aLength);
+	aDocument.append( (const char*)&length, sizeof(length) );
+	aDocument.append( aString, length );
+	aDocument.push_back( '\0' );
+	return offset;
+}
+
+void ChannelBinary::format( const ChannelConfig& aConfig, std::string& aDocument ) const
+{
+	Header header;
+	memset( &header, 0, sizeof(header) );
+	memcpy( header.magic, MAGIC, sizeof(MAGIC) );
+	header.byteOrder = 0x01020304;
+	header.version = VERSION;
+	header.channel = aConfig.channel();
+	header.transferCount = (OwUInt32)aConfig.transferCount();
+	header.bufferCount = (OwUInt32)aConfig.bufferCount();
+	header.transferOffset = align8( sizeof(Header) );
+	header.bufferOffset = align8( header.transferOffset + header.transferCount * sizeof(TransferRecord) );
+	header.stringTableOffset = align8( header.bufferOffset + header.bufferCount * sizeof(BufferRecord) );
+
+	//The records are filled in as their strings are added after them
+	aDocument.assign( header.stringTableOffset, '\0' );
+	header.name = addString( aDocument, header.stringTableOffset, aConfig.name().data(), aConfig.name().size() );
+	for( OwUInt32 i = 0; i < header.transferCount; ++i )
+	{
+		const ChannelConfig::Transfer& transfer = aConfig.transfer( i );
+		TransferRecord record;
+		memset( &record, 0, sizeof(record) );
+		record.rate = transfer.rate;
+		record.name = addString( aDocument, header.stringTableOffset, aConfig.nameAt( transfer.nameOffset ), transfer.nameLength );
+		record.label = transfer.label;
+		record.isPeriod = transfer.isPeriod ? 1 : 0;
+		aDocument.replace( header.transferOffset + i * sizeof(TransferRecord), sizeof(record), (const char*)&record, sizeof(record) );
+	}
+
+	//A buffer is named after its transfer, so share the string. They are in transfer order, so look from the last one found
+	OwUInt32 nextTransfer = 0;
+	for( OwUInt32 i = 0; i < header.bufferCount; ++i )
+	{
+		const ChannelConfig::Buffer& buffer = aConfig.buffer( i );
+		BufferRecord record;
+		memset( &record, 0, sizeof(record) );
+		record.label = buffer.label;
+		OwUInt32 found = header.transferCount;
+		for( OwUInt32 j = 0; j < header.transferCount && found == header.transferCount; ++j )
+		{
+			OwUInt32 candidate = (nextTransfer + j) % header.transferCount;
+			if( aConfig.transfer( candidate ).nameOffset == buffer.nameOffset && aConfig.transfer( candidate ).nameLength == buffer.nameLength )
+			{
+				found = candidate;
+			}
+		}
+		if( found != header.transferCount )
+		{
+			const TransferRecord* transfers = (const TransferRecord*)(aDocument.data() + header.transferOffset);
+			record.name = transfers[found].name;
+			nextTransfer = found + 1;
+		}
+		else
+		{
+			record.name = addString( aDocument, header.stringTableOffset, aConfig.nameAt( buffer.nameOffset ), buffer.nameLength );
+		}
+		aDocument.replace( header.bufferOffset + i * sizeof(BufferRecord), sizeof(record), (const char*)&record, sizeof(record) );
+	}
+
+	aDocument.resize( align8( (OwUInt32)aDocument.size() ), '\0' );
+	header.stringTableSize = (OwUInt32)aDocument.size() - header.stringTableOffset;
+	header.fileSize = (OwUInt32)aDocument.size();
+	aDocument.replace( 0, sizeof(header), (const char*)&header, sizeof(header) );
+}
+
+bool ChannelBinary::read( const char* aData, size_t aLength, ChannelConfig& aConfig, std::string& aError ) const
+{
+	aConfig.clear();
+	ChannelBinaryView view;
+	if( !view.attach( aData, aLength ) )
+	{
+		aError = "not a valid .a429ch file of this version";
+		return false;
+	}
+	aConfig.setChannel( view.channel(), view.name(), view.nameLength() );
+	for( OwUInt32 i = 0; i < view.transferCount(); ++i )
+	{
+		const TransferRecord& transfer = view.transfer( i );
+		aConfig.addTransfer( transfer.label, view.string( transfer.name ), view.stringLength( transfer.name ), transfer.isPeriod != 0, transfer.rate );
+	}
+	for( OwUInt32 i = 0; i < view.bufferCount(); ++i )
+	{
+		const BufferRecord& buffer = view.buffer( i );
+		aConfig.addBuffer( buffer.label, view.string( buffer.name ), view.stringLength( buffer.name ) );
+	}
+	return true;
+}
+
+ChannelBinaryView::ChannelBinaryView()
+	: header(NULL)
+	, transfers(NULL)
+	, buffers(NULL)
+	, strings(NULL)
+{
+}
+
+bool ChannelBinaryView::open( const std::string& aFile )
+{
+	close();
+	if( !file.open( aFile ) || !attach( file.data(), file.size() ) )
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool ChannelBinaryView::stringFits( const ChannelBinary::Header& aHeader, const char* aStrings, OwUInt32 aOffset ) const
+{
+	if( aOffset % 2 != 0 || aOffset > aHeader.stringTableSize || aHeader.stringTableSize - aOffset < sizeof(OwUInt16) + 1 )
+	{
+		return false;
+	}
+	OwUInt16 length = *(const OwUInt16*)(aStrings + aOffset);
+	return (OwUInt64)aOffset + sizeof(OwUInt16) + length + 1 <= aHeader.stringTableSize && aStrings[aOffset + sizeof(OwUInt16) + length] == '\0';
+}
+
+bool ChannelBinaryView::attach( const char* aData, size_t aLength )
+{
+	header = NULL;
+	if( aLength < sizeof(ChannelBinary::Header) || ((size_t)aData & 7) != 0 )
+	{
+		return false;
+	}
+	const ChannelBinary::Header* candidate = (const ChannelBinary::Header*)aData;
+	if( memcmp( candidate->magic, MAGIC, sizeof(MAGIC) ) != 0 || candidate->byteOrder != 0x01020304 || candidate->version != ChannelBinary::VERSION || candidate->fileSize != aLength )
+	{
+		return false;
+	}
+
+	//Make sure every section and string is inside the file before anything is read from it
+	if( !sectionFits( candidate->transferOffset, candidate->transferCount, sizeof(ChannelBinary::TransferRecord), aLength )
+		|| !sectionFits( candidate->bufferOffset, candidate->bufferCount, sizeof(ChannelBinary::BufferRecord), aLength )
+		|| !sectionFits( candidate->stringTableOffset, candidate->stringTableSize, 1, aLength ) )
+	{
+		return false;
+	}
+	const ChannelBinary::TransferRecord* candidateTransfers = (const ChannelBinary::TransferRecord*)(aData + candidate->transferOffset);
+	const ChannelBinary::BufferRecord* candidateBuffers = (const ChannelBinary::BufferRecord*)(aData + candidate->bufferOffset);
+	const char* candidateStrings = aData + candidate->stringTableOffset;
+	bool valid = stringFits( *candidate, candidateStrings, candidate->name );
+	for( OwUInt32 i = 0; i < candidate->transferCount && valid; ++i )
+	{
+		valid = stringFits( *candidate, candidateStrings, candidateTransfers[i].name );
+	}
+	for( OwUInt32 i = 0; i < candidate->bufferCount && valid; ++i )
+	{
+		valid = stringFits( *candidate, candidateStrings, candidateBuffers[i].name );
+	}
+	if( !valid )
+	{
+		return false;
+	}
+
+	header = candidate;
+	transfers = candidateTransfers;
+	buffers = candidateBuffers;
+	strings = candidateStrings;
+	return true;
+}
+
+void ChannelBinaryView::close()
+{
+	file.close();
+	header = NULL;
+	transfers = NULL;
+	buffers = NULL;
+	strings = NULL;
+}
@@ -0,0 +1,230 @@
+/**
+ * @file ChannelBinary.hpp
+ * @brief A binary channel configuration that simulators map and read in place (.a429ch).
+ */
+
+#ifndef A429_CHANNEL_BINARY_HPP
+#define A429_CHANNEL_BINARY_HPP
+
+#include <string>
+#include <cstddef>
+
+#include <Owl429/definitions>
+
+#include "ChannelExporter.hpp"
+#include "MappedFile.hpp"
+
+/**
+ * Writes the channel configuration of an equipment as a .a429ch file. It is made of fixed
+ * size records, so a reader maps it and uses it in place with ChannelBinaryView rather
+ * than parsing it.
+ *
+ * The file is in the byte order of the machine that wrote it, which is checked on opening.
+ * Each section starts on an 8 byte boundary:
+ *  - Header
+ *  - TransferRecord[transferCount]
+ *  - BufferRecord[bufferCount]
+ *  - the string table. Each string starts on a 2 byte boundary with its OwUInt16 length,
+ *    then its bytes and a '\0', and is referred to by its offset in the table
+ */
+class ChannelBinary : public ChannelExporter
+{
+public:
+
+	/**
+	 * The format version this code reads and writes
+	 */
+	enum { VERSION = 1 };
+
+	/**
+	 * What is added to the file names
+	 */
+	static const char* const BINARY_EXTENSION;
+
+	/**
+	 * The start of the file
+	 */
+	typedef struct Header
+	{
+		/**
+		 * @brief "A429CH" then two '\0'
+		 */
+		char magic[8];
+		/**
+		 * @brief 0x01020304 as written by the writing machine, to reject the wrong byte order
+		 */
+		OwUInt32 byteOrder;
+		/**
+		 * @brief The format version
+		 */
+		OwUInt32 version;
+		/**
+		 * @brief The size of the whole file in bytes
+		 */
+		OwUInt32 fileSize;
+		/**
+		 * @brief The channel number
+		 */
+		OwUInt32 channel;
+		/**
+		 * @brief The string offset of the channel name
+		 */
+		OwUInt32 name;
+		OwUInt32 transferCount;
+		OwUInt32 bufferCount;
+		/**
+		 * @brief The byte offsets of the sections from the start of the file
+		 */
+		OwUInt32 transferOffset;
+		OwUInt32 bufferOffset;
+		OwUInt32 stringTableOffset;
+		OwUInt32 stringTableSize;
+		OwUInt32 reserved;
+	} Header;
+
+	/**
+	 * A scheduled transfer
+	 */
+	typedef struct TransferRecord
+	{
+		/**
+		 * @brief The transfer period in ms if isPeriod, otherwise the rate in Hz
+		 */
+		double rate;
+		/**
+		 * @brief The string offset of the name
+		 */
+		OwUInt32 name;
+		/**
+		 * @brief The label code
+		 */
+		OwUInt8 label;
+		OwUInt8 isPeriod;
+		OwUInt16 reserved;
+	} TransferRecord;
+
+	/**
+	 * A label buffer of the monitor
+	 */
+	typedef struct BufferRecord
+	{
+		/**
+		 * @brief The string offset of the name
+		 */
+		OwUInt32 name;
+		/**
+		 * @brief The label code
+		 */
+		OwUInt8 label;
+		OwUInt8 reserved[3];
+	} BufferRecord;
+
+	ChannelBinary();
+
+	const char* extension() const;
+
+	bool read( const char* aData, size_t aLength, ChannelConfig& aConfig, std::string& aError ) const;
+
+protected:
+
+	void format( const ChannelConfig& aConfig, std::string& aDocument ) const;
+
+private:
+
+	/**
+	 * Appends a string to the string table at the end of aDocument
+	 * @returns its offset in the table
+	 */
+	static OwUInt32 addString( std::string& aDocument, OwUInt32 aTableOffset, const char* aString, size_t aLength );
+};
+
+/**
+ * A read-only view of a .a429ch file, used in place. Opening it checks the header, that
+ * every section is inside the file and that every string a record refers to is, so
+ * nothing read through the view needs checking after that.
+ */
+class ChannelBinaryView
+{
+public:
+
+	ChannelBinaryView();
+
+	/**
+	 * Maps a file and checks it
+	 * @returns false if it couldn't be mapped or isn't a valid file of this version
+	 */
+	bool open( const std::string& aFile );
+
+	/**
+	 * Checks a file already in memory, and uses it in place. It must stay there, 8 byte aligned, while it is used
+	 * @returns false if it isn't a valid file of this version
+	 */
+	bool attach( const char* aData, size_t aLength );
+
+	/**
+	 * Unmaps or lets go of the file
+	 */
+	void close();
+
+	/**
+	 * @returns true if a file is open
+	 */
+	bool isOpen() const
+	{
+		return header != NULL;
+	}
+
+	OwUInt32 channel() const				{ return header->channel; }
+	OwUInt32 transferCount() const			{ return header->transferCount; }
+	OwUInt32 bufferCount() const			{ return header->bufferCount; }
+
+	const ChannelBinary::TransferRecord& transfer( OwUInt32 aIndex ) const	{ return transfers[aIndex]; }
+	const ChannelBinary::BufferRecord& buffer( OwUInt32 aIndex ) const		{ return buffers[aIndex]; }
+
+	/**
+	 * @returns the channel name
+	 */
+	const char* name() const
+	{
+		return string( header->name );
+	}
+
+	OwUInt16 nameLength() const
+	{
+		return stringLength( header->name );
+	}
+
+	/**
+	 * @returns the null terminated string at an offset of the string table
+	 */
+	const char* string( OwUInt32 aOffset ) const
+	{
+		return strings + aOffset + sizeof(OwUInt16);
+	}
+
+	/**
+	 * @returns the length of the string at an offset of the string table
+	 */
+	OwUInt16 stringLength( OwUInt32 aOffset ) const
+	{
+		return *(const OwUInt16*)(strings + aOffset);
+	}
+
+private:
+
+	/**
+	 * @returns true if a string offset refers to a whole string inside the table
+	 */
+	bool stringFits( const ChannelBinary::Header& aHeader, const char* aStrings, OwUInt32 aOffset ) const;
+
+	ChannelBinaryView( const ChannelBinaryView& );
+	ChannelBinaryView& operator=( const ChannelBinaryView& );
+
+	MappedFile file;
+	const ChannelBinary::Header* header;
+	const ChannelBinary::TransferRecord* transfers;
+	const ChannelBinary::BufferRecord* buffers;
+	const char* strings;
+};
+
+#endif
@@ -0,0 +1,201 @@
+/**
+ * @file ChannelConfig.cpp
+ * @brief The channel configuration of an equipment, resolved from the loaded sheets for the export backends.
+ */
+
+#include "ChannelConfig.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#include "ContentHash.hpp"
+
+namespace
+{
+	OwUInt64 hashName( const char* aName, size_t aLength )
+	{
+		ContentHash hash;
+		hash.add( aName, aLength );
+		return hash.value();
+	}
+}
+
+ChannelConfig::ChannelConfig()
+	: channelNumber(0)
+{
+}
+
+void ChannelConfig::clear()
+{
+	channelNumber = 0;
+	channelName.clear();
+	transfers.clear();
+	buffers.clear();
+	names.clear();
+	nameHashes.clear();
+}
+
+bool ChannelConfig::isNameUsed( const char* aName, size_t aLength, OwUInt64 aHash ) const
+{
+	for( size_t i = 0; i < transfers.size(); ++i )
+	{
+		const Transfer& used = transfers[i];
+		if( nameHashes[i] == aHash && used.nameLength == aLength && memcmp( names.data() + used.nameOffset, aName, aLength ) == 0 )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void ChannelConfig::resolve( const SpecStore::EquipmentView& aEquipment, OwUInt32 aChannel, std::string& aErrors )
+{
+	clear();
+	channelNumber = aChannel;
+	channelName = aEquipment.type().str();
+
+	//The transfers, chosen as saveEquipment chooses them
+	for( OwUInt32 i = 0; i < aEquipment.transmissionCount(); ++i )
+	{
+		SpecStore::TransmissionView transmission = aEquipment.transmission( i );
+		SpecStore::DataView bcdData = transmission.bcdData();
+		SpecStore::DataView bnrData = transmission.bnrData();
+		SpecStore::DataView data;
+		if( transmission.bcd() && bcdData.isValid() )
+		{
+			data = bcdData;
+		}
+		else if( transmission.bnr() && bnrData.isValid() )
+		{
+			data = bnrData;
+		}
+		else
+		{
+			continue;	//It says there is bcd/bnr data, but there isn't
+		}
+
+		//The name is the parameter, or if a transfer already has that, the parameter and the label
+		PooledString parameter = transmission.parameter();
+		size_t start = names.size();
+		OwUInt64 hash = hashName( parameter.data(), parameter.size() );
+		if( isNameUsed( parameter.data(), parameter.size(), hash ) )
+		{
+			char label[16];
+			sprintf( label, " (%d)", (int)transmission.codeNo() );
+			names.append( parameter.data(), parameter.size() );
+			names.append( label );
+			hash = hashName( names.data() + start, names.size() - start );
+			if( isNameUsed( names.data() + start, names.size() - start, hash ) )
+			{
+				aErrors.append( "Error: The transfer name " );
+				aErrors.append( names, start, std::string::npos );
+				aErrors.append( " is already in use\n" );
+				names.resize( start );
+				continue;
+			}
+		}
+		else
+		{
+			names.append( parameter.data(), parameter.size() );
+		}
+
+		Transfer transfer;
+		transfer.label = (OwUInt8)transmission.codeNo();
+		transfer.nameOffset = (OwUInt32)start;
+		transfer.nameLength = (OwUInt32)(names.size() - start);
+		transfer.isPeriod = data.isPeriod();
+		transfer.rate = data.isPeriod() ? (double)(OwUInt32)data.rate() : data.rate();	//Periods are whole ms, as TxScheduledLabelConfig takes them
+		transfers.push_back( transfer );
+		nameHashes.push_back( hash );
+	}
+
+	//Then a buffer for each label the monitor receives. A label only gets one
+	OwUInt32 buffered[256 / 32] = { 0 };
+	for( size_t i = 0; i < transfers.size(); ++i )
+	{
+		const Transfer& transfer = transfers[i];
+		OwUInt8 label = transfer.label;
+		if( (buffered[label / 32] & (1u << (label % 32))) != 0 )
+		{
+			aErrors.append( "Error: Label " );
+			char code[8];
+			sprintf( code, "%03o", (unsigned)label );
+			aErrors.append( code );
+			aErrors.append( " already has a buffer, so " );
+			aErrors.append( names, transfer.nameOffset, transfer.nameLength );
+			aErrors.append( " isn't monitored\n" );
+			continue;
+		}
+		buffered[label / 32] |= 1u << (label % 32);
+		Buffer buffer;
+		buffer.label = label;
+		buffer.nameOffset = transfer.nameOffset;
+		buffer.nameLength = transfer.nameLength;
+		buffers.push_back( buffer );
+	}
+}
+
+void ChannelConfig::setChannel( OwUInt32 aChannel, const char* aName, size_t aLength )
+{
+	channelNumber = aChannel;
+	channelName.assign( aName, aLength );
+}
+
+void ChannelConfig::addTransfer( OwUInt8 aLabel, const char* aName, size_t aLength, bool aIsPeriod, double aRate )
+{
+	Transfer transfer;
+	transfer.label = aLabel;
+	transfer.nameOffset = (OwUInt32)names.size();
+	transfer.nameLength = (OwUInt32)aLength;
+	transfer.isPeriod = aIsPeriod;
+	transfer.rate = aRate;
+	names.append( aName, aLength );
+	transfers.push_back( transfer );
+}
+
+void ChannelConfig::addBuffer( OwUInt8 aLabel, const char* aName, size_t aLength )
+{
+	Buffer buffer;
+	buffer.label = aLabel;
+	buffer.nameOffset = (OwUInt32)names.size();
+	buffer.nameLength = (OwUInt32)aLength;
+	names.append( aName, aLength );
+	buffers.push_back( buffer );
+}
+
+bool ChannelConfig::sameAs( const ChannelConfig& aOther, std::string& aDifference ) const
+{
+	std::stringstream difference;
+	if( channelNumber != aOther.channelNumber || channelName != aOther.channelName )
+	{
+		difference << "channel " << channelNumber << " \"" << channelName << "\" against " << aOther.channelNumber << " \"" << aOther.channelName << "\"";
+	}
+	else if( transfers.size() != aOther.transfers.size() || buffers.size() != aOther.buffers.size() )
+	{
+		difference << transfers.size() << " transfers and " << buffers.size() << " buffers against " << aOther.transfers.size() << " and " << aOther.buffers.size();
+	}
+	for( size_t i = 0; i < transfers.size() && difference.str().empty(); ++i )
+	{
+		const Transfer& a = transfers[i];
+		const Transfer& b = aOther.transfers[i];
+		if( a.label != b.label || a.isPeriod != b.isPeriod || a.rate != b.rate || a.nameLength != b.nameLength
+			|| memcmp( nameAt( a.nameOffset ), aOther.nameAt( b.nameOffset ), a.nameLength ) != 0 )
+		{
+			difference << "transfer " << i << ": label " << (unsigned)a.label << " " << std::string( nameAt( a.nameOffset ), a.nameLength ) << " " << a.rate
+				<< " against label " << (unsigned)b.label << " " << std::string( aOther.nameAt( b.nameOffset ), b.nameLength ) << " " << b.rate;
+		}
+	}
+	for( size_t i = 0; i < buffers.size() && difference.str().empty(); ++i )
+	{
+		const Buffer& a = buffers[i];
+		const Buffer& b = aOther.buffers[i];
+		if( a.label != b.label || a.nameLength != b.nameLength || memcmp( nameAt( a.nameOffset ), aOther.nameAt( b.nameOffset ), a.nameLength ) != 0 )
+		{
+			difference << "buffer " << i << ": label " << (unsigned)a.label << " " << std::string( nameAt( a.nameOffset ), a.nameLength )
+				<< " against label " << (unsigned)b.label << " " << std::string( aOther.nameAt( b.nameOffset ), b.nameLength );
+		}
+	}
+	aDifference = difference.str();
+	return aDifference.empty();
+}
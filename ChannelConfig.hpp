@@ -0,0 +1,152 @@
+/**
+ * @file ChannelConfig.hpp
+ * @brief The channel configuration of an equipment, resolved from the loaded sheets for the export backends.
+ */
+
+#ifndef A429_CHANNEL_CONFIG_HPP
+#define A429_CHANNEL_CONFIG_HPP
+
+#include <string>
+#include <vector>
+
+#include <Owl429/definitions>
+
+#include "SpecStore.hpp"
+
+/**
+ * What gets exported for an equipment: a rate oriented transmit channel with a scheduled
+ * transfer per label, and a monitor with a buffer per label received.
+ *
+ * resolve() works it out from the Equipment -> Transmission -> BNR/BCD rows the same way
+ * LoadedCSV::saveEquipment does, so every ChannelExporter writes the same configuration,
+ * and each one's read() fills it back in.
+ *
+ * The names are kept one after another in one string, and the lists are kept from one
+ * equipment to the next, so a config that is reused stops allocating.
+ */
+class ChannelConfig
+{
+public:
+
+	/**
+	 * A scheduled transfer
+	 */
+	typedef struct Transfer
+	{
+		/**
+		 * @brief The transfer period in ms if isPeriod, otherwise the rate in Hz
+		 */
+		double rate;
+		/**
+		 * @brief Where the name is in the names
+		 */
+		OwUInt32 nameOffset;
+		OwUInt32 nameLength;
+		/**
+		 * @brief The label code
+		 */
+		OwUInt8 label;
+		bool isPeriod;
+	} Transfer;
+
+	/**
+	 * A label buffer of the monitor
+	 */
+	typedef struct Buffer
+	{
+		/**
+		 * @brief Where the name is in the names
+		 */
+		OwUInt32 nameOffset;
+		OwUInt32 nameLength;
+		/**
+		 * @brief The label code
+		 */
+		OwUInt8 label;
+	} Buffer;
+
+	/**
+	 * The entries of each label buffer, as saveEquipment's LabelBufferConfig(1)
+	 */
+	static const OwUInt32 LABEL_BUFFER_SIZE = 1;
+
+	ChannelConfig();
+
+	/**
+	 * Empties the config, keeping what it has allocated
+	 */
+	void clear();
+
+	/**
+	 * Works out the configuration of an equipment, replacing the last one
+	 * @param aChannel the channel number, as given to Xml429::save
+	 * @param aErrors where to append the errors
+	 */
+	void resolve( const SpecStore::EquipmentView& aEquipment, OwUInt32 aChannel, std::string& aErrors );
+
+	/**
+	 * Sets the channel number and name, for the readers
+	 */
+	void setChannel( OwUInt32 aChannel, const char* aName, size_t aLength );
+
+	/**
+	 * Adds a transfer, for the readers
+	 */
+	void addTransfer( OwUInt8 aLabel, const char* aName, size_t aLength, bool aIsPeriod, double aRate );
+
+	/**
+	 * Adds a label buffer, for the readers
+	 */
+	void addBuffer( OwUInt8 aLabel, const char* aName, size_t aLength );
+
+	/**
+	 * Compares two configs, as the round trip check of the export backends
+	 * @param aDifference set to how they first differ, if they do
+	 * @returns true if they are the same
+	 */
+	bool sameAs( const ChannelConfig& aOther, std::string& aDifference ) const;
+
+	OwUInt32 channel() const				{ return channelNumber; }
+	size_t transferCount() const			{ return transfers.size(); }
+	size_t bufferCount() const				{ return buffers.size(); }
+	const Transfer& transfer( size_t aIndex ) const		{ return transfers[aIndex]; }
+	const Buffer& buffer( size_t aIndex ) const			{ return buffers[aIndex]; }
+
+	/**
+	 * @returns the channel name, the type of the equipment
+	 */
+	const std::string& name() const
+	{
+		return channelName;
+	}
+
+	/**
+	 * @returns the start of a name of a transfer or buffer, nameLength long
+	 */
+	const char* nameAt( OwUInt32 aOffset ) const
+	{
+		return names.data() + aOffset;
+	}
+
+private:
+
+	/**
+	 * @returns true if a transfer already has the name
+	 */
+	bool isNameUsed( const char* aName, size_t aLength, OwUInt64 aHash ) const;
+
+	OwUInt32 channelNumber;
+	std::string channelName;
+	std::vector<Transfer> transfers;
+	std::vector<Buffer> buffers;
+	/**
+	 * @brief The names of the transfers and buffers, one after another
+	 */
+	std::string names;
+	/**
+	 * @brief The hash of the name of each transfer, while resolving
+	 */
+	std::vector<OwUInt64> nameHashes;
+};
+
+#endif
@@ -0,0 +1,74 @@
+/**
+ * @file ChannelExporter.cpp
+ * @brief The export backends that write the channel configuration of each equipment.
+ */
+
+#include "ChannelExporter.hpp"
+
+#include <cstdio>
+
+#include "ChannelBinary.hpp"
+#include "ChannelJson.hpp"
+#include "ChannelXml.hpp"
+
+/**
+ * The names of the formats, in Format order
+ */
+static const char* const FORMAT_NAMES[ChannelExporter::FORMAT_COUNT] = { "xml", "binary", "json" };
+
+ChannelExporter* ChannelExporter::create( Format aFormat, const std::string& aSchemaFile )
+{
+	switch( aFormat )
+	{
+	case FORMAT_BINARY:
+		return new ChannelBinary();
+	case FORMAT_JSON:
+		return new ChannelJson();
+	default:
+		return new ChannelXml( aSchemaFile );
+	}
+}
+
+const char* ChannelExporter::formatName( Format aFormat )
+{
+	return aFormat < FORMAT_COUNT ? FORMAT_NAMES[aFormat] : "";
+}
+
+bool ChannelExporter::formatOf( const std::string& aName, Format& aFormat )
+{
+	for( int i = 0; i < FORMAT_COUNT; ++i )
+	{
+		if( aName == FORMAT_NAMES[i] )
+		{
+			aFormat = (Format)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+ChannelExporter::ChannelExporter()
+{
+}
+
+ChannelExporter::~ChannelExporter()
+{
+}
+
+void ChannelExporter::write( const SpecStore::EquipmentView& aEquipment, OwUInt32 aChannel, std::string& aErrors )
+{
+	resolved.resolve( aEquipment, aChannel, aErrors );
+	document.clear();
+	format( resolved, document );
+}
+
+bool ChannelExporter::save( const std::string& aFileName ) const
+{
+	FILE* file = fopen( (aFileName + extension()).c_str(), "wb" );
+	if( file == NULL )
+	{
+		return false;
+	}
+	bool written = fwrite( document.data(), 1, document.size(), file ) == document.size();
+	return fclose( file ) == 0 && written;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file ChannelExporter.hpp
+ * @brief The export backends that write the channel configuration of each equipment.
+ */
+
+#ifndef A429_CHANNEL_EXPORTER_HPP
+#define A429_CHANNEL_EXPORTER_HPP
+
+#include <string>
+#include <cstddef>
+
+#include <Owl429/definitions>
+
+#include "ChannelConfig.hpp"
+#include "SpecStore.hpp"
+
+/**
+ * Writes the ChannelConfig of an equipment in one format into a buffer, and reads it back.
+ * A backend only formats: the configuration is resolved once, by ChannelConfig, for all of them.
+ *
+ * The config and buffer are kept from one equipment to the next, so an exporter that is
+ * reused, one per thread, stops allocating once it has written its largest document.
+ */
+class ChannelExporter
+{
+public:
+
+	/**
+	 * The backends
+	 */
+	enum Format
+	{
+		/**
+		 * The AIT_429 Xml that Xml429 saves, see ChannelXml
+		 */
+		FORMAT_XML,
+		/**
+		 * A length prefixed binary file that is read in place, see ChannelBinary
+		 */
+		FORMAT_BINARY,
+		/**
+		 * Compact JSON, see ChannelJson
+		 */
+		FORMAT_JSON,
+		FORMAT_COUNT
+	};
+
+	/**
+	 * Makes the exporter of a format. The caller deletes it
+	 * @param aSchemaFile the schema the Xml refers to
+	 */
+	static ChannelExporter* create( Format aFormat, const std::string& aSchemaFile );
+
+	/**
+	 * @returns the name of a format, as formatOf takes it
+	 */
+	static const char* formatName( Format aFormat );
+
+	/**
+	 * Looks up a format by name: "xml", "binary" or "json"
+	 * @returns false if there is no such format
+	 */
+	static bool formatOf( const std::string& aName, Format& aFormat );
+
+	virtual ~ChannelExporter();
+
+	/**
+	 * Resolves the configuration of an equipment and writes it into buffer(), replacing the last one
+	 * @param aChannel the channel number, as given to Xml429::save
+	 * @param aErrors where to append the errors
+	 */
+	void write( const SpecStore::EquipmentView& aEquipment, OwUInt32 aChannel, std::string& aErrors );
+
+	/**
+	 * @returns the last document written
+	 */
+	const std::string& buffer() const
+	{
+		return document;
+	}
+
+	/**
+	 * @returns the configuration of the last document written
+	 */
+	const ChannelConfig& config() const
+	{
+		return resolved;
+	}
+
+	/**
+	 * Saves the last document written to aFileName with extension() added
+	 * @returns false if the file couldn't be written
+	 */
+	bool save( const std::string& aFileName ) const;
+
+	/**
+	 * @returns what is added to the file names, such as ".xml"
+	 */
+	virtual const char* extension() const = 0;
+
+	/**
+	 * Reads a document of this format
+	 * @param aConfig cleared, then filled in
+	 * @param aError set to what couldn't be read, if anything
+	 * @returns false if it couldn't be read
+	 */
+	virtual bool read( const char* aData, size_t aLength, ChannelConfig& aConfig, std::string& aError ) const = 0;
+
+protected:
+
+	ChannelExporter();
+
+	/**
+	 * Formats a configuration
+	 * @param aDocument empty, and to be filled in
+	 */
+	virtual void format( const ChannelConfig& aConfig, std::string& aDocument ) const = 0;
+
+private:
+
+	ChannelExporter( const ChannelExporter& );
+	ChannelExporter& operator=( const ChannelExporter& );
+
+	ChannelConfig resolved;
+	std::string document;
+};
+
+#endif
@@ -0,0 +1,199 @@
+/**
+ * @file ChannelJson.cpp
+ * @brief A compact JSON channel configuration.
+ */
+
+#include "ChannelJson.hpp"
+
+#include <sstream>
+
+#include "JsonReader.hpp"
+#include "JsonWriter.hpp"
+
+const char* const ChannelJson::JSON_EXTENSION = ".json";
+
+namespace
+{
+	/**
+	 * A transfer or buffer as it is read
+	 */
+	typedef struct Entry
+	{
+		double label;
+		std::string name;
+		bool hasLabel;
+		bool hasName;
+		bool isPeriod;
+		bool hasRate;
+		double rate;
+	} Entry;
+
+	/**
+	 * Reads an array of transfers or buffers, after its BEGIN_ARRAY
+	 * @param aTransfers whether they are transfers, which have a period or rate
+	 */
+	bool readEntries( JsonReader& aReader, ChannelConfig& aConfig, bool aTransfers, std::string& aError )
+	{
+		Entry entry;
+		while( true )
+		{
+			JsonReader::Token token = aReader.next();
+			if( token == JsonReader::END_ARRAY )
+			{
+				return true;
+			}
+			if( token != JsonReader::BEGIN_OBJECT )
+			{
+				aError = token == JsonReader::FAILED ? aReader.error() : "a transfer or buffer that isn't an object";
+				return false;
+			}
+			entry.hasLabel = false;
+			entry.hasName = false;
+			entry.hasRate = false;
+			entry.isPeriod = false;
+			for( token = aReader.next(); token == JsonReader::KEY; token = aReader.next() )
+			{
+				std::string key = aReader.text();
+				JsonReader::Token value = aReader.next();
+				if( key == "label" && value == JsonReader::NUMBER )
+				{
+					entry.label = aReader.number();
+					entry.hasLabel = true;
+				}
+				else if( key == "name" && value == JsonReader::STRING )
+				{
+					entry.name = aReader.text();
+					entry.hasName = true;
+				}
+				else if( (key == "period" || key == "rate") && value == JsonReader::NUMBER )
+				{
+					entry.rate = aReader.number();
+					entry.isPeriod = key == "period";
+					entry.hasRate = true;
+				}
+				else if( !aReader.skip( value ) )
+				{
+					aError = aReader.error().empty() ? "the text ends early" : aReader.error();
+					return false;
+				}
+			}
+			if( token != JsonReader::END_OBJECT )
+			{
+				aError = token == JsonReader::FAILED ? aReader.error() : "a transfer or buffer that isn't closed";
+				return false;
+			}
+			if( !entry.hasLabel || entry.label < 0 || entry.label > 255 || !entry.hasName || (aTransfers && !entry.hasRate) )
+			{
+				aError = aTransfers ? "a transfer without a label, name and period or rate" : "a buffer without a label and name";
+				return false;
+			}
+			if( aTransfers )
+			{
+				aConfig.addTransfer( (OwUInt8)entry.label, entry.name.data(), entry.name.size(), entry.isPeriod, entry.rate );
+			}
+			else
+			{
+				aConfig.addBuffer( (OwUInt8)entry.label, entry.name.data(), entry.name.size() );
+			}
+		}
+	}
+}
+
+ChannelJson::ChannelJson()
+{
+}
+
+const char* ChannelJson::extension() const
+{
+	return JSON_EXTENSION;
+}
+
+void ChannelJson::format( const ChannelConfig& aConfig, std::string& aDocument ) const
+{
+	std::ostringstream stream;
+	JsonWriter json( stream, false );
+	json.beginObject();
+	json.key( "channel" ).value( aConfig.channel() );
+	json.key( "name" ).value( aConfig.name() );
+	json.key( "transfers" ).beginArray();
+	for( size_t i = 0; i < aConfig.transferCount(); ++i )
+	{
+		const ChannelConfig::Transfer& transfer = aConfig.transfer( i );
+		json.beginObject();
+		json.key( "label" ).value( (OwUInt32)transfer.label );
+		json.key( "name" ).value( std::string( aConfig.nameAt( transfer.nameOffset ), transfer.nameLength ) );
+		if( transfer.isPeriod )
+		{
+			json.key( "period" ).value( (OwUInt32)transfer.rate );
+		}
+		else
+		{
+			json.key( "rate" ).value( transfer.rate );
+		}
+		json.endObject();
+	}
+	json.endArray();
+	json.key( "buffers" ).beginArray();
+	for( size_t i = 0; i < aConfig.bufferCount(); ++i )
+	{
+		const ChannelConfig::Buffer& buffer = aConfig.buffer( i );
+		json.beginObject();
+		json.key( "label" ).value( (OwUInt32)buffer.label );
+		json.key( "name" ).value( std::string( aConfig.nameAt( buffer.nameOffset ), buffer.nameLength ) );
+		json.endObject();
+	}
+	json.endArray();
+	json.endObject();
+	aDocument = stream.str();
+}
+
+bool ChannelJson::read( const char* aData, size_t aLength, ChannelConfig& aConfig, std::string& aError ) const
+{
+	aConfig.clear();
+	JsonReader reader( aData, aLength );
+	if( reader.next() != JsonReader::BEGIN_OBJECT )
+	{
+		aError = "the document isn't an object";
+		return false;
+	}
+	double channel = -1;
+	std::string name;
+	JsonReader::Token token;
+	for( token = reader.next(); token == JsonReader::KEY; token = reader.next() )
+	{
+		std::string key = reader.text();
+		JsonReader::Token value = reader.next();
+		if( key == "channel" && value == JsonReader::NUMBER )
+		{
+			channel = reader.number();
+		}
+		else if( key == "name" && value == JsonReader::STRING )
+		{
+			name = reader.text();
+		}
+		else if( (key == "transfers" || key == "buffers") && value == JsonReader::BEGIN_ARRAY )
+		{
+			if( !readEntries( reader, aConfig, key == "transfers", aError ) )
+			{
+				return false;
+			}
+		}
+		else if( !reader.skip( value ) )
+		{
+			aError = reader.error().empty() ? "the text ends early" : reader.error();
+			return false;
+		}
+	}
+	if( token != JsonReader::END_OBJECT )
+	{
+		aError = token == JsonReader::FAILED ? reader.error() : "the document isn't closed";
+		return false;
+	}
+	if( channel < 0 )
+	{
+		aError = "there is no channel";
+		return false;
+	}
+	aConfig.setChannel( (OwUInt32)channel, name.data(), name.size() );
+	return true;
+}
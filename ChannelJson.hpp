@@ -0,0 +1,43 @@
+/**
+ * @file ChannelJson.hpp
+ * @brief A compact JSON channel configuration.
+ */
+
+#ifndef A429_CHANNEL_JSON_HPP
+#define A429_CHANNEL_JSON_HPP
+
+#include <string>
+#include <cstddef>
+
+#include "ChannelExporter.hpp"
+
+/**
+ * Writes the channel configuration of an equipment as JSON without whitespace:
+ *
+ *  {"channel":1,"name":"equipment type",
+ *   "transfers":[{"label":8,"name":"transfer name","period":100} | {...,"rate":12.5},...],
+ *   "buffers":[{"label":8,"name":"transfer name"},...]}
+ *
+ * Labels are decimal codes, periods whole ms and rates Hz, as in the Xml.
+ */
+class ChannelJson : public ChannelExporter
+{
+public:
+
+	/**
+	 * What is added to the file names
+	 */
+	static const char* const JSON_EXTENSION;
+
+	ChannelJson();
+
+	const char* extension() const;
+
+	bool read( const char* aData, size_t aLength, ChannelConfig& aConfig, std::string& aError ) const;
+
+protected:
+
+	void format( const ChannelConfig& aConfig, std::string& aDocument ) const;
+};
+
+#endif
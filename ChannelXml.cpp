@@ -0,0 +1,193 @@
+/**
+ * @file ChannelXml.cpp
+ * @brief Streams the Xml channel configuration of an equipment, without building Owl429 objects.
+ */
+
+#include "ChannelXml.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "XmlReader.hpp"
+#include "XmlStreamWriter.hpp"
+
+const char* const ChannelXml::XML_EXTENSION = ".xml";
+
+//The AIT_429 layout of a rate oriented channel configuration, as written by hand. It is not
+//checked against the schema yet, see ChannelXml. Kept together so it can be fixed in one place:
+//
+//  <AIT_429 xsi:noNamespaceSchemaLocation="schema">
+//    <TxRateOrientedChannel channel="1" name="equipment type">
+//      <TxScheduledLabel label="decimal code" name="transfer name" transferPeriod="ms" | transferRate="Hz"/>
+//      ...
+//      <RxChronMon>
+//        <LabelBuffer label="decimal code" name="transfer name" size="1"/>
+//        ...
+//      </RxChronMon>
+//    </TxRateOrientedChannel>
+//  </AIT_429>
+namespace
+{
+	const char* const ROOT_ELEMENT = "AIT_429";
+	const char* const CHANNEL_ELEMENT = "TxRateOrientedChannel";
+	const char* const TRANSFER_ELEMENT = "TxScheduledLabel";
+	const char* const MONITOR_ELEMENT = "RxChronMon";
+	const char* const BUFFER_ELEMENT = "LabelBuffer";
+	const char* const SCHEMA_NAMESPACE = "http://www.w3.org/2001/XMLSchema-instance";
+
+	/**
+	 * Reads a whole number attribute
+	 * @returns false if it is missing or isn't a number
+	 */
+	bool readNumber( const XmlReader& aReader, const char* aName, OwUInt32& aValue, std::string& aError )
+	{
+		const std::string* value = aReader.attribute( aName );
+		char* end = NULL;
+		if( value != NULL )
+		{
+			aValue = strtoul( value->c_str(), &end, 10 );
+		}
+		if( value == NULL || value->empty() || *end != '\0' )
+		{
+			aError = "<" + aReader.name() + "> has no " + aName;
+			return false;
+		}
+		return true;
+	}
+}
+
+ChannelXml::ChannelXml( const std::string& aSchemaFile )
+	: schemaFile(aSchemaFile)
+{
+}
+
+const char* ChannelXml::extension() const
+{
+	return XML_EXTENSION;
+}
+
+void ChannelXml::format( const ChannelConfig& aConfig, std::string& aDocument ) const
+{
+	XmlStreamWriter xml( aDocument );
+	xml.declaration();
+	xml.startElement( ROOT_ELEMENT );
+	xml.attribute( "xmlns:xsi", SCHEMA_NAMESPACE, strlen( SCHEMA_NAMESPACE ) );
+	xml.attribute( "xsi:noNamespaceSchemaLocation", schemaFile );
+	xml.startElement( CHANNEL_ELEMENT );
+	xml.attribute( "channel", aConfig.channel() );
+	xml.attribute( "name", aConfig.name() );
+	for( size_t i = 0; i < aConfig.transferCount(); ++i )
+	{
+		const ChannelConfig::Transfer& transfer = aConfig.transfer( i );
+		xml.startElement( TRANSFER_ELEMENT );
+		xml.attribute( "label", (OwUInt32)transfer.label );
+		xml.attribute( "name", aConfig.nameAt( transfer.nameOffset ), transfer.nameLength );
+		if( transfer.isPeriod )
+		{
+			xml.attribute( "transferPeriod", (OwUInt32)transfer.rate );
+		}
+		else
+		{
+			xml.attribute( "transferRate", transfer.rate );
+		}
+		xml.endElement();
+	}
+	xml.startElement( MONITOR_ELEMENT );
+	for( size_t i = 0; i < aConfig.bufferCount(); ++i )
+	{
+		const ChannelConfig::Buffer& buffer = aConfig.buffer( i );
+		xml.startElement( BUFFER_ELEMENT );
+		xml.attribute( "label", (OwUInt32)buffer.label );
+		xml.attribute( "name", aConfig.nameAt( buffer.nameOffset ), buffer.nameLength );
+		xml.attribute( "size", (OwUInt32)ChannelConfig::LABEL_BUFFER_SIZE );
+		xml.endElement();
+	}
+	xml.endElement();
+	xml.endElement();
+	xml.endElement();
+}
+
+bool ChannelXml::read( const char* aData, size_t aLength, ChannelConfig& aConfig, std::string& aError ) const
+{
+	aConfig.clear();
+	XmlReader reader( aData, aLength, XmlReader::LATIN1 );
+	bool inChannel = false;
+	bool channelRead = false;
+	size_t depth = 0;
+	while( true )
+	{
+		XmlReader::Token token = reader.next();
+		if( token == XmlReader::FAILED )
+		{
+			aError = reader.error();
+			return false;
+		}
+		if( token == XmlReader::DONE )
+		{
+			break;
+		}
+		if( token == XmlReader::END )
+		{
+			--depth;
+			if( depth == 1 )
+			{
+				inChannel = false;
+			}
+			continue;
+		}
+		if( token != XmlReader::START )
+		{
+			continue;
+		}
+		++depth;
+
+		//Only the first channel is read, as only one is written
+		const std::string& element = reader.name();
+		if( depth == 2 && element == CHANNEL_ELEMENT && !channelRead )
+		{
+			OwUInt32 channel = 0;
+			const std::string* name = reader.attribute( "name" );
+			if( !readNumber( reader, "channel", channel, aError ) )
+			{
+				return false;
+			}
+			aConfig.setChannel( channel, name == NULL ? "" : name->data(), name == NULL ? 0 : name->size() );
+			inChannel = true;
+			channelRead = true;
+		}
+		else if( inChannel && depth == 3 && element == TRANSFER_ELEMENT )
+		{
+			OwUInt32 label = 0;
+			const std::string* name = reader.attribute( "name" );
+			const std::string* period = reader.attribute( "transferPeriod" );
+			const std::string* rate = reader.attribute( "transferRate" );
+			if( !readNumber( reader, "label", label, aError ) )
+			{
+				return false;
+			}
+			if( name == NULL || (period == NULL && rate == NULL) )
+			{
+				aError = "a <TxScheduledLabel> has no name or rate";
+				return false;
+			}
+			const std::string& value = period != NULL ? *period : *rate;
+			aConfig.addTransfer( (OwUInt8)label, name->data(), name->size(), period != NULL, strtod( value.c_str(), NULL ) );
+		}
+		else if( inChannel && depth == 4 && element == BUFFER_ELEMENT )
+		{
+			OwUInt32 label = 0;
+			const std::string* name = reader.attribute( "name" );
+			if( !readNumber( reader, "label", label, aError ) )
+			{
+				return false;
+			}
+			aConfig.addBuffer( (OwUInt8)label, name == NULL ? "" : name->data(), name == NULL ? 0 : name->size() );
+		}
+	}
+	if( !channelRead )
+	{
+		aError = std::string( "there is no <" ) + CHANNEL_ELEMENT + ">";
+		return false;
+	}
+	return true;
+}
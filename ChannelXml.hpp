@@ -0,0 +1,53 @@
+/**
+ * @file ChannelXml.hpp
+ * @brief Streams the Xml channel configuration of an equipment, without building Owl429 objects.
+ */
+
+#ifndef A429_CHANNEL_XML_HPP
+#define A429_CHANNEL_XML_HPP
+
+#include <string>
+
+#include <Owl429/definitions>
+
+#include "ChannelExporter.hpp"
+
+/**
+ * Writes an AIT_429 document for an equipment, meant to stand in for the one LoadedCSV::saveEquipment
+ * gets from Owl429Utils::Xml429, without building Owl429 objects or a DOM.
+ * The layout is written by hand. It hasn't been checked against the AIT_429 schema or a file saved by
+ * Xml429, and some of its names, such as RxChronMon and LabelBuffer, aren't among the strings of
+ * owl429utils.dll, which has chronMonitor, buffer and depth instead. Treat it as unverified until
+ * LoadedCSV::verifyXml passes with the SDK installed.
+ */
+class ChannelXml : public ChannelExporter
+{
+public:
+
+	/**
+	 * What Xml429 adds to the file names it is given
+	 */
+	static const char* const XML_EXTENSION;
+
+	/**
+	 * @param aSchemaFile the schema the documents refer to
+	 */
+	explicit ChannelXml( const std::string& aSchemaFile );
+
+	const char* extension() const;
+
+	/**
+	 * Reads a channel of an AIT_429 document, such as Xml429 saves
+	 */
+	bool read( const char* aData, size_t aLength, ChannelConfig& aConfig, std::string& aError ) const;
+
+protected:
+
+	void format( const ChannelConfig& aConfig, std::string& aDocument ) const;
+
+private:
+
+	std::string schemaFile;
+};
+
+#endif
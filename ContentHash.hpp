@@ -0,0 +1,76 @@
+/**
+ * @file ContentHash.hpp
+ * @brief A 64 bit FNV-1a hash for telling whether exported content changed.
+ */
+
+#ifndef A429_CONTENT_HASH_HPP
+#define A429_CONTENT_HASH_HPP
+
+#include <string>
+#include <cstddef>
+
+#include <Owl429/definitions>
+
+#include "StringPool.hpp"
+
+/**
+ * Hashes a sequence of values. Strings are hashed with their length, so
+ * ("ab", "c") and ("a", "bc") hash differently.
+ */
+class ContentHash
+{
+public:
+
+	ContentHash()
+		: hash(OFFSET_BASIS)
+	{
+	}
+
+	void add( const void* aData, size_t aSize )
+	{
+		const OwUInt8* bytes = (const OwUInt8*)aData;
+		for( size_t i = 0; i < aSize; ++i )
+		{
+			hash = (hash ^ bytes[i]) * PRIME;
+		}
+	}
+
+	void add( const std::string& aText )
+	{
+		add( (OwUInt32)aText.size() );
+		add( aText.data(), aText.size() );
+	}
+
+	void add( const PooledString& aText )
+	{
+		add( (OwUInt32)aText.size() );
+		add( aText.data(), aText.size() );
+	}
+
+	void add( OwUInt32 aValue )
+	{
+		add( &aValue, sizeof(aValue) );
+	}
+
+	void add( double aValue )
+	{
+		add( &aValue, sizeof(aValue) );
+	}
+
+	/**
+	 * @returns the hash of everything added so far
+	 */
+	OwUInt64 value() const
+	{
+		return hash;
+	}
+
+private:
+
+	static const OwUInt64 OFFSET_BASIS = 14695981039346656037ULL;
+	static const OwUInt64 PRIME = 1099511628211ULL;
+
+	OwUInt64 hash;
+};
+
+#endif
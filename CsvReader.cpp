@@ -0,0 +1,266 @@
+/**
+ * @file CsvReader.cpp
+ * @brief A single pass, zero copy reader for comma separated value files.
+ */
+
+#include "CsvReader.hpp"
+
+#include <cstring>
+#include <cstdlib>
+
+std::string CsvField::str() const
+{
+	if( !escaped )
+	{
+		return std::string( data, length );
+	}
+	std::string output;
+	output.reserve( length );
+	for( size_t i = 0; i < length; ++i )
+	{
+		output.push_back( data[i] );
+		if( data[i] == '\"' )	//Skip the second quotation mark of the pair
+		{
+			++i;
+		}
+	}
+	return output;
+}
+
+bool CsvField::equals( const char* aText ) const
+{
+	if( escaped )
+	{
+		return str() == aText;
+	}
+	return strncmp( data, aText, length ) == 0 && aText[length] == '\0';
+}
+
+bool CsvField::contains( const char* aText ) const
+{
+	size_t textLength = strlen( aText );
+	if( textLength > length )
+	{
+		return false;
+	}
+	for( size_t i = 0; i + textLength <= length; ++i )
+	{
+		if( memcmp( data + i, aText, textLength ) == 0 )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool CsvField::compact( char* aOutput, size_t aMaxLength ) const
+{
+	size_t o = 0;
+	for( size_t i = 0; i < length; ++i )
+	{
+		if( data[i] != ' ' )
+		{
+			if( o == aMaxLength )
+			{
+				aOutput[o] = '\0';
+				return false;
+			}
+			aOutput[o] = data[i];
+			++o;
+		}
+	}
+	aOutput[o] = '\0';
+	return true;
+}
+
+long CsvField::toLong( int aBase ) const
+{
+	char buffer[64];
+	size_t count = length < sizeof(buffer) - 1 ? length : sizeof(buffer) - 1;	//No number needs more than this
+	memcpy( buffer, data, count );
+	buffer[count] = '\0';
+	return strtol( buffer, NULL, aBase );
+}
+
+double CsvField::toDouble() const
+{
+	char buffer[64];
+	size_t count = length < sizeof(buffer) - 1 ? length : sizeof(buffer) - 1;
+	memcpy( buffer, data, count );
+	buffer[count] = '\0';
+	return strtod( buffer, NULL );
+}
+
+CsvReader::CsvReader( const char* aData, size_t aSize )
+	: cursor(aData)
+	, end(aData + aSize)
+	, line(1)
+	, currentRowLine(0)
+	, kernel(CsvScanner::bestKernel())
+	, chunkBegin(aData)
+	, chunkEnd(aData)
+	, nextIndex(0)
+{
+}
+
+CsvReader::CsvReader( const char* aData, size_t aSize, CsvScanner::Kernel aKernel )
+	: cursor(aData)
+	, end(aData + aSize)
+	, line(1)
+	, currentRowLine(0)
+	, kernel(aKernel)
+	, chunkBegin(aData)
+	, chunkEnd(aData)
+	, nextIndex(0)
+{
+}
+
+const char* CsvReader::nextStructural( const char* aFrom )
+{
+	while( true )
+	{
+		while( nextIndex < structurals.size() )
+		{
+			const char* structural = chunkBegin + structurals[nextIndex];
+			if( structural >= aFrom )
+			{
+				return structural;
+			}
+			++nextIndex;
+		}
+		if( chunkEnd >= end )
+		{
+			return end;
+		}
+
+		//Index the next chunk
+		chunkBegin = chunkEnd;
+		chunkEnd = (size_t)(end - chunkBegin) > CHUNK_SIZE ? chunkBegin + CHUNK_SIZE : end;
+		CsvScanner::index( chunkBegin, (size_t)(chunkEnd - chunkBegin), structurals, kernel );
+		nextIndex = 0;
+	}
+}
+
+bool CsvReader::nextRow( std::vector<CsvField>& aFields )
+{
+	aFields.clear();
+	if( cursor >= end )
+	{
+		return false;
+	}
+	currentRowLine = line;
+
+	const char* p = cursor;
+	while( true )
+	{
+		CsvField field;
+		field.escaped = false;
+
+		if( p < end && *p == '\"' )	//If the field is surrounded by quotation marks
+		{
+			++p;
+			field.data = p;
+			while( (p = nextStructural( p )) < end )	//Only quotation marks and newlines matter inside
+			{
+				if( *p == '\"' )
+				{
+					if( p + 1 < end && p[1] == '\"' )	//An escaped quotation mark
+					{
+						field.escaped = true;
+						p += 2;
+						continue;
+					}
+					break;	//The closing quotation mark
+				}
+				if( *p == '\n' )
+				{
+					++line;
+				}
+				++p;
+			}
+			field.length = (size_t)(p - field.data);
+			if( p < end )
+			{
+				++p;	//Step over the closing quotation mark
+			}
+			while( (p = nextStructural( p )) < end && *p == '\"' )	//Anything between the closing quotation mark and the delimiter isn't valid, so drop it
+			{
+				++p;
+			}
+		}
+		else	//If the field isn't surrounded by quotation marks
+		{
+			field.data = p;
+			while( (p = nextStructural( p )) < end && *p == '\"' )	//A quotation mark inside an unquoted field is just a char
+			{
+				++p;
+			}
+			field.length = (size_t)(p - field.data);
+		}
+		aFields.push_back( field );
+
+		if( p >= end )	//The last row doesn't need a line ending
+		{
+			break;
+		}
+		if( *p == ',' )
+		{
+			++p;
+			continue;
+		}
+		if( *p == '\r' )
+		{
+			++p;
+		}
+		if( p < end && *p == '\n' )
+		{
+			++p;
+		}
+		++line;
+		break;
+	}
+
+	cursor = p;
+	return true;
+}
+
+CsvField CsvReader::field( const std::vector<CsvField>& aFields, size_t aIndex )
+{
+	if( aIndex < aFields.size() )
+	{
+		return aFields[aIndex];
+	}
+	CsvField empty;
+	empty.data = "";
+	empty.length = 0;
+	empty.escaped = false;
+	return empty;
+}
+
+bool CsvReader::isBlank( const std::vector<CsvField>& aFields )
+{
+	for( size_t i = 0; i < aFields.size(); ++i )
+	{
+		if( !aFields[i].empty() )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CsvReader::matches( const std::vector<CsvField>& aFields, const char* const* aExpected, size_t aCount )
+{
+	if( aFields.size() != aCount )
+	{
+		return false;
+	}
+	for( size_t i = 0; i < aCount; ++i )
+	{
+		if( !aFields[i].equals( aExpected[i] ) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file CsvReader.hpp
+ * @brief A single pass, zero copy reader for comma separated value files.
+ */
+
+#ifndef A429_CSV_READER_HPP
+#define A429_CSV_READER_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "CsvScanner.hpp"
+
+/**
+ * A field of a csv file. It points into the buffer being read, so it is only
+ * valid while that buffer is. Nothing is copied until str() is called.
+ */
+typedef struct CsvField
+{
+	/**
+	 * @brief The first char of the field, after the opening quotation mark if it has one
+	 */
+	const char* data;
+	/**
+	 * @brief The number of chars in the field, not counting the surrounding quotation marks
+	 */
+	size_t length;
+	/**
+	 * @brief Denotes whether or not the field contains escaped ("") quotation marks
+	 */
+	bool escaped;
+
+	/**
+	 * @returns true if there is nothing in the field
+	 */
+	bool empty() const
+	{
+		return length == 0;
+	}
+
+	/**
+	 * @returns the first char of the field, or '\0' if it is empty
+	 */
+	char front() const
+	{
+		return length == 0 ? '\0' : data[0];
+	}
+
+	/**
+	 * Copies the field out, turning escaped quotation marks back into single ones
+	 */
+	std::string str() const;
+
+	/**
+	 * @returns true if the field is exactly aText
+	 */
+	bool equals( const char* aText ) const;
+
+	/**
+	 * @returns true if aText appears anywhere in the field
+	 */
+	bool contains( const char* aText ) const;
+
+	/**
+	 * Copies the field with all the spaces removed
+	 * @param aOutput where to store the null terminated result
+	 * @param aMaxLength the most chars aOutput can take, not counting the terminator
+	 * @returns false if there were more than aMaxLength chars that weren't spaces
+	 */
+	bool compact( char* aOutput, size_t aMaxLength ) const;
+
+	/**
+	 * Parses the field the same way as strtol
+	 */
+	long toLong( int aBase ) const;
+
+	/**
+	 * Parses the field the same way as strtod
+	 */
+	double toDouble() const;
+} CsvField;
+
+/**
+ * Splits a buffer into rows and fields following RFC 4180. Quoted fields may
+ * contain commas, newlines and escaped quotation marks, and there is no limit
+ * on the length of a row. Both "\n" and "\r\n" line endings are accepted.
+ * The buffer is indexed a chunk at a time with CsvScanner, and only the
+ * structural characters in the index are looked at.
+ */
+class CsvReader
+{
+public:
+
+	/**
+	 * @param aData the buffer to read. It is not copied, so it must outlive the reader
+	 * @param aSize the size of the buffer in bytes
+	 */
+	CsvReader( const char* aData, size_t aSize );
+
+	/**
+	 * @param aData the buffer to read. It is not copied, so it must outlive the reader
+	 * @param aSize the size of the buffer in bytes
+	 * @param aKernel the scanner implementation to index the buffer with
+	 */
+	CsvReader( const char* aData, size_t aSize, CsvScanner::Kernel aKernel );
+
+	/**
+	 * Reads the next row
+	 * @param aFields cleared, then filled with the fields of the row
+	 * @returns false once there are no rows left
+	 */
+	bool nextRow( std::vector<CsvField>& aFields );
+
+	/**
+	 * @returns the line number, starting at 1, on which the last row read began
+	 */
+	size_t rowLine() const
+	{
+		return currentRowLine;
+	}
+
+	/**
+	 * Returns a field of a row, or an empty field if the row is too short
+	 */
+	static CsvField field( const std::vector<CsvField>& aFields, size_t aIndex );
+
+	/**
+	 * @returns true if every field of the row is empty
+	 */
+	static bool isBlank( const std::vector<CsvField>& aFields );
+
+	/**
+	 * @returns true if the row is exactly the aCount fields given
+	 */
+	static bool matches( const std::vector<CsvField>& aFields, const char* const* aExpected, size_t aCount );
+
+private:
+
+	/**
+	 * The number of bytes indexed at a time, small enough for the index to stay in cache
+	 */
+	enum { CHUNK_SIZE = 64 * 1024 };
+
+	/**
+	 * @returns the first structural character at or after aFrom, or end if there is none
+	 */
+	const char* nextStructural( const char* aFrom );
+
+	/**
+	 * @brief The next char to read
+	 */
+	const char* cursor;
+	/**
+	 * @brief One past the last char of the buffer
+	 */
+	const char* end;
+	/**
+	 * @brief The line the cursor is on
+	 */
+	size_t line;
+	/**
+	 * @brief The line the last row read began on
+	 */
+	size_t currentRowLine;
+	/**
+	 * @brief The scanner implementation used to index the buffer
+	 */
+	CsvScanner::Kernel kernel;
+	/**
+	 * @brief The chunk of the buffer that is indexed
+	 */
+	const char* chunkBegin;
+	const char* chunkEnd;
+	/**
+	 * @brief The offsets from chunkBegin of the structural characters in the chunk
+	 */
+	std::vector<OwUInt32> structurals;
+	/**
+	 * @brief The first entry of structurals that hasn't been passed yet
+	 */
+	size_t nextIndex;
+};
+
+#endif
@@ -0,0 +1,219 @@
+/**
+ * @file CsvScanner.cpp
+ * @brief Vectorized search for the structural characters of a comma separated value file.
+ */
+
+#include "CsvScanner.hpp"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define A429_SCANNER_X86
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#if _MSC_VER >= 1700	//Visual Studio 2012 is the first to have the AVX2 intrinsics
+#define A429_SCANNER_AVX2
+#include <immintrin.h>
+#endif
+#define A429_TARGET_SSE2
+#define A429_TARGET_AVX2
+#elif defined(__GNUC__)
+#define A429_SCANNER_AVX2
+#include <immintrin.h>
+#define A429_TARGET_SSE2 __attribute__((target("sse2")))
+#define A429_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+/**
+ * Appends the offset of every set bit of aMask, lowest first
+ */
+static inline void appendBits( OwUInt32 aMask, OwUInt32 aBase, std::vector<OwUInt32>& aPositions )
+{
+	while( aMask != 0 )
+	{
+#if defined(_MSC_VER)
+		unsigned long bit;
+		_BitScanForward( &bit, aMask );
+#else
+		unsigned int bit = (unsigned int)__builtin_ctz( aMask );
+#endif
+		aPositions.push_back( aBase + (OwUInt32)bit );
+		aMask &= aMask - 1;	//Clear the lowest set bit
+	}
+}
+
+/**
+ * Scans aData[aBegin, aEnd) one char at a time
+ */
+static void indexScalar( const char* aData, size_t aBegin, size_t aEnd, std::vector<OwUInt32>& aPositions )
+{
+	for( size_t i = aBegin; i < aEnd; ++i )
+	{
+		if( CsvScanner::isStructural( aData[i] ) )
+		{
+			aPositions.push_back( (OwUInt32)i );
+		}
+	}
+}
+
+#ifdef A429_SCANNER_X86
+
+/**
+ * Scans 16 chars at a time, and returns where it stopped
+ */
+A429_TARGET_SSE2 static size_t indexSse2( const char* aData, size_t aSize, std::vector<OwUInt32>& aPositions )
+{
+	const __m128i comma = _mm_set1_epi8( ',' );
+	const __m128i quote = _mm_set1_epi8( '\"' );
+	const __m128i newline = _mm_set1_epi8( '\n' );
+	const __m128i carriageReturn = _mm_set1_epi8( '\r' );
+	size_t i = 0;
+	for( ; i + 16 <= aSize; i += 16 )
+	{
+		__m128i block = _mm_loadu_si128( (const __m128i*)(aData + i) );
+		__m128i hits = _mm_or_si128(
+			_mm_or_si128( _mm_cmpeq_epi8( block, comma ), _mm_cmpeq_epi8( block, quote ) ),
+			_mm_or_si128( _mm_cmpeq_epi8( block, newline ), _mm_cmpeq_epi8( block, carriageReturn ) ) );
+		appendBits( (OwUInt32)_mm_movemask_epi8( hits ), (OwUInt32)i, aPositions );
+	}
+	return i;
+}
+
+#ifdef A429_SCANNER_AVX2
+
+/**
+ * Scans 32 chars at a time, and returns where it stopped
+ */
+A429_TARGET_AVX2 static size_t indexAvx2( const char* aData, size_t aSize, std::vector<OwUInt32>& aPositions )
+{
+	const __m256i comma = _mm256_set1_epi8( ',' );
+	const __m256i quote = _mm256_set1_epi8( '\"' );
+	const __m256i newline = _mm256_set1_epi8( '\n' );
+	const __m256i carriageReturn = _mm256_set1_epi8( '\r' );
+	size_t i = 0;
+	for( ; i + 32 <= aSize; i += 32 )
+	{
+		__m256i block = _mm256_loadu_si256( (const __m256i*)(aData + i) );
+		__m256i hits = _mm256_or_si256(
+			_mm256_or_si256( _mm256_cmpeq_epi8( block, comma ), _mm256_cmpeq_epi8( block, quote ) ),
+			_mm256_or_si256( _mm256_cmpeq_epi8( block, newline ), _mm256_cmpeq_epi8( block, carriageReturn ) ) );
+		appendBits( (OwUInt32)_mm256_movemask_epi8( hits ), (OwUInt32)i, aPositions );
+	}
+	return i;
+}
+
+#endif
+
+/**
+ * Checks the CPU for the given kernel
+ */
+static bool detect( CsvScanner::Kernel aKernel )
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid( info, 0 );
+	int maxLeaf = info[0];
+	__cpuid( info, 1 );
+	if( aKernel == CsvScanner::SSE2 )
+	{
+		return (info[3] & (1 << 26)) != 0;
+	}
+#ifdef A429_SCANNER_AVX2
+	bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv( 0 ) & 6) == 6;	//OSXSAVE, and the OS saves the XMM and YMM state
+	if( !osSavesYmm || maxLeaf < 7 )
+	{
+		return false;
+	}
+	__cpuidex( info, 7, 0 );
+	return (info[1] & (1 << 5)) != 0;
+#else
+	(void)maxLeaf;
+	return false;
+#endif
+#else
+	__builtin_cpu_init();
+	if( aKernel == CsvScanner::SSE2 )
+	{
+		return __builtin_cpu_supports( "sse2" ) != 0;
+	}
+	return __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+}
+
+#endif
+
+bool CsvScanner::isSupported( Kernel aKernel )
+{
+	switch( aKernel )
+	{
+	case SCALAR:
+		return true;
+#ifdef A429_SCANNER_X86
+	case SSE2:
+	{
+		static const bool supported = detect( SSE2 );
+		return supported;
+	}
+#ifdef A429_SCANNER_AVX2
+	case AVX2:
+	{
+		static const bool supported = detect( AVX2 );
+		return supported;
+	}
+#endif
+#endif
+	default:
+		return false;
+	}
+}
+
+CsvScanner::Kernel CsvScanner::bestKernel()
+{
+	if( isSupported( AVX2 ) )
+	{
+		return AVX2;
+	}
+	if( isSupported( SSE2 ) )
+	{
+		return SSE2;
+	}
+	return SCALAR;
+}
+
+const char* CsvScanner::kernelName( Kernel aKernel )
+{
+	switch( aKernel )
+	{
+	case SSE2:
+		return "sse2";
+	case AVX2:
+		return "avx2";
+	default:
+		return "scalar";
+	}
+}
+
+void CsvScanner::index( const char* aData, size_t aSize, std::vector<OwUInt32>& aPositions, Kernel aKernel )
+{
+	aPositions.clear();
+	size_t done = 0;
+	if( isSupported( aKernel ) )
+	{
+		switch( aKernel )
+		{
+#ifdef A429_SCANNER_X86
+		case SSE2:
+			done = indexSse2( aData, aSize, aPositions );
+			break;
+#ifdef A429_SCANNER_AVX2
+		case AVX2:
+			done = indexAvx2( aData, aSize, aPositions );
+			break;
+#endif
+#endif
+		default:
+			break;
+		}
+	}
+	indexScalar( aData, done, aSize, aPositions );	//Whatever is left over
+}
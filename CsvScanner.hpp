@@ -0,0 +1,76 @@
+/**
+ * @file CsvScanner.hpp
+ * @brief Vectorized search for the structural characters of a comma separated value file.
+ */
+
+#ifndef A429_CSV_SCANNER_HPP
+#define A429_CSV_SCANNER_HPP
+
+#include <vector>
+#include <cstddef>
+
+#include <Owl429/definitions>
+
+/**
+ * Finds every comma, quotation mark, carriage return and newline in a buffer.
+ * CsvReader walks the resulting index instead of testing every char itself.
+ * Each kernel produces exactly the same index; the fastest one the CPU supports
+ * is picked at runtime.
+ */
+class CsvScanner
+{
+public:
+
+	/**
+	 * The implementations of the scan
+	 */
+	enum Kernel
+	{
+		/**
+		 * @brief One char at a time, on any CPU
+		 */
+		SCALAR,
+		/**
+		 * @brief 16 chars at a time
+		 */
+		SSE2,
+		/**
+		 * @brief 32 chars at a time
+		 */
+		AVX2
+	};
+
+	/**
+	 * @returns the fastest kernel both this build and the CPU support
+	 */
+	static Kernel bestKernel();
+
+	/**
+	 * @returns true if this build and the CPU support the given kernel
+	 */
+	static bool isSupported( Kernel aKernel );
+
+	/**
+	 * @returns the name of the kernel, for reports
+	 */
+	static const char* kernelName( Kernel aKernel );
+
+	/**
+	 * Indexes the structural characters of a buffer
+	 * @param aData the buffer to scan
+	 * @param aSize the size of the buffer in bytes. Must be less than 4 GiB
+	 * @param aPositions cleared, then filled with the offsets of the structural characters in increasing order
+	 * @param aKernel the implementation to use. Falls back to SCALAR if it is not supported
+	 */
+	static void index( const char* aData, size_t aSize, std::vector<OwUInt32>& aPositions, Kernel aKernel );
+
+	/**
+	 * @returns true if the char is a comma, quotation mark, carriage return or newline
+	 */
+	static bool isStructural( char aChar )
+	{
+		return aChar == ',' || aChar == '\"' || aChar == '\n' || aChar == '\r';
+	}
+};
+
+#endif
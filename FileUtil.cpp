@@ -0,0 +1,117 @@
+/**
+ * @file FileUtil.cpp
+ * @brief Portable path and directory helpers.
+ */
+
+#include "FileUtil.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+std::string FileUtil::joinPath( const std::string& aDirectory, const std::string& aName )
+{
+	if( aDirectory.empty() )
+	{
+		return aName;
+	}
+	char last = aDirectory[aDirectory.size() - 1];
+	if( last == '/' || last == '\\' )
+	{
+		return aDirectory + aName;
+	}
+	return aDirectory + "/" + aName;
+}
+
+bool FileUtil::isDirectory( const std::string& aPath )
+{
+#ifdef _WIN32
+	struct _stat status;
+	return _stat( aPath.c_str(), &status ) == 0 && (status.st_mode & _S_IFDIR) != 0;
+#else
+	struct stat status;
+	return stat( aPath.c_str(), &status ) == 0 && S_ISDIR( status.st_mode );
+#endif
+}
+
+bool FileUtil::makeDirectory( const std::string& aDirectory )
+{
+	if( aDirectory.empty() || isDirectory( aDirectory ) )
+	{
+		return true;
+	}
+
+	//Make the parent first, unless it is a root such as "/" or "C:"
+	size_t separator = aDirectory.find_last_of( "/\\" );
+	if( separator != std::string::npos && separator > 0 )
+	{
+		std::string parent = aDirectory.substr( 0, separator );
+		if( parent[parent.size() - 1] != ':' && !makeDirectory( parent ) )
+		{
+			return false;
+		}
+	}
+
+#ifdef _WIN32
+	_mkdir( aDirectory.c_str() );
+#else
+	mkdir( aDirectory.c_str(), 0777 );
+#endif
+	return isDirectory( aDirectory );	//Another process may have made it first
+}
+
+bool FileUtil::listDirectory( const std::string& aDirectory, std::vector<std::string>& aNames )
+{
+	aNames.clear();
+#ifdef _WIN32
+	WIN32_FIND_DATAA found;
+	HANDLE search = FindFirstFileA( joinPath( aDirectory.empty() ? "." : aDirectory, "*" ).c_str(), &found );
+	if( search == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+	do
+	{
+		std::string name( found.cFileName );
+		if( name != "." && name != ".." )
+		{
+			aNames.push_back( name );
+		}
+	} while( FindNextFileA( search, &found ) );
+	FindClose( search );
+#else
+	DIR* directory = opendir( aDirectory.empty() ? "." : aDirectory.c_str() );
+	if( directory == NULL )
+	{
+		return false;
+	}
+	for( struct dirent* entry = readdir( directory ); entry != NULL; entry = readdir( directory ) )
+	{
+		std::string name( entry->d_name );
+		if( name != "." && name != ".." )
+		{
+			aNames.push_back( name );
+		}
+	}
+	closedir( directory );
+#endif
+	std::sort( aNames.begin(), aNames.end() );
+	return true;
+}
+
+bool FileUtil::replaceFile( const std::string& aSource, const std::string& aTarget )
+{
+#ifdef _WIN32
+	return MoveFileExA( aSource.c_str(), aTarget.c_str(), MOVEFILE_REPLACE_EXISTING ) != 0;	//rename() won't replace a file on Windows
+#else
+	return rename( aSource.c_str(), aTarget.c_str() ) == 0;
+#endif
+}
@@ -0,0 +1,50 @@
+/**
+ * @file FileUtil.hpp
+ * @brief Portable path and directory helpers.
+ */
+
+#ifndef A429_FILE_UTIL_HPP
+#define A429_FILE_UTIL_HPP
+
+#include <string>
+#include <vector>
+
+/**
+ * The few file system operations the converter needs, for Windows and POSIX
+ */
+class FileUtil
+{
+public:
+
+	/**
+	 * Joins a directory and a name with a '/', which Windows accepts too
+	 * @returns aName if aDirectory is empty
+	 */
+	static std::string joinPath( const std::string& aDirectory, const std::string& aName );
+
+	/**
+	 * Creates a directory, and any missing parents
+	 * @returns true if the directory exists afterwards
+	 */
+	static bool makeDirectory( const std::string& aDirectory );
+
+	/**
+	 * @returns true if the path names an existing directory
+	 */
+	static bool isDirectory( const std::string& aPath );
+
+	/**
+	 * Lists the names in a directory, without "." and "..", sorted so the order doesn't depend on the platform
+	 * @param aNames cleared, then filled with the names
+	 * @returns false if the directory couldn't be read
+	 */
+	static bool listDirectory( const std::string& aDirectory, std::vector<std::string>& aNames );
+
+	/**
+	 * Renames a file over another, replacing it if it exists
+	 * @returns false if the file couldn't be renamed, in which case aTarget is left as it was
+	 */
+	static bool replaceFile( const std::string& aSource, const std::string& aTarget );
+};
+
+#endif
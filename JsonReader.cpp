@@ -0,0 +1,241 @@
+/**
+ * @file JsonReader.cpp
+ * @brief Reads JSON a token at a time.
+ */
+
+#include "JsonReader.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	bool isSpace( char aChar )
+	{
+		return aChar == ' ' || aChar == '\t' || aChar == '\n' || aChar == '\r';
+	}
+
+	/**
+	 * Reads 4 hex digits
+	 * @returns false if they aren't
+	 */
+	bool readHex( const char* aText, unsigned long& aValue )
+	{
+		aValue = 0;
+		for( int i = 0; i < 4; ++i )
+		{
+			char c = aText[i];
+			int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+			if( digit < 0 )
+			{
+				return false;
+			}
+			aValue = (aValue << 4) | digit;
+		}
+		return true;
+	}
+
+	/**
+	 * Appends a character as Latin-1 if it is one, otherwise as UTF-8
+	 */
+	void appendCharacter( std::string& aText, unsigned long aCodePoint )
+	{
+		if( aCodePoint < 0x100 )
+		{
+			aText.push_back( (char)aCodePoint );
+		}
+		else if( aCodePoint < 0x800 )
+		{
+			aText.push_back( (char)(0xC0 | (aCodePoint >> 6)) );
+			aText.push_back( (char)(0x80 | (aCodePoint & 0x3F)) );
+		}
+		else if( aCodePoint < 0x10000 )
+		{
+			aText.push_back( (char)(0xE0 | (aCodePoint >> 12)) );
+			aText.push_back( (char)(0x80 | ((aCodePoint >> 6) & 0x3F)) );
+			aText.push_back( (char)(0x80 | (aCodePoint & 0x3F)) );
+		}
+		else
+		{
+			aText.push_back( (char)(0xF0 | (aCodePoint >> 18)) );
+			aText.push_back( (char)(0x80 | ((aCodePoint >> 12) & 0x3F)) );
+			aText.push_back( (char)(0x80 | ((aCodePoint >> 6) & 0x3F)) );
+			aText.push_back( (char)(0x80 | (aCodePoint & 0x3F)) );
+		}
+	}
+}
+
+JsonReader::JsonReader( const char* aText, size_t aLength )
+	: document(aText)
+	, length(aLength)
+	, position(0)
+	, numberValue(0)
+{
+}
+
+JsonReader::Token JsonReader::fail( const std::string& aError )
+{
+	errorText = aError;
+	position = length;
+	return FAILED;
+}
+
+bool JsonReader::readString()
+{
+	textValue.clear();
+	size_t i = position + 1;
+	while( i < length )
+	{
+		//Copy up to the next quote or escape in one go
+		size_t run = i;
+		while( run < length && document[run] != '"' && document[run] != '\\' )
+		{
+			++run;
+		}
+		textValue.append( document + i, run - i );
+		i = run;
+		if( i >= length )
+		{
+			break;
+		}
+		if( document[i] == '"' )
+		{
+			position = i + 1;
+			return true;
+		}
+		if( i + 1 >= length )
+		{
+			break;
+		}
+		char escape = document[i + 1];
+		i += 2;
+		switch( escape )
+		{
+		case '"':	textValue.push_back( '"' ); break;
+		case '\\':	textValue.push_back( '\\' ); break;
+		case '/':	textValue.push_back( '/' ); break;
+		case 'b':	textValue.push_back( '\b' ); break;
+		case 'f':	textValue.push_back( '\f' ); break;
+		case 'n':	textValue.push_back( '\n' ); break;
+		case 'r':	textValue.push_back( '\r' ); break;
+		case 't':	textValue.push_back( '\t' ); break;
+		case 'u':
+			{
+				unsigned long codePoint = 0;
+				if( length - i < 4 || !readHex( document + i, codePoint ) )
+				{
+					return false;
+				}
+				i += 4;
+				//A surrogate pair
+				unsigned long low = 0;
+				if( codePoint >= 0xD800 && codePoint < 0xDC00 && length - i >= 6 && document[i] == '\\' && document[i + 1] == 'u'
+					&& readHex( document + i + 2, low ) && low >= 0xDC00 && low < 0xE000 )
+				{
+					codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+					i += 6;
+				}
+				appendCharacter( textValue, codePoint );
+			}
+			break;
+		default:
+			return false;
+		}
+	}
+	return false;
+}
+
+JsonReader::Token JsonReader::next()
+{
+	while( position < length && (isSpace( document[position] ) || document[position] == ',' || document[position] == ':') )
+	{
+		++position;
+	}
+	if( position >= length )
+	{
+		return DONE;
+	}
+
+	char c = document[position];
+	switch( c )
+	{
+	case '{':	++position; return BEGIN_OBJECT;
+	case '}':	++position; return END_OBJECT;
+	case '[':	++position; return BEGIN_ARRAY;
+	case ']':	++position; return END_ARRAY;
+	case '"':
+		{
+			if( !readString() )
+			{
+				return fail( "an unterminated or badly escaped string" );
+			}
+			//A string followed by a colon is a key
+			size_t i = position;
+			while( i < length && isSpace( document[i] ) )
+			{
+				++i;
+			}
+			return i < length && document[i] == ':' ? KEY : STRING;
+		}
+	default:
+		break;
+	}
+
+	static const char* const words[] = { "true", "false", "null" };
+	static const Token wordTokens[] = { TRUE_VALUE, FALSE_VALUE, NULL_VALUE };
+	for( int i = 0; i < 3; ++i )
+	{
+		size_t wordLength = strlen( words[i] );
+		if( length - position >= wordLength && memcmp( document + position, words[i], wordLength ) == 0 )
+		{
+			position += wordLength;
+			return wordTokens[i];
+		}
+	}
+
+	if( c == '-' || (c >= '0' && c <= '9') )
+	{
+		//Copy it out, as the text needn't be null terminated
+		char number[64];
+		size_t numberLength = 0;
+		while( position < length && numberLength < sizeof(number) - 1 && strchr( "+-.eE0123456789", document[position] ) != NULL && document[position] != '\0' )
+		{
+			number[numberLength++] = document[position++];
+		}
+		number[numberLength] = '\0';
+		char* end = NULL;
+		numberValue = strtod( number, &end );
+		if( *end != '\0' )
+		{
+			return fail( std::string( "a bad number " ) + number );
+		}
+		return NUMBER;
+	}
+	return fail( std::string( "an unexpected '" ) + c + "'" );
+}
+
+bool JsonReader::skip( Token aFirst )
+{
+	if( aFirst != BEGIN_OBJECT && aFirst != BEGIN_ARRAY )
+	{
+		return aFirst != DONE && aFirst != FAILED;
+	}
+	size_t depth = 1;
+	while( depth > 0 )
+	{
+		Token token = next();
+		if( token == DONE || token == FAILED )
+		{
+			return false;
+		}
+		if( token == BEGIN_OBJECT || token == BEGIN_ARRAY )
+		{
+			++depth;
+		}
+		else if( token == END_OBJECT || token == END_ARRAY )
+		{
+			--depth;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file JsonReader.hpp
+ * @brief Reads JSON a token at a time.
+ */
+
+#ifndef A429_JSON_READER_HPP
+#define A429_JSON_READER_HPP
+
+#include <string>
+#include <cstddef>
+
+/**
+ * A pull reader over JSON held in memory, the counterpart of JsonWriter. next() moves to
+ * the next token, and the text of a key or string, or the value of a number, can then be
+ * read. Commas and colons are taken as separators and not checked.
+ *
+ * Escaped characters up to U+00FF are read back as single Latin-1 bytes, as JsonWriter
+ * writes the bytes of the sheets; the rest become UTF-8.
+ */
+class JsonReader
+{
+public:
+
+	enum Token
+	{
+		BEGIN_OBJECT,
+		END_OBJECT,
+		BEGIN_ARRAY,
+		END_ARRAY,
+		/**
+		 * The name of the next value of an object
+		 */
+		KEY,
+		STRING,
+		NUMBER,
+		TRUE_VALUE,
+		FALSE_VALUE,
+		NULL_VALUE,
+		/**
+		 * The end of the text
+		 */
+		DONE,
+		/**
+		 * Something that couldn't be read, see error()
+		 */
+		FAILED
+	};
+
+	JsonReader( const char* aText, size_t aLength );
+
+	/**
+	 * Moves to the next token
+	 */
+	Token next();
+
+	/**
+	 * Skips the rest of a value whose first token was just read, such as one under an unknown key
+	 * @returns false if the text ended or couldn't be read first
+	 */
+	bool skip( Token aFirst );
+
+	/**
+	 * @returns the text of a KEY or STRING
+	 */
+	const std::string& text() const
+	{
+		return textValue;
+	}
+
+	/**
+	 * @returns the value of a NUMBER
+	 */
+	double number() const
+	{
+		return numberValue;
+	}
+
+	/**
+	 * @returns what couldn't be read, after next() returned FAILED
+	 */
+	const std::string& error() const
+	{
+		return errorText;
+	}
+
+private:
+
+	Token fail( const std::string& aError );
+
+	/**
+	 * Reads the string starting at the quote at position into textValue
+	 */
+	bool readString();
+
+	const char* document;
+	size_t length;
+	size_t position;
+	std::string textValue;
+	double numberValue;
+	std::string errorText;
+};
+
+#endif
@@ -0,0 +1,193 @@
+/**
+ * @file JsonWriter.cpp
+ * @brief Writes indented JSON to a stream.
+ */
+
+#include "JsonWriter.hpp"
+
+#include <cstdio>
+#include <cmath>
+
+JsonWriter::JsonWriter( std::ostream& aStream, bool aIndent )
+	: stream(aStream)
+	, indent(aIndent)
+	, afterKey(false)
+{
+}
+
+void JsonWriter::newLine()
+{
+	if( indent )
+	{
+		stream << '\n';
+		for( size_t i = 0; i < hasValue.size(); ++i )
+		{
+			stream << '\t';
+		}
+	}
+}
+
+void JsonWriter::separate()
+{
+	if( afterKey )
+	{
+		afterKey = false;
+		return;
+	}
+	if( !hasValue.empty() )
+	{
+		if( hasValue.back() )
+		{
+			stream << ',';
+		}
+		hasValue.back() = true;
+		newLine();
+	}
+}
+
+JsonWriter& JsonWriter::beginObject()
+{
+	separate();
+	stream << '{';
+	hasValue.push_back( false );
+	return *this;
+}
+
+JsonWriter& JsonWriter::endObject()
+{
+	bool empty = !hasValue.back();
+	hasValue.pop_back();
+	if( !empty )
+	{
+		newLine();
+	}
+	stream << '}';
+	return *this;
+}
+
+JsonWriter& JsonWriter::beginArray()
+{
+	separate();
+	stream << '[';
+	hasValue.push_back( false );
+	return *this;
+}
+
+JsonWriter& JsonWriter::endArray()
+{
+	bool empty = !hasValue.back();
+	hasValue.pop_back();
+	if( !empty )
+	{
+		newLine();
+	}
+	stream << ']';
+	return *this;
+}
+
+JsonWriter& JsonWriter::key( const std::string& aKey )
+{
+	separate();
+	writeString( stream, aKey );
+	stream << (indent ? ": " : ":");
+	afterKey = true;
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( const std::string& aValue )
+{
+	separate();
+	writeString( stream, aValue );
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( const char* aValue )
+{
+	return value( std::string( aValue ) );
+}
+
+JsonWriter& JsonWriter::value( double aValue )
+{
+	separate();
+	if( aValue != aValue || fabs( aValue ) > 1.7976931348623157e308 )
+	{
+		stream << "null";	//JSON has no NaN or infinity
+		return *this;
+	}
+	char text[32];
+	sprintf( text, "%.17g", aValue );
+	stream << text;
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( OwUInt64 aValue )
+{
+	separate();
+	stream << aValue;
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( OwInt64 aValue )
+{
+	separate();
+	stream << aValue;
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( OwUInt32 aValue )
+{
+	separate();
+	stream << aValue;
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( int aValue )
+{
+	separate();
+	stream << aValue;
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( bool aValue )
+{
+	separate();
+	stream << (aValue ? "true" : "false");
+	return *this;
+}
+
+JsonWriter& JsonWriter::null()
+{
+	separate();
+	stream << "null";
+	return *this;
+}
+
+void JsonWriter::writeString( std::ostream& aStream, const std::string& aText )
+{
+	aStream << '"';
+	for( size_t i = 0; i < aText.size(); ++i )
+	{
+		unsigned char c = (unsigned char)aText[i];
+		switch( c )
+		{
+		case '"':	aStream << "\\\""; break;
+		case '\\':	aStream << "\\\\"; break;
+		case '\n':	aStream << "\\n"; break;
+		case '\r':	aStream << "\\r"; break;
+		case '\t':	aStream << "\\t"; break;
+		default:
+			if( c < 0x20 || c >= 0x80 )
+			{
+				//The sheets are Windows-1252, not UTF-8. Latin-1 covers what they use, such as the plus/minus sign
+				char escape[8];
+				sprintf( escape, "\\u%04x", c );
+				aStream << escape;
+			}
+			else
+			{
+				aStream << (char)c;
+			}
+		}
+	}
+	aStream << '"';
+}
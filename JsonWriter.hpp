@@ -0,0 +1,73 @@
+/**
+ * @file JsonWriter.hpp
+ * @brief Writes indented JSON to a stream.
+ */
+
+#ifndef A429_JSON_WRITER_HPP
+#define A429_JSON_WRITER_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <Owl429/definitions>
+
+/**
+ * Writes JSON a value at a time, taking care of the commas, quoting and indentation.
+ * Inside an object each value is preceded by key(); inside an array values follow each other.
+ */
+class JsonWriter
+{
+public:
+
+	/**
+	 * @param aIndent whether to put each value on its own indented line
+	 */
+	explicit JsonWriter( std::ostream& aStream, bool aIndent = true );
+
+	JsonWriter& beginObject();
+	JsonWriter& endObject();
+	JsonWriter& beginArray();
+	JsonWriter& endArray();
+
+	/**
+	 * Names the next value of the current object
+	 */
+	JsonWriter& key( const std::string& aKey );
+
+	JsonWriter& value( const std::string& aValue );
+	JsonWriter& value( const char* aValue );
+	JsonWriter& value( double aValue );
+	JsonWriter& value( OwUInt64 aValue );
+	JsonWriter& value( OwInt64 aValue );
+	JsonWriter& value( OwUInt32 aValue );
+	JsonWriter& value( int aValue );
+	JsonWriter& value( bool aValue );
+	JsonWriter& null();
+
+	/**
+	 * Writes a string with the JSON escapes
+	 */
+	static void writeString( std::ostream& aStream, const std::string& aText );
+
+private:
+
+	/**
+	 * Writes what goes before a value: a comma if it isn't the first, and the indentation
+	 */
+	void separate();
+	void newLine();
+
+	std::ostream& stream;
+	bool indent;
+	/**
+	 * @brief Whether each open object or array has a value yet
+	 */
+	std::vector<bool> hasValue;
+	/**
+	 * @brief Whether a key was just written, so the value follows on the same line
+	 */
+	bool afterKey;
+};
+
+#endif
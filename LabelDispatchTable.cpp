@@ -0,0 +1,45 @@
+/**
+ * @file LabelDispatchTable.cpp
+ * @brief Maps the label and SDI of a received word straight to how to decode it.
+ */
+
+#include "LabelDispatchTable.hpp"
+
+LabelDispatchTable::LabelDispatchTable()
+{
+	clear();
+}
+
+void LabelDispatchTable::clear()
+{
+	for( size_t i = 0; i < SLOT_COUNT; ++i )
+	{
+		slots[i] = NO_ENTRY;
+	}
+	descriptors.clear();
+	parameters.clear();
+}
+
+OwUInt16 LabelDispatchTable::addDescriptor( const A429WordCodec::Descriptor& aDescriptor, const std::string& aParameter )
+{
+	if( descriptors.size() >= NO_ENTRY )
+	{
+		return NO_ENTRY;
+	}
+	descriptors.push_back( aDescriptor );
+	parameters.push_back( aParameter );
+	return (OwUInt16)(descriptors.size() - 1);
+}
+
+void LabelDispatchTable::map( OwUInt8 aLabel, OwUInt8 aSdi, OwUInt16 aDescriptor )
+{
+	slots[((aSdi & 0x3) << 8) | aLabel] = aDescriptor;
+}
+
+void LabelDispatchTable::mapAllSdi( OwUInt8 aLabel, OwUInt16 aDescriptor )
+{
+	for( OwUInt8 sdi = 0; sdi < 4; ++sdi )
+	{
+		map( aLabel, sdi, aDescriptor );
+	}
+}
@@ -0,0 +1,101 @@
+/**
+ * @file LabelDispatchTable.hpp
+ * @brief Maps the label and SDI of a received word straight to how to decode it.
+ */
+
+#ifndef A429_LABEL_DISPATCH_TABLE_HPP
+#define A429_LABEL_DISPATCH_TABLE_HPP
+
+#include <string>
+#include <vector>
+
+#include <Owl429/definitions>
+
+#include "A429WordCodec.hpp"
+
+/**
+ * The decoders of one equipment's bus, addressed by the low 10 bits of a word:
+ * the 8 bit label and the 2 bit SDI. The table is 2 KiB, so it stays in cache,
+ * and each slot holds the number of a pre-resolved descriptor.
+ */
+class LabelDispatchTable
+{
+public:
+
+	/**
+	 * What a slot holds when nothing is known about the label and SDI
+	 */
+	enum { NO_ENTRY = 0xFFFF };
+
+	/**
+	 * The number of slots, one for each label and SDI
+	 */
+	enum { SLOT_COUNT = 1024 };
+
+	LabelDispatchTable();
+
+	/**
+	 * Removes every descriptor and empties every slot
+	 */
+	void clear();
+
+	/**
+	 * Adds a descriptor to the table
+	 * @param aParameter the name of the parameter, for reports
+	 * @returns the number of the descriptor, or NO_ENTRY if the table is full
+	 */
+	OwUInt16 addDescriptor( const A429WordCodec::Descriptor& aDescriptor, const std::string& aParameter );
+
+	/**
+	 * Decodes words with one label and SDI using a descriptor
+	 */
+	void map( OwUInt8 aLabel, OwUInt8 aSdi, OwUInt16 aDescriptor );
+
+	/**
+	 * Decodes words with one label, whatever their SDI, using a descriptor
+	 */
+	void mapAllSdi( OwUInt8 aLabel, OwUInt16 aDescriptor );
+
+	/**
+	 * @returns the number of the descriptor for a word, or NO_ENTRY
+	 */
+	OwUInt16 lookup( OwUInt32 aWord ) const
+	{
+		return slots[aWord & (SLOT_COUNT - 1)];
+	}
+
+	/**
+	 * @returns a descriptor by number
+	 */
+	const A429WordCodec::Descriptor& descriptor( OwUInt16 aDescriptor ) const
+	{
+		return descriptors[aDescriptor];
+	}
+
+	/**
+	 * @returns the parameter name of a descriptor
+	 */
+	const std::string& parameter( OwUInt16 aDescriptor ) const
+	{
+		return parameters[aDescriptor];
+	}
+
+	/**
+	 * @returns the number of descriptors
+	 */
+	size_t size() const
+	{
+		return descriptors.size();
+	}
+
+private:
+
+	/**
+	 * @brief The descriptor of each label and SDI
+	 */
+	OwUInt16 slots[SLOT_COUNT];
+	std::vector<A429WordCodec::Descriptor> descriptors;
+	std::vector<std::string> parameters;
+};
+
+#endif
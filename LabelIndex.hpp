@@ -0,0 +1,196 @@
+/**
+ * @file LabelIndex.hpp
+ * @brief A flat hash index keyed on (equipment ID, label) used to link the specification sheets.
+ */
+
+#ifndef A429_LABEL_INDEX_HPP
+#define A429_LABEL_INDEX_HPP
+
+#include <vector>
+#include <cstddef>
+
+#include <Owl429/definitions>
+
+/**
+ * An open addressing hash table mapping a 12 bit equipment ID and an 8 bit label to a value.
+ * The key fits in 20 bits, so it is stored directly in the slot and no hashing of strings
+ * or allocation per entry takes place. The first value inserted for a key is kept.
+ */
+template <typename T>
+class LabelIndex
+{
+public:
+
+	LabelIndex()
+		: count(0)
+	{
+		clear();
+	}
+
+	/**
+	 * Packs an equipment ID and a label into a 20 bit key
+	 * @param aEquipmentId the 12 bit equipment ID
+	 * @param aLabel the 8 bit label code
+	 * @returns the key
+	 */
+	static OwUInt32 makeKey( OwUInt16 aEquipmentId, OwUInt8 aLabel )
+	{
+		return ((OwUInt32)(aEquipmentId & 0xFFF) << 8) | aLabel;
+	}
+
+	/**
+	 * Hashes a key to its home slot. Shared with the index stored in .a429db files
+	 * @param aKey a key made by makeKey
+	 * @param aMask the capacity of the table, a power of 2, minus one
+	 */
+	static size_t homeSlot( OwUInt32 aKey, size_t aMask )
+	{
+		return (size_t)((aKey * 0x9E3779B1u) >> 12) & aMask;	//Fibonacci hashing spreads the adjacent labels of an equipment
+	}
+
+	/**
+	 * Removes all the entries
+	 */
+	void clear()
+	{
+		Slot empty;
+		empty.key = EMPTY_KEY;
+		empty.value = T();
+		slots.assign( MIN_CAPACITY, empty );
+		count = 0;
+	}
+
+	/**
+	 * Grows the table so that it can hold aCount entries without rehashing
+	 */
+	void reserve( size_t aCount )
+	{
+		size_t capacity = slots.size();
+		while( capacity < aCount * 2 )
+		{
+			capacity *= 2;
+		}
+		if( capacity != slots.size() )
+		{
+			rehash( capacity );
+		}
+	}
+
+	/**
+	 * Adds a value to the index. If the key is already present the existing value is kept.
+	 * @returns true if the value was added
+	 */
+	bool insert( OwUInt16 aEquipmentId, OwUInt8 aLabel, const T& aValue )
+	{
+		if( (count + 1) * 2 > slots.size() )
+		{
+			rehash( slots.size() * 2 );
+		}
+		OwUInt32 key = makeKey( aEquipmentId, aLabel );
+		size_t i = probe( key );
+		if( slots[i].key == key )
+		{
+			return false;
+		}
+		slots[i].key = key;
+		slots[i].value = aValue;
+		++count;
+		return true;
+	}
+
+	/**
+	 * Looks up a value
+	 * @param aValue set to the stored value if the key is present
+	 * @returns true if the key is present
+	 */
+	bool find( OwUInt16 aEquipmentId, OwUInt8 aLabel, T& aValue ) const
+	{
+		OwUInt32 key = makeKey( aEquipmentId, aLabel );
+		const Slot& slot = slots[probe( key )];
+		if( slot.key != key )
+		{
+			return false;
+		}
+		aValue = slot.value;
+		return true;
+	}
+
+	/**
+	 * @returns the number of slots, for walking the entries with entry()
+	 */
+	size_t capacity() const
+	{
+		return slots.size();
+	}
+
+	/**
+	 * Reads a slot
+	 * @param aSlot the slot, less than capacity()
+	 * @returns false if the slot is empty, otherwise true with its key and value
+	 */
+	bool entry( size_t aSlot, OwUInt32& aKey, T& aValue ) const
+	{
+		if( slots[aSlot].key == EMPTY_KEY )
+		{
+			return false;
+		}
+		aKey = slots[aSlot].key;
+		aValue = slots[aSlot].value;
+		return true;
+	}
+
+	/**
+	 * @returns the number of keys in the index
+	 */
+	size_t size() const
+	{
+		return count;
+	}
+
+private:
+
+	enum { MIN_CAPACITY = 64 };
+	static const OwUInt32 EMPTY_KEY = 0xFFFFFFFF;
+
+	typedef struct Slot
+	{
+		OwUInt32 key;
+		T value;
+	} Slot;
+
+	/**
+	 * Finds the slot holding aKey, or the empty slot where it belongs
+	 */
+	size_t probe( OwUInt32 aKey ) const
+	{
+		size_t mask = slots.size() - 1;
+		size_t i = homeSlot( aKey, mask );
+		while( slots[i].key != EMPTY_KEY && slots[i].key != aKey )
+		{
+			i = (i + 1) & mask;
+		}
+		return i;
+	}
+
+	void rehash( size_t aCapacity )
+	{
+		std::vector<Slot> old;
+		old.swap( slots );
+		Slot empty;
+		empty.key = EMPTY_KEY;
+		empty.value = T();
+		slots.assign( aCapacity, empty );
+		for( size_t i = 0; i < old.size(); ++i )
+		{
+			if( old[i].key != EMPTY_KEY )
+			{
+				slots[probe( old[i].key )] = old[i];
+			}
+		}
+	}
+
+	std::vector<Slot> slots;
+	size_t count;
+};
+
+#endif
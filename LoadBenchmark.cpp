@@ -0,0 +1,394 @@
+/**
+ * @file LoadBenchmark.cpp
+ * @brief Times loading the specification sheets and exporting them, a phase at a time.
+ */
+
+#include "LoadBenchmark.hpp"
+
+#include <fstream>
+#include <set>
+#include <sstream>
+
+#include "ChannelConfig.hpp"
+#include "CsvScanner.hpp"
+#include "FileUtil.hpp"
+#include "JsonWriter.hpp"
+#include "LoadedCSV.hpp"
+#include "MappedFile.hpp"
+#include "Stopwatch.hpp"
+#include "SyntheticSpec.hpp"
+#include "WorkerPool.hpp"
+
+/**
+ * The size of the pieces CsvReader indexes a sheet in
+ */
+static const size_t TOKENIZE_CHUNK = 64 * 1024;
+
+LoadBenchmark::LoadBenchmark( unsigned aRepetitions, unsigned aExportThreads )
+	: repetitions(aRepetitions == 0 ? 1 : aRepetitions)
+	, exportThreads(aExportThreads)
+{
+}
+
+OwUInt64 LoadBenchmark::tokenize( const std::string& aFile, OwUInt64& aBytes )
+{
+	Stopwatch stopwatch;
+	MappedFile file;
+	if( !file.open( aFile ) )
+	{
+		aBytes = 0;
+		return 0;
+	}
+	CsvScanner::Kernel kernel = CsvScanner::bestKernel();
+	std::vector<OwUInt32> positions;
+	for( size_t offset = 0; offset < file.size(); offset += TOKENIZE_CHUNK )
+	{
+		size_t length = file.size() - offset < TOKENIZE_CHUNK ? file.size() - offset : TOKENIZE_CHUNK;
+		positions.clear();
+		CsvScanner::index( file.data() + offset, length, positions, kernel );
+	}
+	aBytes = file.size();
+	return stopwatch.elapsed();
+}
+
+LoadBenchmark::FormatResult LoadBenchmark::runFormat( const LoadedCSV& aLoaded, ChannelExporter::Format aFormat, bool aCheck )
+{
+	FormatResult result = FormatResult();
+	const SpecStore& spec = aLoaded.spec();
+	ChannelExporter* exporter = ChannelExporter::create( aFormat, aLoaded.schema() );
+	std::vector<std::string> documents( spec.equipmentCount() );
+	std::string errors;
+	Stopwatch stopwatch;
+	for( OwUInt32 i = 0; i < spec.equipmentCount(); ++i )
+	{
+		exporter->write( spec.equipmentAt( i ), 1, errors );
+		documents[i] = exporter->buffer();
+		result.bytes += documents[i].size();
+	}
+	result.writeTime = stopwatch.elapsed();
+
+	ChannelConfig config;
+	std::string error;
+	stopwatch.restart();
+	for( OwUInt32 i = 0; i < spec.equipmentCount(); ++i )
+	{
+		exporter->read( documents[i].data(), documents[i].size(), config, error );
+	}
+	result.readTime = stopwatch.elapsed();
+
+	for( OwUInt32 i = 0; i < spec.equipmentCount() && aCheck; ++i )
+	{
+		std::string difference;
+		exporter->write( spec.equipmentAt( i ), 1, errors );
+		if( !exporter->read( documents[i].data(), documents[i].size(), config, error ) || !exporter->config().sameAs( config, difference ) )
+		{
+			++result.roundTripFailures;
+		}
+	}
+	delete exporter;
+	return result;
+}
+
+void LoadBenchmark::addTimes( SheetTimes& aTotal, const SheetTimes& aRun )
+{
+	aTotal.equipment += aRun.equipment;
+	aTotal.transmissions += aRun.transmissions;
+	aTotal.bnr += aRun.bnr;
+	aTotal.bcd += aRun.bcd;
+}
+
+void LoadBenchmark::keepFastest( SheetTimes& aBest, const SheetTimes& aRun, bool aFirst )
+{
+	if( aFirst || aRun.equipment + aRun.transmissions + aRun.bnr + aRun.bcd < aBest.equipment + aBest.transmissions + aBest.bnr + aBest.bcd )
+	{
+		aBest = aRun;
+	}
+}
+
+bool LoadBenchmark::run( const std::string& aName, const std::string& aPrefix, unsigned aScale, const std::string& aOutputDirectory )
+{
+	return run( aName, std::vector<std::string>( 1, aPrefix ), aScale, aOutputDirectory );
+}
+
+bool LoadBenchmark::run( const std::string& aName, const std::vector<std::string>& aPrefixes, unsigned aScale, const std::string& aOutputDirectory )
+{
+	if( aPrefixes.empty() || !FileUtil::makeDirectory( aOutputDirectory ) )
+	{
+		return false;
+	}
+
+	Result result = Result();
+	result.name = aName;
+	result.scale = aScale;
+	result.revisions = (unsigned)aPrefixes.size();
+	for( unsigned repetition = 0; repetition < repetitions; ++repetition )
+	{
+		bool first = repetition == 0;
+		SheetTimes tokenizeRun = SheetTimes();
+		SheetTimes parseRun = SheetTimes();
+		SheetTimes linkRun = SheetTimes();
+		OwUInt64 exportRun = 0;
+		FormatResult formatRuns[ChannelExporter::FORMAT_COUNT] = {};
+
+		//Each revision is loaded and exported on its own, as BatchConverter does, and the times added up
+		for( size_t revision = 0; revision < aPrefixes.size(); ++revision )
+		{
+			const std::string equipmentFile = aPrefixes[revision] + "EquipmentIDs.csv";
+			const std::string transmissionFile = aPrefixes[revision] + "LabelIDs.csv";
+			const std::string bnrFile = aPrefixes[revision] + "BnrData.csv";
+			const std::string bcdFile = aPrefixes[revision] + "BcdData.csv";
+
+			//Tokenize
+			SheetTimes tokenizeTimes;
+			OwUInt64 bytes[4];
+			tokenizeTimes.equipment = tokenize( equipmentFile, bytes[0] );
+			tokenizeTimes.transmissions = tokenize( transmissionFile, bytes[1] );
+			tokenizeTimes.bnr = tokenize( bnrFile, bytes[2] );
+			tokenizeTimes.bcd = tokenize( bcdFile, bytes[3] );
+			if( tokenizeTimes.equipment == 0 || tokenizeTimes.transmissions == 0 || tokenizeTimes.bnr == 0 || tokenizeTimes.bcd == 0 )
+			{
+				return false;	//A sheet couldn't be opened
+			}
+			addTimes( tokenizeRun, tokenizeTimes );
+
+			//Parse and link, on one thread so each sheet's steps run on their own. LoadStats keeps the time of each
+			LoadedCSV loaded;
+			loaded.load( equipmentFile, transmissionFile, bnrFile, bcdFile, 1 );
+			LoadStats loadStats = loaded.stats();
+			if( !loadStats.equipment.error.empty() || !loadStats.transmissions.error.empty() || !loadStats.bnr.error.empty() || !loadStats.bcd.error.empty() )
+			{
+				return false;
+			}
+			SheetTimes parseTimes;
+			parseTimes.equipment = loadStats.equipment.parseTime;
+			parseTimes.transmissions = loadStats.transmissions.parseTime;
+			parseTimes.bnr = loadStats.bnr.parseTime;
+			parseTimes.bcd = loadStats.bcd.parseTime;
+			addTimes( parseRun, parseTimes );
+			SheetTimes linkTimes;
+			linkTimes.equipment = loadStats.equipment.linkTime;
+			linkTimes.transmissions = loadStats.transmissions.linkTime;
+			linkTimes.bnr = loadStats.bnr.linkTime;
+			linkTimes.bcd = loadStats.bcd.linkTime;
+			addTimes( linkRun, linkTimes );
+
+			//Export
+			loaded.setOutputDirectory( aOutputDirectory );
+			Stopwatch stopwatch;
+			loaded.save( exportThreads );
+			exportRun += stopwatch.elapsed();
+
+			//The backends, in memory so the disk doesn't decide it
+			for( int format = 0; format < ChannelExporter::FORMAT_COUNT; ++format )
+			{
+				FormatResult formatTimes = runFormat( loaded, (ChannelExporter::Format)format, first );
+				formatRuns[format].bytes += formatTimes.bytes;
+				formatRuns[format].writeTime += formatTimes.writeTime;
+				formatRuns[format].readTime += formatTimes.readTime;
+				formatRuns[format].roundTripFailures += formatTimes.roundTripFailures;
+			}
+
+			if( first )
+			{
+				const SpecStore& spec = loaded.spec();
+				result.bytes += bytes[0] + bytes[1] + bytes[2] + bytes[3];
+				result.equipmentRows += spec.equipmentCount();
+				result.transmissionRows += spec.transmissionCount();
+				result.bnrRows += spec.bnr.size();
+				result.bcdRows += spec.bcd.size();
+				result.links += (OwUInt32)spec.equipment.links.size();
+				std::set<std::string> fileNames;
+				for( OwUInt32 i = 0; i < spec.equipmentCount(); ++i )
+				{
+					fileNames.insert( LoadedCSV::fileNameOf( spec.equipmentAt( i ) ) );
+				}
+				result.filesWritten += (OwUInt32)fileNames.size();
+			}
+		}
+
+		keepFastest( result.tokenize, tokenizeRun, first );
+		keepFastest( result.parse, parseRun, first );
+		keepFastest( result.link, linkRun, first );
+		if( first || exportRun < result.exportTime )
+		{
+			result.exportTime = exportRun;
+		}
+		for( int format = 0; format < ChannelExporter::FORMAT_COUNT; ++format )
+		{
+			FormatResult& best = result.formats[format];
+			if( first )
+			{
+				best = formatRuns[format];
+			}
+			else
+			{
+				best.writeTime = formatRuns[format].writeTime < best.writeTime ? formatRuns[format].writeTime : best.writeTime;
+				best.readTime = formatRuns[format].readTime < best.readTime ? formatRuns[format].readTime : best.readTime;
+			}
+		}
+	}
+
+	const SheetTimes* phases[3] = { &result.tokenize, &result.parse, &result.link };
+	result.totalTime = result.exportTime;
+	for( int i = 0; i < 3; ++i )
+	{
+		result.totalTime += phases[i]->equipment + phases[i]->transmissions + phases[i]->bnr + phases[i]->bcd;
+	}
+	resultList.push_back( result );
+	return true;
+}
+
+/**
+ * Writes the times of a phase, and their sum
+ */
+static void writeSheetTimes( JsonWriter& aJson, const LoadBenchmark::SheetTimes& aTimes )
+{
+	aJson.beginObject();
+	aJson.key( "equipment" ).value( aTimes.equipment );
+	aJson.key( "transmissions" ).value( aTimes.transmissions );
+	aJson.key( "bnr" ).value( aTimes.bnr );
+	aJson.key( "bcd" ).value( aTimes.bcd );
+	aJson.key( "total" ).value( aTimes.equipment + aTimes.transmissions + aTimes.bnr + aTimes.bcd );
+	aJson.endObject();
+}
+
+/**
+ * @returns the throughput of a phase over the sheets, in MB/s
+ */
+static double megabytesPerSecond( OwUInt64 aBytes, const LoadBenchmark::SheetTimes& aTimes )
+{
+	OwUInt64 total = aTimes.equipment + aTimes.transmissions + aTimes.bnr + aTimes.bcd;
+	return total == 0 ? 0 : (double)aBytes * 1000 / (double)total;
+}
+
+void LoadBenchmark::writeJson( std::ostream& aStream ) const
+{
+	JsonWriter json( aStream );
+	json.beginObject();
+	json.key( "benchmark" ).value( "a429DataUtils load and export" );
+	json.key( "csvKernel" ).value( CsvScanner::kernelName( CsvScanner::bestKernel() ) );
+	json.key( "hardwareThreads" ).value( (OwUInt32)WorkerPool::hardwareConcurrency() );
+	json.key( "exportThreads" ).value( (OwUInt32)(exportThreads == 0 ? WorkerPool::hardwareConcurrency() : exportThreads) );
+	json.key( "repetitions" ).value( (OwUInt32)repetitions );
+	json.key( "results" ).beginArray();
+	for( size_t i = 0; i < resultList.size(); ++i )
+	{
+		const Result& result = resultList[i];
+		json.beginObject();
+		json.key( "name" ).value( result.name );
+		json.key( "scale" ).value( (OwUInt32)result.scale );
+		json.key( "revisions" ).value( (OwUInt32)result.revisions );
+		json.key( "bytes" ).value( result.bytes );
+		json.key( "rows" ).beginObject();
+		json.key( "equipment" ).value( result.equipmentRows );
+		json.key( "transmissions" ).value( result.transmissionRows );
+		json.key( "bnr" ).value( result.bnrRows );
+		json.key( "bcd" ).value( result.bcdRows );
+		json.key( "links" ).value( result.links );
+		json.endObject();
+		json.key( "filesWritten" ).value( result.filesWritten );
+		json.key( "tokenizeNs" );
+		writeSheetTimes( json, result.tokenize );
+		json.key( "parseNs" );
+		writeSheetTimes( json, result.parse );
+		json.key( "linkNs" );
+		writeSheetTimes( json, result.link );
+		json.key( "exportNs" ).value( result.exportTime );
+		json.key( "totalNs" ).value( result.totalTime );
+		json.key( "tokenizeMBps" ).value( megabytesPerSecond( result.bytes, result.tokenize ) );
+		json.key( "parseMBps" ).value( megabytesPerSecond( result.bytes, result.parse ) );
+		json.key( "formats" ).beginObject();
+		const FormatResult& xml = result.formats[ChannelExporter::FORMAT_XML];
+		for( int format = 0; format < ChannelExporter::FORMAT_COUNT; ++format )
+		{
+			const FormatResult& formatResult = result.formats[format];
+			json.key( ChannelExporter::formatName( (ChannelExporter::Format)format ) ).beginObject();
+			json.key( "bytes" ).value( formatResult.bytes );
+			json.key( "writeNs" ).value( formatResult.writeTime );
+			json.key( "readNs" ).value( formatResult.readTime );
+			json.key( "roundTripFailures" ).value( formatResult.roundTripFailures );
+			json.key( "sizeOfXml" ).value( xml.bytes == 0 ? 0 : (double)formatResult.bytes / (double)xml.bytes );
+			json.key( "readTimeOfXml" ).value( xml.readTime == 0 ? 0 : (double)formatResult.readTime / (double)xml.readTime );
+			json.endObject();
+		}
+		json.endObject();
+		json.endObject();
+	}
+	json.endArray();
+	json.endObject();
+	aStream << "\n";
+}
+
+/**
+ * A sample program that benchmarks the shipped sheets, and copies of them 2, 4, 10, 100 and
+ * 1000 times the size, and writes the results to benchmark/results.json. The 12 bit equipment
+ * IDs only leave room for a few copies in one revision, so the bigger sets are batches of
+ * revisions that are each as big as they allow
+ *
+ * @return 0 for success or 1 on error.
+ */
+int sample_Benchmark()
+{
+	const std::string shipped = "data/ARINC429P1-18-";
+	const std::string directory = "benchmark";
+	if( !FileUtil::makeDirectory( directory ) )
+	{
+		return 1;
+	}
+
+	LoadBenchmark benchmark;
+	if( !benchmark.run( "P1-18", shipped, 1, FileUtil::joinPath( directory, "x1" ) ) )
+	{
+		return 1;
+	}
+	const unsigned perRevision = SyntheticSpec::maxScale( shipped );
+	const unsigned scales[] = { 2, 4, 10, 100, 1000 };
+	for( size_t i = 0; i < sizeof(scales) / sizeof(scales[0]); ++i )
+	{
+		std::stringstream name;
+		name << "P1-18x" << scales[i];
+		std::stringstream output;
+		output << "x" << scales[i];
+
+		//As many full revisions as fit, then one for the rest
+		std::vector<std::string> prefixes;
+		unsigned rest = scales[i];
+		if( scales[i] > perRevision )
+		{
+			std::stringstream full;
+			full << "P1-18x" << perRevision << "-";
+			std::string fullPrefix = FileUtil::joinPath( directory, full.str() );
+			if( !SyntheticSpec::write( shipped, fullPrefix, perRevision ) )
+			{
+				return 1;
+			}
+			prefixes.assign( scales[i] / perRevision, fullPrefix );
+			rest = scales[i] % perRevision;
+		}
+		if( rest == 1 )
+		{
+			prefixes.push_back( shipped );
+		}
+		else if( rest > 1 )
+		{
+			std::stringstream part;
+			part << "P1-18x" << rest << "-";
+			std::string partPrefix = FileUtil::joinPath( directory, part.str() );
+			if( !SyntheticSpec::write( shipped, partPrefix, rest ) )
+			{
+				return 1;
+			}
+			prefixes.push_back( partPrefix );
+		}
+
+		if( !benchmark.run( name.str(), prefixes, scales[i], FileUtil::joinPath( directory, output.str() ) ) )
+		{
+			return 1;
+		}
+	}
+
+	std::ofstream json( FileUtil::joinPath( directory, "results.json" ).c_str() );
+	benchmark.writeJson( json );
+	json.close();
+	return json.fail() ? 1 : 0;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file LoadBenchmark.hpp
+ * @brief Times loading the specification sheets and exporting them, a phase at a time.
+ */
+
+#ifndef A429_LOAD_BENCHMARK_HPP
+#define A429_LOAD_BENCHMARK_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <Owl429/definitions>
+
+#include "ChannelExporter.hpp"
+
+class LoadedCSV;
+
+/**
+ * Times each phase of turning a set of sheets into Xml:
+ *  - tokenize: mapping each sheet and finding its structural characters
+ *  - parse: reading each sheet into staging columns
+ *  - link: linking the staged rows together and indexing them
+ *  - export: writing the Xml of every equipment
+ *
+ * Then each ChannelExporter backend writes every equipment into memory and reads it
+ * back, for the size and parse time of each format, and checks that it reads back what
+ * it wrote.
+ *
+ * Each phase is run a number of times and the fastest run is kept, which is
+ * the least disturbed by the rest of the machine.
+ */
+class LoadBenchmark
+{
+public:
+
+	/**
+	 * The nanoseconds a phase took on each sheet
+	 */
+	typedef struct SheetTimes
+	{
+		OwUInt64 equipment;
+		OwUInt64 transmissions;
+		OwUInt64 bnr;
+		OwUInt64 bcd;
+	} SheetTimes;
+
+	/**
+	 * What was measured of an export backend
+	 */
+	typedef struct FormatResult
+	{
+		/**
+		 * @brief The size of every equipment's document together
+		 */
+		OwUInt64 bytes;
+		/**
+		 * @brief The nanoseconds taken to write them, and to read them back
+		 */
+		OwUInt64 writeTime;
+		OwUInt64 readTime;
+		/**
+		 * @brief The documents that didn't read back to what was written
+		 */
+		OwUInt32 roundTripFailures;
+	} FormatResult;
+
+	/**
+	 * What was measured on a set of sheets
+	 */
+	typedef struct Result
+	{
+		std::string name;
+		unsigned scale;
+		/**
+		 * @brief The number of revisions the sheets were loaded as
+		 */
+		unsigned revisions;
+		/**
+		 * @brief The size of the four sheets
+		 */
+		OwUInt64 bytes;
+		OwUInt32 equipmentRows;
+		OwUInt32 transmissionRows;
+		OwUInt32 bnrRows;
+		OwUInt32 bcdRows;
+		OwUInt32 links;
+		/**
+		 * @brief The number of files written by each export
+		 */
+		OwUInt32 filesWritten;
+		SheetTimes tokenize;
+		SheetTimes parse;
+		SheetTimes link;
+		OwUInt64 exportTime;
+		/**
+		 * @brief The backends, by ChannelExporter::Format
+		 */
+		FormatResult formats[ChannelExporter::FORMAT_COUNT];
+		/**
+		 * @brief Every phase together, on the fastest run
+		 */
+		OwUInt64 totalTime;
+	} Result;
+
+	/**
+	 * @param aRepetitions how many times to run each phase
+	 * @param aExportThreads the threads to export on. 0 uses one per core
+	 */
+	LoadBenchmark( unsigned aRepetitions = 3, unsigned aExportThreads = 0 );
+
+	/**
+	 * Times a set of sheets, and adds the result
+	 * @param aName what to call the set in the results
+	 * @param aPrefix the path of the sheets up to "EquipmentIDs.csv", "LabelIDs.csv"...
+	 * @param aScale how many times the size of the real set it is, for the results
+	 * @param aOutputDirectory where to export to. Made if it doesn't exist
+	 * @returns false if a sheet couldn't be opened
+	 */
+	bool run( const std::string& aName, const std::string& aPrefix, unsigned aScale, const std::string& aOutputDirectory );
+
+	/**
+	 * Times a batch of revisions, each loaded and exported on its own as BatchConverter does,
+	 * and adds the result with the times and row counts of the revisions added up. This is how
+	 * sets too big for the 12 bit equipment IDs of one revision are measured
+	 * @param aPrefixes the path of each revision's sheets up to "EquipmentIDs.csv"... A prefix
+	 *        may be repeated, in which case its sheets are loaded again
+	 * @param aOutputDirectory where to export every revision to, one over the other
+	 */
+	bool run( const std::string& aName, const std::vector<std::string>& aPrefixes, unsigned aScale, const std::string& aOutputDirectory );
+
+	const std::vector<Result>& results() const
+	{
+		return resultList;
+	}
+
+	/**
+	 * Writes the results as JSON
+	 */
+	void writeJson( std::ostream& aStream ) const;
+
+private:
+
+	/**
+	 * Maps a sheet and finds its structural characters, 64 KiB at a time as CsvReader does
+	 * @returns the nanoseconds taken
+	 */
+	static OwUInt64 tokenize( const std::string& aFile, OwUInt64& aBytes );
+
+	static void addTimes( SheetTimes& aTotal, const SheetTimes& aRun );
+
+	static void keepFastest( SheetTimes& aBest, const SheetTimes& aRun, bool aFirst );
+
+	/**
+	 * Writes every equipment with a backend and reads it back
+	 * @param aCheck whether to check each document reads back to what was written
+	 */
+	static FormatResult runFormat( const LoadedCSV& aLoaded, ChannelExporter::Format aFormat, bool aCheck );
+
+	unsigned repetitions;
+	unsigned exportThreads;
+	std::vector<Result> resultList;
+};
+
+#endif
@@ -0,0 +1,152 @@
+/**
+ * @file LoadStats.cpp
+ * @brief Counters and timers kept while loading and exporting the specification sheets.
+ */
+
+#include "LoadStats.hpp"
+
+#include "JsonWriter.hpp"
+
+namespace
+{
+	const char* const SKIP_REASON_NAMES[LoadStats::SKIP_REASON_COUNT] =
+	{
+		"blankRow",
+		"missingField",
+		"badLabel",
+		"badEquipmentId",
+		"invalidWildcard",
+		"unknownRate"
+	};
+
+	void writeSheet( JsonWriter& aJson, const LoadStats::SheetStats& aSheet )
+	{
+		aJson.beginObject();
+		aJson.key( "bytes" ).value( aSheet.bytes );
+		aJson.key( "parseNs" ).value( aSheet.parseTime );
+		aJson.key( "linkNs" ).value( aSheet.linkTime );
+		aJson.key( "bytesAllocated" ).value( aSheet.bytesAllocated );
+		aJson.key( "rowsRead" ).value( aSheet.rowsRead );
+		aJson.key( "rowsAccepted" ).value( aSheet.rowsAccepted );
+		aJson.key( "rowsSkipped" ).value( LoadStats::totalSkipped( aSheet ) );
+		aJson.key( "skipReasons" ).beginObject();
+		for( int i = 0; i < LoadStats::SKIP_REASON_COUNT; ++i )
+		{
+			if( aSheet.rowsSkipped[i] != 0 )
+			{
+				aJson.key( LoadStats::skipReasonName( (LoadStats::SkipReason)i ) ).value( aSheet.rowsSkipped[i] );
+			}
+		}
+		aJson.endObject();
+		aJson.key( "linkHits" ).value( aSheet.linkHits );
+		aJson.key( "linkMisses" ).value( aSheet.linkMisses );
+		if( aSheet.error.empty() )
+		{
+			aJson.key( "error" ).null();
+		}
+		else
+		{
+			aJson.key( "error" ).value( aSheet.error );
+		}
+		aJson.endObject();
+	}
+}
+
+LoadStats::LoadStats()
+{
+	clear();
+}
+
+void LoadStats::clear()
+{
+	clear( this->equipment );
+	clear( this->transmissions );
+	clear( this->bnr );
+	clear( this->bcd );
+	this->loadTime = 0;
+	this->wildcardLinks = 0;
+	this->validateTime = 0;
+	this->findings = 0;
+	this->exportTime = 0;
+	this->filesWritten = 0;
+	this->filesUnchanged = 0;
+	this->filesFailed = 0;
+	this->exportWarnings = 0;
+	this->manifestFailed = false;
+	this->storeBytes = 0;
+	this->stringsInterned = 0;
+	this->distinctStrings = 0;
+	this->stringBytes = 0;
+	this->stringBytesSaved = 0;
+}
+
+void LoadStats::clear( SheetStats& aSheet )
+{
+	aSheet.bytes = 0;
+	aSheet.parseTime = 0;
+	aSheet.linkTime = 0;
+	aSheet.bytesAllocated = 0;
+	aSheet.rowsRead = 0;
+	aSheet.rowsAccepted = 0;
+	for( int i = 0; i < SKIP_REASON_COUNT; ++i )
+	{
+		aSheet.rowsSkipped[i] = 0;
+	}
+	aSheet.linkHits = 0;
+	aSheet.linkMisses = 0;
+	aSheet.error.clear();
+}
+
+OwUInt32 LoadStats::totalSkipped( const SheetStats& aSheet )
+{
+	OwUInt32 total = 0;
+	for( int i = 0; i < SKIP_REASON_COUNT; ++i )
+	{
+		total += aSheet.rowsSkipped[i];
+	}
+	return total;
+}
+
+const char* LoadStats::skipReasonName( SkipReason aReason )
+{
+	return aReason >= 0 && aReason < SKIP_REASON_COUNT ? SKIP_REASON_NAMES[aReason] : "unknown";
+}
+
+void LoadStats::writeJson( std::ostream& aStream ) const
+{
+	JsonWriter json( aStream );
+	json.beginObject();
+	json.key( "sheets" ).beginObject();
+	json.key( "equipment" );
+	writeSheet( json, this->equipment );
+	json.key( "transmissions" );
+	writeSheet( json, this->transmissions );
+	json.key( "bnr" );
+	writeSheet( json, this->bnr );
+	json.key( "bcd" );
+	writeSheet( json, this->bcd );
+	json.endObject();
+	json.key( "loadNs" ).value( this->loadTime );
+	json.key( "wildcardLinks" ).value( this->wildcardLinks );
+	json.key( "storeBytes" ).value( this->storeBytes );
+	json.key( "strings" ).beginObject();
+	json.key( "interned" ).value( this->stringsInterned );
+	json.key( "distinct" ).value( this->distinctStrings );
+	json.key( "bytes" ).value( this->stringBytes );
+	json.key( "bytesSaved" ).value( this->stringBytesSaved );
+	json.endObject();
+	json.key( "validation" ).beginObject();
+	json.key( "ns" ).value( this->validateTime );
+	json.key( "findings" ).value( this->findings );
+	json.endObject();
+	json.key( "export" ).beginObject();
+	json.key( "ns" ).value( this->exportTime );
+	json.key( "filesWritten" ).value( this->filesWritten );
+	json.key( "filesUnchanged" ).value( this->filesUnchanged );
+	json.key( "filesFailed" ).value( this->filesFailed );
+	json.key( "warnings" ).value( this->exportWarnings );
+	json.key( "manifestFailed" ).value( this->manifestFailed );
+	json.endObject();
+	json.endObject();
+	aStream << "\n";
+}
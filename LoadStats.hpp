@@ -0,0 +1,196 @@
+/**
+ * @file LoadStats.hpp
+ * @brief Counters and timers kept while loading and exporting the specification sheets.
+ */
+
+#ifndef A429_LOAD_STATS_HPP
+#define A429_LOAD_STATS_HPP
+
+#include <string>
+#include <ostream>
+#include <cstddef>
+
+#include <Owl429/definitions>
+
+/**
+ * What the loaders did with each sheet: how long each phase took, how many rows were
+ * kept, why the others were skipped and how many found what they refer to.
+ * Each sheet has its own counters, so sheets parsed on different threads never share them.
+ * Counting is a few increments per row, so the counters are always on.
+ */
+class LoadStats
+{
+public:
+
+	/**
+	 * Why a row of a sheet was skipped
+	 */
+	enum SkipReason
+	{
+		/**
+		 * @brief An empty row, or one with too few fields
+		 */
+		SKIP_BLANK_ROW,
+		/**
+		 * @brief An equipment without an ID or a type
+		 */
+		SKIP_MISSING_FIELD,
+		/**
+		 * @brief A label that isn't 3 digits
+		 */
+		SKIP_BAD_LABEL,
+		/**
+		 * @brief An equipment ID that isn't 3 digits
+		 */
+		SKIP_BAD_EQUIPMENT_ID,
+		/**
+		 * @brief An equipment ID mixing X or Y wildcard digits with hex digits
+		 */
+		SKIP_INVALID_WILDCARD,
+		/**
+		 * @brief BNR or BCD data whose min transit interval is 0 or not a number
+		 */
+		SKIP_UNKNOWN_RATE,
+		SKIP_REASON_COUNT
+	};
+
+	/**
+	 * The counters of one sheet
+	 */
+	typedef struct SheetStats
+	{
+		/**
+		 * @brief The size of the file
+		 */
+		OwUInt64 bytes;
+		/**
+		 * @brief The nanoseconds spent parsing the file into columns
+		 */
+		OwUInt64 parseTime;
+		/**
+		 * @brief The nanoseconds spent linking the columns to the other sheets
+		 */
+		OwUInt64 linkTime;
+		/**
+		 * @brief The heap memory of the parsed columns, in bytes
+		 */
+		OwUInt64 bytesAllocated;
+		/**
+		 * @brief The rows after the header
+		 */
+		OwUInt32 rowsRead;
+		/**
+		 * @brief The rows that were parsed into columns
+		 */
+		OwUInt32 rowsAccepted;
+		/**
+		 * @brief The rows that weren't, by SkipReason
+		 */
+		OwUInt32 rowsSkipped[SKIP_REASON_COUNT];
+		/**
+		 * @brief The rows that found what they refer to: an unused equipment ID,
+		 *        the equipment of a transmission, or the transmission of a BNR or BCD row
+		 */
+		OwUInt32 linkHits;
+		/**
+		 * @brief The rows that didn't, and so aren't reachable
+		 */
+		OwUInt32 linkMisses;
+		/**
+		 * @brief Why the whole sheet couldn't be read, or empty
+		 */
+		std::string error;
+	} SheetStats;
+
+	LoadStats();
+
+	/**
+	 * Zeroes every counter
+	 */
+	void clear();
+
+	/**
+	 * Zeroes the counters of one sheet
+	 */
+	static void clear( SheetStats& aSheet );
+
+	/**
+	 * @returns the rows of a sheet skipped for any reason
+	 */
+	static OwUInt32 totalSkipped( const SheetStats& aSheet );
+
+	/**
+	 * @returns the name of a reason, as written to JSON
+	 */
+	static const char* skipReasonName( SkipReason aReason );
+
+	/**
+	 * Writes the counters as a JSON object
+	 */
+	void writeJson( std::ostream& aStream ) const;
+
+	SheetStats equipment;
+	SheetStats transmissions;
+	SheetStats bnr;
+	SheetStats bcd;
+
+	/**
+	 * @brief The nanoseconds load() took from start to finish. The parse times of the
+	 *        sheets add up to more, as load() parses them at the same time
+	 */
+	OwUInt64 loadTime;
+	/**
+	 * @brief The transmissions every equipment has through wildcard rows. They are kept
+	 *        once and merged in when asked for, rather than added to every equipment
+	 */
+	OwUInt64 wildcardLinks;
+	/**
+	 * @brief The nanoseconds spent checking the sheets against each other, and the rows found not to fit
+	 */
+	OwUInt64 validateTime;
+	OwUInt32 findings;
+	/**
+	 * @brief The nanoseconds spent exporting Xml
+	 */
+	OwUInt64 exportTime;
+	/**
+	 * @brief The Xml files written
+	 */
+	OwUInt32 filesWritten;
+	/**
+	 * @brief The Xml files left alone by saveChanged, as they hadn't changed
+	 */
+	OwUInt32 filesUnchanged;
+	/**
+	 * @brief The files that couldn't be written
+	 */
+	OwUInt32 filesFailed;
+	/**
+	 * @brief The warnings printed while exporting, such as duplicate labels. They don't stop a file being written
+	 */
+	OwUInt32 exportWarnings;
+	/**
+	 * @brief Denotes whether or not saveChanged couldn't write its manifest
+	 */
+	bool manifestFailed;
+	/**
+	 * @brief The heap memory of everything loaded, in bytes
+	 */
+	OwUInt64 storeBytes;
+	/**
+	 * @brief The text fields loaded, and how many distinct strings they are. Each is kept once
+	 */
+	OwUInt64 stringsInterned;
+	OwUInt64 distinctStrings;
+	/**
+	 * @brief The heap memory of the distinct strings, part of storeBytes
+	 */
+	OwUInt64 stringBytes;
+	/**
+	 * @brief An estimate of the heap memory saved by keeping each distinct string once, rather
+	 *        than a std::string per field
+	 */
+	OwInt64 stringBytesSaved;
+};
+
+#endif
@@ -17,15 +17,15 @@
  * the prior written consent of AIT. 
  */
 
+#include "LoadedCSV.hpp"
+
 #include <iostream>
 #include <iomanip>
-#include <memory>
-#include <vector>
-#include <list>
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
 #include <sstream>
+#include <fstream>
 #include <algorithm>
 
 #include <Owl429/ArincUtil>
@@ -46,934 +46,1260 @@
 #include <Owl429/TxScheduledLabelConfig>
 #include <Owl429Utils/Xml429.hpp>
 
+#include "ChannelXml.hpp"
+#include "MappedFile.hpp"
+#include "Stopwatch.hpp"
+#include "XmlCompare.hpp"
+
 // All OWL objects are in the Owl429 namespace
 using namespace Owl429;
 
-/**
- * A class to read in data from comma seperated value files and populate Owl objects.
- */
-class LoadedCSV
-{
-public:
-
-	/**
-	 * A structure to store bnr data
-	 */
-	typedef struct BNR
-	{
-		/**
-		 * @brief The units of the data
-		 */
-		std::string units;
-		/**
-		 * @brief The range of the data
-		 */
-		std::string range;
-		/**
-		 * @brief The number of significant bits of the data
-		 */
-		OwUInt8 sigBits;
-		/**
-		 * @brief The Pos Sense of the data
-		 */
-		std::string posSense;
-		/**
-		 * @brief The resolution of the data
-		 */
-		std::string resolution;
-		/**
-		 * @brief The minimum Transit Interval of the data
-		 */
-		std::string minTransitInterval;
-		/**
-		 * @brief The value at which to set the rate in FSIM. Derived from minTransitInterval
-		 */
-		double rate;
-		/**
-		 * @brief Defines the units of the rate. ms or Hz
-		 */
-		bool isPeriod;
-		/**
-		 * @brief The maximum Transit Interval of the data
-		 */
-		std::string maxTransitInterval;
-		/**
-		 * @brief The maximum Transport Delay of the data
-		 */
-		OwUInt16 maxTransportDelay;
-	};
-
-	/**
-	 * A structure to store bcd data
-	 */
-	typedef struct BCD
-	{
-		/**
-		 * @brief The units of the data
-		 */
-		std::string units;
-		/**
-		 * @brief The range of the data
-		 */
-		std::string range;
-		/**
-		 * @brief The number of significant bits of the data
-		 */
-		OwUInt8 sigBits;
-		/**
-		 * @brief The Pos Sense of the data
-		 */
-		std::string posSense;
-		/**
-		 * @brief The resolution of the data
-		 */
-		std::string resolution;
-		/**
-		 * @brief The minimum Transit Interval of the data
-		 */
-		std::string minTransitInterval;
-		/**
-		 * @brief The value at which to set the rate in FSIM. Derived from minTransitInterval
-		 */
-		double rate;
-		/**
-		 * @brief Defines the units of the rate. ms or Hz
-		 */
-		bool isPeriod;
-		/**
-		 * @brief The maximum Transit Interval of the data
-		 */
-		std::string maxTransitInterval;
-		/**
-		 * @brief The maximum Transport Delay of the data
-		 */
-		OwUInt16 maxTransportDelay;
-	};
-
-	/**
-	 * A structure to store label data
-	 */
-	typedef struct Transmission
-	{
-		/**
-		 * @brief The 9 bit octal identifier of the label
-		 */
-		OwInt16 codeNo;
-		/**
-		 * @brief The Transmission Order Bit Position
-		 */
-		OwUInt8 transmissionOrderBitPosition;
-		/**
-		 * @brief The Parameter
-		 */
-		std::string parameter;
-		/**
-		 * @brief Denotes whether or not the data is Binary
-		 */
-		bool bnr;
-		/**
-		 * @brief Denotes whether or not the data is Binary Coded Decimal
-		 */
-		bool bcd;
-		/**
-		 * @brief Denotes whether or not the data is Discrete
-		 */
-		bool disc;
-		/**
-		 * @brief Denotes whether or not the data is System Address Label
-		 */
-		bool sal;
-		/**
-		 * @brief a pointer to the bnr data if any
-		 */
-		BNR* bnrData;
-		/**
-		 * @brief a pointer to the bcd data if any
-		 */
-		BCD* bcdData;
-	};
-
-	/**
-	 * A structure to store equipment data
-	 */
-	typedef struct Equipment
-	{
-		/**
-		 * @brief The 12 bit hexadecimal identifier for the equipment
-		 */
-		OwInt16 id;
-		/**
-		 * @brief The type of the equipment
-		 */
-		std::string type;
-		/*
-		 * @brief A list of all the transmissions the Equipment can produce.
-		 */
-		std::list<Transmission*> transmissions;
-	};
-
-	/**
-	 * Loads the equipment data from the EquipmentIDs.csv file
-	 */
-	void loadEquipmentList(const std::string& aFile )
-	{
-		if ( aFile.empty() )
-		{
-			std::invalid_argument("loadEquipmentList: argument aFile is empty");
-			return;
-		}
-
-		//Clear the equipment list
-		equipmentList.clear();
-
-		//Open the equipment file
-		FILE* pFile;
-		fopen_s( &pFile, aFile.c_str(), "r");
-		if( pFile == NULL )
-		{
-			std::invalid_argument("loadEquipmentList: The given file could not be opened");
-			return;
-		}
-
-		char line[256];
-		char field[256];
-		int charPointer;
-
-		//Read in the first line
-		fgets( line, 256, pFile );
-
-		//Compare the first line to what we expect
-		if( strcmp( line, "\"Equip ID(Hex)\",\"Equipment Type\"\n" ) != 0)
-		{
-			std::invalid_argument("loadEquipmentList: The first line of the given file was not what was expected");
-			return;
-		}
-
-		//Start reading in lines
-		while( fgets( line, 256, pFile ) != NULL )
-		{
-			//Create a new equipment structure
-			Equipment equipment;
-			equipment.id = -1;
-			charPointer = 0;
-
-			readField( line, &charPointer, field );	//Read in the ID
-			if( field[0] != '\0' )	//If we got something
-			{
-				equipment.id = (OwInt16)strtol( field, NULL, 16 );	//Parse and store
-			}
+const char* const LoadedCSV::XML_SCHEMA_FILE = "C:\\Program Files (x86)\\AIT\\ARINC-429 SDK v3.13.1\\C++ API\\xmlSchema\\AIT_429.xsd";
 
-			readField( line, &charPointer, field);	//read in the Type
-			if( field[0] != '\0' )	//We read in something
-			{
-				equipment.type = std::string(field);	//store it to the equipment
-				if( equipment.id != -1 )
-				{
-					equipmentList.push_back(equipment);		//save the equipment
-				}
-			}
-		}
+LoadedCSV::LoadedCSV()
+	: schemaFile(XML_SCHEMA_FILE)
+	, streamingXml(false)
+	, exportFormat(ChannelExporter::FORMAT_XML)
+	, queryStale(true)
+{
+}
+
+void LoadedCSV::loadEquipmentList(const std::string& aFile )
+{
+	EquipmentColumns rows;
+	parseEquipmentList( aFile, rows, statistics.equipment );
+	linkEquipmentList( rows );
+}
+
+void LoadedCSV::loadTransmissionList(const std::string& aFile )
+{
+	TransmissionColumns rows;
+	parseTransmissionList( aFile, rows, statistics.transmissions );
+	linkTransmissionList( rows );
+}
+
+void LoadedCSV::loadBnrData(const std::string& aFile )
+{
+	DataColumns rows;
+	parseBnrData( aFile, rows, statistics.bnr );
+	linkBnrData( rows );
+}
+
+void LoadedCSV::loadBcdData(const std::string& aFile )
+{
+	DataColumns rows;
+	parseBcdData( aFile, rows, statistics.bcd );
+	linkBcdData( rows );
+}
 
-		fclose(pFile);
+void LoadedCSV::load( const std::string& aEquipmentFile, const std::string& aTransmissionFile, const std::string& aBnrFile, const std::string& aBcdFile, unsigned aThreadCount )
+{
+	LoadPipeline pipeline( *this, aEquipmentFile, aTransmissionFile, aBnrFile, aBcdFile );
+	WorkerMethodTask<LoadPipeline> parseEquipment( &pipeline, &LoadPipeline::parseEquipment );
+	WorkerMethodTask<LoadPipeline> parseTransmissions( &pipeline, &LoadPipeline::parseTransmissions );
+	WorkerMethodTask<LoadPipeline> parseBnr( &pipeline, &LoadPipeline::parseBnr );
+	WorkerMethodTask<LoadPipeline> parseBcd( &pipeline, &LoadPipeline::parseBcd );
+	WorkerMethodTask<LoadPipeline> linkEquipment( &pipeline, &LoadPipeline::linkEquipment );
+	WorkerMethodTask<LoadPipeline> linkTransmissions( &pipeline, &LoadPipeline::linkTransmissions );
+	WorkerMethodTask<LoadPipeline> linkBnr( &pipeline, &LoadPipeline::linkBnr );
+	WorkerMethodTask<LoadPipeline> linkBcd( &pipeline, &LoadPipeline::linkBcd );
+
+	TaskGraph graph;
+	size_t parseEquipmentId = graph.add( &parseEquipment );
+	size_t parseTransmissionsId = graph.add( &parseTransmissions );
+	size_t parseBnrId = graph.add( &parseBnr );
+	size_t parseBcdId = graph.add( &parseBcd );
+	size_t linkEquipmentId = graph.add( &linkEquipment );
+	size_t linkTransmissionsId = graph.add( &linkTransmissions );
+	size_t linkBnrId = graph.add( &linkBnr );
+	size_t linkBcdId = graph.add( &linkBcd );
+
+	graph.addDependency( linkEquipmentId, parseEquipmentId );
+	graph.addDependency( linkTransmissionsId, parseTransmissionsId );
+	graph.addDependency( linkTransmissionsId, linkEquipmentId );
+	graph.addDependency( linkBnrId, parseBnrId );
+	graph.addDependency( linkBnrId, linkTransmissionsId );
+	graph.addDependency( linkBcdId, parseBcdId );
+	graph.addDependency( linkBcdId, linkTransmissionsId );	//BNR and BCD link into different members, so they can run together
+
+	unsigned threadCount = aThreadCount == 0 ? WorkerPool::hardwareConcurrency() : aThreadCount;
+	WorkerPool pool( threadCount < 4 ? threadCount : 4 );	//There are never more than four tasks ready at once
+	Stopwatch stopwatch;
+	pool.run( graph );
+	statistics.loadTime += stopwatch.elapsed();
+}
+
+bool LoadedCSV::compile( const std::string& aFile ) const
+{
+	A429DatabaseBuilder builder;
+
+	//The records are numbered as the rows are, so references carry over unchanged
+	for( OwUInt32 i = 0; i < store.bnr.size(); ++i )
+	{
+		builder.addBnr( toRecord( builder, store.bnrAt( i ) ) );
+	}
+	for( OwUInt32 i = 0; i < store.bcd.size(); ++i )
+	{
+		builder.addBcd( toRecord( builder, store.bcdAt( i ) ) );
+	}
+	for( OwUInt32 i = 0; i < store.transmissionCount(); ++i )
+	{
+		Transmission transmission = store.transmissionAt( i );
+		A429Database::TransmissionRecord record;
+		record.codeNo = transmission.codeNo();
+		record.transmissionOrderBitPosition = transmission.transmissionOrderBitPosition();
+		record.types = transmission.types();	//SpecStore::TypeFlags match A429Database::TypeFlags
+		record.parameter = builder.addString( transmission.parameter().str() );
+		record.bnrData = store.transmissions.bnrData[i];
+		record.bcdData = store.transmissions.bcdData[i];
+		record.equipmentId = transmission.equipmentId();
+		record.reserved = 0;
+		builder.addTransmission( record );
 	}
 
-	/**
-	 * Loads the transmission data from the LabelIDs.csv file. To be run after loadEquipmentList
-	 */
-	void loadTransmissionList(const std::string& aFile )
+	//Then the equipment, with their own transmission lists. The wildcards are found again from their IDs
+	std::vector<OwUInt32> links;
+	for( OwUInt32 i = 0; i < store.equipmentCount(); ++i )
 	{
-		if ( aFile.empty() )
+		Equipment equipment = store.equipmentAt( i );
+		std::vector<OwUInt32>::const_iterator first = store.equipment.links.begin() + store.equipment.firstLink[i];
+		links.assign( first, first + store.equipment.linkCount[i] );
+		builder.addEquipment( equipment.id(), equipment.type().str(), links );
+	}
+
+	//And the indexes, as they are
+	OwUInt32 key;
+	OwUInt32 transmission;
+	for( size_t i = 0; i < transmissionIndex.capacity(); ++i )
+	{
+		if( transmissionIndex.entry( i, key, transmission ) )
 		{
-			std::invalid_argument("loadTransmissionList: argument aFile is empty");
-			return;
+			builder.indexTransmission( (OwUInt16)(key >> 8), (OwUInt8)key, transmission );
 		}
-
-		//Clear the equipment list
-		transmissionList.clear();
-
-		//Open the label file
-		FILE* pFile;
-		fopen_s( &pFile, aFile.c_str(), "r");
-		if( pFile == NULL )
+	}
+	for( size_t label = 0; label < wildcardIndex.size(); ++label )
+	{
+		if( wildcardIndex[label] != SpecStore::NONE )
 		{
-			std::invalid_argument("loadTransmissionList: The given file could not be opened");
-			return;
+			builder.indexWildcard( (OwUInt8)label, wildcardIndex[label] );
 		}
+	}
 
-		char line[256];
-		char field[256];
-		int charPointer;
+	return builder.write( aFile );
+}
 
-		//Read in the first line
-		fgets( line, 256, pFile );
+bool LoadedCSV::loadDatabase( const std::string& aFile, bool aVerify )
+{
+	A429Database database;
+	if( !database.open( aFile ) || (aVerify && !database.verify()) )
+	{
+		return false;
+	}
 
-		//Compare the first line to what we expect
-		if( strcmp( line, "\"Code No. (Octal)\",,,\"Eqpt. ID (Hex)\",,,\"Transmission Order Bit Position\",,,,,,,,\"Parameter\",\"Data\",,,,\"Notes & Cross Ref. to Tables in Att. 6\"\n" ) != 0)
+	//Clear everything
+	store.clear();
+	queryStale = true;
+	equipmentIndex.assign( MAX_EQUIPMENT_ID + 1, (OwUInt32)SpecStore::NONE );
+	transmissionIndex.clear();
+	transmissionIndex.reserve( database.transmissionCount() );
+	wildcardIndex.assign( 256, (OwUInt32)SpecStore::NONE );
+
+	//Rebuild the columns in record order, so record numbers are row numbers
+	store.bnr.reserve( database.bnrCount() );
+	for( OwUInt32 i = 0; i < database.bnrCount(); ++i )
+	{
+		fromRecord( database, database.bnr( i ), store.bnr );
+		SpecStore::normalize( store.bnr, i, A429WordCodec::FORMAT_BNR, 0 );	//The database doesn't keep the lines of the sheet
+	}
+	store.bnr.indexWildcards();
+	store.bcd.reserve( database.bcdCount() );
+	for( OwUInt32 i = 0; i < database.bcdCount(); ++i )
+	{
+		fromRecord( database, database.bcd( i ), store.bcd );
+		SpecStore::normalize( store.bcd, i, A429WordCodec::FORMAT_BCD, 0 );
+	}
+	store.bcd.indexWildcards();
+	TransmissionColumns& transmissions = store.transmissions;
+	transmissions.reserve( database.transmissionCount() );
+	for( OwUInt32 i = 0; i < database.transmissionCount(); ++i )
+	{
+		const A429Database::TransmissionRecord& record = database.transmission( i );
+		transmissions.codeNo.push_back( record.codeNo );
+		transmissions.equipmentId.push_back( record.equipmentId );
+		transmissions.transmissionOrderBitPosition.push_back( record.transmissionOrderBitPosition );
+		transmissions.types.push_back( record.types );
+		transmissions.parameter.push_back( transmissions.strings.intern( database.string( record.parameter ) ) );
+		transmissions.bnrData.push_back( record.bnrData < database.bnrCount() ? record.bnrData : (OwUInt32)SpecStore::NONE );
+		transmissions.bcdData.push_back( record.bcdData < database.bcdCount() ? record.bcdData : (OwUInt32)SpecStore::NONE );
+		transmissions.line.push_back( 0 );
+	}
+	EquipmentColumns& equipment = store.equipment;
+	for( OwUInt32 i = 0; i < transmissions.size(); ++i )
+	{
+		if( transmissions.equipmentId[i] == SpecStore::WILDCARD_EQUIPMENT )
 		{
-			std::invalid_argument("loadTransmissionList: The first line of the given file was not what was expected");
-			return;
+			equipment.wildcardLinks.push_back( i );
 		}
+	}
+	for( OwUInt32 i = 0; i < database.equipmentCount(); ++i )
+	{
+		const A429Database::EquipmentRecord& record = database.equipment( i );
+		equipment.id.push_back( record.id );
+		equipment.type.push_back( equipment.strings.intern( database.string( record.type ) ) );
+		equipment.line.push_back( 0 );
+		equipment.firstLink.push_back( (OwUInt32)equipment.links.size() );
+		const OwUInt32* links = database.links( record );
+		for( OwUInt32 j = 0; j < record.linkCount; ++j )
+		{
+			if( links[j] < database.transmissionCount() )
+			{
+				equipment.links.push_back( links[j] );
+			}
+		}
+		equipment.linkCount.push_back( (OwUInt32)equipment.links.size() - equipment.firstLink.back() );
+		if( record.id >= 0 && record.id <= MAX_EQUIPMENT_ID && equipmentIndex[record.id] == SpecStore::NONE )
+		{
+			equipmentIndex[record.id] = i;	//The first entry for an ID wins
+		}
+	}
 
-		//Read in the second line
-		fgets( line, 256, pFile );
-		//Compare the second line to what we expect
-		if( strcmp( line, ",,,,,,1,2,3,4,5,6,7,8,,\"BNR\",\"BCD\",\"DISC\",\"SAL\",\n" ) != 0)
+	//And the indexes
+	for( OwUInt32 i = 0; i < database.indexCapacity(); ++i )
+	{
+		const A429Database::IndexSlot& slot = database.indexSlot( i );
+		if( slot.key != A429Database::NONE && slot.transmission < database.transmissionCount() )
 		{
-			std::invalid_argument("loadTransmissionList: The second line of the given file was not what was expected");
-			return;
+			transmissionIndex.insert( (OwUInt16)(slot.key >> 8), (OwUInt8)slot.key, slot.transmission );
 		}
+	}
+	for( size_t label = 0; label < wildcardIndex.size(); ++label )
+	{
+		OwUInt32 wildcard = database.wildcard( (OwUInt8)label );
+		if( wildcard < database.transmissionCount() )
+		{
+			wildcardIndex[label] = wildcard;
+		}
+	}
+	return true;
+}
 
-		//Start reading in lines
-		OwInt16 currentCodeNo = 0;
-		while( fgets( line, 256, pFile ) != NULL )
+bool LoadedCSV::verifyXml( const Equipment& aEquipment, std::string& aDifference ) const
+{
+	std::string errors;
+	std::string reference = FileUtil::joinPath( outputDirectory, fileNameOf( aEquipment ) + ".verify" );
+	saveEquipment( aEquipment, reference, errors );
+	ChannelXml streamed( schemaFile );
+	streamed.write( aEquipment, 1, errors );
+
+	std::string referenceFile = reference + ChannelXml::XML_EXTENSION;
+	bool equivalent = false;
+	{
+		MappedFile file;
+		if( file.open( referenceFile ) )
 		{
-			//Create a new transmission structure
-			Transmission transmission;
-			charPointer = 0;
+			equivalent = XmlCompare::equivalent( file.data(), file.size(), streamed.buffer().data(), streamed.buffer().size(), aDifference );
+		}
+		else
+		{
+			aDifference = "Xml429 didn't write " + referenceFile;
+		}
+	}
+	remove( referenceFile.c_str() );
+	return equivalent;
+}
 
-			readField( line, &charPointer, field );	//Read in the code No
-			if( field[0] != '\0')	//If we read something in
-			{
-				//Remove all the whitespace
-				char codeNoString[4] = "\0\0\0";
-				for( int i = 0, j = 0; field[i] != '\0'; ++i)
-				{
-					if( field[i] != ' ' )
-					{
-						codeNoString[j] = field[i];
-						++j;
-					}
-				}
+void LoadedCSV::save( unsigned aThreadCount )
+{
+	exportEquipment( aThreadCount, NULL, NULL );
+	return;
+}
 
-				//Parse it for the number and update the current Code No
-				currentCodeNo = (OwInt16)strtol( codeNoString, NULL, 8 );
-			}
-			transmission.codeNo = currentCodeNo;	//Save the code No
+size_t LoadedCSV::saveChanged( const std::string& aManifestFile, unsigned aThreadCount )
+{
+	std::map<std::string, OwUInt64> previous;
+	readManifest( aManifestFile, previous );
+	std::map<std::string, OwUInt64> current;
+	size_t written = exportEquipment( aThreadCount, &previous, &current );
+	if( !writeManifest( aManifestFile, current ) )
+	{
+		statistics.manifestFailed = true;
+	}
+	return written;
+}
 
-			readField( line, &charPointer, field );	//These two fields don't have anything
-			readField( line, &charPointer, field );
+OwUInt64 LoadedCSV::contentHashOf( const Equipment& aEquipment, const std::string& aSchemaFile, ChannelExporter::Format aFormat )
+{
+	ContentHash hash;
+	hash.add( (OwUInt32)MANIFEST_VERSION );
+	hash.add( aSchemaFile );
+	if( aFormat != ChannelExporter::FORMAT_XML )
+	{
+		hash.add( (OwUInt32)aFormat );	//Left out for Xml, so the manifests written before there were backends still match
+	}
+	hash.add( (OwUInt32)aEquipment.id() );
+	hash.add( aEquipment.type() );
+	hash.add( aEquipment.transmissionCount() );
+	for( OwUInt32 i = 0; i < aEquipment.transmissionCount(); ++i )
+	{
+		Transmission transmission = aEquipment.transmission( i );
+		hash.add( (OwUInt32)transmission.codeNo() );
+		hash.add( (OwUInt32)transmission.transmissionOrderBitPosition() );
+		hash.add( (OwUInt32)transmission.types() );
+		hash.add( transmission.parameter() );
+		addContentHash( hash, transmission.bnrData() );
+		addContentHash( hash, transmission.bcdData() );
+	}
+	return hash.value();
+}
 
-			//Read in the equipment ID
-			OwUInt16 equipmentID = 0;
-			bool wildcard = false;	//If all three digits are X or Y, then it's a wildcard
-			bool valid = true;		//If all three digits aren't numbers, unless it's a wildcard, then it's invalid
-			readField( line, &charPointer, field );	//Read in the first digit of the hardware ID
-			if( field[0] != '\0' )
-			{
-				if( field[0] != 'X' && field[0] != 'Y' && field[0] != ' ' )
-				{
-					equipmentID = equipmentID | (OwInt16)strtol( field, NULL, 16 ) << 8;
-				}
-				else if( field[0] == 'X' || field[0] == 'Y' )
-				{
-					wildcard = true;
-				}
-			}
-			readField( line, &charPointer, field );	//Read in the second digit of the hardware ID
-			if( field[0] != '\0' )
+bool LoadedCSV::saveEquipment( const Equipment& aEquipment, const std::string& aFileName, std::string& aErrors ) const
+{
+	Owl429Utils::Xml429 xml429( schemaFile.c_str() );	//Each equipment has its own, so they can be saved on different threads
+	Owl429::TxRateOrientedConfig txRateOrientedConfig = Owl429::TxRateOrientedConfig();
+	Owl429::RxChronMonConfig rxChronMonConfig = Owl429::RxChronMonConfig();
+	Owl429::LabelBufferConfig labelBufferConfig = Owl429::LabelBufferConfig(1);
+	//Set the Channel Name
+	txRateOrientedConfig.setName(aEquipment.type().str());
+	//Add the Transfers
+	for( OwUInt32 i = 0; i < aEquipment.transmissionCount(); ++i )
+	{
+		Transmission transmission = aEquipment.transmission( i );
+		Owl429::TxScheduledLabelConfig txScheduledLabelConfig = Owl429::TxScheduledLabelConfig((OwUInt8)transmission.codeNo());
+		//Set the transfer name. This may need to be updated later.
+		std::string name = transmission.parameter().str();
+		txScheduledLabelConfig.setName(name);
+		//Set some of the other values
+		BCD bcdData = transmission.bcdData();
+		BNR bnrData = transmission.bnrData();
+		if( transmission.bcd() && bcdData.isValid() )
+		{
+			//Set the Rate
+			if( bcdData.isPeriod() )
 			{
-				if( field[0] != 'X' && field[0] != 'Y' && field[0] != ' ' )
-				{
-					equipmentID = equipmentID | (OwInt16)strtol( field, NULL, 16 ) << 4;
-					if( wildcard == true )
-					{
-						valid = false;
-					}
-				}
-				else if( field[0] == 'X' || field[0] == 'Y' )
-				{
-					if( wildcard == false )
-					{
-						valid = false;
-					}
-				}
+				txScheduledLabelConfig.setTransferPeriod( (OwUInt32)bcdData.rate() );
 			}
-			readField( line, &charPointer, field );	//Read in the third digit of the hardware ID
-			if( field[0] != '\0' )
+			else
 			{
-				if( field[0] != 'X' && field[0] != 'Y' && field[0] != ' ' )
-				{
-					equipmentID = equipmentID | (OwInt16)strtol( field, NULL, 16 );
-					if( wildcard == true )
-					{
-						valid = false;
-					}
-				}
-				else if( field[0] == 'X' || field[0] == 'Y' )
-				{
-					if( wildcard == false )
-					{
-						valid = false;
-					}
-				}
+				txScheduledLabelConfig.setTransferRate( bcdData.rate() );
 			}
-
-			if( !valid )	//If it isn't valid, move on to the next transmission
+		}
+		else if( transmission.bnr() && bnrData.isValid() )
+		{
+			//Set the Rate
+			if( bnrData.isPeriod() )
 			{
-				continue;
+				txScheduledLabelConfig.setTransferPeriod( (OwUInt32)bnrData.rate() );
 			}
-
-			//Read in the Transmission Order Bit Position
-			transmission.transmissionOrderBitPosition = 0;
-			readField( line, &charPointer, field );	//Read in the first digit of the Transmission Order Bit Position
-			transmission.transmissionOrderBitPosition = transmission.transmissionOrderBitPosition | (OwInt8)strtol( field, NULL, 2 ) << 7;
-			readField( line, &charPointer, field );	//Read in the second digit of the Transmission Order Bit Position
-			transmission.transmissionOrderBitPosition = transmission.transmissionOrderBitPosition | (OwInt8)strtol( field, NULL, 2 ) << 6;
-			readField( line, &charPointer, field );	//Read in the third digit of the Transmission Order Bit Position
-			transmission.transmissionOrderBitPosition = transmission.transmissionOrderBitPosition | (OwInt8)strtol( field, NULL, 2 ) << 5;
-			readField( line, &charPointer, field );	//Read in the fourth digit of the Transmission Order Bit Position
-			transmission.transmissionOrderBitPosition = transmission.transmissionOrderBitPosition | (OwInt8)strtol( field, NULL, 2 ) << 4;
-			readField( line, &charPointer, field );	//Read in the fifth digit of the Transmission Order Bit Position
-			transmission.transmissionOrderBitPosition = transmission.transmissionOrderBitPosition | (OwInt8)strtol( field, NULL, 2 ) << 3;
-			readField( line, &charPointer, field );	//Read in the sixth digit of the Transmission Order Bit Position
-			transmission.transmissionOrderBitPosition = transmission.transmissionOrderBitPosition | (OwInt8)strtol( field, NULL, 2 ) << 2;
-			readField( line, &charPointer, field );	//Read in the seventh digit of the Transmission Order Bit Position
-			transmission.transmissionOrderBitPosition = transmission.transmissionOrderBitPosition | (OwInt8)strtol( field, NULL, 2 ) << 1;
-			readField( line, &charPointer, field );	//Read in the eighth digit of the Transmission Order Bit Position
-			transmission.transmissionOrderBitPosition = transmission.transmissionOrderBitPosition | (OwInt8)strtol( field, NULL, 2 );
-
-			//Read in the Parameter
-			readField( line, &charPointer, field );
-			transmission.parameter.assign(field);
-
-			//Read in the data types
-			readField( line, &charPointer, field );
-			transmission.bnr = field[0] == 'X';
-			readField( line, &charPointer, field );
-			transmission.bcd = field[0] == 'X';
-			readField( line, &charPointer, field );
-			transmission.disc = field[0] == 'X';
-			readField( line, &charPointer, field );
-			transmission.sal = field[0] == 'X';
-
-			transmission.bcdData = NULL;
-			transmission.bnrData = NULL;
-
-			//The next field is the notes and cross references, which aren't important
-
-			//Add the transmission to the list
-			this->transmissionList.push_back(transmission);
-
-			//Search for the equipment.
-			for( std::list<Equipment>::iterator it = this->equipmentList.begin(); it != this->equipmentList.end(); ++it )
+			else
 			{
-				if( wildcard || it->id == equipmentID )
-				{
-					it->transmissions.push_back( &(this->transmissionList.back()) );	//Add a pointer to this transmission to the equipment
-					if( !wildcard )
-					{
-						break;
-					}
-				}
+				txScheduledLabelConfig.setTransferRate( bnrData.rate() );
 			}
-
 		}
-
-		fclose(pFile);
+		else
+		{
+			//Unknown data type. (It says there is bcd/bnr data, but there isn't)
+			//This can occur when there's a typo in the csv file,
+			//like for HF COM Frequency, whose equipment id doesn't match between the Label Ids and BCD data sheets.
+			//validate() reports these as SpecValidator::MISSING_DATA
+			continue;
+		}
+		//Add the Transfer
+		try{
+			txRateOrientedConfig.addTransfer(txScheduledLabelConfig);
+		} catch ( std::invalid_argument err ){	//If the name is the same
+			//Change the name
+			std::stringstream newName;
+			newName << transmission.parameter().c_str() << " (" << transmission.codeNo() << ")";
+			name = newName.str();	//Update the name
+			txScheduledLabelConfig.setName( name );
+			//Retry
+			txRateOrientedConfig.addTransfer(txScheduledLabelConfig);
+		}
+		try{
+			rxChronMonConfig.addLabelBufferConfig((OwUInt8)(transmission.codeNo()), labelBufferConfig, name);
+		} catch ( std::invalid_argument err ){
+			aErrors.append( "Error: " );
+			aErrors.append( err.what() );
+			aErrors.append( "\n" );
+			continue;
+		}
 	}
+	txRateOrientedConfig.setMonitorConfig(rxChronMonConfig);
+
+	//Save to xml under a temporary name, so a failed save leaves the last good file. Xml429 doesn't
+	//say whether it managed to, so check the file has something in it before replacing the old one
+	std::string temporaryName = aFileName + ".saving";
+	std::string temporaryFile = temporaryName + ChannelXml::XML_EXTENSION;
+	remove( temporaryFile.c_str() );
+	try{
+		xml429.save( txRateOrientedConfig, 1, temporaryName);
+	} catch ( const std::exception& ){
+		remove( temporaryFile.c_str() );
+		return false;
+	}
+	if( !hasContent( temporaryFile ) || !FileUtil::replaceFile( temporaryFile, aFileName + ChannelXml::XML_EXTENSION ) )
+	{
+		remove( temporaryFile.c_str() );
+		return false;
+	}
+	return true;
+}
 
-	/**
-	 * Loads the bnr data from the BnrData.csv file. To be run after loadTransmissionList
-	 */
-	void loadBnrData(const std::string& aFile )
+std::string LoadedCSV::fileNameOf( const Equipment& aEquipment )
+{
+	std::stringstream xmlFileName;
+	std::string equipmentNameString = aEquipment.type().str();
+	for( size_t i = 0; i < equipmentNameString.size(); ++i )
 	{
-		if ( aFile.empty() )
+		char c = equipmentNameString[i];
+		if( c == ' ' || (unsigned char)c < 0x20 || strchr( "/\\:*?\"<>|", c ) != NULL )
 		{
-			std::invalid_argument("loadBnrData: argument aFile is empty");
-			return;
+			equipmentNameString[i] = '-';
 		}
+	}
+	char hexId[4] = "000";
+	sprintf(hexId, "%.3X", aEquipment.id());	//Convert the id to hex and pad it with zeros
+	xmlFileName << hexId << "-" << equipmentNameString;
+	return xmlFileName.str();
+}
 
-		//Open the bnr data file
-		FILE* pFile;
-		fopen_s( &pFile, aFile.c_str(), "r");
-		if( pFile == NULL )
-		{
-			std::invalid_argument("loadBnrData: The given file could not be opened");
-			return;
-		}
+const SpecQuery& LoadedCSV::query()
+{
+	if( queryStale )
+	{
+		specQuery.build( store );
+		queryStale = false;
+	}
+	return specQuery;
+}
 
-		char line[256];
-		char field[256];
-		int charPointer;
+LoadStats LoadedCSV::stats() const
+{
+	LoadStats current( statistics );
+	current.storeBytes = store.memoryUsage();
+	const StringPool* pools[4] = { &store.equipment.strings, &store.transmissions.strings, &store.bnr.strings, &store.bcd.strings };
+	for( int i = 0; i < 4; ++i )
+	{
+		current.stringsInterned += pools[i]->requests();
+		current.distinctStrings += pools[i]->size();
+		current.stringBytes += pools[i]->memoryUsage();
+		current.stringBytesSaved += pools[i]->savedBytes();
+	}
+	return current;
+}
 
-		//Read in the first line
-		fgets( line, 256, pFile );
+bool LoadedCSV::validate( std::vector<SpecValidator::Finding>& aFindings, unsigned aThreadCount )
+{
+	Stopwatch stopwatch;
+	SpecValidator validator;
+	validator.validate( store, aFindings, aThreadCount );
+	statistics.validateTime += stopwatch.elapsed();
+	statistics.findings = (OwUInt32)aFindings.size();
+	return aFindings.empty();
+}
+
+LoadedCSV::Equipment LoadedCSV::findEquipment( OwUInt16 aEquipmentId ) const
+{
+	if( aEquipmentId >= equipmentIndex.size() || equipmentIndex[aEquipmentId] == SpecStore::NONE )
+	{
+		return Equipment();
+	}
+	return store.equipmentAt( equipmentIndex[aEquipmentId] );
+}
 
-		//Compare the first line to what we expect
-		if( strcmp( line, "\"Label\",\"Eqpt ID(Hex)\",\"Parameter Name\",\"Units\",\"Range(Scale)\",\"Sig Bits\",\"Pos Sense\",\"Resolution\",\"Min Transit Interval(msec) 2\",\"Max Transit Interval(msec) 2\",\"Max Trans-port Delay(msec) 3\",\"Notes & Cross Ref. to Tables and Attachments\"\n" ) != 0)
+LoadedCSV::Transmission LoadedCSV::findTransmission( OwUInt16 aEquipmentId, OwUInt8 aLabel ) const
+{
+	OwUInt32 row = findTransmissionRow( aEquipmentId, aLabel );
+	if( row == SpecStore::NONE )
+	{
+		return Transmission();
+	}
+	return store.transmissionAt( row );
+}
+
+bool LoadedCSV::describe( const Transmission& aTransmission, A429WordCodec::Descriptor& aDescriptor )
+{
+	BNR bnrData = aTransmission.bnrData();
+	if( aTransmission.bnr() && bnrData.isValid() )
+	{
+		aDescriptor.format = A429WordCodec::FORMAT_BNR;
+		aDescriptor.sigBits = bnrData.sigBits();
+		aDescriptor.lsb = bnrData.lsb();
+		return aDescriptor.lsb > 0;
+	}
+	BCD bcdData = aTransmission.bcdData();
+	if( aTransmission.bcd() && bcdData.isValid() )
+	{
+		aDescriptor.format = A429WordCodec::FORMAT_BCD;
+		aDescriptor.sigBits = bcdData.sigBits();
+		aDescriptor.lsb = bcdData.lsb();
+		return aDescriptor.lsb > 0;
+	}
+	return false;
+}
+
+bool LoadedCSV::buildDispatchTable( OwUInt16 aEquipmentId, LabelDispatchTable& aTable ) const
+{
+	aTable.clear();
+	if( !findEquipment( aEquipmentId ).isValid() )
+	{
+		return false;
+	}
+	for( int label = 0; label < 256; ++label )
+	{
+		Transmission transmission = findTransmission( aEquipmentId, (OwUInt8)label );
+		A429WordCodec::Descriptor descriptor;
+		if( transmission.isValid() && describe( transmission, descriptor ) )
 		{
-			std::invalid_argument("loadBnrData: The first line of the given file was not what was expected");
-			return;
+			aTable.mapAllSdi( (OwUInt8)label, aTable.addDescriptor( descriptor, transmission.parameter().str() ) );
 		}
+	}
+	return true;
+}
 
-		//Start reading in lines
-		OwInt16 currentLabel = 0;
-		while( fgets( line, 256, pFile ) != NULL )
-		{
-			if(strcmp(line, ",,,,,,,,,,,\n") == 0 || !(line[0] == '\"' || line[0] == ',') || strlen(line) < 12 )	//If it's an empty line, or if it's invalidly formatted
-			{
-				continue;
-			}
-			bool valid = true;
+A429Database::DataRecord LoadedCSV::toRecord( A429DatabaseBuilder& aBuilder, const SpecStore::DataView& aData )
+{
+	A429Database::DataRecord record;
+	record.units = aBuilder.addString( aData.units().str() );
+	record.range = aBuilder.addString( aData.range().str() );
+	record.posSense = aBuilder.addString( aData.posSense().str() );
+	record.resolution = aBuilder.addString( aData.resolution().str() );
+	record.minTransitInterval = aBuilder.addString( aData.minTransitInterval().str() );
+	record.maxTransitInterval = aBuilder.addString( aData.maxTransitInterval().str() );
+	record.rate = aData.rate();
+	record.maxTransportDelay = aData.maxTransportDelay();
+	record.sigBits = aData.sigBits();
+	record.isPeriod = aData.isPeriod() ? 1 : 0;
+	record.equipmentId = aData.equipmentId();
+	record.label = aData.label();
+	record.reserved = 0;
+	return record;
+}
+
+void LoadedCSV::fromRecord( const A429Database& aDatabase, const A429Database::DataRecord& aRecord, DataColumns& aColumns )
+{
+	aColumns.equipmentId.push_back( aRecord.equipmentId );
+	aColumns.label.push_back( aRecord.label );
+	aColumns.units.push_back( aColumns.strings.intern( aDatabase.string( aRecord.units ) ) );
+	aColumns.range.push_back( aColumns.strings.intern( aDatabase.string( aRecord.range ) ) );
+	aColumns.sigBits.push_back( aRecord.sigBits );
+	aColumns.posSense.push_back( aColumns.strings.intern( aDatabase.string( aRecord.posSense ) ) );
+	aColumns.resolution.push_back( aColumns.strings.intern( aDatabase.string( aRecord.resolution ) ) );
+	aColumns.minTransitInterval.push_back( aColumns.strings.intern( aDatabase.string( aRecord.minTransitInterval ) ) );
+	aColumns.rate.push_back( aRecord.rate );
+	aColumns.isPeriod.push_back( aRecord.isPeriod != 0 ? 1 : 0 );
+	aColumns.maxTransitInterval.push_back( aColumns.strings.intern( aDatabase.string( aRecord.maxTransitInterval ) ) );
+	aColumns.maxTransportDelay.push_back( aRecord.maxTransportDelay );
+}
+
+OwUInt32 LoadedCSV::findTransmissionRow( OwUInt16 aEquipmentId, OwUInt8 aLabel ) const
+{
+	if( !findEquipment( aEquipmentId ).isValid() )
+	{
+		return SpecStore::NONE;
+	}
+	OwUInt32 row = SpecStore::NONE;
+	if( transmissionIndex.find( aEquipmentId, aLabel, row ) )
+	{
+		return row;
+	}
+	if( wildcardIndex.empty() )
+	{
+		return SpecStore::NONE;
+	}
+	return wildcardIndex[aLabel];
+}
 
-			//Create a new bnr structure
-			BNR bnr;
-			charPointer = 0;
+size_t LoadedCSV::exportEquipment( unsigned aThreadCount, const std::map<std::string, OwUInt64>* aPrevious, std::map<std::string, OwUInt64>* aCurrent )
+{
+	Stopwatch stopwatch;
+	//Work out the file names up front. If two equipment share a name the last one
+	//is written, as it would overwrite the others when saved one after another
+	std::vector<ExportTask> tasks;
+	tasks.reserve( store.equipmentCount() );
+	std::map<std::string, size_t> lastWithName;
+	for( OwUInt32 i = 0; i < store.equipmentCount(); ++i )
+	{
+		tasks.push_back( ExportTask( *this, store.equipmentAt( i ) ) );
+		lastWithName[tasks.back().fileName] = tasks.size() - 1;
+	}
 
-			readField( line, &charPointer, field );	//Read in the label
-			if( field[0] != '\0')	//If we read something in
+	//The extension the files of the format are saved with, to check they are still there
+	ChannelExporter* exporter = ChannelExporter::create( exportFormat, schemaFile );
+	std::string extension = exporter->extension();
+	delete exporter;
+
+	std::vector<ExportTask*> selected;
+	for( size_t i = 0; i < tasks.size(); ++i )
+	{
+		if( lastWithName[tasks[i].fileName] != i )
+		{
+			continue;
+		}
+		if( aCurrent != NULL || aPrevious != NULL )
+		{
+			tasks[i].hash = contentHashOf( tasks[i].equipment, schemaFile, exportFormat );
+			if( aPrevious != NULL )
 			{
-				//Remove all the whitespace
-				char labelString[4] = "\0\0\0";
-				for( int i = 0, j = 0; field[i] != '\0'; ++i)
+				std::map<std::string, OwUInt64>::const_iterator found = aPrevious->find( tasks[i].fileName );
+				if( found != aPrevious->end() && found->second == tasks[i].hash
+					&& hasContent( FileUtil::joinPath( outputDirectory, tasks[i].fileName ) + extension ) )
 				{
-					if( field[i] != ' ' )
+					++statistics.filesUnchanged;
+					if( aCurrent != NULL )
 					{
-						if( j > 3 )
-						{
-							valid = false;
-							break;
-						}
-						labelString[j] = field[i];
-						++j;
+						(*aCurrent)[tasks[i].fileName] = tasks[i].hash;
 					}
+					continue;	//Unchanged since it was last written
 				}
-				if( !valid ) {continue;}	//Improperly formatted label. Skip this entry
-				//Parse it for the number and update the current Label
-				currentLabel = (OwInt16)strtol( labelString, NULL, 8 );
 			}
+		}
+		selected.push_back( &tasks[i] );
+	}
 
+	TaskGraph graph;
+	std::vector<StreamingExportTask> batches;
+	if( streamingXml || exportFormat != ChannelExporter::FORMAT_XML )
+	{
+		//One writer per thread, each given an equal share of the files, so its buffers are reused
+		unsigned threadCount = aThreadCount == 0 ? WorkerPool::hardwareConcurrency() : aThreadCount;
+		batches.assign( threadCount < selected.size() ? threadCount : selected.size(), StreamingExportTask( *this ) );
+		for( size_t i = 0; i < selected.size(); ++i )
+		{
+			batches[i % batches.size()].tasks.push_back( selected[i] );
+		}
+		for( size_t i = 0; i < batches.size(); ++i )
+		{
+			graph.add( &batches[i] );
+		}
+	}
+	else
+	{
+		for( size_t i = 0; i < selected.size(); ++i )
+		{
+			graph.add( selected[i] );
+		}
+	}
+	WorkerPool pool( aThreadCount );
+	pool.run( graph );
 
-
-			readField( line, &charPointer, field );	//Read in the equipment ID
-			OwUInt16 equipmentID = 0;
-			bool wildcard = false;
-			if( field[0] != '\0')	//If we read something in
+	//Report the errors in equipment order. Only a file that couldn't be written has failed
+	OwUInt32 failed = 0;
+	for( size_t i = 0; i < tasks.size(); ++i )
+	{
+		fputs( tasks[i].errors.c_str(), stdout );
+		statistics.exportWarnings += (OwUInt32)std::count( tasks[i].errors.begin(), tasks[i].errors.end(), '\n' );
+		if( tasks[i].failed )
+		{
+			printf( "Error: The file of %s could not be written\n", tasks[i].fileName.c_str() );
+			++failed;
+		}
+	}
+	statistics.filesFailed += failed;
+	if( aCurrent != NULL )
+	{
+		//Only the files written are up to date
+		for( size_t i = 0; i < selected.size(); ++i )
+		{
+			if( !selected[i]->failed )
 			{
-				//Remove all the whitespace
-				char idString[4] = "\0\0\0";
-				for( int i = 0, j = 0; field[i] != '\0'; ++i)
-				{
-					if( field[i] != ' ' )
-					{
-						if( j > 3 )
-						{
-							valid = false;
-							break;
-						}
-						idString[j] = field[i];
-						++j;
-					}
-				}
-				if( !valid ) {continue;}	//Improperly formatted label. Skip this entry
-
-				//Parse it for the number and update the equipment Id
-				if( strcmp(idString, "XXX") == 0 || strcmp(idString, "YYY") == 0)
-				{
-					wildcard = true;
-					continue;	//Skip the wildcard ones. I'll leave the code that deals with them in though.
-				}
-				else
-				{
-					equipmentID = (OwInt16)strtol( idString, NULL, 16 );
-				}
+				(*aCurrent)[selected[i]->fileName] = selected[i]->hash;
 			}
+		}
+	}
+	statistics.filesWritten += (OwUInt32)selected.size() - failed;
+	statistics.exportTime += stopwatch.elapsed();
+	return selected.size();
+}
 
-			readField( line, &charPointer, field );	//Read in the Parameter Name, but this is redundant info, so don't do anything with it.
-
-			readField( line, &charPointer, field );	//Read in the units
-			bnr.units.assign(field);
-
-			readField( line, &charPointer, field );	//Read in the range
-			bnr.range.assign(field);
-
-			readField( line, &charPointer, field );	//Read in the sig bits
-			bnr.sigBits = 0;
-			bnr.sigBits = (OwInt8)strtol( field, NULL, 10 );
-
-			readField( line, &charPointer, field );	//Read in the pos sense
-			bnr.posSense.assign(field);
-
-			readField( line, &charPointer, field );	//Read in the resolution
-			bnr.resolution.assign(field);
+bool LoadedCSV::hasContent( const std::string& aFile )
+{
+	std::ifstream file( aFile.c_str() );
+	return file.peek() != EOF;
+}
 
-			readField( line, &charPointer, field );	//Read in the min transit interval
-			bnr.minTransitInterval.assign(field);
+void LoadedCSV::addContentHash( ContentHash& aHash, const SpecStore::DataView& aData )
+{
+	if( !aData.isValid() )
+	{
+		aHash.add( (OwUInt32)0 );
+		return;
+	}
+	aHash.add( (OwUInt32)1 );
+	aHash.add( aData.units() );
+	aHash.add( aData.range() );
+	aHash.add( (OwUInt32)aData.sigBits() );
+	aHash.add( aData.posSense() );
+	aHash.add( aData.resolution() );
+	aHash.add( aData.minTransitInterval() );
+	aHash.add( aData.rate() );
+	aHash.add( (OwUInt32)(aData.isPeriod() ? 1 : 0) );
+	aHash.add( aData.maxTransitInterval() );
+	aHash.add( (OwUInt32)aData.maxTransportDelay() );
+}
+
+void LoadedCSV::readManifest( const std::string& aFile, std::map<std::string, OwUInt64>& aHashes )
+{
+	std::ifstream manifest( aFile.c_str() );
+	std::string line;
+	std::stringstream expected;
+	expected << "a429manifest " << MANIFEST_VERSION;
+	if( !std::getline( manifest, line ) || line != expected.str() )
+	{
+		return;	//Not a manifest of this version, so everything is rewritten
+	}
+	while( std::getline( manifest, line ) )
+	{
+		//Each line is the hash in hex, a space, then the file name
+		size_t space = line.find( ' ' );
+		if( space == std::string::npos )
+		{
+			continue;
+		}
+		std::istringstream hashText( line.substr( 0, space ) );
+		OwUInt64 hash;
+		if( hashText >> std::hex >> hash )
+		{
+			aHashes[line.substr( space + 1 )] = hash;
+		}
+	}
+}
 
-			bnr.rate = 0;
-			bnr.isPeriod = true;
+bool LoadedCSV::writeManifest( const std::string& aFile, const std::map<std::string, OwUInt64>& aHashes )
+{
+	std::ofstream manifest( aFile.c_str(), std::ios::out | std::ios::trunc );
+	if( !manifest )
+	{
+		return false;
+	}
+	manifest << "a429manifest " << MANIFEST_VERSION << "\n";
+	for( std::map<std::string, OwUInt64>::const_iterator it = aHashes.begin(); it != aHashes.end(); ++it )
+	{
+		manifest << std::hex << std::setw( 16 ) << std::setfill( '0' ) << it->second << " " << it->first << "\n";
+	}
+	manifest.close();
+	return !manifest.fail();
+}
 
-			bnr.rate = strtod( field, NULL );
-			if( bnr.rate == 0 )
-			{
-				//The rate is unknown. Skip this bnr
-				continue;
-			}
-			bnr.isPeriod = strstr(field, "Hz") == NULL;	//Check if it's in Hz
-			if( strstr( field, "." ) != NULL && bnr.isPeriod == true )	//Check if it's a period with a decimal point
-			{
-				bnr.rate = 1000 / bnr.rate;	//Convert to Hz
-				bnr.isPeriod = false;
-			}
+void LoadedCSV::parseEquipmentList( const std::string& aFile, EquipmentColumns& aRows, LoadStats::SheetStats& aStats )
+{
+	Stopwatch stopwatch;
+	if ( aFile.empty() )
+	{
+		aStats.error = "loadEquipmentList: argument aFile is empty";
+		return;
+	}
 
-			readField( line, &charPointer, field );	//Read in the max transit interval
-			bnr.maxTransitInterval.assign(field);
+	//Map the equipment file
+	MappedFile file;
+	if( !file.open( aFile ) )
+	{
+		aStats.error = "loadEquipmentList: The given file could not be opened";
+		return;
+	}
+	aStats.bytes += file.size();
+	CsvReader reader( file.data(), file.size() );
+	std::vector<CsvField> row;
+	CsvField field;
 
-			readField( line, &charPointer, field );	//Read in the max transport delay
-			bnr.maxTransportDelay = 0;
-			if( field[0] != '\0' )
-			{
-				bnr.maxTransportDelay = (OwUInt16)strtol( field, NULL, 10);
-			}
+	//Read in the first line
+	reader.nextRow( row );
 
-			//Add the bnr to the list
-			this->bnrList.push_back(bnr);
-			BNR* bnrReference = &(this->bnrList.back());
+	//Compare the first line to what we expect
+	static const char* const header[] = { "Equip ID(Hex)", "Equipment Type" };
+	if( !CsvReader::matches( row, header, sizeof(header) / sizeof(header[0]) ) )
+	{
+		aStats.error = "loadEquipmentList: The first line of the given file was not what was expected";
+		return;
+	}
 
-			//Search for the equipment.
-			bool breakFlag = false;
-			for( std::list<Equipment>::iterator it = this->equipmentList.begin(); it != this->equipmentList.end() && !breakFlag; ++it )
-			{
-				if( wildcard || it->id == equipmentID )
-				{
-					for( std::list<Transmission*>::iterator it2 = it->transmissions.begin(); it2 != it->transmissions.end(); ++it2 )	//Search for the label
-					{
-						if( (*it2)->codeNo == currentLabel )
-						{
-							(*it2)->bnrData = bnrReference;	//Add the bnr reference
-							breakFlag = true;
-							break;
-						}
-					}
-				}
-			}
+	//Start reading in lines
+	while( reader.nextRow( row ) )
+	{
+		++aStats.rowsRead;
+		OwInt16 id = -1;
 
+		field = CsvReader::field( row, 0 );	//Read in the ID
+		if( !field.empty() )	//If we got something
+		{
+			id = (OwInt16)field.toLong( 16 );	//Parse and store
 		}
 
-		fclose(pFile);
+		field = CsvReader::field( row, 1 );	//read in the Type
+		if( !field.empty() && id != -1 )	//We read in something
+		{
+			//save the equipment
+			aRows.id.push_back( id );
+			aRows.type.push_back( intern( aRows.strings, field ) );
+			aRows.line.push_back( (OwUInt32)reader.rowLine() );
+			++aStats.rowsAccepted;
+		}
+		else
+		{
+			++aStats.rowsSkipped[CsvReader::isBlank( row ) ? LoadStats::SKIP_BLANK_ROW : LoadStats::SKIP_MISSING_FIELD];
+		}
 	}
+	aStats.bytesAllocated += aRows.memoryUsage();
+	aStats.parseTime += stopwatch.elapsed();
+}
 
-	/**
-	 * Loads the bcd data from the BcdData.csv file. To be run after loadTransmissionList
-	 */
-	void loadBcdData(const std::string& aFile )
+void LoadedCSV::linkEquipmentList( EquipmentColumns& aRows )
+{
+	Stopwatch stopwatch;
+	//Take the parsed columns as they are, nothing is copied. The equipment have no transmissions yet
+	store.equipment.swap( aRows );
+	queryStale = true;
+	aRows.clear();
+	store.equipment.firstLink.assign( store.equipment.size(), 0 );
+	store.equipment.linkCount.assign( store.equipment.size(), 0 );
+	store.equipment.links.clear();
+	store.equipment.wildcardLinks.clear();
+
+	equipmentIndex.assign( MAX_EQUIPMENT_ID + 1, (OwUInt32)SpecStore::NONE );
+	for( OwUInt32 i = 0; i < store.equipment.size(); ++i )
 	{
-		if ( aFile.empty() )
+		OwInt16 id = store.equipment.id[i];
+		if( id >= 0 && id <= MAX_EQUIPMENT_ID && equipmentIndex[id] == SpecStore::NONE )
 		{
-			std::invalid_argument("loadBcdData: argument aFile is empty");
-			return;
+			equipmentIndex[id] = i;	//The first entry for an ID wins
+			++statistics.equipment.linkHits;
 		}
-
-		//Open the bnr data file
-		FILE* pFile;
-		fopen_s( &pFile, aFile.c_str(), "r");
-		if( pFile == NULL )
+		else
 		{
-			std::invalid_argument("loadBcdData: The given file could not be opened");
-			return;
+			++statistics.equipment.linkMisses;
 		}
+	}
+	statistics.equipment.linkTime += stopwatch.elapsed();
+}
 
-		char line[256];
-		char field[256];
-		int charPointer;
+void LoadedCSV::parseTransmissionList( const std::string& aFile, TransmissionColumns& aRows, LoadStats::SheetStats& aStats )
+{
+	Stopwatch stopwatch;
+	if ( aFile.empty() )
+	{
+		aStats.error = "loadTransmissionList: argument aFile is empty";
+		return;
+	}
 
-		//Read in the first line
-		fgets( line, 256, pFile );
+	//Map the label file
+	MappedFile file;
+	if( !file.open( aFile ) )
+	{
+		aStats.error = "loadTransmissionList: The given file could not be opened";
+		return;
+	}
+	aStats.bytes += file.size();
+	CsvReader reader( file.data(), file.size() );
+	std::vector<CsvField> row;
+	CsvField field;
 
-		//Compare the first line to what we expect
-		if( strcmp( line, "\"Label\",\"Eqpt ID(Hex)\",\"Parameter Name\",\"Units\",\"Range(Scale)\",\"Sig Bits\",\"Pos Sense\",\"Resolution\",\"Min Transit Interval(msec) 2\",\"Max Transit Interval(msec) 2\",\"Max Trans-port Delay(msec) 3\",\"Notes & Cross Ref. to Tables and Attachments\"\n" ) != 0)
-		{
-			std::invalid_argument("loadBcdData: The first line of the given file was not what was expected");
-			return;
-		}
+	//Read in the first line
+	reader.nextRow( row );
+
+	//Compare the first line to what we expect
+	static const char* const header[] = { "Code No. (Octal)", "", "", "Eqpt. ID (Hex)", "", "", "Transmission Order Bit Position", "", "", "", "", "", "", "", "Parameter", "Data", "", "", "", "Notes & Cross Ref. to Tables in Att. 6" };
+	if( !CsvReader::matches( row, header, sizeof(header) / sizeof(header[0]) ) )
+	{
+		aStats.error = "loadTransmissionList: The first line of the given file was not what was expected";
+		return;
+	}
+
+	//Read in the second line
+	reader.nextRow( row );
+	//Compare the second line to what we expect
+	static const char* const subHeader[] = { "", "", "", "", "", "", "1", "2", "3", "4", "5", "6", "7", "8", "", "BNR", "BCD", "DISC", "SAL", "" };
+	if( !CsvReader::matches( row, subHeader, sizeof(subHeader) / sizeof(subHeader[0]) ) )
+	{
+		aStats.error = "loadTransmissionList: The second line of the given file was not what was expected";
+		return;
+	}
 
-		//Start reading in lines
-		OwInt16 currentLabel = 0;
-		while( fgets( line, 256, pFile ) != NULL )
+	//Start reading in lines
+	OwInt16 currentCodeNo = 0;
+	while( reader.nextRow( row ) )
+	{
+		++aStats.rowsRead;
+		field = CsvReader::field( row, 0 );	//Read in the code No
+		if( !field.empty() )	//If we read something in
 		{
-			if(strcmp(line, ",,,,,,,,,,,\n") == 0 || !(line[0] == '\"' || line[0] == ',') || strlen(line) < 12 )	//If it's an empty line, or if it's invalidly formatted
+			//Remove all the whitespace
+			char codeNoString[4];
+			if( !field.compact( codeNoString, 3 ) )
 			{
-				continue;
+				++aStats.rowsSkipped[LoadStats::SKIP_BAD_LABEL];
+				continue;	//Improperly formatted code No. Skip this entry
 			}
-			bool valid = true;
-
-			//Create a new bnr structure
-			BCD bcd;
-			charPointer = 0;
 
-			readField( line, &charPointer, field );	//Read in the label
-			if( field[0] != '\0')	//If we read something in
+			//Parse it for the number and update the current Code No
+			currentCodeNo = (OwInt16)strtol( codeNoString, NULL, 8 );
+		}
+		//The next two fields don't have anything
+
+		//Read in the equipment ID
+		OwUInt16 equipmentID = 0;
+		bool wildcard = false;	//If all three digits are X or Y, then it's a wildcard
+		bool valid = true;		//If all three digits aren't numbers, unless it's a wildcard, then it's invalid
+		field = CsvReader::field( row, 3 );	//Read in the first digit of the hardware ID
+		if( !field.empty() )
+		{
+			if( field.front() != 'X' && field.front() != 'Y' && field.front() != ' ' )
+			{
+				equipmentID = equipmentID | (OwInt16)field.toLong( 16 ) << 8;
+			}
+			else if( field.front() == 'X' || field.front() == 'Y' )
+			{
+				wildcard = true;
+			}
+		}
+		field = CsvReader::field( row, 4 );	//Read in the second digit of the hardware ID
+		if( !field.empty() )
+		{
+			if( field.front() != 'X' && field.front() != 'Y' && field.front() != ' ' )
 			{
-				//Remove all the whitespace
-				char labelString[4] = "\0\0\0";
-				for( int i = 0, j = 0; field[i] != '\0'; ++i)
+				equipmentID = equipmentID | (OwInt16)field.toLong( 16 ) << 4;
+				if( wildcard == true )
 				{
-					if( field[i] != ' ' )
-					{
-						if( j > 3 )
-						{
-							valid = false;
-							break;
-						}
-						labelString[j] = field[i];
-						++j;
-					}
+					valid = false;
 				}
-				if( !valid ) {continue;}	//Improperly formatted label. Skip this entry
-				//Parse it for the number and update the current Label
-				currentLabel = (OwInt16)strtol( labelString, NULL, 8 );
 			}
-
-
-
-			readField( line, &charPointer, field );	//Read in the equipment ID
-			OwUInt16 equipmentID = 0;
-			bool wildcard = false;
-			if( field[0] != '\0')	//If we read something in
+			else if( field.front() == 'X' || field.front() == 'Y' )
 			{
-				//Remove all the whitespace
-				char idString[4] = "\0\0\0";
-				for( int i = 0, j = 0; field[i] != '\0'; ++i)
+				if( wildcard == false )
 				{
-					if( field[i] != ' ' )
-					{
-						if( j > 3 )
-						{
-							valid = false;
-							break;
-						}
-						idString[j] = field[i];
-						++j;
-					}
+					valid = false;
 				}
-				if( !valid ) {continue;}	//Improperly formatted label. Skip this entry
-
-				//Parse it for the number and update the equipment Id
-				if( strcmp(idString, "XXX") == 0 || strcmp(idString, "YYY") == 0)
+			}
+		}
+		field = CsvReader::field( row, 5 );	//Read in the third digit of the hardware ID
+		if( !field.empty() )
+		{
+			if( field.front() != 'X' && field.front() != 'Y' && field.front() != ' ' )
+			{
+				equipmentID = equipmentID | (OwInt16)field.toLong( 16 );
+				if( wildcard == true )
 				{
-					wildcard = true;
-					continue;	//Skip the wildcard ones. I'll leave the code that deals with them in though.
+					valid = false;
 				}
-				else
+			}
+			else if( field.front() == 'X' || field.front() == 'Y' )
+			{
+				if( wildcard == false )
 				{
-					equipmentID = (OwInt16)strtol( idString, NULL, 16 );
+					valid = false;
 				}
 			}
+		}
 
-			readField( line, &charPointer, field );	//Read in the Parameter Name, but this is redundant info, so don't do anything with it.
-
-			readField( line, &charPointer, field );	//Read in the units
-			bcd.units.assign(field);
-
-			readField( line, &charPointer, field );	//Read in the range
-			bcd.range.assign(field);
-
-			readField( line, &charPointer, field );	//Read in the sig bits
-			bcd.sigBits = 0;
-			bcd.sigBits = (OwInt8)strtol( field, NULL, 10 );
-
-			readField( line, &charPointer, field );	//Read in the pos sense
-			bcd.posSense.assign(field);
-
-			readField( line, &charPointer, field );	//Read in the resolution
-			bcd.resolution.assign(field);
-
-			readField( line, &charPointer, field );	//Read in the min transit interval
-			bcd.minTransitInterval.assign(field);
-
-			bcd.rate = 0;
-			bcd.isPeriod = true;
+		if( !valid )	//If it isn't valid, move on to the next transmission
+		{
+			++aStats.rowsSkipped[LoadStats::SKIP_INVALID_WILDCARD];
+			continue;
+		}
 
-			bcd.rate = strtod( field, NULL );
-			if( bcd.rate == 0 )
+		//Read in the Transmission Order Bit Position, most significant digit first. Nearly every
+		//digit is a lone 0 or 1, so only the others are parsed
+		OwUInt8 transmissionOrderBitPosition = 0;
+		for( int bit = 0; bit < 8; ++bit )
+		{
+			field = CsvReader::field( row, 6 + bit );
+			OwInt8 digit;
+			if( field.length == 1 && (field.data[0] == '0' || field.data[0] == '1') )
 			{
-				//The rate is unknown. Skip this bnr
-				continue;
+				digit = (OwInt8)(field.data[0] - '0');
 			}
-			bcd.isPeriod = strstr( field, "Hz") == NULL;	//Check if it's in Hz
-			if( strstr( field, "." ) != NULL && bcd.isPeriod == true )	//Check if it's a period with a decimal point
+			else
 			{
-				bcd.rate = 1000 / bcd.rate;	//Convert to Hz
-				bcd.isPeriod = false;
+				digit = (OwInt8)field.toLong( 2 );
 			}
+			transmissionOrderBitPosition = transmissionOrderBitPosition | digit << (7 - bit);
+		}
 
-			readField( line, &charPointer, field );	//Read in the max transit interval
-			bcd.maxTransitInterval.assign(field);
+		//Read in the data types
+		OwUInt8 types = 0;
+		types |= CsvReader::field( row, 15 ).front() == 'X' ? SpecStore::TYPE_BNR : 0;
+		types |= CsvReader::field( row, 16 ).front() == 'X' ? SpecStore::TYPE_BCD : 0;
+		types |= CsvReader::field( row, 17 ).front() == 'X' ? SpecStore::TYPE_DISC : 0;
+		types |= CsvReader::field( row, 18 ).front() == 'X' ? SpecStore::TYPE_SAL : 0;
+
+		//The next field is the notes and cross references, which aren't important
+
+		//Stage the transmission, and where it belongs
+		aRows.codeNo.push_back( currentCodeNo );
+		aRows.equipmentId.push_back( wildcard ? (OwUInt16)SpecStore::WILDCARD_EQUIPMENT : equipmentID );
+		aRows.transmissionOrderBitPosition.push_back( transmissionOrderBitPosition );
+		aRows.types.push_back( types );
+		aRows.parameter.push_back( intern( aRows.strings, CsvReader::field( row, 14 ) ) );	//Read in the Parameter
+		aRows.bnrData.push_back( (OwUInt32)SpecStore::NONE );
+		aRows.bcdData.push_back( (OwUInt32)SpecStore::NONE );
+		aRows.line.push_back( (OwUInt32)reader.rowLine() );
+		++aStats.rowsAccepted;
+	}
+	aStats.bytesAllocated += aRows.memoryUsage();
+	aStats.parseTime += stopwatch.elapsed();
+}
 
-			readField( line, &charPointer, field );	//Read in the max transport delay
-			bcd.maxTransportDelay = 0;
-			if( field[0] != '\0' )
+void LoadedCSV::linkTransmissionList( TransmissionColumns& aRows )
+{
+	Stopwatch stopwatch;
+	//Take the parsed columns as they are, nothing is copied
+	store.transmissions.swap( aRows );
+	queryStale = true;
+	aRows.clear();
+	const TransmissionColumns& transmissions = store.transmissions;
+	EquipmentColumns& equipment = store.equipment;
+
+	transmissionIndex.clear();
+	transmissionIndex.reserve( transmissions.size() );
+	wildcardIndex.assign( 256, (OwUInt32)SpecStore::NONE );
+
+	//Count the transmissions of each equipment, so each gets a contiguous run of links.
+	//Wildcards belong to every equipment, so they are kept once rather than in every run
+	std::vector<OwUInt32> equipmentOf( transmissions.size(), (OwUInt32)SpecStore::NONE );
+	equipment.linkCount.assign( equipment.size(), 0 );
+	equipment.wildcardLinks.clear();
+	OwUInt32 unmatched = 0;
+	for( OwUInt32 i = 0; i < transmissions.size(); ++i )
+	{
+		if( transmissions.equipmentId[i] == SpecStore::WILDCARD_EQUIPMENT )
+		{
+			equipment.wildcardLinks.push_back( i );
+		}
+		else
+		{
+			Equipment owner = findEquipment( transmissions.equipmentId[i] );
+			if( owner.isValid() )
 			{
-				bcd.maxTransportDelay = (OwUInt16)strtol( field, NULL, 10);
+				equipmentOf[i] = owner.index();
+				++equipment.linkCount[owner.index()];
 			}
-
-			//Add the bnr to the list
-			this->bcdList.push_back(bcd);
-			BCD* bcdReference = &(this->bcdList.back());
-
-			//Search for the equipment.
-			bool breakFlag = false;
-			for( std::list<Equipment>::iterator it = this->equipmentList.begin(); it != this->equipmentList.end() && !breakFlag; ++it )
+			else
 			{
-				if( wildcard || it->id == equipmentID )
-				{
-					for( std::list<Transmission*>::iterator it2 = it->transmissions.begin(); it2 != it->transmissions.end(); ++it2 )	//Search for the label
-					{
-						if( (*it2)->codeNo == currentLabel )
-						{
-							(*it2)->bcdData = bcdReference;	//Add the bnr reference
-							breakFlag = true;
-							break;
-						}
-					}
-				}
+				++unmatched;	//No equipment has the ID, so nothing reaches the row
 			}
-
 		}
-
-		fclose(pFile);
+	}
+	statistics.transmissions.linkHits += transmissions.size() - unmatched;
+	statistics.transmissions.linkMisses += unmatched;
+	statistics.wildcardLinks = (OwUInt64)equipment.wildcardLinks.size() * equipment.size();
+	equipment.firstLink.assign( equipment.size(), 0 );
+	OwUInt32 linkTotal = 0;
+	for( OwUInt32 i = 0; i < equipment.size(); ++i )
+	{
+		equipment.firstLink[i] = linkTotal;
+		linkTotal += equipment.linkCount[i];
 	}
 
-	/**
-	 * A function to convert a LoadedCSV to Owl429 objects and dump them to Xml
-	 */
-	void save()
+	//Then fill the links in sheet order, and index the transmissions
+	equipment.links.assign( linkTotal, 0 );
+	std::vector<OwUInt32> next( equipment.firstLink );
+	for( OwUInt32 i = 0; i < transmissions.size(); ++i )
 	{
-		for( std::list<Equipment>::iterator it = this->equipmentList.begin(); it != this->equipmentList.end(); ++it)
+		OwUInt8 label = (OwUInt8)transmissions.codeNo[i];
+		if( transmissions.equipmentId[i] == SpecStore::WILDCARD_EQUIPMENT )
 		{
-			Owl429Utils::Xml429 xml429( "C:\\Program Files (x86)\\AIT\\ARINC-429 SDK v3.13.1\\C++ API\\xmlSchema\\AIT_429.xsd" );
-			//Owl429Utils::Xml429 xml429 = Owl429Utils::Xml429::Xml429( "C:\\Program Files (x86)\\AIT\\ARINC-429 SDK v3.13.1\\C++ API\\xmlSchema\\AIT_429.xsd" );
-			TxRateOrientedConfig txRateOrientedConfig = TxRateOrientedConfig();
-			RxChronMonConfig rxChronMonConfig = RxChronMonConfig();
-			LabelBufferConfig labelBufferConfig = LabelBufferConfig(1);
-			//Set the Channel Name
-			txRateOrientedConfig.setName(it->type);
-			//Add the Transfers
-			for( std::list<Transmission*>::iterator it2 = it->transmissions.begin(); it2 != it->transmissions.end(); ++it2)
+			if( wildcardIndex[label] == SpecStore::NONE )
 			{
-				TxScheduledLabelConfig txScheduledLabelConfig = Owl429::TxScheduledLabelConfig((OwUInt8)(*it2)->codeNo);
-				//Set the transfer name. This may need to be updated later.
-				std::string name = (*it2)->parameter;
-				txScheduledLabelConfig.setName(name);
-				//Set some of the other values
-				if( (*it2)->bcd && (*it2)->bcdData != NULL )
-				{
-					//Set the Rate
-					if( (*it2)->bcdData->isPeriod )
-					{
-						txScheduledLabelConfig.setTransferPeriod( (OwUInt32)(*it2)->bcdData->rate );
-					}
-					else
-					{
-						txScheduledLabelConfig.setTransferRate( (*it2)->bcdData->rate );
-					}
-				}
-				else if( (*it2)->bnr && (*it2)->bnrData != NULL )
-				{
-					//Set the Rate
-					if( (*it2)->bnrData->isPeriod )
-					{
-						txScheduledLabelConfig.setTransferPeriod( (OwUInt32)(*it2)->bnrData->rate );
-					}
-					else
-					{
-						txScheduledLabelConfig.setTransferRate( (*it2)->bnrData->rate );
-					}
-				}
-				else
-				{
-					//Unknown data type. (It says there is bcd/bnr data, but there isn't)
-					//This can occur when there's a typo in the csv file,
-					//like for HF COM Frequency, whose equipment id doesn't match between the Label Ids and BCD data sheets.
-					continue;
-				}
-				//Add the Transfer
-				try{
-					txRateOrientedConfig.addTransfer(txScheduledLabelConfig);
-				} catch ( std::invalid_argument err ){	//If the name is the same
-					//Change the name
-					std::stringstream newName;
-					newName << (*it2)->parameter << " (" << (*it2)->codeNo << ")";
-					name = newName.str();	//Update the name
-					txScheduledLabelConfig.setName( name );
-					//Retry
-					txRateOrientedConfig.addTransfer(txScheduledLabelConfig);
-				}
-				try{
-					rxChronMonConfig.addLabelBufferConfig((OwUInt8)((*it2)->codeNo), labelBufferConfig, name);
-				} catch ( std::invalid_argument err ){
-					printf( "Error: %s\n", err.what() );
-					continue;
-				}
+				wildcardIndex[label] = i;
 			}
-			txRateOrientedConfig.setMonitorConfig(rxChronMonConfig);
+		}
+		else if( equipmentOf[i] != SpecStore::NONE )
+		{
+			equipment.links[next[equipmentOf[i]]++] = i;
+			transmissionIndex.insert( transmissions.equipmentId[i], label, i );
+		}
+	}
+	statistics.transmissions.linkTime += stopwatch.elapsed();
+}
+
+void LoadedCSV::parseBnrData( const std::string& aFile, DataColumns& aRows, LoadStats::SheetStats& aStats )
+{
+	parseDataSheet( aFile, "loadBnrData", A429WordCodec::FORMAT_BNR, aRows, aStats );
+}
 
-			//Figure out the filename
-			std::stringstream xmlFileName;
-			std::string equipmentNameString = std::string(it->type);
-			std::replace( equipmentNameString.begin(), equipmentNameString.end(), ' ', '-' );	//Replace all the whitespace
-			char hexId[4] = "000";
-			sprintf(hexId, "%.3X", it->id);	//Convert the id to hex and pad it with zeros
-			xmlFileName << hexId << "-" << equipmentNameString;
+void LoadedCSV::parseBcdData( const std::string& aFile, DataColumns& aRows, LoadStats::SheetStats& aStats )
+{
+	parseDataSheet( aFile, "loadBcdData", A429WordCodec::FORMAT_BCD, aRows, aStats );
+}
 
-			//Save to xml
-			xml429.save( txRateOrientedConfig, 1, xmlFileName.str());
-		}
+void LoadedCSV::linkBnrData( DataColumns& aRows )
+{
+	linkDataSheet( aRows, store.bnr, store.transmissions.bnrData, statistics.bnr );
+}
+
+void LoadedCSV::linkBcdData( DataColumns& aRows )
+{
+	linkDataSheet( aRows, store.bcd, store.transmissions.bcdData, statistics.bcd );
+}
+
+void LoadedCSV::parseDataSheet( const std::string& aFile, const std::string& aLoader, A429WordCodec::Format aFormat, DataColumns& aRows, LoadStats::SheetStats& aStats )
+{
+	Stopwatch stopwatch;
+	if ( aFile.empty() )
+	{
+		aStats.error = aLoader + ": argument aFile is empty";
+		return;
+	}
+
+	//Map the data file
+	MappedFile file;
+	if( !file.open( aFile ) )
+	{
+		aStats.error = aLoader + ": The given file could not be opened";
 		return;
 	}
+	aStats.bytes += file.size();
+	CsvReader reader( file.data(), file.size() );
+	std::vector<CsvField> row;
+	CsvField field;
 
-private:
+	//Read in the first line
+	reader.nextRow( row );
 
-	/**
-	 * A helper function to parse out fields from csv files
-	 * @param inputString the string to parse
-	 * @param startIndex the index to begin parsing from.
-	 * This should point to the beginning quotation mark,
-	 * and returns pointing to the beginning of the next field.
-	 * @param outputString the string to store the parsed field to
-	 * @returns the index of the char after the last quotation mark of the parsed field
-	 */
-	void readField( const char* inputString, int* startIndex, char* outputString)
+	//Compare the first line to what we expect
+	static const char* const header[] = { "Label", "Eqpt ID(Hex)", "Parameter Name", "Units", "Range(Scale)", "Sig Bits", "Pos Sense", "Resolution", "Min Transit Interval(msec) 2", "Max Transit Interval(msec) 2", "Max Trans-port Delay(msec) 3", "Notes & Cross Ref. to Tables and Attachments" };
+	if( !CsvReader::matches( row, header, sizeof(header) / sizeof(header[0]) ) )
 	{
-		int i = *startIndex; //inputString index
-		int o = 0; //outputString index
-		if( inputString[*startIndex] != ',' && inputString[*startIndex] != '\n' && inputString[*startIndex] != '\0') //If there is something to read
+		aStats.error = aLoader + ": The first line of the given file was not what was expected";
+		return;
+	}
+
+	//Start reading in lines
+	OwInt16 currentLabel = 0;
+	while( reader.nextRow( row ) )
+	{
+		++aStats.rowsRead;
+		if( CsvReader::isBlank( row ) || row.size() < sizeof(header) / sizeof(header[0]) )	//If it's an empty line, or if it's invalidly formatted
 		{
-			if( inputString[*startIndex] == '\"')	//If the field is surrounded by quotation marks
+			++aStats.rowsSkipped[LoadStats::SKIP_BLANK_ROW];
+			continue;
+		}
+
+		field = CsvReader::field( row, 0 );	//Read in the label
+		if( !field.empty() )	//If we read something in
+		{
+			//Remove all the whitespace
+			char labelString[4];
+			if( !field.compact( labelString, 3 ) )
 			{
-				i++;
-				while( inputString[i] != '\"' )	//while we aren't at the end of the field
-				{
-					outputString[o] = inputString[i];	//copy the char
-					i++;	//increment
-					o++;	//increment
-				}
-				i++;
+				++aStats.rowsSkipped[LoadStats::SKIP_BAD_LABEL];
+				continue;	//Improperly formatted label. Skip this entry
+			}
+			//Parse it for the number and update the current Label
+			currentLabel = (OwInt16)strtol( labelString, NULL, 8 );
+		}
+
+		field = CsvReader::field( row, 1 );	//Read in the equipment ID
+		OwUInt16 equipmentID = 0;
+		if( !field.empty() )	//If we read something in
+		{
+			//Remove all the whitespace
+			char idString[4];
+			if( !field.compact( idString, 3 ) )
+			{
+				++aStats.rowsSkipped[LoadStats::SKIP_BAD_EQUIPMENT_ID];
+				continue;	//Improperly formatted equipment ID. Skip this entry
 			}
-			else	//If the field isn't surrounded by quotation marks
+
+			//Parse it for the number and update the equipment Id
+			if( strcmp(idString, "XXX") == 0 || strcmp(idString, "YYY") == 0)
 			{
-				while( inputString[i] != ',' )	//while we aren't at the end of the field
-				{
-					outputString[o] = inputString[i];	//copy the char
-					i++;	//increment
-					o++;	//increment
-				}
+				equipmentID = SpecStore::WILDCARD_EQUIPMENT;	//It applies to every equipment that has no data of its own for the label
+			}
+			else
+			{
+				equipmentID = (OwInt16)strtol( idString, NULL, 16 );
 			}
 		}
-		outputString[o] = '\0';	//append a null Terminating character
-		if( inputString[*startIndex] != '\0' )
+
+		//The Parameter Name is redundant info, so don't do anything with it.
+
+		field = CsvReader::field( row, 8 );	//Read in the min transit interval
+
+		double rate = field.toDouble();
+		if( rate == 0 )
 		{
-			*startIndex = i + 1;	//return the index of the next field
+			//The rate is unknown. Skip this entry
+			++aStats.rowsSkipped[LoadStats::SKIP_UNKNOWN_RATE];
+			continue;
 		}
-		return;
+		bool isPeriod = !field.contains( "Hz" );	//Check if it's in Hz
+		if( field.contains( "." ) && isPeriod == true )	//Check if it's a period with a decimal point
+		{
+			rate = 1000 / rate;	//Convert to Hz
+			isPeriod = false;
+		}
+
+		OwUInt16 maxTransportDelay = 0;
+		CsvField delayField = CsvReader::field( row, 10 );	//Read in the max transport delay
+		if( !delayField.empty() )
+		{
+			maxTransportDelay = (OwUInt16)delayField.toLong( 10 );
+		}
+
+		//Stage the data, and where it belongs
+		aRows.equipmentId.push_back( equipmentID );
+		aRows.label.push_back( (OwUInt8)currentLabel );
+		aRows.units.push_back( intern( aRows.strings, CsvReader::field( row, 3 ) ) );	//Read in the units
+		aRows.range.push_back( intern( aRows.strings, CsvReader::field( row, 4 ) ) );	//Read in the range
+		aRows.sigBits.push_back( (OwUInt8)CsvReader::field( row, 5 ).toLong( 10 ) );	//Read in the sig bits
+		aRows.posSense.push_back( intern( aRows.strings, CsvReader::field( row, 6 ) ) );	//Read in the pos sense
+		aRows.resolution.push_back( intern( aRows.strings, CsvReader::field( row, 7 ) ) );	//Read in the resolution
+		aRows.minTransitInterval.push_back( intern( aRows.strings, field ) );
+		aRows.rate.push_back( rate );
+		aRows.isPeriod.push_back( isPeriod ? 1 : 0 );
+		aRows.maxTransitInterval.push_back( intern( aRows.strings, CsvReader::field( row, 9 ) ) );	//Read in the max transit interval
+		aRows.maxTransportDelay.push_back( maxTransportDelay );
+
+		//Work out the scaling once, so nothing downstream parses the text again
+		SpecStore::normalize( aRows, aRows.size() - 1, aFormat, (OwUInt32)reader.rowLine() );
+		++aStats.rowsAccepted;
 	}
+	aStats.bytesAllocated += aRows.memoryUsage();
+	aStats.parseTime += stopwatch.elapsed();
+}
 
-	std::list<Equipment> equipmentList;
-	std::list<Transmission> transmissionList;
-	std::list<BNR> bnrList;
-	std::list<BCD> bcdList;
-};
+void LoadedCSV::linkDataSheet( DataColumns& aRows, DataColumns& aColumns, std::vector<OwUInt32>& aData, LoadStats::SheetStats& aStats )
+{
+	Stopwatch stopwatch;
+	OwUInt32 first = aColumns.size();
+	OwUInt32 unusedBefore = aColumns.indexWildcards();
+	OwUInt32 wildcardRows = 0;
+	for( OwUInt32 i = 0; i < aRows.size(); ++i )
+	{
+		//Rows given for every equipment are looked up by label when a transmission has no data of its own
+		if( aRows.equipmentId[i] == SpecStore::WILDCARD_EQUIPMENT )
+		{
+			++wildcardRows;
+			continue;
+		}
+
+		//Look up the transmission for this equipment and label
+		OwUInt32 transmission = findTransmissionRow( aRows.equipmentId[i], aRows.label[i] );
+		if( transmission != SpecStore::NONE )
+		{
+			aData[transmission] = first + i;	//Add the reference
+			++aStats.linkHits;
+		}
+		else
+		{
+			++aStats.linkMisses;
+		}
+	}
 
+	if( first == 0 )
+	{
+		aColumns.swap( aRows );	//Take the parsed columns as they are, nothing is copied
+	}
+	else
+	{
+		aColumns.append( aRows );
+	}
+	aRows.clear();
+	OwUInt32 unused = aColumns.indexWildcards() - unusedBefore;	//Those of a label that already has one
+	aStats.linkHits += wildcardRows - unused;
+	aStats.linkMisses += unused;
+	aStats.linkTime += stopwatch.elapsed();
+}
 
 /**
  * A sample program for loading from csv.
@@ -983,10 +1309,12 @@ private:
 int sample_LoadedCSV()
 {
 	LoadedCSV loadedCsv;
-	loadedCsv.loadEquipmentList("C:\\Users\\Evan\\Downloads\\ARINC429P1-18-EquipmentIDs.csv");
-	loadedCsv.loadTransmissionList("C:\\Users\\Evan\\Downloads\\ARINC429P1-18-LabelIDs.csv");
-	loadedCsv.loadBnrData("C:\\Users\\Evan\\Downloads\\ARINC429P1-18-BnrData.csv");
-	loadedCsv.loadBcdData("C:\\Users\\Evan\\Downloads\\ARINC429P1-18-BcdData.csv");
+	loadedCsv.load("data/ARINC429P1-18-EquipmentIDs.csv",
+		"data/ARINC429P1-18-LabelIDs.csv",
+		"data/ARINC429P1-18-BnrData.csv",
+		"data/ARINC429P1-18-BcdData.csv");
 	loadedCsv.save();
+	std::ofstream stats("LoadStats.json");
+	loadedCsv.stats().writeJson(stats);
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,570 @@
+/**
+ * @file LoadedCSV.hpp
+ * @brief Loads the ARINC 429 specification sheets and converts them to Owl429 channel configurations.
+ */
+
+#ifndef A429_LOADED_CSV_HPP
+#define A429_LOADED_CSV_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <Owl429/definitions>
+
+#include "A429Database.hpp"
+#include "A429WordCodec.hpp"
+#include "ChannelExporter.hpp"
+#include "ContentHash.hpp"
+#include "CsvReader.hpp"
+#include "FileUtil.hpp"
+#include "LabelDispatchTable.hpp"
+#include "LabelIndex.hpp"
+#include "LoadStats.hpp"
+#include "SpecQuery.hpp"
+#include "SpecStore.hpp"
+#include "SpecValidator.hpp"
+#include "WorkerPool.hpp"
+
+/**
+ * A class to read in data from comma seperated value files and populate Owl objects.
+ */
+class LoadedCSV
+{
+public:
+
+	/**
+	 * A row of the EquipmentIDs sheet, and the transmissions the equipment can produce
+	 */
+	typedef SpecStore::EquipmentView Equipment;
+
+	/**
+	 * A row of the LabelIDs sheet
+	 */
+	typedef SpecStore::TransmissionView Transmission;
+
+	/**
+	 * A row of the BnrData sheet
+	 */
+	typedef SpecStore::DataView BNR;
+
+	/**
+	 * A row of the BcdData sheet
+	 */
+	typedef SpecStore::DataView BCD;
+
+	LoadedCSV();
+
+	/**
+	 * Loads the equipment data from the EquipmentIDs.csv file
+	 */
+	void loadEquipmentList(const std::string& aFile );
+
+	/**
+	 * Loads the transmission data from the LabelIDs.csv file. To be run after loadEquipmentList
+	 */
+	void loadTransmissionList(const std::string& aFile );
+
+	/**
+	 * Loads the bnr data from the BnrData.csv file. To be run after loadTransmissionList
+	 */
+	void loadBnrData(const std::string& aFile );
+
+	/**
+	 * Loads the bcd data from the BcdData.csv file. To be run after loadTransmissionList
+	 */
+	void loadBcdData(const std::string& aFile );
+
+	/**
+	 * Loads all four specification sheets at once. The sheets are parsed concurrently,
+	 * then linked in the order loadEquipmentList, loadTransmissionList, then loadBnrData
+	 * alongside loadBcdData, so the result is the same as calling them one after another.
+	 * @param aThreadCount the number of threads to use. 0 uses one per core, 1 loads on the calling thread
+	 */
+	void load( const std::string& aEquipmentFile, const std::string& aTransmissionFile, const std::string& aBnrFile, const std::string& aBcdFile, unsigned aThreadCount = 0 );
+
+	/**
+	 * Compiles everything loaded into a .a429db database, which loadDatabase can read back
+	 * without parsing the sheets, or A429Database can look up in place
+	 * @param aFile the database to write
+	 * @returns false if the database couldn't be written
+	 */
+	bool compile( const std::string& aFile ) const;
+
+	/**
+	 * Replaces everything loaded with the contents of a .a429db database written by compile.
+	 * This is a copying loader: every record is copied into the columns and every string interned
+	 * again, so it skips the parsing but not a pass over the whole file, and nothing stays shared
+	 * with the mapping. Use A429Database for lookups in place
+	 * @param aFile the database to open
+	 * @param aVerify whether to check the checksum of the whole file first. open() already checks
+	 *        that every reference is in range, so this only catches corrupted contents
+	 * @returns false if the database couldn't be opened, or isn't valid
+	 */
+	bool loadDatabase( const std::string& aFile, bool aVerify = false );
+
+	/**
+	 * Sets the directory that save and saveChanged write to, which must exist.
+	 * By default they write to the current directory
+	 */
+	void setOutputDirectory( const std::string& aDirectory )
+	{
+		outputDirectory = aDirectory;
+	}
+
+	/**
+	 * Sets the schema the Xml is saved against. By default it is where the ARINC-429 SDK installs it on Windows
+	 */
+	void setSchemaFile( const std::string& aSchemaFile )
+	{
+		schemaFile = aSchemaFile;
+	}
+
+	/**
+	 * @returns the schema the Xml is saved against
+	 */
+	const std::string& schema() const
+	{
+		return schemaFile;
+	}
+
+	/**
+	 * Chooses how save and saveChanged write the Xml: through Owl429 objects and Xml429,
+	 * which is the default, or streamed straight from the loaded columns by ChannelXml.
+	 * verifyXml checks that the two agree
+	 */
+	void setStreamingXml( bool aStreaming )
+	{
+		streamingXml = aStreaming;
+	}
+
+	/**
+	 * Chooses the backend save and saveChanged write each equipment with. Anything but
+	 * the default FORMAT_XML is streamed straight from the loaded columns, as with
+	 * setStreamingXml, and saved with the extension of its ChannelExporter
+	 */
+	void setExportFormat( ChannelExporter::Format aFormat )
+	{
+		exportFormat = aFormat;
+	}
+
+	/**
+	 * Checks that ChannelXml writes the same document for an equipment as Xml429 does.
+	 * Xml429's document is saved to the output directory, read back, then removed
+	 * @param aDifference set to where the documents first differ, if they do
+	 * @returns true if the documents are equivalent
+	 */
+	bool verifyXml( const Equipment& aEquipment, std::string& aDifference ) const;
+
+	/**
+	 * A function to convert a LoadedCSV to Owl429 objects and dump them to Xml
+	 * @param aThreadCount the number of threads to export the equipment on. 0 uses one per core.
+	 * The files written, and the errors printed, are the same whatever the count.
+	 */
+	void save( unsigned aThreadCount = 1 );
+
+	/**
+	 * Like save, but only rewrites the files of the equipment that changed since the last call.
+	 * A hash of each equipment's transmissions and their BNR/BCD data is kept in a manifest,
+	 * and the files whose hash is unchanged, and that are still there and not empty, are skipped.
+	 * Delete the manifest to rewrite everything
+	 * @param aManifestFile the manifest. Read if it exists, then rewritten
+	 * @param aThreadCount the number of threads to export the equipment on. 0 uses one per core.
+	 * @returns the number of files written. If the manifest couldn't be written, LoadStats::manifestFailed is set
+	 */
+	size_t saveChanged( const std::string& aManifestFile, unsigned aThreadCount = 1 );
+
+	/**
+	 * Hashes everything the file of an equipment is made from
+	 * @param aSchemaFile the schema the file is saved against
+	 * @param aFormat the backend the file is written with
+	 */
+	static OwUInt64 contentHashOf( const Equipment& aEquipment, const std::string& aSchemaFile = XML_SCHEMA_FILE, ChannelExporter::Format aFormat = ChannelExporter::FORMAT_XML );
+
+	/**
+	 * Converts one equipment to Owl429 objects and dumps them to Xml
+	 * @param aEquipment the equipment to save
+	 * @param aFileName the name of the file to save to
+	 * @param aErrors where to append the warnings, such as duplicate labels, instead of printing them
+	 * @returns false if the file couldn't be written
+	 */
+	bool saveEquipment( const Equipment& aEquipment, const std::string& aFileName, std::string& aErrors ) const;
+
+	/**
+	 * Works out the name of the file an equipment is saved to
+	 * @returns the name, as the 3 digit hex ID then the type with its whitespace, and the
+	 *          characters file systems don't allow in names such as '/', replaced
+	 */
+	static std::string fileNameOf( const Equipment& aEquipment );
+
+	/**
+	 * @returns everything loaded, as columns. Views into it stay valid until the next load
+	 */
+	const SpecStore& spec() const
+	{
+		return store;
+	}
+
+	/**
+	 * @returns the indexes for looking up what was loaded by label, equipment, type and parameter.
+	 * They are built the first time they are asked for after loading, so conversions that don't
+	 * query don't pay for them. Ask for them once before sharing them between threads
+	 */
+	const SpecQuery& query();
+
+	/**
+	 * @returns what loading and exporting did since the last clearStats, and the memory held now
+	 */
+	LoadStats stats() const;
+
+	/**
+	 * Checks the loaded sheets against each other, see SpecValidator. To be run after load
+	 * @param aFindings cleared, then filled with the rows that don't fit, in sheet then row order
+	 * @param aThreadCount the number of threads to use. 0 uses one per core
+	 * @returns true if nothing was found
+	 */
+	bool validate( std::vector<SpecValidator::Finding>& aFindings, unsigned aThreadCount = 0 );
+
+	/**
+	 * Zeroes the counters of stats()
+	 */
+	void clearStats()
+	{
+		statistics.clear();
+	}
+
+	/**
+	 * Looks up an equipment by its ID. To be run after loadEquipmentList
+	 * @param aEquipmentId the 12 bit equipment ID
+	 * @returns the first equipment loaded with that ID, which isn't valid if there is none
+	 */
+	Equipment findEquipment( OwUInt16 aEquipmentId ) const;
+
+	/**
+	 * Looks up the transmission of a label by an equipment. To be run after loadTransmissionList
+	 * @param aEquipmentId the 12 bit equipment ID
+	 * @param aLabel the label code
+	 * @returns the first transmission loaded for that equipment and label,
+	 * falling back to a wildcard transmission of the label, which isn't valid if there is none
+	 */
+	Transmission findTransmission( OwUInt16 aEquipmentId, OwUInt8 aLabel ) const;
+
+	/**
+	 * Builds the decoding descriptor of a transmission from the scaling of its BNR or BCD data
+	 * @returns false if the transmission has no BNR or BCD data that describes a decodable value
+	 */
+	static bool describe( const Transmission& aTransmission, A429WordCodec::Descriptor& aDescriptor );
+
+	/**
+	 * Builds the decoders of an equipment's bus, for every label with BNR or BCD data.
+	 * Each label is decoded the same way whatever its SDI
+	 * @param aEquipmentId the 12 bit equipment ID
+	 * @param aTable cleared, then filled with the decoders
+	 * @returns false if there is no such equipment
+	 */
+	bool buildDispatchTable( OwUInt16 aEquipmentId, LabelDispatchTable& aTable ) const;
+
+private:
+
+	/**
+	 * The largest 12 bit equipment ID
+	 */
+	enum { MAX_EQUIPMENT_ID = 0xFFF };
+
+	/**
+	 * Converts a BNR or BCD row to its database record
+	 */
+	static A429Database::DataRecord toRecord( A429DatabaseBuilder& aBuilder, const SpecStore::DataView& aData );
+
+	/**
+	 * Appends a database record to the BNR or BCD columns
+	 */
+	static void fromRecord( const A429Database& aDatabase, const A429Database::DataRecord& aRecord, DataColumns& aColumns );
+
+	/**
+	 * Interns a field as it is read. Only escaped fields need copying out first
+	 * @returns its handle in aPool
+	 */
+	static StringPool::Handle intern( StringPool& aPool, const CsvField& aField )
+	{
+		return aField.escaped ? aPool.intern( aField.str() ) : aPool.intern( aField.data, aField.length );
+	}
+
+	/**
+	 * Looks up the row of the transmission of a label by an equipment, as findTransmission does
+	 * @returns the row, or SpecStore::NONE
+	 */
+	OwUInt32 findTransmissionRow( OwUInt16 aEquipmentId, OwUInt8 aLabel ) const;
+
+	/**
+	 * The version of the manifest of saveChanged. Raise it when the way files are written changes
+	 */
+	enum { MANIFEST_VERSION = 1 };
+
+	/**
+	 * Saves the equipment, one file per name, for save and saveChanged
+	 * @param aPrevious the hashes of the files as they were last written, to skip the unchanged ones. NULL writes every file
+	 * @param aCurrent if not NULL, filled with the hash of each file that is up to date: those
+	 *        written, and those left unchanged. A file that couldn't be written is left out, so it is retried
+	 * @returns the number of files written
+	 */
+	size_t exportEquipment( unsigned aThreadCount, const std::map<std::string, OwUInt64>* aPrevious, std::map<std::string, OwUInt64>* aCurrent );
+
+	/**
+	 * @returns true if a file exists and isn't empty
+	 */
+	static bool hasContent( const std::string& aFile );
+
+	/**
+	 * Adds the columns of a BNR or BCD row to a content hash
+	 */
+	static void addContentHash( ContentHash& aHash, const SpecStore::DataView& aData );
+
+	/**
+	 * Reads a manifest written by writeManifest. A missing or unreadable manifest reads as empty
+	 */
+	static void readManifest( const std::string& aFile, std::map<std::string, OwUInt64>& aHashes );
+
+	/**
+	 * Writes the hash of each file to a manifest
+	 * @returns false if the manifest couldn't be written
+	 */
+	static bool writeManifest( const std::string& aFile, const std::map<std::string, OwUInt64>& aHashes );
+
+	/**
+	 * The schema the Xml is saved against
+	 */
+	static const char* const XML_SCHEMA_FILE;
+
+	/**
+	 * Saves one equipment for save()
+	 */
+	class ExportTask : public WorkerTask
+	{
+	public:
+		ExportTask( const LoadedCSV& aLoaded, const Equipment& aEquipment )
+			: fileName(LoadedCSV::fileNameOf( aEquipment ))
+			, equipment(aEquipment)
+			, hash(0)
+			, failed(false)
+			, loaded(&aLoaded)
+		{
+		}
+
+		void run()
+		{
+			failed = !loaded->saveEquipment( equipment, FileUtil::joinPath( loaded->outputDirectory, fileName ), errors );
+		}
+
+		/**
+		 * @brief The name of the file the equipment is saved to
+		 */
+		std::string fileName;
+		/**
+		 * @brief The warnings from saving the equipment, such as duplicate labels. The file is still written
+		 */
+		std::string errors;
+		/**
+		 * @brief The equipment to save
+		 */
+		Equipment equipment;
+		/**
+		 * @brief The content hash of the equipment, for saveChanged
+		 */
+		OwUInt64 hash;
+		/**
+		 * @brief Denotes whether or not the file couldn't be written
+		 */
+		bool failed;
+
+	private:
+		const LoadedCSV* loaded;
+	};
+
+	/**
+	 * Streams a share of the equipment with one ChannelExporter, for save() with
+	 * setStreamingXml or setExportFormat
+	 */
+	class StreamingExportTask : public WorkerTask
+	{
+	public:
+		StreamingExportTask( const LoadedCSV& aLoaded )
+			: loaded(&aLoaded)
+		{
+		}
+
+		void run()
+		{
+			ChannelExporter* writer = ChannelExporter::create( loaded->exportFormat, loaded->schemaFile );
+			for( size_t i = 0; i < tasks.size(); ++i )
+			{
+				ExportTask& task = *tasks[i];
+				writer->write( task.equipment, 1, task.errors );
+				task.failed = !writer->save( FileUtil::joinPath( loaded->outputDirectory, task.fileName ) );
+			}
+			delete writer;
+		}
+
+		/**
+		 * @brief The equipment to save, and where their errors go
+		 */
+		std::vector<ExportTask*> tasks;
+
+	private:
+		const LoadedCSV* loaded;
+	};
+
+	/**
+	 * The staging buffers and tasks of load()
+	 */
+	class LoadPipeline
+	{
+	public:
+		LoadPipeline( LoadedCSV& aLoaded, const std::string& aEquipmentFile, const std::string& aTransmissionFile, const std::string& aBnrFile, const std::string& aBcdFile )
+			: loaded(aLoaded)
+			, equipmentFile(aEquipmentFile)
+			, transmissionFile(aTransmissionFile)
+			, bnrFile(aBnrFile)
+			, bcdFile(aBcdFile)
+		{
+		}
+
+		void parseEquipment()		{ LoadedCSV::parseEquipmentList( equipmentFile, equipmentRows, loaded.statistics.equipment ); }
+		void parseTransmissions()	{ LoadedCSV::parseTransmissionList( transmissionFile, transmissionRows, loaded.statistics.transmissions ); }
+		void parseBnr()				{ LoadedCSV::parseBnrData( bnrFile, bnrRows, loaded.statistics.bnr ); }
+		void parseBcd()				{ LoadedCSV::parseBcdData( bcdFile, bcdRows, loaded.statistics.bcd ); }
+		void linkEquipment()		{ loaded.linkEquipmentList( equipmentRows ); }
+		void linkTransmissions()	{ loaded.linkTransmissionList( transmissionRows ); }
+		void linkBnr()				{ loaded.linkBnrData( bnrRows ); }
+		void linkBcd()				{ loaded.linkBcdData( bcdRows ); }
+
+	private:
+		LoadedCSV& loaded;
+		std::string equipmentFile;
+		std::string transmissionFile;
+		std::string bnrFile;
+		std::string bcdFile;
+		EquipmentColumns equipmentRows;
+		TransmissionColumns transmissionRows;
+		DataColumns bnrRows;
+		DataColumns bcdRows;
+	};
+
+	//The loaders in two steps: parsing a sheet into staging columns, then linking those in.
+	//This is how load() overlaps the sheets. Each step adds its time to statistics
+
+	/**
+	 * Parses the EquipmentIDs.csv file into staging columns. Touches no members, so it can run on any thread
+	 * @param aStats the counters of the sheet, added to
+	 */
+	static void parseEquipmentList( const std::string& aFile, EquipmentColumns& aRows, LoadStats::SheetStats& aStats );
+
+	/**
+	 * Replaces the equipment with the parsed rows, and indexes them by ID
+	 */
+	void linkEquipmentList( EquipmentColumns& aRows );
+
+	/**
+	 * Parses the LabelIDs.csv file into staging columns, with the equipment each row belongs to.
+	 * Touches no members, so it can run on any thread
+	 * @param aStats the counters of the sheet, added to
+	 */
+	static void parseTransmissionList( const std::string& aFile, TransmissionColumns& aRows, LoadStats::SheetStats& aStats );
+
+	/**
+	 * Replaces the transmissions with the parsed rows, adds them to their equipment
+	 * and indexes them by (equipment ID, label). To be run after linkEquipmentList
+	 */
+	void linkTransmissionList( TransmissionColumns& aRows );
+
+	/**
+	 * Parses the BnrData.csv file into staging columns. Touches no members, so it can run on any thread
+	 * @param aStats the counters of the sheet, added to
+	 */
+	static void parseBnrData( const std::string& aFile, DataColumns& aRows, LoadStats::SheetStats& aStats );
+
+	/**
+	 * Parses the BcdData.csv file into staging columns. Touches no members, so it can run on any thread
+	 * @param aStats the counters of the sheet, added to
+	 */
+	static void parseBcdData( const std::string& aFile, DataColumns& aRows, LoadStats::SheetStats& aStats );
+
+	/**
+	 * Appends parsed bnr rows, and links each one to its transmission. To be run after linkTransmissionList
+	 */
+	void linkBnrData( DataColumns& aRows );
+
+	/**
+	 * Appends parsed bcd rows, and links each one to its transmission. To be run after linkTransmissionList
+	 */
+	void linkBcdData( DataColumns& aRows );
+
+	/**
+	 * Parses the BnrData.csv or BcdData.csv file into staging columns, with the equipment and label of each row.
+	 * Touches no members, so it can run on any thread
+	 * @param aLoader the name of the loader, for errors
+	 * @param aFormat how the sheet's data is encoded, for working out the scaling columns
+	 * @param aStats the counters of the sheet, added to
+	 */
+	static void parseDataSheet( const std::string& aFile, const std::string& aLoader, A429WordCodec::Format aFormat, DataColumns& aRows, LoadStats::SheetStats& aStats );
+
+	/**
+	 * Appends parsed BNR or BCD rows to their columns and links each one to its transmission.
+	 * To be run after linkTransmissionList
+	 * @param aColumns the columns to append the rows to
+	 * @param aData the column of TransmissionColumns that refers to rows of this kind
+	 * @param aStats the counters of the sheet, added to
+	 */
+	void linkDataSheet( DataColumns& aRows, DataColumns& aColumns, std::vector<OwUInt32>& aData, LoadStats::SheetStats& aStats );
+
+	/**
+	 * @brief Everything loaded
+	 */
+	SpecStore store;
+
+	/**
+	 * @brief What loading and exporting did, since the last clearStats
+	 */
+	LoadStats statistics;
+
+	/**
+	 * @brief Where the Xml is saved, or empty for the current directory
+	 */
+	std::string outputDirectory;
+
+	/**
+	 * @brief The schema the Xml is saved against
+	 */
+	std::string schemaFile;
+
+	/**
+	 * @brief Whether the Xml is streamed by ChannelXml rather than saved through Xml429
+	 */
+	bool streamingXml;
+
+	/**
+	 * @brief The backend each equipment is written with
+	 */
+	ChannelExporter::Format exportFormat;
+
+	/**
+	 * @brief The indexes of query(), and whether the store changed since they were built
+	 */
+	SpecQuery specQuery;
+	bool queryStale;
+
+	/**
+	 * @brief The equipment, directly addressed by ID
+	 */
+	std::vector<OwUInt32> equipmentIndex;
+	/**
+	 * @brief The transmissions, keyed on (equipment ID, label)
+	 */
+	LabelIndex<OwUInt32> transmissionIndex;
+	/**
+	 * @brief The wildcard transmissions, directly addressed by label
+	 */
+	std::vector<OwUInt32> wildcardIndex;
+};
+
+#endif
@@ -0,0 +1,151 @@
+/**
+ * @file MappedFile.cpp
+ * @brief A read-only memory mapping of a whole file.
+ */
+
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * What empty and closed files point at, so that data() never returns NULL
+ */
+static const char emptyView[1] = { '\0' };
+
+MappedFile::MappedFile()
+	: view(emptyView)
+	, length(0)
+#ifdef _WIN32
+	, fileHandle(INVALID_HANDLE_VALUE)
+	, mappingHandle(NULL)
+#else
+	, fileDescriptor(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open( const std::string& aFile )
+{
+	close();
+
+	fileHandle = CreateFileA( aFile.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	if( fileHandle == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if( !GetFileSizeEx( fileHandle, &fileSize ) || (unsigned __int64)fileSize.QuadPart > (size_t)-1 )
+	{
+		close();
+		return false;
+	}
+	if( fileSize.QuadPart == 0 )	//Empty files can't be mapped, but they are valid
+	{
+		return true;
+	}
+
+	mappingHandle = CreateFileMappingA( fileHandle, NULL, PAGE_READONLY, 0, 0, NULL );
+	if( mappingHandle == NULL )
+	{
+		close();
+		return false;
+	}
+
+	const void* mapped = MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 );
+	if( mapped == NULL )
+	{
+		close();
+		return false;
+	}
+	view = (const char*)mapped;
+	length = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if( view != emptyView )
+	{
+		UnmapViewOfFile( view );
+	}
+	if( mappingHandle != NULL )
+	{
+		CloseHandle( mappingHandle );
+	}
+	if( fileHandle != INVALID_HANDLE_VALUE )
+	{
+		CloseHandle( fileHandle );
+	}
+	view = emptyView;
+	length = 0;
+	mappingHandle = NULL;
+	fileHandle = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::open( const std::string& aFile )
+{
+	close();
+
+	fileDescriptor = ::open( aFile.c_str(), O_RDONLY );
+	if( fileDescriptor == -1 )
+	{
+		return false;
+	}
+
+	struct stat fileStat;
+	if( fstat( fileDescriptor, &fileStat ) != 0 )
+	{
+		close();
+		return false;
+	}
+	if( fileStat.st_size == 0 )	//Empty files can't be mapped, but they are valid
+	{
+		return true;
+	}
+
+	void* mapped = mmap( NULL, (size_t)fileStat.st_size, PROT_READ, MAP_SHARED, fileDescriptor, 0 );
+	if( mapped == MAP_FAILED )
+	{
+		close();
+		return false;
+	}
+	madvise( mapped, (size_t)fileStat.st_size, MADV_SEQUENTIAL );	//The parsers read front to back
+	view = (const char*)mapped;
+	length = (size_t)fileStat.st_size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if( view != emptyView )
+	{
+		munmap( (void*)view, length );
+	}
+	if( fileDescriptor != -1 )
+	{
+		::close( fileDescriptor );
+	}
+	view = emptyView;
+	length = 0;
+	fileDescriptor = -1;
+}
+
+#endif
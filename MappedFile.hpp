@@ -0,0 +1,79 @@
+/**
+ * @file MappedFile.hpp
+ * @brief A read-only memory mapping of a whole file.
+ */
+
+#ifndef A429_MAPPED_FILE_HPP
+#define A429_MAPPED_FILE_HPP
+
+#include <string>
+#include <cstddef>
+
+/**
+ * Maps a file read-only into memory so that it can be parsed in place.
+ * The mapping stays valid until close() is called or the object is destroyed.
+ */
+class MappedFile
+{
+public:
+
+	MappedFile();
+	~MappedFile();
+
+	/**
+	 * Maps the given file, unmapping any previously mapped file
+	 * @param aFile the path of the file to map
+	 * @returns true if the file was mapped
+	 */
+	bool open( const std::string& aFile );
+
+	/**
+	 * Unmaps the file
+	 */
+	void close();
+
+	/**
+	 * @returns the first byte of the file. Never NULL, even for an empty or closed file
+	 */
+	const char* data() const
+	{
+		return view;
+	}
+
+	/**
+	 * @returns the size of the file in bytes
+	 */
+	size_t size() const
+	{
+		return length;
+	}
+
+private:
+
+	//Not copyable
+	MappedFile( const MappedFile& );
+	MappedFile& operator=( const MappedFile& );
+
+	/**
+	 * @brief The mapped bytes of the file
+	 */
+	const char* view;
+	/**
+	 * @brief The size of the mapping in bytes
+	 */
+	size_t length;
+#ifdef _WIN32
+	/**
+	 * @brief The file and file mapping handles
+	 */
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	/**
+	 * @brief The file descriptor
+	 */
+	int fileDescriptor;
+#endif
+};
+
+#endif
@@ -0,0 +1,342 @@
+/**
+ * @file ParameterSearch.cpp
+ * @brief A trigram index of the parameter names, for fuzzy and substring search.
+ */
+
+#include "ParameterSearch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+const float ParameterSearch::DEFAULT_MIN_SCORE = 0.3f;
+
+namespace
+{
+	/**
+	 * Orders matches best first, then by name
+	 */
+	bool betterMatch( const ParameterSearch::Match& aFirst, const ParameterSearch::Match& aSecond )
+	{
+		if( aFirst.contains != aSecond.contains )
+		{
+			return aFirst.contains;
+		}
+		if( aFirst.score != aSecond.score )
+		{
+			return aFirst.score > aSecond.score;
+		}
+		return aFirst.name < aSecond.name;
+	}
+}
+
+ParameterSearch::ParameterSearch()
+{
+	clear();
+}
+
+void ParameterSearch::clear()
+{
+	names.clear();
+	nameOffsets.assign( 1, 0 );
+	trigramCounts.clear();
+	rows.clear();
+	rowOffsets.assign( 1, 0 );
+	trigrams.clear();
+	trigramOffsets.assign( 1, 0 );
+	postings.clear();
+}
+
+std::string ParameterSearch::normalize( const std::string& aName )
+{
+	std::string normal;
+	normal.reserve( aName.size() );
+	bool space = false;
+	for( size_t i = 0; i < aName.size(); ++i )
+	{
+		char c = aName[i];
+		if( c >= 'A' && c <= 'Z' )
+		{
+			c = (char)(c - 'A' + 'a');
+		}
+		if( (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') )
+		{
+			//A run of anything else between two words is one space
+			if( space && !normal.empty() )
+			{
+				normal.push_back( ' ' );
+			}
+			normal.push_back( c );
+			space = false;
+		}
+		else
+		{
+			space = true;
+		}
+	}
+	return normal;
+}
+
+void ParameterSearch::trigramsOf( const std::string& aNormal, bool aPadded, std::vector<OwUInt32>& aTrigrams )
+{
+	aTrigrams.clear();
+	std::string text = aPadded ? " " + aNormal + " " : aNormal;
+	for( size_t i = 0; i + 3 <= text.size(); ++i )
+	{
+		aTrigrams.push_back( ((OwUInt32)(OwUInt8)text[i] << 16) | ((OwUInt32)(OwUInt8)text[i + 1] << 8) | (OwUInt8)text[i + 2] );
+	}
+	std::sort( aTrigrams.begin(), aTrigrams.end() );
+	aTrigrams.erase( std::unique( aTrigrams.begin(), aTrigrams.end() ), aTrigrams.end() );
+}
+
+void ParameterSearch::build( const std::vector<StringPool::Handle>& aParameters, const StringPool& aStrings )
+{
+	clear();
+
+	//Each string is put in the normal form once, however many rows have it
+	std::vector<std::string> normals( aStrings.size() );
+	for( StringPool::Handle i = 0; i < aStrings.size(); ++i )
+	{
+		normals[i] = normalize( aStrings.get( i ).str() );
+	}
+
+	//The distinct names in order, each with its rows in order
+	std::vector< std::pair<std::string, OwUInt32> > named;
+	named.reserve( aParameters.size() );
+	for( size_t i = 0; i < aParameters.size(); ++i )
+	{
+		const std::string& normal = normals[aParameters[i]];
+		if( !normal.empty() )
+		{
+			named.push_back( std::make_pair( normal, (OwUInt32)i ) );
+		}
+	}
+	std::sort( named.begin(), named.end() );
+	rows.reserve( named.size() );
+	for( size_t i = 0; i < named.size(); ++i )
+	{
+		if( i > 0 && named[i].first != named[i - 1].first )
+		{
+			rowOffsets.push_back( (OwUInt32)rows.size() );
+		}
+		if( i == 0 || named[i].first != named[i - 1].first )
+		{
+			names.append( named[i].first );
+			nameOffsets.push_back( (OwUInt32)names.size() );
+		}
+		rows.push_back( named[i].second );
+	}
+	if( !rows.empty() )
+	{
+		rowOffsets.push_back( (OwUInt32)rows.size() );
+	}
+
+	//The pieces of every name, sorted by piece then name so each piece's names are together and in order
+	std::vector< std::pair<OwUInt32, OwUInt32> > pieces;
+	std::vector<OwUInt32> nameTrigrams;
+	trigramCounts.resize( nameCount() );
+	for( OwUInt32 name = 0; name < nameCount(); ++name )
+	{
+		trigramsOf( text( name ), true, nameTrigrams );
+		trigramCounts[name] = (OwUInt16)std::min<size_t>( nameTrigrams.size(), 0xFFFF );
+		for( size_t i = 0; i < nameTrigrams.size(); ++i )
+		{
+			pieces.push_back( std::make_pair( nameTrigrams[i], name ) );
+		}
+	}
+	std::sort( pieces.begin(), pieces.end() );
+	postings.resize( pieces.size() );
+	for( size_t i = 0; i < pieces.size(); ++i )
+	{
+		if( i > 0 && pieces[i].first != pieces[i - 1].first )
+		{
+			trigramOffsets.push_back( (OwUInt32)i );
+		}
+		if( i == 0 || pieces[i].first != pieces[i - 1].first )
+		{
+			trigrams.push_back( pieces[i].first );
+		}
+		postings[i] = pieces[i].second;
+	}
+	if( !pieces.empty() )
+	{
+		trigramOffsets.push_back( (OwUInt32)pieces.size() );
+	}
+}
+
+bool ParameterSearch::contains( OwUInt32 aName, const std::string& aNormal ) const
+{
+	const char* first = names.data() + nameOffsets[aName];
+	const char* last = names.data() + nameOffsets[aName + 1];
+	return std::search( first, last, aNormal.begin(), aNormal.end() ) != last;
+}
+
+void ParameterSearch::postingsOf( OwUInt32 aFirst, OwUInt32 aLast, std::vector<Postings>& aPostings ) const
+{
+	std::vector<OwUInt32>::const_iterator first = std::lower_bound( trigrams.begin(), trigrams.end(), aFirst );
+	std::vector<OwUInt32>::const_iterator last = std::lower_bound( first, trigrams.end(), aLast );
+	for( ; first != last; ++first )
+	{
+		size_t index = first - trigrams.begin();
+		Postings list;
+		list.first = &postings[trigramOffsets[index]];
+		list.last = &postings[trigramOffsets[index + 1]];
+		list.inside = false;
+		aPostings.push_back( list );
+	}
+}
+
+void ParameterSearch::search( const std::string& aQuery, size_t aMaxMatches, std::vector<Match>& aMatches, float aMinScore ) const
+{
+	aMatches.clear();
+	std::string normal = normalize( aQuery );
+	if( normal.empty() || aMaxMatches == 0 )
+	{
+		return;
+	}
+
+	Match match;
+	match.contains = true;
+	if( normal.size() == 1 )
+	{
+		//One character is in too many pieces to be worth it, so look in every name. The score is how much of the name it is
+		for( OwUInt32 name = 0; name < nameCount(); ++name )
+		{
+			if( contains( name, normal ) )
+			{
+				match.name = name;
+				match.score = 1.0f / (nameOffsets[name + 1] - nameOffsets[name]);
+				aMatches.push_back( match );
+			}
+		}
+	}
+	else if( normal.size() == 2 )
+	{
+		//Every 2 characters of a name start one of its pieces, as a name is followed by a space, and the
+		//pieces that start with them are next to each other. So the names with them are those of these pieces
+		OwUInt32 prefix = ((OwUInt32)(OwUInt8)normal[0] << 16) | ((OwUInt32)(OwUInt8)normal[1] << 8);
+		std::vector<Postings> lists;
+		postingsOf( prefix, prefix + 0x100, lists );
+		std::vector<OwUInt32> found;
+		for( size_t i = 0; i < lists.size(); ++i )
+		{
+			found.insert( found.end(), lists[i].first, lists[i].last );
+		}
+		std::sort( found.begin(), found.end() );
+		found.erase( std::unique( found.begin(), found.end() ), found.end() );
+		for( size_t i = 0; i < found.size(); ++i )
+		{
+			match.name = found[i];
+			match.score = 2.0f / (nameOffsets[found[i] + 1] - nameOffsets[found[i]]);
+			aMatches.push_back( match );
+		}
+	}
+	else
+	{
+		std::vector<OwUInt32> queryTrigrams;
+		trigramsOf( normal, false, queryTrigrams );
+		//A name can only contain the query if it has all of the query's own pieces
+		std::vector<OwUInt32> inside( queryTrigrams );
+		trigramsOf( normal, true, queryTrigrams );
+
+		//The names of each piece the query has, fewest first
+		std::vector<Postings> lists;
+		bool canContain = true;
+		for( size_t i = 0; i < queryTrigrams.size(); ++i )
+		{
+			size_t before = lists.size();
+			postingsOf( queryTrigrams[i], queryTrigrams[i] + 1, lists );
+			if( lists.size() > before )
+			{
+				lists.back().inside = std::binary_search( inside.begin(), inside.end(), queryTrigrams[i] );
+			}
+			else if( std::binary_search( inside.begin(), inside.end(), queryTrigrams[i] ) )
+			{
+				canContain = false;
+			}
+		}
+		std::sort( lists.begin(), lists.end() );
+
+		//A name scores aMinScore only if it shares that much of the query's pieces, so it is in one of all but
+		//the longest (enough - 1) lists. A name that contains the query is in the shortest list of its own pieces.
+		//So only those lists are gone through, and the longer ones are looked up in for the names found
+		size_t enough = (size_t)std::max( 1.0f, (float)ceil( aMinScore * queryTrigrams.size() - 0.0001f ) );
+		size_t scanned = enough <= lists.size() ? lists.size() - enough + 1 : 0;
+		if( canContain && !inside.empty() )
+		{
+			size_t shortestInside = 0;
+			while( !lists[shortestInside].inside )
+			{
+				++shortestInside;
+			}
+			scanned = std::max( scanned, shortestInside + 1 );
+		}
+		std::vector<OwUInt16> shared( nameCount(), 0 );
+		std::vector<OwUInt32> found;
+		for( size_t i = 0; i < scanned; ++i )
+		{
+			for( const OwUInt32* name = lists[i].first; name != lists[i].last; ++name )
+			{
+				if( shared[*name]++ == 0 )
+				{
+					found.push_back( *name );
+				}
+			}
+		}
+		for( size_t i = scanned; i < lists.size(); ++i )
+		{
+			//Look the names found up in a list much longer than them, otherwise go through it
+			if( found.size() * 16 < (size_t)(lists[i].last - lists[i].first) )
+			{
+				for( size_t j = 0; j < found.size(); ++j )
+				{
+					shared[found[j]] += std::binary_search( lists[i].first, lists[i].last, found[j] );
+				}
+			}
+			else
+			{
+				for( const OwUInt32* name = lists[i].first; name != lists[i].last; ++name )
+				{
+					if( shared[*name] != 0 )
+					{
+						++shared[*name];
+					}
+				}
+			}
+		}
+
+		for( size_t i = 0; i < found.size(); ++i )
+		{
+			OwUInt32 name = found[i];
+			match.name = name;
+			match.score = (float)shared[name] / (queryTrigrams.size() + trigramCounts[name] - shared[name]);
+			match.contains = canContain && shared[name] >= inside.size() && contains( name, normal );
+			if( match.contains || match.score >= aMinScore )
+			{
+				aMatches.push_back( match );
+			}
+		}
+	}
+
+	if( aMatches.size() > aMaxMatches )
+	{
+		std::partial_sort( aMatches.begin(), aMatches.begin() + aMaxMatches, aMatches.end(), betterMatch );
+		aMatches.resize( aMaxMatches );
+	}
+	else
+	{
+		std::sort( aMatches.begin(), aMatches.end(), betterMatch );
+	}
+}
+
+size_t ParameterSearch::memoryUsage() const
+{
+	return names.capacity()
+		+ nameOffsets.capacity() * sizeof(OwUInt32)
+		+ trigramCounts.capacity() * sizeof(OwUInt16)
+		+ rows.capacity() * sizeof(OwUInt32)
+		+ rowOffsets.capacity() * sizeof(OwUInt32)
+		+ trigrams.capacity() * sizeof(OwUInt32)
+		+ trigramOffsets.capacity() * sizeof(OwUInt32)
+		+ postings.capacity() * sizeof(OwUInt32);
+}
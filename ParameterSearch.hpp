@@ -0,0 +1,184 @@
+/**
+ * @file ParameterSearch.hpp
+ * @brief A trigram index of the parameter names, for fuzzy and substring search.
+ */
+
+#ifndef A429_PARAMETER_SEARCH_HPP
+#define A429_PARAMETER_SEARCH_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include <Owl429/definitions>
+
+#include "StringPool.hpp"
+
+/**
+ * Finds parameters by a part of their name, or a name that is nearly right.
+ *
+ * Names are compared in a normal form: lower case, with everything that isn't a letter or digit
+ * taken as a space and runs of spaces as one, so "Distance to Go  " and "distance-to-go" are the
+ * same name. Each distinct name is split into the 3 character pieces of " name ", and an inverted
+ * index lists the names each piece occurs in. A search merges the lists of the query's pieces,
+ * which gives the number of pieces each name shares with it, then ranks:
+ *
+ *  - the names that contain the query, first
+ *  - then the names whose pieces are similar enough, by the shared pieces over all the pieces
+ *    of the two (0 to 1)
+ *
+ * Only the shortest lists are gone through; a name in none of them can't share enough pieces,
+ * and the longer lists are looked up in for the names that are. Queries of 2 characters are the
+ * start of the pieces that have them, and those of 1 character are looked for in every name.
+ * Their score is how much of the name they are.
+ *
+ * Searches are const and safe from any number of threads.
+ */
+class ParameterSearch
+{
+public:
+
+	/**
+	 * A name that was found
+	 */
+	typedef struct Match
+	{
+		/**
+		 * @brief The name, for text() and transmissionsOf()
+		 */
+		OwUInt32 name;
+		/**
+		 * @brief How similar the name is to the query, from 0 to 1
+		 */
+		float score;
+		/**
+		 * @brief Whether the name contains the query
+		 */
+		bool contains;
+	} Match;
+
+	/**
+	 * The default for the smallest score a name that doesn't contain the query is found with
+	 */
+	static const float DEFAULT_MIN_SCORE;
+
+	ParameterSearch();
+
+	/**
+	 * Indexes the parameter names of a set of transmissions, replacing what was indexed before
+	 * @param aParameters the Parameter column, by transmission row
+	 * @param aStrings the strings its handles are of
+	 */
+	void build( const std::vector<StringPool::Handle>& aParameters, const StringPool& aStrings );
+
+	/**
+	 * Removes the index
+	 */
+	void clear();
+
+	/**
+	 * Finds the names most like a query
+	 * @param aMaxMatches the most matches to return
+	 * @param aMinScore the smallest score of the names that don't contain the query
+	 * @param aMatches cleared, then filled with the matches, best first. Equal matches are in name order
+	 */
+	void search( const std::string& aQuery, size_t aMaxMatches, std::vector<Match>& aMatches, float aMinScore = DEFAULT_MIN_SCORE ) const;
+
+	/**
+	 * @returns the number of distinct names
+	 */
+	OwUInt32 nameCount() const
+	{
+		return (OwUInt32)nameOffsets.size() - 1;
+	}
+
+	/**
+	 * @returns a name in the normal form
+	 */
+	std::string text( OwUInt32 aName ) const
+	{
+		return std::string( &names[nameOffsets[aName]], nameOffsets[aName + 1] - nameOffsets[aName] );
+	}
+
+	/**
+	 * @returns the transmission rows with a name, in order. aCount is set to how many
+	 */
+	const OwUInt32* transmissionsOf( OwUInt32 aName, size_t& aCount ) const
+	{
+		aCount = rowOffsets[aName + 1] - rowOffsets[aName];
+		return &rows[rowOffsets[aName]];
+	}
+
+	/**
+	 * Puts a name in the normal form
+	 */
+	static std::string normalize( const std::string& aName );
+
+	/**
+	 * @returns the heap memory held by the index, in bytes
+	 */
+	size_t memoryUsage() const;
+
+private:
+
+	/**
+	 * The names a piece occurs in
+	 */
+	typedef struct Postings
+	{
+		const OwUInt32* first;
+		const OwUInt32* last;
+		/**
+		 * @brief Whether the piece is one of the query's own, rather than one with its padding
+		 */
+		bool inside;
+
+		bool operator<( const Postings& aOther ) const
+		{
+			return last - first < aOther.last - aOther.first;
+		}
+	} Postings;
+
+	/**
+	 * Appends the names of the pieces from aFirst up to aLast
+	 */
+	void postingsOf( OwUInt32 aFirst, OwUInt32 aLast, std::vector<Postings>& aPostings ) const;
+
+	/**
+	 * Lists the distinct pieces of a name in the normal form, in order. A piece is its 3 bytes in
+	 * the low 24 bits
+	 * @param aPadded whether to take the pieces of " name " rather than "name"
+	 */
+	static void trigramsOf( const std::string& aNormal, bool aPadded, std::vector<OwUInt32>& aTrigrams );
+
+	/**
+	 * @returns whether a name contains a query, both in the normal form
+	 */
+	bool contains( OwUInt32 aName, const std::string& aNormal ) const;
+
+	/**
+	 * @brief The names in the normal form one after the other, and where each starts. nameCount() + 1 offsets
+	 */
+	std::string names;
+	std::vector<OwUInt32> nameOffsets;
+	/**
+	 * @brief The number of pieces of each name
+	 */
+	std::vector<OwUInt16> trigramCounts;
+	/**
+	 * @brief The transmission rows of each name, and where each name's start. nameCount() + 1 offsets
+	 */
+	std::vector<OwUInt32> rows;
+	std::vector<OwUInt32> rowOffsets;
+	/**
+	 * @brief The distinct pieces in order, and where the names each occurs in start in postings
+	 */
+	std::vector<OwUInt32> trigrams;
+	std::vector<OwUInt32> trigramOffsets;
+	/**
+	 * @brief The names each piece occurs in, in order
+	 */
+	std::vector<OwUInt32> postings;
+};
+
+#endif
@@ -0,0 +1,460 @@
+/**
+ * @file ReceivePipeline.cpp
+ * @brief Replays received words through decode worker threads, measuring how long each word takes.
+ */
+
+#include "ReceivePipeline.hpp"
+
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0600
+#endif
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#define A429_CPU_PAUSE() _mm_pause()
+#else
+#define A429_CPU_PAUSE()
+#endif
+
+#include "JsonWriter.hpp"
+#include "LoadedCSV.hpp"
+#include "MappedFile.hpp"
+#include "Stopwatch.hpp"
+
+namespace
+{
+	/**
+	 * Waits for the other end of a ring: spins for a while, then yields the core, in case
+	 * the other thread is waiting for it
+	 */
+	class SpinWait
+	{
+	public:
+		SpinWait() : polls(0) {}
+
+		void wait()
+		{
+			if( ++polls < SPIN_POLLS )
+			{
+				A429_CPU_PAUSE();
+				return;
+			}
+#ifdef _WIN32
+			SwitchToThread();
+#else
+			sched_yield();
+#endif
+		}
+
+		void reset()
+		{
+			polls = 0;
+		}
+
+	private:
+		/**
+		 * @brief The polls spun through before yielding
+		 */
+		enum { SPIN_POLLS = 1000 };
+
+		unsigned polls;
+	};
+
+	/**
+	 * Reads a little endian integer of aSize bytes, as CaptureDecoder writes them
+	 */
+	OwUInt64 readLittleEndian( const char* aData, int aSize )
+	{
+		OwUInt64 value = 0;
+		for( int i = aSize - 1; i >= 0; --i )
+		{
+			value = (value << 8) | (OwUInt8)aData[i];
+		}
+		return value;
+	}
+}
+
+LatencyHistogram::LatencyHistogram()
+	: counts(BUCKET_COUNT, 0)
+	, total(0)
+	, maximum(0)
+{
+}
+
+void LatencyHistogram::clear()
+{
+	counts.assign( BUCKET_COUNT, 0 );
+	total = 0;
+	maximum = 0;
+}
+
+void LatencyHistogram::merge( const LatencyHistogram& aOther )
+{
+	for( size_t i = 0; i < counts.size(); ++i )
+	{
+		counts[i] += aOther.counts[i];
+	}
+	total += aOther.total;
+	if( aOther.maximum > maximum )
+	{
+		maximum = aOther.maximum;
+	}
+}
+
+OwUInt64 LatencyHistogram::upperBound( size_t aBucket )
+{
+	if( aBucket < SUB_BUCKETS )
+	{
+		return aBucket;
+	}
+	unsigned top = (unsigned)(aBucket / SUB_BUCKETS) + 3;
+	OwUInt64 width = (OwUInt64)1 << (top - 4);
+	return (SUB_BUCKETS + aBucket % SUB_BUCKETS) * width + width - 1;
+}
+
+OwUInt64 LatencyHistogram::percentile( double aFraction ) const
+{
+	if( total == 0 )
+	{
+		return 0;
+	}
+	OwUInt64 rank = (OwUInt64)(aFraction * (double)total + 0.5);
+	if( rank == 0 )
+	{
+		rank = 1;
+	}
+	OwUInt64 seen = 0;
+	for( size_t i = 0; i < counts.size(); ++i )
+	{
+		seen += counts[i];
+		if( seen >= rank )
+		{
+			OwUInt64 bound = upperBound( i );
+			return bound < maximum ? bound : maximum;
+		}
+	}
+	return maximum;
+}
+
+ReceivePipeline::Worker::Worker( const LabelDispatchTable& aTable, size_t aRingCapacity, size_t aBatchSize )
+	: ring(aRingCapacity)
+	, sink(NULL)
+	, decoder(aTable, 1)
+	, received(aBatchSize == 0 ? 1 : aBatchSize)
+	, decoded(received.size())
+{
+	reset();
+}
+
+void ReceivePipeline::Worker::reset()
+{
+	ring.reset();
+	latency.clear();
+	words = 0;
+	unknownLabels = 0;
+	parityErrors = 0;
+	finishedAt = 0;
+}
+
+void ReceivePipeline::Worker::run()
+{
+	SpinWait idle;
+	while( true )
+	{
+		size_t count = ring.tryPop( &received[0], received.size() );
+		if( count == 0 )
+		{
+			//Closing comes after the last push, so one more pop drains the ring
+			if( ring.isClosed() )
+			{
+				count = ring.tryPop( &received[0], received.size() );
+				if( count == 0 )
+				{
+					break;
+				}
+			}
+			else
+			{
+				idle.wait();
+				continue;
+			}
+		}
+		idle.reset();
+
+		for( size_t i = 0; i < count; ++i )
+		{
+			DecodedRecord& record = decoded[i];
+			decoder.decode( received[i].timestamp, received[i].word, record );
+			unknownLabels += record.descriptor == LabelDispatchTable::NO_ENTRY ? 1 : 0;
+			parityErrors += record.parityValid ? 0 : 1;
+		}
+		if( sink != NULL )
+		{
+			sink->onRecords( &decoded[0], count );
+		}
+
+		//The whole batch is ready at once
+		OwUInt64 now = Stopwatch::now();
+		for( size_t i = 0; i < count; ++i )
+		{
+			latency.add( now - received[i].receivedAt );
+		}
+		words += count;
+		finishedAt = now;
+	}
+}
+
+ReceivePipeline::ReceivePipeline( const LabelDispatchTable& aTable, unsigned aWorkerCount, size_t aRingCapacity, size_t aBatchSize )
+	: pacing(0)
+	, replayData(NULL)
+	, replayCount(0)
+	, producerStalls(0)
+	, startedAt(0)
+{
+	unsigned count = aWorkerCount;
+	if( count == 0 )
+	{
+		unsigned cores = WorkerPool::hardwareConcurrency();
+		count = cores > 1 ? cores - 1 : 1;
+	}
+	for( unsigned i = 0; i < count; ++i )
+	{
+		workers.push_back( new Worker( aTable, aRingCapacity, aBatchSize ) );
+	}
+	statistics.words = 0;
+	statistics.unknownLabels = 0;
+	statistics.parityErrors = 0;
+	statistics.producerStalls = 0;
+	statistics.elapsed = 0;
+	statistics.latency50 = 0;
+	statistics.latency90 = 0;
+	statistics.latency99 = 0;
+	statistics.latency999 = 0;
+	statistics.latencyMax = 0;
+}
+
+ReceivePipeline::~ReceivePipeline()
+{
+	for( size_t i = 0; i < workers.size(); ++i )
+	{
+		delete workers[i];
+	}
+}
+
+void ReceivePipeline::setSink( unsigned aWorker, CaptureSink* aSink )
+{
+	if( aWorker < workers.size() )
+	{
+		workers[aWorker]->sink = aSink;
+	}
+}
+
+void ReceivePipeline::setPacing( double aNanosecondsPerTick )
+{
+	pacing = aNanosecondsPerTick;
+}
+
+void ReceivePipeline::produce()
+{
+	const unsigned count = (unsigned)workers.size();
+	const char* record = replayData;
+	OwUInt64 firstTimestamp = replayCount != 0 ? readLittleEndian( record, 8 ) : 0;
+	startedAt = Stopwatch::now();
+	for( size_t i = 0; i < replayCount; ++i, record += CaptureDecoder::RECORD_SIZE )
+	{
+		ReceivedWord received;
+		received.timestamp = readLittleEndian( record, 8 );
+		received.word = (OwUInt32)readLittleEndian( record + 8, 4 );
+		if( pacing > 0 && received.timestamp > firstTimestamp )
+		{
+			//Wait for the time the word was captured at, as a receiver would
+			OwUInt64 due = startedAt + (OwUInt64)((double)(received.timestamp - firstTimestamp) * pacing);
+			SpinWait early;
+			while( Stopwatch::now() < due )
+			{
+				early.wait();
+			}
+		}
+		received.receivedAt = Stopwatch::now();
+
+		SpscRing<ReceivedWord>& ring = workers[workerOf( A429WordCodec::label( received.word ), count )]->ring;
+		if( !ring.tryPush( received ) )
+		{
+			SpinWait full;
+			do
+			{
+				++producerStalls;
+				full.wait();
+			}
+			while( !ring.tryPush( received ) );
+		}
+	}
+	for( unsigned i = 0; i < count; ++i )
+	{
+		workers[i]->ring.close();
+	}
+}
+
+bool ReceivePipeline::replay( const char* aData, size_t aCount )
+{
+	//A thread for the producer and each worker, so they all run at once. With fewer, the
+	//producer would wait forever on the ring of a worker that never starts
+	WorkerMethodTask<ReceivePipeline> producer( this, &ReceivePipeline::produce );
+	TaskGraph graph;
+	graph.add( &producer );
+	for( size_t i = 0; i < workers.size(); ++i )
+	{
+		graph.add( workers[i] );
+	}
+	WorkerPool pool( (unsigned)graph.size() );
+	if( pool.threadCount() != graph.size() )
+	{
+		return false;
+	}
+
+	replayData = aData;
+	replayCount = aCount;
+	producerStalls = 0;
+	for( size_t i = 0; i < workers.size(); ++i )
+	{
+		workers[i]->reset();
+	}
+	pool.run( graph );
+
+	LatencyHistogram latency;
+	statistics.words = 0;
+	statistics.unknownLabels = 0;
+	statistics.parityErrors = 0;
+	statistics.producerStalls = producerStalls;
+	statistics.workerWords.clear();
+	OwUInt64 finishedAt = startedAt;
+	for( size_t i = 0; i < workers.size(); ++i )
+	{
+		const Worker& worker = *workers[i];
+		statistics.words += worker.words;
+		statistics.unknownLabels += worker.unknownLabels;
+		statistics.parityErrors += worker.parityErrors;
+		statistics.workerWords.push_back( worker.words );
+		latency.merge( worker.latency );
+		if( worker.finishedAt > finishedAt )
+		{
+			finishedAt = worker.finishedAt;
+		}
+	}
+	statistics.elapsed = finishedAt - startedAt;
+	statistics.latency50 = latency.percentile( 0.5 );
+	statistics.latency90 = latency.percentile( 0.9 );
+	statistics.latency99 = latency.percentile( 0.99 );
+	statistics.latency999 = latency.percentile( 0.999 );
+	statistics.latencyMax = latency.max();
+	replayData = NULL;
+	replayCount = 0;
+	return true;
+}
+
+bool ReceivePipeline::replayFile( const std::string& aFile )
+{
+	MappedFile file;
+	if( !file.open( aFile ) )
+	{
+		return false;
+	}
+	return replay( file.data(), file.size() / CaptureDecoder::RECORD_SIZE );
+}
+
+void ReceivePipeline::writeJson( std::ostream& aStream, const ReceiveStats& aStats )
+{
+	JsonWriter json( aStream );
+	json.beginObject();
+	json.key( "words" ).value( aStats.words );
+	json.key( "unknownLabels" ).value( aStats.unknownLabels );
+	json.key( "parityErrors" ).value( aStats.parityErrors );
+	json.key( "producerStalls" ).value( aStats.producerStalls );
+	json.key( "ns" ).value( aStats.elapsed );
+	json.key( "wordsPerSecond" ).value( aStats.elapsed == 0 ? 0.0 : (double)aStats.words * 1e9 / (double)aStats.elapsed );
+	json.key( "workerWords" ).beginArray();
+	for( size_t i = 0; i < aStats.workerWords.size(); ++i )
+	{
+		json.value( aStats.workerWords[i] );
+	}
+	json.endArray();
+	json.key( "latencyNs" ).beginObject();
+	json.key( "p50" ).value( aStats.latency50 );
+	json.key( "p90" ).value( aStats.latency90 );
+	json.key( "p99" ).value( aStats.latency99 );
+	json.key( "p999" ).value( aStats.latency999 );
+	json.key( "max" ).value( aStats.latencyMax );
+	json.endObject();
+	json.endObject();
+	aStream << "\n";
+}
+
+/**
+ * Replays a million words of made up traffic of the Flight Management Computer, 360 s of bus
+ * time, through the pipeline: once as fast as it can, and once paced a thousand times faster
+ * than the bus. Writes the stats of both
+ */
+int sample_ReceivePipeline()
+{
+	LoadedCSV loadedCsv;
+	loadedCsv.load("data/ARINC429P1-18-EquipmentIDs.csv",
+		"data/ARINC429P1-18-LabelIDs.csv",
+		"data/ARINC429P1-18-BnrData.csv",
+		"data/ARINC429P1-18-BcdData.csv");
+	LabelDispatchTable table;
+	if( !loadedCsv.buildDispatchTable( 0x002, table ) )
+	{
+		return 1;
+	}
+
+	//Every label it can decode in turn, timestamped in microseconds, a word every 360 us as on a busy 100 kbps bus
+	std::vector<OwUInt8> labels;
+	for( int label = 0; label < 256; ++label )
+	{
+		if( table.lookup( (OwUInt32)label ) != LabelDispatchTable::NO_ENTRY )
+		{
+			labels.push_back( (OwUInt8)label );
+		}
+	}
+	if( labels.empty() )
+	{
+		return 1;
+	}
+	const size_t wordCount = 1000000;
+	std::vector<char> capture;
+	capture.reserve( wordCount * CaptureDecoder::RECORD_SIZE );
+	for( size_t i = 0; i < wordCount; ++i )
+	{
+		OwUInt8 label = labels[i % labels.size()];
+		const A429WordCodec::Descriptor& descriptor = table.descriptor( table.lookup( label ) );
+		OwUInt32 word = A429WordCodec::encode( (double)(i % 100) * descriptor.lsb, label, 0, A429WordCodec::STATUS_NORMAL, descriptor );
+		CaptureDecoder::appendRecord( capture, (OwUInt64)i * 360, word );
+	}
+
+	std::ofstream json( "ReceivePipeline.json" );
+	json << "[\n";
+	ReceivePipeline pipeline( table );
+	if( !pipeline.replay( &capture[0], wordCount ) )
+	{
+		return 1;
+	}
+	ReceivePipeline::writeJson( json, pipeline.stats() );
+	json << ",\n";
+	pipeline.setPacing( 1.0 );	//A nanosecond a microsecond, a thousand times the pace of the bus
+	if( !pipeline.replay( &capture[0], wordCount ) )
+	{
+		return 1;
+	}
+	ReceivePipeline::writeJson( json, pipeline.stats() );
+	json << "]\n";
+	json.close();
+	return json.fail() ? 1 : 0;
+}
@@ -0,0 +1,293 @@
+/**
+ * @file ReceivePipeline.hpp
+ * @brief Replays received words through decode worker threads, measuring how long each word takes.
+ */
+
+#ifndef A429_RECEIVE_PIPELINE_HPP
+#define A429_RECEIVE_PIPELINE_HPP
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include <Owl429/definitions>
+
+#include "CaptureDecoder.hpp"
+#include "LabelDispatchTable.hpp"
+#include "SpscRing.hpp"
+#include "WorkerPool.hpp"
+
+/**
+ * Counts of nanosecond latencies in buckets a sixteenth of a power of 2 wide, so any latency
+ * is counted to within 6.25% in a fixed 8 kB, and adding one never allocates.
+ */
+class LatencyHistogram
+{
+public:
+
+	enum
+	{
+		/**
+		 * @brief The buckets each power of 2 is split into
+		 */
+		SUB_BUCKETS = 16,
+		BUCKET_COUNT = 64 * SUB_BUCKETS
+	};
+
+	LatencyHistogram();
+
+	void clear();
+
+	/**
+	 * Counts a latency
+	 */
+	void add( OwUInt64 aNanoseconds )
+	{
+		++counts[bucketOf( aNanoseconds )];
+		++total;
+		if( aNanoseconds > maximum )
+		{
+			maximum = aNanoseconds;
+		}
+	}
+
+	/**
+	 * Adds the counts of another histogram
+	 */
+	void merge( const LatencyHistogram& aOther );
+
+	/**
+	 * @param aFraction such as 0.99 for the 99th percentile
+	 * @returns the latency that fraction of those counted are at or under, rounded up to the
+	 *          top of its bucket, or 0 if none were counted
+	 */
+	OwUInt64 percentile( double aFraction ) const;
+
+	OwUInt64 count() const		{ return total; }
+	OwUInt64 max() const		{ return maximum; }
+
+private:
+
+	/**
+	 * @returns the bucket of a latency. Those under SUB_BUCKETS have one each
+	 */
+	static size_t bucketOf( OwUInt64 aNanoseconds )
+	{
+		if( aNanoseconds < SUB_BUCKETS )
+		{
+			return (size_t)aNanoseconds;
+		}
+		//The power of 2 it is in, then the 4 bits after the top one
+		unsigned top = 4;
+		while( (aNanoseconds >> (top + 1)) != 0 )
+		{
+			++top;
+		}
+		return (top - 3) * SUB_BUCKETS + (size_t)((aNanoseconds >> (top - 4)) & (SUB_BUCKETS - 1));
+	}
+
+	/**
+	 * @returns the largest latency of a bucket
+	 */
+	static OwUInt64 upperBound( size_t aBucket );
+
+	std::vector<OwUInt64> counts;
+	OwUInt64 total;
+	OwUInt64 maximum;
+};
+
+/**
+ * A word as the receive side gets it
+ */
+typedef struct ReceivedWord
+{
+	/**
+	 * @brief The timestamp of the word, as captured
+	 */
+	OwUInt64 timestamp;
+	/**
+	 * @brief The Stopwatch::now() the word was received at, for its latency
+	 */
+	OwUInt64 receivedAt;
+	OwUInt32 word;
+} ReceivedWord;
+
+/**
+ * What a replay did
+ */
+typedef struct ReceiveStats
+{
+	/**
+	 * @brief The words received and decoded
+	 */
+	OwUInt64 words;
+	/**
+	 * @brief The words whose label and SDI the table has no descriptor for
+	 */
+	OwUInt64 unknownLabels;
+	/**
+	 * @brief The words without odd parity
+	 */
+	OwUInt64 parityErrors;
+	/**
+	 * @brief The times a word found its worker's ring full and had to wait
+	 */
+	OwUInt64 producerStalls;
+	/**
+	 * @brief The nanoseconds from the first word received to the last decoded
+	 */
+	OwUInt64 elapsed;
+	/**
+	 * @brief The words each worker decoded
+	 */
+	std::vector<OwUInt64> workerWords;
+	/**
+	 * @brief The nanoseconds from a word being received to it being decoded and given to
+	 *        the sink, at the 50th, 90th, 99th and 99.9th percentiles and the worst
+	 */
+	OwUInt64 latency50;
+	OwUInt64 latency90;
+	OwUInt64 latency99;
+	OwUInt64 latency999;
+	OwUInt64 latencyMax;
+} ReceiveStats;
+
+/**
+ * Couples received traffic to the specification: a producer thread replays recorded words,
+ * standing in for a chronological monitor channel such as the RxChronMonChannel of the
+ * samples, and hands each to a decode worker through an SpscRing. The workers decode the
+ * words with a LabelDispatchTable built from the loaded sheets, see LoadedCSV::buildDispatchTable,
+ * and give them to a CaptureSink a batch at a time.
+ *
+ * The words of a label always go to the same worker, so each label is decoded in the order it
+ * was received. The rings, batches and latency counts are allocated before the threads start,
+ * so nothing locks or allocates while words flow. A worker with nothing to do spins for a while,
+ * then yields its core.
+ *
+ * Each word is stamped when it is received and again once its batch is decoded, and the
+ * difference is counted in the worker's LatencyHistogram, merged into the percentiles of
+ * stats() at the end.
+ */
+class ReceivePipeline
+{
+public:
+
+	/**
+	 * @param aTable the decoders of the bus. It is not copied, so it must outlive the pipeline
+	 * @param aWorkerCount the decode threads. 0 uses one per core, less the producer's
+	 * @param aRingCapacity the words each worker's ring holds
+	 * @param aBatchSize the most words a worker decodes at a time
+	 */
+	explicit ReceivePipeline( const LabelDispatchTable& aTable, unsigned aWorkerCount = 0, size_t aRingCapacity = 4096, size_t aBatchSize = 256 );
+
+	~ReceivePipeline();
+
+	/**
+	 * Gives the decoded words of a worker to a sink, on the worker's thread. The sink isn't owned
+	 */
+	void setSink( unsigned aWorker, CaptureSink* aSink );
+
+	/**
+	 * Replays the words at the pace they were captured instead of as fast as they can be received
+	 * @param aNanosecondsPerTick the nanoseconds of a timestamp tick, or 0 not to pace
+	 */
+	void setPacing( double aNanosecondsPerTick );
+
+	/**
+	 * Replays capture records held in memory, in the format of CaptureDecoder, and waits for
+	 * every word to be decoded. The producer and every worker need a thread of their own,
+	 * as they wait on each other
+	 * @param aData the records, aCount * CaptureDecoder::RECORD_SIZE bytes
+	 * @returns false if not enough threads could be started, in which case nothing is
+	 *          replayed and the stats are left as they were
+	 */
+	bool replay( const char* aData, size_t aCount );
+
+	/**
+	 * Replays a capture file
+	 * @returns false if the file couldn't be read, or the threads couldn't be started
+	 */
+	bool replayFile( const std::string& aFile );
+
+	/**
+	 * @returns what the last replay did
+	 */
+	const ReceiveStats& stats() const
+	{
+		return statistics;
+	}
+
+	unsigned workerCount() const
+	{
+		return (unsigned)workers.size();
+	}
+
+	/**
+	 * @returns the worker the words of a label go to
+	 */
+	static unsigned workerOf( OwUInt8 aLabel, unsigned aWorkerCount )
+	{
+		return aLabel % aWorkerCount;
+	}
+
+	/**
+	 * Writes replay stats as a JSON object
+	 */
+	static void writeJson( std::ostream& aStream, const ReceiveStats& aStats );
+
+private:
+
+	/**
+	 * A decode thread, with its ring and everything it counts
+	 */
+	class Worker : public WorkerTask
+	{
+	public:
+		Worker( const LabelDispatchTable& aTable, size_t aRingCapacity, size_t aBatchSize );
+
+		/**
+		 * Decodes words until the ring is closed and empty
+		 */
+		void run();
+
+		void reset();
+
+		SpscRing<ReceivedWord> ring;
+		CaptureSink* sink;
+		LatencyHistogram latency;
+		OwUInt64 words;
+		OwUInt64 unknownLabels;
+		OwUInt64 parityErrors;
+		/**
+		 * @brief The Stopwatch::now() the last batch was decoded at
+		 */
+		OwUInt64 finishedAt;
+
+	private:
+		CaptureDecoder decoder;
+		std::vector<ReceivedWord> received;
+		std::vector<DecodedRecord> decoded;
+	};
+
+	//Not copyable
+	ReceivePipeline( const ReceivePipeline& );
+	ReceivePipeline& operator=( const ReceivePipeline& );
+
+	/**
+	 * Receives the words of the replay and hands them to the workers, then closes their rings
+	 */
+	void produce();
+
+	std::vector<Worker*> workers;
+	double pacing;
+	/**
+	 * @brief The records being replayed
+	 */
+	const char* replayData;
+	size_t replayCount;
+	OwUInt64 producerStalls;
+	OwUInt64 startedAt;
+	ReceiveStats statistics;
+};
+
+#endif
@@ -0,0 +1,445 @@
+/**
+ * @file RevisionDiff.cpp
+ * @brief Works out what changed between two revisions of the specification sheets.
+ */
+
+#include "RevisionDiff.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+#include "JsonWriter.hpp"
+
+namespace
+{
+	/**
+	 * The largest 12 bit equipment ID
+	 */
+	const OwUInt16 MAX_EQUIPMENT_ID = 0xFFF;
+
+	/**
+	 * Where wildcard transmissions are keyed, after every equipment ID
+	 */
+	const OwUInt32 WILDCARD_KEY = MAX_EQUIPMENT_ID + 1;
+
+	const char* const CHANGE_KIND_NAMES[RevisionDiff::CHANGE_KIND_COUNT] =
+	{
+		"added",
+		"removed",
+		"changed"
+	};
+
+	const char* const TRANSMISSION_FIELD_NAMES[RevisionDiff::TRANSMISSION_FIELD_COUNT] =
+	{
+		"parameter",
+		"types",
+		"bitOrder",
+		"bnrData",
+		"bcdData"
+	};
+
+	const char* const DATA_FIELD_NAMES[RevisionDiff::DATA_FIELD_COUNT] =
+	{
+		"presence",
+		"units",
+		"range",
+		"sigBits",
+		"posSense",
+		"resolution",
+		"minTransitInterval",
+		"maxTransitInterval",
+		"rate",
+		"maxTransportDelay"
+	};
+
+	/**
+	 * @returns the name of the single flag set in aField, or "unknown"
+	 */
+	const char* flagName( OwUInt16 aField, const char* const* aNames, int aCount )
+	{
+		for( int i = 0; i < aCount; ++i )
+		{
+			if( aField == (1u << i) )
+			{
+				return aNames[i];
+			}
+		}
+		return "unknown";
+	}
+
+	/**
+	 * Writes the names of the flags set in aFields as an array
+	 */
+	void writeFlags( JsonWriter& aJson, OwUInt16 aFields, const char* const* aNames, int aCount )
+	{
+		aJson.beginArray();
+		for( int i = 0; i < aCount; ++i )
+		{
+			if( (aFields & (1u << i)) != 0 )
+			{
+				aJson.value( aNames[i] );
+			}
+		}
+		aJson.endArray();
+	}
+
+	std::string equipmentIdText( OwUInt16 aEquipmentId )
+	{
+		if( aEquipmentId == SpecStore::WILDCARD_EQUIPMENT )
+		{
+			return "*";
+		}
+		std::stringstream id;
+		id << std::hex << std::uppercase << std::setw( 3 ) << std::setfill( '0' ) << aEquipmentId;
+		return id.str();
+	}
+}
+
+RevisionDiff::RevisionDiff()
+{
+}
+
+void RevisionDiff::compare( const SpecStore& aOld, const SpecStore& aNew, Difference& aDifference )
+{
+	aDifference.equipment.clear();
+	aDifference.transmissions.clear();
+	aDifference.affectedEquipment.clear();
+	affected.assign( MAX_EQUIPMENT_ID + 1, false );
+
+	//The equipment, by ID
+	indexEquipment( aOld, oldEquipment );
+	indexEquipment( aNew, newEquipment );
+	for( OwUInt16 id = 0; id <= MAX_EQUIPMENT_ID; ++id )
+	{
+		EquipmentChange change;
+		change.equipmentId = id;
+		change.oldRow = oldEquipment[id];
+		change.newRow = newEquipment[id];
+		if( change.oldRow == SpecStore::NONE && change.newRow == SpecStore::NONE )
+		{
+			continue;
+		}
+		else if( change.oldRow == SpecStore::NONE )
+		{
+			change.kind = ADDED;
+		}
+		else if( change.newRow == SpecStore::NONE )
+		{
+			change.kind = REMOVED;
+		}
+		else if( aOld.equipmentAt( change.oldRow ).type() != aNew.equipmentAt( change.newRow ).type() )
+		{
+			change.kind = CHANGED;	//The type names the file
+		}
+		else
+		{
+			continue;
+		}
+		aDifference.equipment.push_back( change );
+		affected[id] = true;
+	}
+
+	//Then the transmissions, merging the keys of both revisions
+	sortTransmissions( aOld, oldEquipment, oldKeys );
+	sortTransmissions( aNew, newEquipment, newKeys );
+	std::vector<bool> changedLabels( 256, false );
+	OwUInt32 changedCount = 0;
+	size_t i = 0;
+	size_t j = 0;
+	while( i < oldKeys.size() || j < newKeys.size() )
+	{
+		TransmissionChange change;
+		change.oldRow = SpecStore::NONE;
+		change.newRow = SpecStore::NONE;
+		change.fields = 0;
+		change.bnrFields = 0;
+		change.bcdFields = 0;
+		OwUInt32 key = 0;
+		if( j == newKeys.size() || (i < oldKeys.size() && oldKeys[i].key < newKeys[j].key) )
+		{
+			change.kind = REMOVED;
+			key = oldKeys[i].key;
+			change.oldRow = oldKeys[i++].row;
+		}
+		else if( i == oldKeys.size() || newKeys[j].key < oldKeys[i].key )
+		{
+			change.kind = ADDED;
+			key = newKeys[j].key;
+			change.newRow = newKeys[j++].row;
+		}
+		else
+		{
+			change.kind = CHANGED;
+			key = oldKeys[i].key;
+			change.oldRow = oldKeys[i++].row;
+			change.newRow = newKeys[j++].row;
+			change.fields = compareTransmissions( aOld, change.oldRow, aNew, change.newRow, change.bnrFields, change.bcdFields );
+			if( change.fields == 0 )
+			{
+				continue;
+			}
+		}
+		OwUInt32 equipmentKey = key >> 8;
+		change.equipmentId = equipmentKey == WILDCARD_KEY ? SpecStore::WILDCARD_EQUIPMENT : (OwUInt16)equipmentKey;
+		change.label = (OwUInt8)key;
+		aDifference.transmissions.push_back( change );
+		if( equipmentKey != WILDCARD_KEY )
+		{
+			affected[equipmentKey] = true;
+		}
+		else if( !changedLabels[change.label] )
+		{
+			changedLabels[change.label] = true;
+			++changedCount;
+		}
+	}
+	if( changedCount != 0 )
+	{
+		markWildcardUsers( oldEquipment, oldKeys, changedLabels, changedCount );
+		markWildcardUsers( newEquipment, newKeys, changedLabels, changedCount );
+	}
+
+	for( OwUInt16 id = 0; id <= MAX_EQUIPMENT_ID; ++id )
+	{
+		if( affected[id] )
+		{
+			aDifference.affectedEquipment.push_back( id );
+		}
+	}
+}
+
+void RevisionDiff::indexEquipment( const SpecStore& aStore, std::vector<OwUInt32>& aRows )
+{
+	aRows.assign( MAX_EQUIPMENT_ID + 1, (OwUInt32)SpecStore::NONE );
+	for( OwUInt32 i = 0; i < aStore.equipmentCount(); ++i )
+	{
+		OwInt16 id = aStore.equipment.id[i];
+		if( id >= 0 && id <= MAX_EQUIPMENT_ID && aRows[id] == SpecStore::NONE )
+		{
+			aRows[id] = i;	//The first entry for an ID wins
+		}
+	}
+}
+
+void RevisionDiff::sortTransmissions( const SpecStore& aStore, const std::vector<OwUInt32>& aEquipment, std::vector<KeyedRow>& aKeys )
+{
+	const TransmissionColumns& transmissions = aStore.transmissions;
+	scratch.clear();
+	scratch.reserve( transmissions.size() );
+	for( OwUInt32 i = 0; i < transmissions.size(); ++i )
+	{
+		OwUInt16 id = transmissions.equipmentId[i];
+		OwUInt32 equipmentKey = id;
+		if( id == SpecStore::WILDCARD_EQUIPMENT )
+		{
+			equipmentKey = WILDCARD_KEY;
+		}
+		else if( id > MAX_EQUIPMENT_ID || aEquipment[id] == SpecStore::NONE )
+		{
+			continue;	//No equipment has it
+		}
+		KeyedRow keyed;
+		keyed.key = (equipmentKey << 8) | (OwUInt8)transmissions.codeNo[i];
+		keyed.row = i;
+		scratch.push_back( keyed );
+	}
+
+	//Label, then equipment. Both passes are stable, so a key's rows stay in sheet order
+	sortPass( scratch, aKeys, 0, 256 );
+	sortPass( aKeys, scratch, 8, WILDCARD_KEY + 1 );
+
+	//Keep the first row of each key, as loading does
+	aKeys.clear();
+	for( size_t i = 0; i < scratch.size(); ++i )
+	{
+		if( aKeys.empty() || aKeys.back().key != scratch[i].key )
+		{
+			aKeys.push_back( scratch[i] );
+		}
+	}
+}
+
+void RevisionDiff::sortPass( const std::vector<KeyedRow>& aFrom, std::vector<KeyedRow>& aTo, unsigned aShift, OwUInt32 aBuckets )
+{
+	OwUInt32 mask = aShift == 0 ? 0xFF : 0xFFFFFFFF;
+	bucketStarts.assign( aBuckets + 1, 0 );
+	for( size_t i = 0; i < aFrom.size(); ++i )
+	{
+		++bucketStarts[((aFrom[i].key >> aShift) & mask) + 1];
+	}
+	for( OwUInt32 i = 1; i <= aBuckets; ++i )
+	{
+		bucketStarts[i] += bucketStarts[i - 1];
+	}
+	aTo.resize( aFrom.size() );
+	for( size_t i = 0; i < aFrom.size(); ++i )
+	{
+		aTo[bucketStarts[(aFrom[i].key >> aShift) & mask]++] = aFrom[i];
+	}
+}
+
+OwUInt16 RevisionDiff::compareTransmissions( const SpecStore& aOld, OwUInt32 aOldRow, const SpecStore& aNew, OwUInt32 aNewRow,
+	OwUInt16& aBnrFields, OwUInt16& aBcdFields )
+{
+	SpecStore::TransmissionView oldTransmission = aOld.transmissionAt( aOldRow );
+	SpecStore::TransmissionView newTransmission = aNew.transmissionAt( aNewRow );
+	OwUInt16 fields = 0;
+	if( oldTransmission.parameter() != newTransmission.parameter() )
+	{
+		fields |= FIELD_PARAMETER;
+	}
+	if( oldTransmission.types() != newTransmission.types() )
+	{
+		fields |= FIELD_TYPES;
+	}
+	if( oldTransmission.transmissionOrderBitPosition() != newTransmission.transmissionOrderBitPosition() )
+	{
+		fields |= FIELD_BIT_ORDER;
+	}
+
+	//The data save() would use: only that of the types the transmission is marked with
+	SpecStore::DataView none;
+	aBnrFields = compareData( oldTransmission.bnr() ? oldTransmission.bnrData() : none, newTransmission.bnr() ? newTransmission.bnrData() : none );
+	aBcdFields = compareData( oldTransmission.bcd() ? oldTransmission.bcdData() : none, newTransmission.bcd() ? newTransmission.bcdData() : none );
+	if( aBnrFields != 0 )
+	{
+		fields |= FIELD_BNR_DATA;
+	}
+	if( aBcdFields != 0 )
+	{
+		fields |= FIELD_BCD_DATA;
+	}
+	return fields;
+}
+
+OwUInt16 RevisionDiff::compareData( const SpecStore::DataView& aOld, const SpecStore::DataView& aNew )
+{
+	if( aOld.isValid() != aNew.isValid() )
+	{
+		return DATA_PRESENCE;
+	}
+	if( !aOld.isValid() )
+	{
+		return 0;
+	}
+	OwUInt16 fields = 0;
+	fields |= aOld.units() != aNew.units() ? DATA_UNITS : 0;
+	fields |= aOld.range() != aNew.range() ? DATA_RANGE : 0;
+	fields |= aOld.sigBits() != aNew.sigBits() ? DATA_SIG_BITS : 0;
+	fields |= aOld.posSense() != aNew.posSense() ? DATA_POS_SENSE : 0;
+	fields |= aOld.resolution() != aNew.resolution() ? DATA_RESOLUTION : 0;
+	fields |= aOld.minTransitInterval() != aNew.minTransitInterval() ? DATA_MIN_TRANSIT : 0;
+	fields |= aOld.maxTransitInterval() != aNew.maxTransitInterval() ? DATA_MAX_TRANSIT : 0;
+	fields |= aOld.periodUs() != aNew.periodUs() ? DATA_RATE : 0;
+	fields |= aOld.maxTransportDelay() != aNew.maxTransportDelay() ? DATA_MAX_DELAY : 0;
+	return fields;
+}
+
+void RevisionDiff::markWildcardUsers( const std::vector<OwUInt32>& aEquipment, const std::vector<KeyedRow>& aKeys,
+	const std::vector<bool>& aChangedLabels, OwUInt32 aChangedCount )
+{
+	//The keys are in order of equipment, so each equipment's own labels are counted in one walk
+	size_t k = 0;
+	for( OwUInt32 id = 0; id <= MAX_EQUIPMENT_ID; ++id )
+	{
+		OwUInt32 owned = 0;
+		for( ; k < aKeys.size() && (aKeys[k].key >> 8) == id; ++k )
+		{
+			if( aChangedLabels[(OwUInt8)aKeys[k].key] )
+			{
+				++owned;
+			}
+		}
+		if( aEquipment[id] != SpecStore::NONE && owned < aChangedCount )
+		{
+			affected[id] = true;	//It has at least one of the changed wildcards
+		}
+	}
+}
+
+const char* RevisionDiff::changeKindName( ChangeKind aKind )
+{
+	return aKind >= 0 && aKind < CHANGE_KIND_COUNT ? CHANGE_KIND_NAMES[aKind] : "unknown";
+}
+
+const char* RevisionDiff::transmissionFieldName( OwUInt16 aField )
+{
+	return flagName( aField, TRANSMISSION_FIELD_NAMES, TRANSMISSION_FIELD_COUNT );
+}
+
+const char* RevisionDiff::dataFieldName( OwUInt16 aField )
+{
+	return flagName( aField, DATA_FIELD_NAMES, DATA_FIELD_COUNT );
+}
+
+void RevisionDiff::writeJson( std::ostream& aStream, const SpecStore& aOld, const SpecStore& aNew, const Difference& aDifference )
+{
+	JsonWriter json( aStream );
+	json.beginObject();
+	json.key( "equipment" ).beginArray();
+	for( size_t i = 0; i < aDifference.equipment.size(); ++i )
+	{
+		const EquipmentChange& change = aDifference.equipment[i];
+		json.beginObject();
+		json.key( "change" ).value( changeKindName( change.kind ) );
+		json.key( "equipmentId" ).value( equipmentIdText( change.equipmentId ) );
+		if( change.oldRow != SpecStore::NONE )
+		{
+			json.key( "oldType" ).value( aOld.equipmentAt( change.oldRow ).type().str() );
+		}
+		if( change.newRow != SpecStore::NONE )
+		{
+			json.key( "newType" ).value( aNew.equipmentAt( change.newRow ).type().str() );
+		}
+		json.endObject();
+	}
+	json.endArray();
+
+	json.key( "transmissions" ).beginArray();
+	for( size_t i = 0; i < aDifference.transmissions.size(); ++i )
+	{
+		const TransmissionChange& change = aDifference.transmissions[i];
+		std::stringstream code;
+		code << std::oct << std::setw( 3 ) << std::setfill( '0' ) << (int)change.label;
+		json.beginObject();
+		json.key( "change" ).value( changeKindName( change.kind ) );
+		json.key( "equipmentId" ).value( equipmentIdText( change.equipmentId ) );
+		json.key( "label" ).value( code.str() );
+		if( change.oldRow != SpecStore::NONE )
+		{
+			json.key( "oldLine" ).value( aOld.transmissionAt( change.oldRow ).line() );
+		}
+		if( change.newRow != SpecStore::NONE )
+		{
+			json.key( "newLine" ).value( aNew.transmissionAt( change.newRow ).line() );
+		}
+		SpecStore::TransmissionView transmission = change.newRow != SpecStore::NONE ? aNew.transmissionAt( change.newRow ) : aOld.transmissionAt( change.oldRow );
+		json.key( "parameter" ).value( transmission.parameter().str() );
+		if( change.kind == CHANGED )
+		{
+			json.key( "fields" );
+			writeFlags( json, change.fields, TRANSMISSION_FIELD_NAMES, TRANSMISSION_FIELD_COUNT );
+			if( change.bnrFields != 0 )
+			{
+				json.key( "bnrFields" );
+				writeFlags( json, change.bnrFields, DATA_FIELD_NAMES, DATA_FIELD_COUNT );
+			}
+			if( change.bcdFields != 0 )
+			{
+				json.key( "bcdFields" );
+				writeFlags( json, change.bcdFields, DATA_FIELD_NAMES, DATA_FIELD_COUNT );
+			}
+		}
+		json.endObject();
+	}
+	json.endArray();
+
+	json.key( "affectedEquipment" ).beginArray();
+	for( size_t i = 0; i < aDifference.affectedEquipment.size(); ++i )
+	{
+		json.value( equipmentIdText( aDifference.affectedEquipment[i] ) );
+	}
+	json.endArray();
+	json.endObject();
+	aStream << "\n";
+}
@@ -0,0 +1,253 @@
+/**
+ * @file RevisionDiff.hpp
+ * @brief Works out what changed between two revisions of the specification sheets.
+ */
+
+#ifndef A429_REVISION_DIFF_HPP
+#define A429_REVISION_DIFF_HPP
+
+#include <vector>
+#include <ostream>
+
+#include <Owl429/definitions>
+
+#include "SpecStore.hpp"
+
+/**
+ * Compares two loaded revisions, such as ARINC429P1-18 and the next, as save() would configure them.
+ *
+ * The equipment are matched by ID and the transmissions by equipment ID and label, using the
+ * rows loading keeps: the first for an ID or a key, and only transmissions of equipment there
+ * are. Wildcard transmissions are keyed under their own equipment, after every real one. The
+ * keys of each revision are put in order with a counting sort, label then equipment, and the two
+ * lists are merged, so a comparison takes time in proportion to the rows. The BNR and BCD data
+ * of a transmission are compared as it resolves them, wildcard data included.
+ *
+ * Along with the changes comes the equipment whose configuration they affect, so only those
+ * files need writing again. A change to a wildcard transmission affects every equipment that
+ * doesn't have its own transmission of the label.
+ *
+ * The key lists are kept in buffers that are reused from comparison to comparison.
+ */
+class RevisionDiff
+{
+public:
+
+	/**
+	 * How a row changed
+	 */
+	enum ChangeKind
+	{
+		/**
+		 * @brief Only in the new revision
+		 */
+		ADDED,
+		/**
+		 * @brief Only in the old revision
+		 */
+		REMOVED,
+		/**
+		 * @brief In both, with different fields
+		 */
+		CHANGED,
+		CHANGE_KIND_COUNT
+	};
+
+	/**
+	 * The fields of a transmission that differ, as flags
+	 */
+	enum TransmissionField
+	{
+		FIELD_PARAMETER = 0x01,
+		FIELD_TYPES = 0x02,
+		FIELD_BIT_ORDER = 0x04,
+		/**
+		 * @brief Some of the BNR data, see bnrFields
+		 */
+		FIELD_BNR_DATA = 0x08,
+		/**
+		 * @brief Some of the BCD data, see bcdFields
+		 */
+		FIELD_BCD_DATA = 0x10,
+		TRANSMISSION_FIELD_COUNT = 5
+	};
+
+	/**
+	 * The fields of the BNR or BCD data of a transmission that differ, as flags
+	 */
+	enum DataField
+	{
+		/**
+		 * @brief One revision has the data and the other doesn't. The other flags are left clear
+		 */
+		DATA_PRESENCE = 0x001,
+		DATA_UNITS = 0x002,
+		DATA_RANGE = 0x004,
+		DATA_SIG_BITS = 0x008,
+		DATA_POS_SENSE = 0x010,
+		DATA_RESOLUTION = 0x020,
+		DATA_MIN_TRANSIT = 0x040,
+		DATA_MAX_TRANSIT = 0x080,
+		/**
+		 * @brief The rate, as the period it is sent at
+		 */
+		DATA_RATE = 0x100,
+		DATA_MAX_DELAY = 0x200,
+		DATA_FIELD_COUNT = 10
+	};
+
+	/**
+	 * An equipment added, removed or renamed
+	 */
+	typedef struct EquipmentChange
+	{
+		ChangeKind kind;
+		OwUInt16 equipmentId;
+		/**
+		 * @brief The equipment row in each revision, or SpecStore::NONE
+		 */
+		OwUInt32 oldRow;
+		OwUInt32 newRow;
+	} EquipmentChange;
+
+	/**
+	 * A transmission added, removed or changed
+	 */
+	typedef struct TransmissionChange
+	{
+		ChangeKind kind;
+		/**
+		 * @brief The equipment ID, or SpecStore::WILDCARD_EQUIPMENT
+		 */
+		OwUInt16 equipmentId;
+		OwUInt8 label;
+		/**
+		 * @brief The transmission row in each revision, or SpecStore::NONE
+		 */
+		OwUInt32 oldRow;
+		OwUInt32 newRow;
+		/**
+		 * @brief The TransmissionField flags of what changed, 0 unless CHANGED
+		 */
+		OwUInt16 fields;
+		/**
+		 * @brief The DataField flags of what changed in the BNR and BCD data
+		 */
+		OwUInt16 bnrFields;
+		OwUInt16 bcdFields;
+	} TransmissionChange;
+
+	/**
+	 * Everything that changed between two revisions
+	 */
+	typedef struct Difference
+	{
+		/**
+		 * @brief In order of equipment ID
+		 */
+		std::vector<EquipmentChange> equipment;
+		/**
+		 * @brief In order of equipment ID then label, the wildcards last
+		 */
+		std::vector<TransmissionChange> transmissions;
+		/**
+		 * @brief The IDs of the equipment whose configuration changed, in order, those removed included
+		 */
+		std::vector<OwUInt16> affectedEquipment;
+	} Difference;
+
+	RevisionDiff();
+
+	/**
+	 * Compares two revisions
+	 * @param aDifference cleared, then filled with the changes from aOld to aNew
+	 */
+	void compare( const SpecStore& aOld, const SpecStore& aNew, Difference& aDifference );
+
+	/**
+	 * Writes a difference as a JSON object with the equipment changes, the transmission
+	 * changes with the names of the fields that changed, and the affected equipment IDs
+	 */
+	static void writeJson( std::ostream& aStream, const SpecStore& aOld, const SpecStore& aNew, const Difference& aDifference );
+
+	/**
+	 * @returns the name of a kind of change, as written by writeJson
+	 */
+	static const char* changeKindName( ChangeKind aKind );
+
+	/**
+	 * @returns the name of a TransmissionField flag, as written by writeJson
+	 */
+	static const char* transmissionFieldName( OwUInt16 aField );
+
+	/**
+	 * @returns the name of a DataField flag, as written by writeJson
+	 */
+	static const char* dataFieldName( OwUInt16 aField );
+
+private:
+
+	/**
+	 * A transmission row with its equipment and label packed into one key
+	 */
+	typedef struct KeyedRow
+	{
+		OwUInt32 key;
+		OwUInt32 row;
+	} KeyedRow;
+
+	//Not copyable
+	RevisionDiff( const RevisionDiff& );
+	RevisionDiff& operator=( const RevisionDiff& );
+
+	/**
+	 * Indexes the equipment of a revision by ID, the first row of each
+	 */
+	static void indexEquipment( const SpecStore& aStore, std::vector<OwUInt32>& aRows );
+
+	/**
+	 * Lists the transmissions loading keeps, in order of key
+	 * @param aEquipment the equipment index of the revision
+	 */
+	void sortTransmissions( const SpecStore& aStore, const std::vector<OwUInt32>& aEquipment, std::vector<KeyedRow>& aKeys );
+
+	/**
+	 * One stable counting sort pass over a field of the keys
+	 */
+	void sortPass( const std::vector<KeyedRow>& aFrom, std::vector<KeyedRow>& aTo, unsigned aShift, OwUInt32 aBuckets );
+
+	/**
+	 * @returns the TransmissionField flags of what differs between two transmission rows
+	 */
+	static OwUInt16 compareTransmissions( const SpecStore& aOld, OwUInt32 aOldRow, const SpecStore& aNew, OwUInt32 aNewRow,
+		OwUInt16& aBnrFields, OwUInt16& aBcdFields );
+
+	/**
+	 * @returns the DataField flags of what differs between the data two transmissions resolve to
+	 */
+	static OwUInt16 compareData( const SpecStore::DataView& aOld, const SpecStore::DataView& aNew );
+
+	/**
+	 * Marks the equipment of a revision without their own transmission of a changed wildcard label
+	 * @param aKeys the sorted transmissions of the revision
+	 * @param aChangedLabels for each label, whether its wildcard transmission changed
+	 */
+	void markWildcardUsers( const std::vector<OwUInt32>& aEquipment, const std::vector<KeyedRow>& aKeys,
+		const std::vector<bool>& aChangedLabels, OwUInt32 aChangedCount );
+
+	std::vector<KeyedRow> oldKeys;
+	std::vector<KeyedRow> newKeys;
+	/**
+	 * @brief The keys between sort passes
+	 */
+	std::vector<KeyedRow> scratch;
+	std::vector<OwUInt32> bucketStarts;
+	std::vector<OwUInt32> oldEquipment;
+	std::vector<OwUInt32> newEquipment;
+	/**
+	 * @brief Whether the configuration of each equipment ID changed
+	 */
+	std::vector<bool> affected;
+};
+
+#endif
@@ -0,0 +1,289 @@
+/**
+ * @file ScheduleAnalyzer.cpp
+ * @brief Works out the transmit schedule of each equipment and how much of the bus it takes.
+ */
+
+#include "ScheduleAnalyzer.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "JsonWriter.hpp"
+
+namespace
+{
+	/**
+	 * The longest hyperperiod counted, about 12 days. Anything longer is reported as 0
+	 */
+	const OwUInt64 MAX_HYPERPERIOD_US = (OwUInt64)1 << 40;
+
+	OwUInt64 greatestCommonDivisor( OwUInt64 aA, OwUInt64 aB )
+	{
+		while( aB != 0 )
+		{
+			OwUInt64 remainder = aA % aB;
+			aA = aB;
+			aB = remainder;
+		}
+		return aA;
+	}
+
+	/**
+	 * Orders labels by period, then label, so the schedule doesn't depend on the sheet order
+	 */
+	bool shorterPeriod( const ScheduleAnalyzer::ScheduledLabel& aA, const ScheduleAnalyzer::ScheduledLabel& aB )
+	{
+		if( aA.periodUs != aB.periodUs )
+		{
+			return aA.periodUs < aB.periodUs;
+		}
+		if( aA.label != aB.label )
+		{
+			return aA.label < aB.label;
+		}
+		return aA.transmission < aB.transmission;
+	}
+
+	void writeRates( JsonWriter& aJson, const double aUtilization[] )
+	{
+		aJson.beginObject();
+		aJson.key( "12.5kbps" ).value( aUtilization[ScheduleAnalyzer::LOW_SPEED] );
+		aJson.key( "100kbps" ).value( aUtilization[ScheduleAnalyzer::HIGH_SPEED] );
+		aJson.endObject();
+	}
+}
+
+ScheduleAnalyzer::ScheduleAnalyzer()
+{
+}
+
+OwUInt32 ScheduleAnalyzer::bitsPerSecond( BitRate aRate )
+{
+	return aRate == LOW_SPEED ? 12500 : 100000;
+}
+
+OwUInt32 ScheduleAnalyzer::periodOf( const SpecStore::TransmissionView& aTransmission )
+{
+	//The same choice as save(): the BCD rate if there is one, then the BNR rate
+	SpecStore::DataView bcdData = aTransmission.bcdData();
+	if( aTransmission.bcd() && bcdData.isValid() )
+	{
+		return bcdData.periodUs();
+	}
+	SpecStore::DataView bnrData = aTransmission.bnrData();
+	if( aTransmission.bnr() && bnrData.isValid() )
+	{
+		return bnrData.periodUs();
+	}
+	return 0;
+}
+
+double ScheduleAnalyzer::utilization( OwUInt64 aWords, OwUInt64 aTimeUs, BitRate aRate )
+{
+	if( aTimeUs == 0 )
+	{
+		return 0;
+	}
+	return (double)(aWords * WORD_BITS) * 1000000.0 / ((double)bitsPerSecond( aRate ) * (double)aTimeUs);
+}
+
+OwUInt32 ScheduleAnalyzer::addLabel( std::vector<OwUInt32>& aFrames, OwUInt32 aFrameUs, OwUInt64 aSpanUs, OwUInt32 aPeriodUs, OwUInt32 aOffsetUs )
+{
+	OwUInt32 words = 0;
+	for( OwUInt64 time = aOffsetUs; time < aSpanUs; time += aPeriodUs )
+	{
+		++aFrames[(size_t)(time / aFrameUs)];
+		++words;
+	}
+	return words;
+}
+
+OwUInt32 ScheduleAnalyzer::pickOffset( const std::vector<OwUInt32>& aFrames, OwUInt32 aFrameUs, OwUInt64 aSpanUs, OwUInt32 aPeriodUs )
+{
+	OwUInt32 bestOffset = 0;
+	OwUInt32 bestPeak = 0;
+	OwUInt64 bestTotal = 0;
+	bool first = true;
+	for( OwUInt32 offset = 0; offset < aPeriodUs && offset < aSpanUs; offset += aFrameUs )
+	{
+		OwUInt32 peak = 0;
+		OwUInt64 total = 0;
+		for( OwUInt64 time = offset; time < aSpanUs; time += aPeriodUs )
+		{
+			OwUInt32 words = aFrames[(size_t)(time / aFrameUs)];
+			peak = words > peak ? words : peak;
+			total += words;
+		}
+		if( first || peak < bestPeak || (peak == bestPeak && total < bestTotal) )
+		{
+			bestOffset = offset;
+			bestPeak = peak;
+			bestTotal = total;
+			first = false;
+		}
+		if( bestPeak == 0 )
+		{
+			break;	//Every frame it lands in is empty, which can't be beaten
+		}
+	}
+	return bestOffset;
+}
+
+void ScheduleAnalyzer::analyze( const SpecStore& aStore, OwUInt32 aEquipment, EquipmentSchedule& aSchedule )
+{
+	aSchedule.equipment = aEquipment;
+	aSchedule.labels.clear();
+	aSchedule.unscheduled = 0;
+	aSchedule.minorFrameUs = 0;
+	aSchedule.hyperperiodUs = 0;
+	aSchedule.frameCount = 0;
+	aSchedule.truncated = false;
+	aSchedule.words = 0;
+	aSchedule.peakWords = 0;
+	aSchedule.staggeredPeakWords = 0;
+	aSchedule.frameWords.clear();
+	for( int rate = 0; rate < BIT_RATE_COUNT; ++rate )
+	{
+		aSchedule.averageUtilization[rate] = 0;
+		aSchedule.peakUtilization[rate] = 0;
+		aSchedule.staggeredPeakUtilization[rate] = 0;
+	}
+
+	//Gather the labels with a period
+	SpecStore::EquipmentView equipment = aStore.equipmentAt( aEquipment );
+	for( OwUInt32 i = 0; i < equipment.transmissionCount(); ++i )
+	{
+		SpecStore::TransmissionView transmission = equipment.transmission( i );
+		OwUInt32 period = periodOf( transmission );
+		if( period == 0 )
+		{
+			++aSchedule.unscheduled;
+			continue;
+		}
+		ScheduledLabel label;
+		label.transmission = transmission.index();
+		label.label = (OwUInt8)transmission.codeNo();
+		label.periodUs = period;
+		label.offsetUs = 0;
+		aSchedule.labels.push_back( label );
+	}
+	if( aSchedule.labels.empty() )
+	{
+		return;
+	}
+	std::sort( aSchedule.labels.begin(), aSchedule.labels.end(), shorterPeriod );
+
+	//The minor frame divides every period, and the hyperperiod is divided by every period
+	OwUInt64 divisor = 0;
+	OwUInt64 hyperperiod = 1;
+	for( size_t i = 0; i < aSchedule.labels.size(); ++i )
+	{
+		OwUInt64 period = aSchedule.labels[i].periodUs;
+		divisor = greatestCommonDivisor( divisor, period );
+		if( hyperperiod != 0 )
+		{
+			//Checked before multiplying, so that the product can't wrap
+			OwUInt64 reduced = hyperperiod / greatestCommonDivisor( hyperperiod, period );
+			hyperperiod = reduced > MAX_HYPERPERIOD_US / period ? 0 : reduced * period;
+		}
+	}
+	OwUInt32 frameUs = divisor < MIN_FRAME_US ? (OwUInt32)MIN_FRAME_US : (OwUInt32)divisor;
+	OwUInt64 frames = hyperperiod == 0 ? (OwUInt64)MAX_FRAMES + 1 : (hyperperiod + frameUs - 1) / frameUs;
+	aSchedule.truncated = frames > MAX_FRAMES;
+	aSchedule.frameCount = aSchedule.truncated ? (OwUInt32)MAX_FRAMES : (OwUInt32)frames;
+	aSchedule.minorFrameUs = frameUs;
+	aSchedule.hyperperiodUs = hyperperiod;
+	OwUInt64 span = aSchedule.truncated ? (OwUInt64)aSchedule.frameCount * frameUs : hyperperiod;
+
+	//Every label starting at once
+	unstaggered.assign( aSchedule.frameCount, 0 );
+	for( size_t i = 0; i < aSchedule.labels.size(); ++i )
+	{
+		aSchedule.words += addLabel( unstaggered, frameUs, span, aSchedule.labels[i].periodUs, 0 );
+	}
+	aSchedule.peakWords = *std::max_element( unstaggered.begin(), unstaggered.end() );
+
+	//Then staggered, placing the most frequent labels first while there is the most room
+	aSchedule.frameWords.assign( aSchedule.frameCount, 0 );
+	for( size_t i = 0; i < aSchedule.labels.size(); ++i )
+	{
+		ScheduledLabel& label = aSchedule.labels[i];
+		label.offsetUs = pickOffset( aSchedule.frameWords, frameUs, span, label.periodUs );
+		addLabel( aSchedule.frameWords, frameUs, span, label.periodUs, label.offsetUs );
+	}
+	aSchedule.staggeredPeakWords = *std::max_element( aSchedule.frameWords.begin(), aSchedule.frameWords.end() );
+
+	for( int rate = 0; rate < BIT_RATE_COUNT; ++rate )
+	{
+		aSchedule.averageUtilization[rate] = utilization( aSchedule.words, span, (BitRate)rate );
+		aSchedule.peakUtilization[rate] = utilization( aSchedule.peakWords, frameUs, (BitRate)rate );
+		aSchedule.staggeredPeakUtilization[rate] = utilization( aSchedule.staggeredPeakWords, frameUs, (BitRate)rate );
+	}
+}
+
+void ScheduleAnalyzer::analyzeAll( const SpecStore& aStore, std::vector<EquipmentSchedule>& aSchedules )
+{
+	aSchedules.resize( aStore.equipmentCount() );
+	for( OwUInt32 i = 0; i < aStore.equipmentCount(); ++i )
+	{
+		analyze( aStore, i, aSchedules[i] );
+	}
+}
+
+void ScheduleAnalyzer::writeJson( std::ostream& aStream, const SpecStore& aStore, const std::vector<EquipmentSchedule>& aSchedules, bool aFrameWords )
+{
+	JsonWriter json( aStream );
+	json.beginArray();
+	for( size_t i = 0; i < aSchedules.size(); ++i )
+	{
+		const EquipmentSchedule& schedule = aSchedules[i];
+		SpecStore::EquipmentView equipment = aStore.equipmentAt( schedule.equipment );
+		std::stringstream id;
+		id << std::hex << std::uppercase << std::setw( 3 ) << std::setfill( '0' ) << equipment.id();
+
+		json.beginObject();
+		json.key( "equipmentId" ).value( id.str() );
+		json.key( "type" ).value( equipment.type().str() );
+		json.key( "scheduled" ).value( (OwUInt32)schedule.labels.size() );
+		json.key( "unscheduled" ).value( schedule.unscheduled );
+		json.key( "minorFrameUs" ).value( schedule.minorFrameUs );
+		json.key( "hyperperiodUs" ).value( schedule.hyperperiodUs );
+		json.key( "frames" ).value( schedule.frameCount );
+		json.key( "truncated" ).value( schedule.truncated );
+		json.key( "words" ).value( schedule.words );
+		json.key( "peakWords" ).value( schedule.peakWords );
+		json.key( "staggeredPeakWords" ).value( schedule.staggeredPeakWords );
+		json.key( "averageUtilization" );
+		writeRates( json, schedule.averageUtilization );
+		json.key( "peakUtilization" );
+		writeRates( json, schedule.peakUtilization );
+		json.key( "staggeredPeakUtilization" );
+		writeRates( json, schedule.staggeredPeakUtilization );
+		json.key( "labels" ).beginArray();
+		for( size_t j = 0; j < schedule.labels.size(); ++j )
+		{
+			const ScheduledLabel& label = schedule.labels[j];
+			std::stringstream code;
+			code << std::oct << std::setw( 3 ) << std::setfill( '0' ) << (int)label.label;
+			json.beginObject();
+			json.key( "label" ).value( code.str() );
+			json.key( "periodUs" ).value( label.periodUs );
+			json.key( "offsetUs" ).value( label.offsetUs );
+			json.endObject();
+		}
+		json.endArray();
+		if( aFrameWords )
+		{
+			json.key( "frameWords" ).beginArray();
+			for( size_t j = 0; j < schedule.frameWords.size(); ++j )
+			{
+				json.value( schedule.frameWords[j] );
+			}
+			json.endArray();
+		}
+		json.endObject();
+	}
+	json.endArray();
+	aStream << "\n";
+}
@@ -0,0 +1,208 @@
+/**
+ * @file ScheduleAnalyzer.hpp
+ * @brief Works out the transmit schedule of each equipment and how much of the bus it takes.
+ */
+
+#ifndef A429_SCHEDULE_ANALYZER_HPP
+#define A429_SCHEDULE_ANALYZER_HPP
+
+#include <vector>
+#include <ostream>
+
+#include <Owl429/definitions>
+
+#include "SpecStore.hpp"
+
+/**
+ * Checks whether the labels an equipment transmits fit its bus, as save() configures them.
+ *
+ * Each label is sent every periodUs of its BCD data, or failing that its BNR data. Time is
+ * divided into minor frames of the greatest common divisor of the periods, and the pattern
+ * repeats every hyperperiod, their least common multiple. Counting the words sent in each
+ * minor frame gives the peak load, where every label is sent at the same time, and the
+ * average load. A phase offset is then picked for each label to spread the words evenly.
+ *
+ * Everything is counted in whole microseconds and words. The frame counts are kept in one
+ * buffer that is reused from equipment to equipment.
+ */
+class ScheduleAnalyzer
+{
+public:
+
+	/**
+	 * The bit rates of an ARINC 429 bus
+	 */
+	enum BitRate
+	{
+		/**
+		 * @brief 12.5 kbps
+		 */
+		LOW_SPEED,
+		/**
+		 * @brief 100 kbps
+		 */
+		HIGH_SPEED,
+		BIT_RATE_COUNT
+	};
+
+	enum
+	{
+		/**
+		 * @brief The bit times a word takes on the bus: 32 bits, then the 4 bit gap
+		 */
+		WORD_BITS = 36,
+		/**
+		 * @brief The shortest minor frame, long enough for a word at 12.5 kbps.
+		 *        Periods whose divisor is shorter are counted in frames this long
+		 */
+		MIN_FRAME_US = 5000,
+		/**
+		 * @brief The most minor frames analyzed. Longer hyperperiods are cut short
+		 */
+		MAX_FRAMES = 4096
+	};
+
+	/**
+	 * A label an equipment sends periodically
+	 */
+	typedef struct ScheduledLabel
+	{
+		/**
+		 * @brief The transmission row
+		 */
+		OwUInt32 transmission;
+		/**
+		 * @brief The label code
+		 */
+		OwUInt8 label;
+		/**
+		 * @brief How often it is sent
+		 */
+		OwUInt32 periodUs;
+		/**
+		 * @brief When it is first sent in the staggered schedule, less than periodUs
+		 */
+		OwUInt32 offsetUs;
+	} ScheduledLabel;
+
+	/**
+	 * The schedule of one equipment, and the load it puts on the bus
+	 */
+	typedef struct EquipmentSchedule
+	{
+		/**
+		 * @brief The equipment row
+		 */
+		OwUInt32 equipment;
+		/**
+		 * @brief The labels with a period, shortest period first
+		 */
+		std::vector<ScheduledLabel> labels;
+		/**
+		 * @brief The transmissions without BNR or BCD data giving a rate, which aren't scheduled
+		 */
+		OwUInt32 unscheduled;
+		/**
+		 * @brief The length of a minor frame
+		 */
+		OwUInt32 minorFrameUs;
+		/**
+		 * @brief The time after which the schedule repeats, or 0 if it is too long to count
+		 */
+		OwUInt64 hyperperiodUs;
+		/**
+		 * @brief The minor frames analyzed. Fewer than the hyperperiod holds if it is truncated
+		 */
+		OwUInt32 frameCount;
+		/**
+		 * @brief True if the hyperperiod is longer than MAX_FRAMES minor frames
+		 */
+		bool truncated;
+		/**
+		 * @brief The words sent over the frames analyzed
+		 */
+		OwUInt64 words;
+		/**
+		 * @brief The most words in a minor frame when every label starts at once
+		 */
+		OwUInt32 peakWords;
+		/**
+		 * @brief The most words in a minor frame with the staggered offsets
+		 */
+		OwUInt32 staggeredPeakWords;
+		/**
+		 * @brief The words in each minor frame with the staggered offsets, frameCount of them
+		 */
+		std::vector<OwUInt32> frameWords;
+		/**
+		 * @brief The share of the bus used on average, by BitRate
+		 */
+		double averageUtilization[BIT_RATE_COUNT];
+		/**
+		 * @brief The share of the busiest minor frame used when every label starts at once, by BitRate
+		 */
+		double peakUtilization[BIT_RATE_COUNT];
+		/**
+		 * @brief The share of the busiest minor frame used with the staggered offsets, by BitRate
+		 */
+		double staggeredPeakUtilization[BIT_RATE_COUNT];
+	} EquipmentSchedule;
+
+	ScheduleAnalyzer();
+
+	/**
+	 * Schedules the labels of an equipment and measures their load
+	 * @param aEquipment the equipment row
+	 * @param aSchedule filled with the result. Reusing one keeps its buffers
+	 */
+	void analyze( const SpecStore& aStore, OwUInt32 aEquipment, EquipmentSchedule& aSchedule );
+
+	/**
+	 * Analyzes every equipment
+	 * @param aSchedules resized to the equipment count and filled in equipment order
+	 */
+	void analyzeAll( const SpecStore& aStore, std::vector<EquipmentSchedule>& aSchedules );
+
+	/**
+	 * @returns the bits per second of a bit rate
+	 */
+	static OwUInt32 bitsPerSecond( BitRate aRate );
+
+	/**
+	 * @returns the period a transmission is sent with, as save() sets it, or 0 if it has none
+	 */
+	static OwUInt32 periodOf( const SpecStore::TransmissionView& aTransmission );
+
+	/**
+	 * Writes schedules as a JSON array
+	 * @param aFrameWords whether to write the words of every minor frame
+	 */
+	static void writeJson( std::ostream& aStream, const SpecStore& aStore, const std::vector<EquipmentSchedule>& aSchedules, bool aFrameWords );
+
+private:
+
+	/**
+	 * Adds the words of a label to the frames, starting at an offset
+	 * @param aSpanUs the time the frames cover
+	 * @returns the words added
+	 */
+	static OwUInt32 addLabel( std::vector<OwUInt32>& aFrames, OwUInt32 aFrameUs, OwUInt64 aSpanUs, OwUInt32 aPeriodUs, OwUInt32 aOffsetUs );
+
+	/**
+	 * Picks the offset of a label, on a frame boundary, that keeps the busiest frame it lands in
+	 * as quiet as possible, then the frames it lands in as a whole
+	 */
+	static OwUInt32 pickOffset( const std::vector<OwUInt32>& aFrames, OwUInt32 aFrameUs, OwUInt64 aSpanUs, OwUInt32 aPeriodUs );
+
+	/**
+	 * @returns the share of a frame that some words take at a bit rate
+	 */
+	static double utilization( OwUInt64 aWords, OwUInt64 aTimeUs, BitRate aRate );
+
+	/**
+	 * @brief The frame counts when every label starts at once, reused between equipment
+	 */
+	std::vector<OwUInt32> unstaggered;
+};
+
+#endif
@@ -0,0 +1,281 @@
+/**
+ * @file SpecQuery.cpp
+ * @brief Secondary indexes over a SpecStore, for answering questions about the loaded sheets.
+ */
+
+#include "SpecQuery.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace
+{
+	/**
+	 * @returns the number of bits set
+	 */
+	OwUInt32 bitCount( OwUInt32 aWord )
+	{
+		aWord = aWord - ((aWord >> 1) & 0x55555555);
+		aWord = (aWord & 0x33333333) + ((aWord >> 2) & 0x33333333);
+		return (((aWord + (aWord >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+	}
+
+	/**
+	 * Skips the whitespace at both ends of a string
+	 * @param aLength the length of the string, set to the length without it
+	 * @returns where the string starts without it
+	 */
+	const char* trim( const char* aText, size_t& aLength )
+	{
+		while( aLength > 0 && isspace( (unsigned char)aText[0] ) )
+		{
+			++aText;
+			--aLength;
+		}
+		while( aLength > 0 && isspace( (unsigned char)aText[aLength - 1] ) )
+		{
+			--aLength;
+		}
+		return aText;
+	}
+}
+
+SpecQuery::SpecQuery()
+	: store(NULL)
+{
+	clear();
+}
+
+void SpecQuery::clear()
+{
+	store = NULL;
+	labelOffsets.assign( 257, 0 );
+	labelLinks.clear();
+	wildcardOffsets.assign( 257, 0 );
+	wildcardRows.clear();
+	labelSets.clear();
+	std::fill( wildcardLabels, wildcardLabels + LABEL_WORDS, 0 );
+	typeOffsets.assign( TYPE_COUNT + 1, 0 );
+	typeRows.clear();
+	trimmedNames.clear();
+	nameOffsets.assign( 1, 0 );
+	nameRows.clear();
+	parameterSearch.clear();
+}
+
+void SpecQuery::build( const SpecStore& aStore )
+{
+	clear();
+	store = &aStore;
+	const EquipmentColumns& equipment = aStore.equipment;
+	const TransmissionColumns& transmissions = aStore.transmissions;
+
+	//Label to wildcards, counted then placed so each label's are in order
+	const std::vector<OwUInt32>& wildcards = equipment.wildcardLinks;
+	for( size_t i = 0; i < wildcards.size(); ++i )
+	{
+		OwUInt8 label = (OwUInt8)transmissions.codeNo[wildcards[i]];
+		++wildcardOffsets[label + 1];
+		wildcardLabels[label / 32] |= 1u << (label % 32);
+	}
+	for( size_t i = 1; i < wildcardOffsets.size(); ++i )
+	{
+		wildcardOffsets[i] += wildcardOffsets[i - 1];
+	}
+	wildcardRows.resize( wildcards.size() );
+	std::vector<OwUInt32> next( wildcardOffsets.begin(), wildcardOffsets.end() - 1 );
+	for( size_t i = 0; i < wildcards.size(); ++i )
+	{
+		wildcardRows[next[(OwUInt8)transmissions.codeNo[wildcards[i]]]++] = wildcards[i];
+	}
+
+	//Label to links, the same way so each label's links are in equipment order
+	labelSets.assign( (size_t)aStore.equipmentCount() * LABEL_WORDS, 0 );
+	for( OwUInt32 i = 0; i < aStore.equipmentCount(); ++i )
+	{
+		for( OwUInt32 j = 0; j < equipment.linkCount[i]; ++j )
+		{
+			OwUInt8 label = (OwUInt8)transmissions.codeNo[equipment.links[equipment.firstLink[i] + j]];
+			++labelOffsets[label + 1];
+			labelSets[i * LABEL_WORDS + label / 32] |= 1u << (label % 32);
+		}
+	}
+	for( size_t i = 1; i < labelOffsets.size(); ++i )
+	{
+		labelOffsets[i] += labelOffsets[i - 1];
+	}
+	labelLinks.resize( labelOffsets.back() );
+	next.assign( labelOffsets.begin(), labelOffsets.end() - 1 );
+	for( OwUInt32 i = 0; i < aStore.equipmentCount(); ++i )
+	{
+		for( OwUInt32 j = 0; j < equipment.linkCount[i]; ++j )
+		{
+			OwUInt32 transmission = equipment.links[equipment.firstLink[i] + j];
+			Link& link = labelLinks[next[(OwUInt8)transmissions.codeNo[transmission]]++];
+			link.equipment = i;
+			link.transmission = transmission;
+		}
+	}
+
+	//Type to transmissions, the same way
+	for( OwUInt32 i = 0; i < aStore.transmissionCount(); ++i )
+	{
+		for( int type = 0; type < TYPE_COUNT; ++type )
+		{
+			typeOffsets[type + 1] += (transmissions.types[i] >> type) & 1;
+		}
+	}
+	for( int type = 0; type < TYPE_COUNT; ++type )
+	{
+		typeOffsets[type + 1] += typeOffsets[type];
+	}
+	typeRows.resize( typeOffsets.back() );
+	OwUInt32 typeNext[TYPE_COUNT];
+	std::copy( typeOffsets.begin(), typeOffsets.end() - 1, typeNext );
+	for( OwUInt32 i = 0; i < aStore.transmissionCount(); ++i )
+	{
+		for( int type = 0; type < TYPE_COUNT; ++type )
+		{
+			if( (transmissions.types[i] >> type) & 1 )
+			{
+				typeRows[typeNext[type]++] = i;
+			}
+		}
+	}
+
+	//Parameter name to transmissions. The names are interned again without the whitespace at their ends,
+	//so "Gross Weight " and "Gross Weight" share a handle that groups their rows; counted then placed
+	std::vector<OwUInt32> nameOf( transmissions.strings.size() );
+	for( StringPool::Handle name = 0; name < transmissions.strings.size(); ++name )
+	{
+		PooledString text = transmissions.strings.get( name );
+		size_t length = text.size();
+		const char* trimmed = trim( text.data(), length );
+		nameOf[name] = trimmedNames.intern( trimmed, length );
+	}
+	nameOffsets.assign( trimmedNames.size() + 1, 0 );
+	for( OwUInt32 i = 0; i < aStore.transmissionCount(); ++i )
+	{
+		++nameOffsets[nameOf[transmissions.parameter[i]] + 1];
+	}
+	for( size_t i = 1; i < nameOffsets.size(); ++i )
+	{
+		nameOffsets[i] += nameOffsets[i - 1];
+	}
+	nameRows.resize( aStore.transmissionCount() );
+	std::vector<OwUInt32> nameNext( nameOffsets.begin(), nameOffsets.end() - 1 );
+	for( OwUInt32 i = 0; i < aStore.transmissionCount(); ++i )
+	{
+		nameRows[nameNext[nameOf[transmissions.parameter[i]]]++] = i;
+	}
+
+	parameterSearch.build( transmissions.parameter, transmissions.strings );
+}
+
+void SpecQuery::equipmentWithLabel( OwUInt8 aLabel, OwUInt8 aTypes, std::vector<OwUInt32>& aEquipment ) const
+{
+	aEquipment.clear();
+
+	//A wildcard of the label puts every equipment in
+	size_t count = 0;
+	const OwUInt32* wildcards = wildcardsWithLabel( aLabel, count );
+	for( size_t i = 0; i < count; ++i )
+	{
+		if( aTypes == 0 || (store->transmissions.types[wildcards[i]] & aTypes) != 0 )
+		{
+			aEquipment.resize( store->equipmentCount() );
+			for( OwUInt32 j = 0; j < store->equipmentCount(); ++j )
+			{
+				aEquipment[j] = j;
+			}
+			return;
+		}
+	}
+
+	const Link* links = linksWithLabel( aLabel, count );
+	for( size_t i = 0; i < count; ++i )
+	{
+		//An equipment can have more than one transmission of a label, and they are next to each other
+		if( aTypes != 0 && (store->transmissions.types[links[i].transmission] & aTypes) == 0 )
+		{
+			continue;
+		}
+		if( aEquipment.empty() || aEquipment.back() != links[i].equipment )
+		{
+			aEquipment.push_back( links[i].equipment );
+		}
+	}
+}
+
+void SpecQuery::labelsOf( OwUInt32 aEquipment, std::vector<OwUInt8>& aLabels ) const
+{
+	aLabels.clear();
+	const OwUInt32* words = &labelSets[aEquipment * LABEL_WORDS];
+	for( int word = 0; word < LABEL_WORDS; ++word )
+	{
+		for( OwUInt32 bits = words[word] | wildcardLabels[word]; bits != 0; bits &= bits - 1 )
+		{
+			int bit = 0;
+			while( ((bits >> bit) & 1) == 0 )
+			{
+				++bit;
+			}
+			aLabels.push_back( (OwUInt8)(word * 32 + bit) );
+		}
+	}
+}
+
+OwUInt32 SpecQuery::labelCount( OwUInt32 aEquipment ) const
+{
+	OwUInt32 count = 0;
+	for( int word = 0; word < LABEL_WORDS; ++word )
+	{
+		count += bitCount( labelSets[aEquipment * LABEL_WORDS + word] | wildcardLabels[word] );
+	}
+	return count;
+}
+
+const OwUInt32* SpecQuery::transmissionsOfType( SpecStore::TypeFlags aType, size_t& aCount ) const
+{
+	int type = 0;
+	while( type < TYPE_COUNT && aType != (1 << type) )
+	{
+		++type;
+	}
+	if( type == TYPE_COUNT )
+	{
+		aCount = 0;
+		return NULL;	//Not a single flag
+	}
+	aCount = typeOffsets[type + 1] - typeOffsets[type];
+	return aCount == 0 ? NULL : &typeRows[typeOffsets[type]];
+}
+
+const OwUInt32* SpecQuery::transmissionsNamed( const char* aParameter, size_t aLength, size_t& aCount ) const
+{
+	aCount = 0;
+	StringPool::Handle name;
+	const char* trimmed = trim( aParameter, aLength );
+	if( store == NULL || !trimmedNames.find( trimmed, aLength, name ) || name + 1 >= nameOffsets.size() )
+	{
+		return NULL;
+	}
+	aCount = nameOffsets[name + 1] - nameOffsets[name];
+	return aCount == 0 ? NULL : &nameRows[nameOffsets[name]];
+}
+
+size_t SpecQuery::memoryUsage() const
+{
+	return labelOffsets.capacity() * sizeof(OwUInt32)
+		+ labelLinks.capacity() * sizeof(Link)
+		+ wildcardOffsets.capacity() * sizeof(OwUInt32)
+		+ wildcardRows.capacity() * sizeof(OwUInt32)
+		+ labelSets.capacity() * sizeof(OwUInt32)
+		+ typeOffsets.capacity() * sizeof(OwUInt32)
+		+ typeRows.capacity() * sizeof(OwUInt32)
+		+ trimmedNames.memoryUsage()
+		+ nameOffsets.capacity() * sizeof(OwUInt32)
+		+ nameRows.capacity() * sizeof(OwUInt32)
+		+ parameterSearch.memoryUsage();
+}
@@ -0,0 +1,184 @@
+/**
+ * @file SpecQuery.hpp
+ * @brief Secondary indexes over a SpecStore, for answering questions about the loaded sheets.
+ */
+
+#ifndef A429_SPEC_QUERY_HPP
+#define A429_SPEC_QUERY_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include <Owl429/definitions>
+
+#include "ParameterSearch.hpp"
+#include "SpecStore.hpp"
+
+/**
+ * Indexes the rows of a SpecStore by label, equipment, data type and parameter name, so that
+ * questions such as "which equipment transmit label 206 as BNR" are answered without
+ * walking the rows. Parameters can also be searched for by a part of their name, or a
+ * name that is nearly right, through parameters(). Each index is a flat array with an offset table in front of it, so a
+ * lookup is an index or hash computation and then a contiguous read.
+ *
+ * Wildcard transmissions are indexed once, not for every equipment, so the indexes grow
+ * with the rows of the sheets. The indexes refer to the rows of the store they were built
+ * from, and are only valid until it changes. Lookups are const and safe from any number of threads.
+ */
+class SpecQuery
+{
+public:
+
+	/**
+	 * A transmission of an equipment
+	 */
+	typedef struct Link
+	{
+		/**
+		 * @brief The equipment row
+		 */
+		OwUInt32 equipment;
+		/**
+		 * @brief The transmission row
+		 */
+		OwUInt32 transmission;
+	} Link;
+
+	SpecQuery();
+
+	/**
+	 * Indexes a store, replacing what was indexed before. This is a pass over the links and transmissions
+	 */
+	void build( const SpecStore& aStore );
+
+	/**
+	 * Removes the indexes
+	 */
+	void clear();
+
+	/**
+	 * @returns the transmissions of a label by each equipment, by equipment row. aCount is set to how many.
+	 * The wildcard transmissions every equipment has aren't among them, see wildcardsWithLabel
+	 */
+	const Link* linksWithLabel( OwUInt8 aLabel, size_t& aCount ) const
+	{
+		aCount = labelOffsets[aLabel + 1] - labelOffsets[aLabel];
+		return aCount == 0 ? NULL : &labelLinks[labelOffsets[aLabel]];
+	}
+
+	/**
+	 * @returns the wildcard transmission rows of a label, which every equipment has. aCount is set to how many
+	 */
+	const OwUInt32* wildcardsWithLabel( OwUInt8 aLabel, size_t& aCount ) const
+	{
+		aCount = wildcardOffsets[aLabel + 1] - wildcardOffsets[aLabel];
+		return aCount == 0 ? NULL : &wildcardRows[wildcardOffsets[aLabel]];
+	}
+
+	/**
+	 * Finds the equipment that transmit a label
+	 * @param aTypes the SpecStore::TypeFlags the transmission must have one of, or 0 for any
+	 * @param aEquipment cleared, then filled with the equipment rows in order
+	 */
+	void equipmentWithLabel( OwUInt8 aLabel, OwUInt8 aTypes, std::vector<OwUInt32>& aEquipment ) const;
+
+	/**
+	 * @returns true if an equipment transmits a label
+	 */
+	bool transmitsLabel( OwUInt32 aEquipment, OwUInt8 aLabel ) const
+	{
+		return ((labelSets[aEquipment * LABEL_WORDS + aLabel / 32] | wildcardLabels[aLabel / 32]) & (1u << (aLabel % 32))) != 0;
+	}
+
+	/**
+	 * Lists the labels an equipment transmits
+	 * @param aLabels cleared, then filled with the labels in order
+	 */
+	void labelsOf( OwUInt32 aEquipment, std::vector<OwUInt8>& aLabels ) const;
+
+	/**
+	 * @returns the number of labels an equipment transmits
+	 */
+	OwUInt32 labelCount( OwUInt32 aEquipment ) const;
+
+	/**
+	 * @param aType one SpecStore::TypeFlags
+	 * @returns the transmission rows with the type, in order. aCount is set to how many
+	 */
+	const OwUInt32* transmissionsOfType( SpecStore::TypeFlags aType, size_t& aCount ) const;
+
+	/**
+	 * Looks up the transmissions with a parameter name. The name must match exactly, apart from
+	 * whitespace at either end, which some cells of the sheets have and others don't
+	 * @returns the transmission rows, in order. aCount is set to how many, 0 if there are none
+	 */
+	const OwUInt32* transmissionsNamed( const std::string& aParameter, size_t& aCount ) const
+	{
+		return transmissionsNamed( aParameter.data(), aParameter.size(), aCount );
+	}
+
+	const OwUInt32* transmissionsNamed( const char* aParameter, size_t aLength, size_t& aCount ) const;
+
+	/**
+	 * @returns the trigram index of the parameter names, for fuzzy and substring search
+	 */
+	const ParameterSearch& parameters() const
+	{
+		return parameterSearch;
+	}
+
+	/**
+	 * @returns the heap memory held by the indexes, in bytes
+	 */
+	size_t memoryUsage() const;
+
+private:
+
+	/**
+	 * The 32 bit words of a set of 256 labels
+	 */
+	enum { LABEL_WORDS = 256 / 32 };
+
+	/**
+	 * The flags indexed by transmissionsOfType
+	 */
+	enum { TYPE_COUNT = 4 };
+
+	const SpecStore* store;
+	/**
+	 * @brief Where each label's links start in labelLinks. 257 entries
+	 */
+	std::vector<OwUInt32> labelOffsets;
+	std::vector<Link> labelLinks;
+	/**
+	 * @brief Where each label's wildcards start in wildcardRows. 257 entries
+	 */
+	std::vector<OwUInt32> wildcardOffsets;
+	std::vector<OwUInt32> wildcardRows;
+	/**
+	 * @brief LABEL_WORDS words per equipment, a bit per label it transmits itself
+	 */
+	std::vector<OwUInt32> labelSets;
+	/**
+	 * @brief A bit per label with a wildcard, which every equipment transmits
+	 */
+	OwUInt32 wildcardLabels[LABEL_WORDS];
+	/**
+	 * @brief Where each type's rows start in typeRows. TYPE_COUNT + 1 entries
+	 */
+	std::vector<OwUInt32> typeOffsets;
+	std::vector<OwUInt32> typeRows;
+	/**
+	 * @brief The parameter names without whitespace at either end. Their handles group the rows
+	 */
+	StringPool trimmedNames;
+	/**
+	 * @brief Where each trimmed name's rows start in nameRows, by its handle in trimmedNames
+	 */
+	std::vector<OwUInt32> nameOffsets;
+	std::vector<OwUInt32> nameRows;
+	ParameterSearch parameterSearch;
+};
+
+#endif
@@ -0,0 +1,480 @@
+/**
+ * @file SpecStore.cpp
+ * @brief Column oriented storage for the rows of the ARINC 429 specification sheets.
+ */
+
+#include "SpecStore.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+namespace
+{
+	template <typename T>
+	void appendColumn( std::vector<T>& aTarget, const std::vector<T>& aSource )
+	{
+		aTarget.insert( aTarget.end(), aSource.begin(), aSource.end() );
+	}
+
+	template <typename T>
+	size_t columnBytes( const std::vector<T>& aColumn )
+	{
+		return aColumn.capacity() * sizeof(T);
+	}
+
+	/**
+	 * Appends a text column of another set of columns
+	 * @param aHandles the handle in the target's strings of each of the source's
+	 */
+	void appendText( std::vector<StringPool::Handle>& aTarget, const std::vector<StringPool::Handle>& aSource, const std::vector<StringPool::Handle>& aHandles )
+	{
+		aTarget.reserve( aTarget.size() + aSource.size() );
+		for( size_t i = 0; i < aSource.size(); ++i )
+		{
+			aTarget.push_back( aHandles[aSource[i]] );
+		}
+	}
+
+	/**
+	 * The spellings of each Unit in the sheets, lower case and without spaces or dots
+	 */
+	typedef struct UnitSpelling
+	{
+		const char* text;
+		SpecStore::Unit unit;
+	} UnitSpelling;
+
+	const UnitSpelling UNIT_SPELLINGS[] =
+	{
+		{ "n/a", SpecStore::UNIT_NONE },
+		{ "deg", SpecStore::UNIT_DEGREES },
+		{ "degrees", SpecStore::UNIT_DEGREES },
+		{ "deg/180", SpecStore::UNIT_SEMICIRCLES },
+		{ "deg/sec", SpecStore::UNIT_DEGREES_PER_SECOND },
+		{ "deg/sec2", SpecStore::UNIT_DEGREES_PER_SECOND_SQUARED },
+		{ "degc", SpecStore::UNIT_DEGREES_C },
+		{ "feet", SpecStore::UNIT_FEET },
+		{ "ft", SpecStore::UNIT_FEET },
+		{ "feet/min", SpecStore::UNIT_FEET_PER_MINUTE },
+		{ "ft/min", SpecStore::UNIT_FEET_PER_MINUTE },
+		{ "meters", SpecStore::UNIT_METERS },
+		{ "nm", SpecStore::UNIT_NAUTICAL_MILES },
+		{ "knots", SpecStore::UNIT_KNOTS },
+		{ "mach", SpecStore::UNIT_MACH },
+		{ "g", SpecStore::UNIT_G },
+		{ "gs", SpecStore::UNIT_G },
+		{ "percent", SpecStore::UNIT_PERCENT },
+		{ "rpm", SpecStore::UNIT_RPM },
+		{ "ratio", SpecStore::UNIT_RATIO },
+		{ "epr", SpecStore::UNIT_RATIO },
+		{ "psi", SpecStore::UNIT_PSI },
+		{ "psia", SpecStore::UNIT_PSI },
+		{ "psig", SpecStore::UNIT_PSI },
+		{ "mb", SpecStore::UNIT_MILLIBARS },
+		{ "inhg", SpecStore::UNIT_INCHES_HG },
+		{ "inshg", SpecStore::UNIT_INCHES_HG },
+		{ "lb", SpecStore::UNIT_POUNDS },
+		{ "lbs", SpecStore::UNIT_POUNDS },
+		{ "lb/hr", SpecStore::UNIT_POUNDS_PER_HOUR },
+		{ "lbs/hr", SpecStore::UNIT_POUNDS_PER_HOUR },
+		{ "pph", SpecStore::UNIT_POUNDS_PER_HOUR },
+		{ "kg", SpecStore::UNIT_KILOGRAMS },
+		{ "kilograms", SpecStore::UNIT_KILOGRAMS },
+		{ "seconds", SpecStore::UNIT_SECONDS },
+		{ "msec", SpecStore::UNIT_MILLISECONDS },
+		{ "min", SpecStore::UNIT_MINUTES },
+		{ "minute", SpecStore::UNIT_MINUTES },
+		{ "minutes", SpecStore::UNIT_MINUTES },
+		{ "hz", SpecStore::UNIT_HERTZ },
+		{ "volts", SpecStore::UNIT_VOLTS },
+		{ "vdc", SpecStore::UNIT_VOLTS },
+		{ "amperes", SpecStore::UNIT_AMPERES }
+	};
+
+	const char* const UNIT_NAMES[SpecStore::UNIT_COUNT] =
+	{
+		"", "unknown", "degrees", "semicircles", "degrees/s", "degrees/s^2", "degrees C", "feet", "feet/min", "meters",
+		"nautical miles", "knots", "mach", "g", "percent", "rpm", "ratio", "psi", "millibars", "inches Hg",
+		"pounds", "pounds/hr", "kilograms", "seconds", "milliseconds", "minutes", "hertz", "volts", "amperes"
+	};
+
+	/**
+	 * @returns true if the text is empty or only spaces
+	 */
+	bool isBlank( const std::string& aText )
+	{
+		return aText.find_first_not_of( ' ' ) == std::string::npos;
+	}
+
+	void addDiagnostic( DataColumns& aColumns, OwUInt32 aRow, OwUInt32 aLine, const char* aColumn, const char* aMessage )
+	{
+		ScaleDiagnostic diagnostic;
+		diagnostic.row = aRow;
+		diagnostic.line = aLine;
+		diagnostic.column = aColumn;
+		diagnostic.message = aColumns.strings.intern( aMessage );	//The same few messages come up again and again
+		aColumns.diagnostics.push_back( diagnostic );
+	}
+
+	/**
+	 * The most of a field quoted in a diagnostic, so the messages fit in a buffer on the stack
+	 */
+	const size_t QUOTED_LENGTH = 200;
+
+	/**
+	 * @returns how much of a field to quote, for "%.*s"
+	 */
+	int quoted( const std::string& aText )
+	{
+		return (int)std::min( aText.size(), QUOTED_LENGTH );
+	}
+}
+
+void DataColumns::clear()
+{
+	DataColumns empty;
+	swap( empty );
+}
+
+void DataColumns::reserve( size_t aRows )
+{
+	equipmentId.reserve( aRows );
+	label.reserve( aRows );
+	units.reserve( aRows );
+	range.reserve( aRows );
+	sigBits.reserve( aRows );
+	posSense.reserve( aRows );
+	resolution.reserve( aRows );
+	minTransitInterval.reserve( aRows );
+	rate.reserve( aRows );
+	isPeriod.reserve( aRows );
+	maxTransitInterval.reserve( aRows );
+	maxTransportDelay.reserve( aRows );
+	line.reserve( aRows );
+	fullScale.reserve( aRows );
+	lsb.reserve( aRows );
+	isSigned.reserve( aRows );
+	periodUs.reserve( aRows );
+	unit.reserve( aRows );
+}
+
+void DataColumns::swap( DataColumns& aOther )
+{
+	equipmentId.swap( aOther.equipmentId );
+	label.swap( aOther.label );
+	units.swap( aOther.units );
+	range.swap( aOther.range );
+	sigBits.swap( aOther.sigBits );
+	posSense.swap( aOther.posSense );
+	resolution.swap( aOther.resolution );
+	minTransitInterval.swap( aOther.minTransitInterval );
+	rate.swap( aOther.rate );
+	isPeriod.swap( aOther.isPeriod );
+	maxTransitInterval.swap( aOther.maxTransitInterval );
+	maxTransportDelay.swap( aOther.maxTransportDelay );
+	line.swap( aOther.line );
+	fullScale.swap( aOther.fullScale );
+	lsb.swap( aOther.lsb );
+	isSigned.swap( aOther.isSigned );
+	periodUs.swap( aOther.periodUs );
+	unit.swap( aOther.unit );
+	diagnostics.swap( aOther.diagnostics );
+	wildcards.swap( aOther.wildcards );
+	strings.swap( aOther.strings );
+}
+
+void DataColumns::append( const DataColumns& aOther )
+{
+	//The other strings are interned once each, and their handles swapped for these
+	std::vector<StringPool::Handle> handles( aOther.strings.size() );
+	for( StringPool::Handle i = 0; i < aOther.strings.size(); ++i )
+	{
+		PooledString text = aOther.strings.get( i );
+		handles[i] = strings.intern( text.data(), text.size() );
+	}
+
+	appendColumn( equipmentId, aOther.equipmentId );
+	appendColumn( label, aOther.label );
+	appendText( units, aOther.units, handles );
+	appendText( range, aOther.range, handles );
+	appendColumn( sigBits, aOther.sigBits );
+	appendText( posSense, aOther.posSense, handles );
+	appendText( resolution, aOther.resolution, handles );
+	appendText( minTransitInterval, aOther.minTransitInterval, handles );
+	appendColumn( rate, aOther.rate );
+	appendColumn( isPeriod, aOther.isPeriod );
+	appendText( maxTransitInterval, aOther.maxTransitInterval, handles );
+	appendColumn( maxTransportDelay, aOther.maxTransportDelay );
+	appendColumn( line, aOther.line );
+	appendColumn( fullScale, aOther.fullScale );
+	appendColumn( lsb, aOther.lsb );
+	appendColumn( isSigned, aOther.isSigned );
+	appendColumn( periodUs, aOther.periodUs );
+	appendColumn( unit, aOther.unit );
+
+	//The diagnostics refer to rows, which move along
+	OwUInt32 first = size() - aOther.size();
+	for( size_t i = 0; i < aOther.diagnostics.size(); ++i )
+	{
+		diagnostics.push_back( aOther.diagnostics[i] );
+		diagnostics.back().row += first;
+		diagnostics.back().message = handles[aOther.diagnostics[i].message];
+	}
+}
+
+OwUInt32 DataColumns::indexWildcards()
+{
+	OwUInt32 unused = 0;
+	wildcards.assign( 256, (OwUInt32)SpecStore::NONE );
+	for( OwUInt32 i = 0; i < size(); ++i )
+	{
+		if( equipmentId[i] != SpecStore::WILDCARD_EQUIPMENT )
+		{
+			continue;
+		}
+		if( wildcards[label[i]] == SpecStore::NONE )
+		{
+			wildcards[label[i]] = i;
+		}
+		else
+		{
+			++unused;
+		}
+	}
+	return unused;
+}
+
+size_t DataColumns::memoryUsage() const
+{
+	return columnBytes( equipmentId ) + columnBytes( label ) + columnBytes( units ) + columnBytes( range )
+		+ columnBytes( sigBits ) + columnBytes( posSense ) + columnBytes( resolution ) + columnBytes( minTransitInterval )
+		+ columnBytes( rate ) + columnBytes( isPeriod ) + columnBytes( maxTransitInterval ) + columnBytes( maxTransportDelay )
+		+ columnBytes( line ) + columnBytes( fullScale ) + columnBytes( lsb ) + columnBytes( isSigned )
+		+ columnBytes( periodUs ) + columnBytes( unit ) + columnBytes( wildcards ) + strings.memoryUsage();
+}
+
+void TransmissionColumns::clear()
+{
+	TransmissionColumns empty;
+	swap( empty );
+}
+
+void TransmissionColumns::reserve( size_t aRows )
+{
+	codeNo.reserve( aRows );
+	equipmentId.reserve( aRows );
+	transmissionOrderBitPosition.reserve( aRows );
+	types.reserve( aRows );
+	parameter.reserve( aRows );
+	bnrData.reserve( aRows );
+	bcdData.reserve( aRows );
+	line.reserve( aRows );
+}
+
+void TransmissionColumns::swap( TransmissionColumns& aOther )
+{
+	codeNo.swap( aOther.codeNo );
+	equipmentId.swap( aOther.equipmentId );
+	transmissionOrderBitPosition.swap( aOther.transmissionOrderBitPosition );
+	types.swap( aOther.types );
+	parameter.swap( aOther.parameter );
+	bnrData.swap( aOther.bnrData );
+	bcdData.swap( aOther.bcdData );
+	line.swap( aOther.line );
+	strings.swap( aOther.strings );
+}
+
+size_t TransmissionColumns::memoryUsage() const
+{
+	return columnBytes( codeNo ) + columnBytes( equipmentId ) + columnBytes( transmissionOrderBitPosition )
+		+ columnBytes( types ) + columnBytes( parameter ) + columnBytes( bnrData ) + columnBytes( bcdData )
+		+ columnBytes( line ) + strings.memoryUsage();
+}
+
+void EquipmentColumns::clear()
+{
+	EquipmentColumns empty;
+	swap( empty );
+}
+
+void EquipmentColumns::swap( EquipmentColumns& aOther )
+{
+	id.swap( aOther.id );
+	type.swap( aOther.type );
+	line.swap( aOther.line );
+	firstLink.swap( aOther.firstLink );
+	linkCount.swap( aOther.linkCount );
+	links.swap( aOther.links );
+	wildcardLinks.swap( aOther.wildcardLinks );
+	strings.swap( aOther.strings );
+}
+
+size_t EquipmentColumns::memoryUsage() const
+{
+	return columnBytes( id ) + columnBytes( type ) + columnBytes( line ) + columnBytes( firstLink ) + columnBytes( linkCount ) + columnBytes( links ) + columnBytes( wildcardLinks )
+		+ strings.memoryUsage();
+}
+
+void SpecStore::clear()
+{
+	equipment.clear();
+	transmissions.clear();
+	bnr.clear();
+	bcd.clear();
+}
+
+OwUInt32 SpecStore::linkAt( OwUInt32 aEquipment, OwUInt32 aIndex ) const
+{
+	const OwUInt32* links = equipment.links.empty() ? NULL : &equipment.links[0] + equipment.firstLink[aEquipment];	//The last equipment may start at the end
+	OwUInt32 linkCount = equipment.linkCount[aEquipment];
+	const std::vector<OwUInt32>& wildcards = equipment.wildcardLinks;
+	if( wildcards.empty() )
+	{
+		return links[aIndex];
+	}
+
+	//Wildcard w comes after w wildcards and the links before it, so its place grows with w. Find how many of
+	//them come before aIndex; the transmission is the next wildcard if that is at aIndex, otherwise a link
+	OwUInt32 first = 0;
+	OwUInt32 last = (OwUInt32)wildcards.size();
+	OwUInt32 place = 0;
+	while( first < last )
+	{
+		OwUInt32 middle = first + (last - first) / 2;
+		place = middle + (OwUInt32)(std::lower_bound( links, links + linkCount, wildcards[middle] ) - links);
+		if( place < aIndex )
+		{
+			first = middle + 1;
+		}
+		else
+		{
+			last = middle;
+		}
+	}
+	if( first < wildcards.size() && first + (OwUInt32)(std::lower_bound( links, links + linkCount, wildcards[first] ) - links) == aIndex )
+	{
+		return wildcards[first];
+	}
+	return links[aIndex - first];
+}
+
+void SpecStore::normalize( DataColumns& aColumns, OwUInt32 aRow, A429WordCodec::Format aFormat, OwUInt32 aLine )
+{
+	//Copied out for the codec, and short enough not to allocate mostly
+	const std::string range = aColumns.strings.get( aColumns.range[aRow] ).str();
+	const std::string resolution = aColumns.strings.get( aColumns.resolution[aRow] ).str();
+	aColumns.line.push_back( aLine );
+
+	//The range
+	double low = 0;
+	double high = 0;
+	bool hasRange = A429WordCodec::parseRange( range, low, high );
+	aColumns.fullScale.push_back( hasRange ? (high > -low ? high : -low) : 0 );
+	aColumns.isSigned.push_back( hasRange && low < 0 ? 1 : 0 );
+	if( !hasRange && !isBlank( range ) )
+	{
+		char message[2 * QUOTED_LENGTH + 100];
+		sprintf( message, "'%.*s' is neither a scale nor bounds", quoted( range ), range.data() );
+		addDiagnostic( aColumns, aRow, aLine, "range", message );
+	}
+
+	//The weight of the least significant bit or digit
+	A429WordCodec::Descriptor descriptor;
+	bool described = A429WordCodec::describe( aFormat, range, resolution, aColumns.sigBits[aRow], descriptor );
+	aColumns.lsb.push_back( described ? descriptor.lsb : 0 );
+	if( !described )
+	{
+		char message[2 * QUOTED_LENGTH + 100];
+		sprintf( message, "no LSB weight from range '%.*s', resolution '%.*s' and %d%s", quoted( range ), range.data(), quoted( resolution ), resolution.data(),
+			(int)aColumns.sigBits[aRow], aFormat == A429WordCodec::FORMAT_BNR ? " sig bits" : " digits" );
+		addDiagnostic( aColumns, aRow, aLine, "resolution", message );
+	}
+
+	//The period, rounded to the microsecond
+	double rate = aColumns.rate[aRow];
+	double period = aColumns.isPeriod[aRow] != 0 ? rate * 1000 : 1000000 / rate;
+	aColumns.periodUs.push_back( period > 0 && period < 4294967295.0 ? (OwUInt32)(period + 0.5) : 0 );
+
+	//The units
+	const std::string units = aColumns.strings.get( aColumns.units[aRow] ).str();
+	Unit unit = unitOf( units );
+	aColumns.unit.push_back( (OwUInt8)unit );
+	if( unit == UNIT_UNKNOWN )
+	{
+		char message[2 * QUOTED_LENGTH + 100];
+		sprintf( message, "'%.*s' is not a known unit", quoted( units ), units.data() );
+		addDiagnostic( aColumns, aRow, aLine, "units", message );
+	}
+}
+
+SpecStore::Unit SpecStore::unitOf( const std::string& aUnits )
+{
+	std::string key;
+	for( size_t i = 0; i < aUnits.size(); ++i )
+	{
+		if( aUnits[i] != ' ' && aUnits[i] != '.' )
+		{
+			key.push_back( (char)tolower( (unsigned char)aUnits[i] ) );
+		}
+	}
+	if( key.empty() )
+	{
+		return UNIT_NONE;
+	}
+	if( key[0] == '%' )
+	{
+		return UNIT_PERCENT;	//Of full scale, of nominal N1, of MAC...
+	}
+	for( size_t i = 0; i < sizeof(UNIT_SPELLINGS) / sizeof(UNIT_SPELLINGS[0]); ++i )
+	{
+		if( key == UNIT_SPELLINGS[i].text )
+		{
+			return UNIT_SPELLINGS[i].unit;
+		}
+	}
+	return UNIT_UNKNOWN;
+}
+
+const char* SpecStore::unitName( Unit aUnit )
+{
+	return aUnit < UNIT_COUNT ? UNIT_NAMES[aUnit] : UNIT_NAMES[UNIT_UNKNOWN];
+}
+
+void SpecStore::selectByRate( OwUInt8 aTypes, double aMinRateHz, std::vector<OwUInt32>& aRows ) const
+{
+	aRows.clear();
+	const std::vector<OwUInt8>& types = this->transmissions.types;
+	for( OwUInt32 i = 0; i < (OwUInt32)types.size(); ++i )
+	{
+		//Only the rows of the types the transmission has, as a wildcard row of the other type may exist for its label
+		OwUInt8 wanted = types[i] & aTypes;
+		if( wanted == 0 )
+		{
+			continue;
+		}
+		OwUInt32 data = NONE;
+		const DataColumns* columns = NULL;
+		OwUInt32 bnrRow = (wanted & TYPE_BNR) ? dataRowOf( this->bnr, this->transmissions.bnrData[i], this->transmissions.codeNo[i] ) : (OwUInt32)NONE;
+		OwUInt32 bcdRow = (wanted & TYPE_BCD) ? dataRowOf( this->bcd, this->transmissions.bcdData[i], this->transmissions.codeNo[i] ) : (OwUInt32)NONE;
+		if( bnrRow != NONE )
+		{
+			data = bnrRow;
+			columns = &this->bnr;
+		}
+		else if( bcdRow != NONE )
+		{
+			data = bcdRow;
+			columns = &this->bcd;
+		}
+		if( columns != NULL && columns->periodUs[data] != 0 && 1000000.0 / columns->periodUs[data] > aMinRateHz )
+		{
+			aRows.push_back( i );
+		}
+	}
+}
+
+size_t SpecStore::memoryUsage() const
+{
+	return this->equipment.memoryUsage() + this->transmissions.memoryUsage() + this->bnr.memoryUsage() + this->bcd.memoryUsage();
+}
@@ -0,0 +1,538 @@
+/**
+ * @file SpecStore.hpp
+ * @brief Column oriented storage for the rows of the ARINC 429 specification sheets.
+ */
+
+#ifndef A429_SPEC_STORE_HPP
+#define A429_SPEC_STORE_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include <Owl429/definitions>
+
+#include "A429WordCodec.hpp"
+#include "StringPool.hpp"
+
+/**
+ * A row of the BnrData or BcdData sheet that couldn't be fully normalized
+ */
+typedef struct ScaleDiagnostic
+{
+	/**
+	 * @brief The row in the columns
+	 */
+	OwUInt32 row;
+	/**
+	 * @brief The line of the sheet the row starts on, or 0 if it isn't known
+	 */
+	OwUInt32 line;
+	/**
+	 * @brief The column that couldn't be normalized
+	 */
+	const char* column;
+	/**
+	 * @brief What was wrong with it, in the strings of the columns
+	 */
+	StringPool::Handle message;
+} ScaleDiagnostic;
+
+/**
+ * The rows of the BnrData or BcdData sheet, one vector per column.
+ * The text columns are kept as they were read, for exporting, as handles into the
+ * strings of the sheet, which keeps each distinct text once. The scaling columns
+ * hold the same information as numbers, worked out once when the row is loaded
+ */
+typedef struct DataColumns
+{
+	/**
+	 * @brief The equipment ID each row was given for
+	 */
+	std::vector<OwUInt16> equipmentId;
+	/**
+	 * @brief The label each row was given for
+	 */
+	std::vector<OwUInt8> label;
+	/**
+	 * @brief The units of the data
+	 */
+	std::vector<StringPool::Handle> units;
+	/**
+	 * @brief The range of the data
+	 */
+	std::vector<StringPool::Handle> range;
+	/**
+	 * @brief The number of significant bits of the data
+	 */
+	std::vector<OwUInt8> sigBits;
+	/**
+	 * @brief The Pos Sense of the data
+	 */
+	std::vector<StringPool::Handle> posSense;
+	/**
+	 * @brief The resolution of the data
+	 */
+	std::vector<StringPool::Handle> resolution;
+	/**
+	 * @brief The minimum Transit Interval of the data
+	 */
+	std::vector<StringPool::Handle> minTransitInterval;
+	/**
+	 * @brief The value at which to set the rate in FSIM. Derived from minTransitInterval
+	 */
+	std::vector<double> rate;
+	/**
+	 * @brief Denotes whether the rate is a period in ms (1) or a frequency in Hz (0)
+	 */
+	std::vector<OwUInt8> isPeriod;
+	/**
+	 * @brief The maximum Transit Interval of the data
+	 */
+	std::vector<StringPool::Handle> maxTransitInterval;
+	/**
+	 * @brief The maximum Transport Delay of the data
+	 */
+	std::vector<OwUInt16> maxTransportDelay;
+	/**
+	 * @brief The line of the sheet each row starts on, or 0 if it isn't known
+	 */
+	std::vector<OwUInt32> line;
+	/**
+	 * @brief The largest magnitude of the range, or 0 if the range isn't numeric
+	 */
+	std::vector<double> fullScale;
+	/**
+	 * @brief The value of the least significant bit (BNR) or digit (BCD), or 0 if it can't be worked out
+	 */
+	std::vector<double> lsb;
+	/**
+	 * @brief Denotes whether the range takes negative values (1) or not (0)
+	 */
+	std::vector<OwUInt8> isSigned;
+	/**
+	 * @brief The minimum transit interval as a period in microseconds
+	 */
+	std::vector<OwUInt32> periodUs;
+	/**
+	 * @brief The SpecStore::Unit of the units column
+	 */
+	std::vector<OwUInt8> unit;
+	/**
+	 * @brief The rows whose scaling columns couldn't all be worked out. Not a column
+	 */
+	std::vector<ScaleDiagnostic> diagnostics;
+	/**
+	 * @brief The row of each label given for every equipment (X X X), or SpecStore::NONE. 256 entries
+	 *        once indexWildcards has run. Not a column
+	 */
+	std::vector<OwUInt32> wildcards;
+	/**
+	 * @brief The text of the text columns and the diagnostics. Not a column
+	 */
+	StringPool strings;
+
+	/**
+	 * @returns the number of rows
+	 */
+	OwUInt32 size() const
+	{
+		return (OwUInt32)rate.size();
+	}
+
+	void clear();
+	void reserve( size_t aRows );
+	void swap( DataColumns& aOther );
+
+	/**
+	 * Appends the rows of another set of columns, and their diagnostics. The text is interned again,
+	 * and the wildcards need indexing again
+	 */
+	void append( const DataColumns& aOther );
+
+	/**
+	 * Fills wildcards from the equipment ID column. The first row of a label given for every equipment is the one used
+	 * @returns the number of rows given for every equipment that aren't used, as their label already has one
+	 */
+	OwUInt32 indexWildcards();
+
+	/**
+	 * @returns an estimate of the heap memory held by the columns, in bytes
+	 */
+	size_t memoryUsage() const;
+} DataColumns;
+
+/**
+ * The rows of the LabelIDs sheet, one vector per column
+ */
+typedef struct TransmissionColumns
+{
+	/**
+	 * @brief The label of each row
+	 */
+	std::vector<OwInt16> codeNo;
+	/**
+	 * @brief The equipment ID of each row, or SpecStore::WILDCARD_EQUIPMENT
+	 */
+	std::vector<OwUInt16> equipmentId;
+	/**
+	 * @brief The Transmission Order Bit Position
+	 */
+	std::vector<OwUInt8> transmissionOrderBitPosition;
+	/**
+	 * @brief The SpecStore::TypeFlags of the data
+	 */
+	std::vector<OwUInt8> types;
+	/**
+	 * @brief The Parameter
+	 */
+	std::vector<StringPool::Handle> parameter;
+	/**
+	 * @brief The row of the bnr data if any, or SpecStore::NONE
+	 */
+	std::vector<OwUInt32> bnrData;
+	/**
+	 * @brief The row of the bcd data if any, or SpecStore::NONE
+	 */
+	std::vector<OwUInt32> bcdData;
+	/**
+	 * @brief The line of the sheet each row starts on, or 0 if it isn't known
+	 */
+	std::vector<OwUInt32> line;
+	/**
+	 * @brief The text of the Parameter column. Not a column
+	 */
+	StringPool strings;
+
+	/**
+	 * @returns the number of rows
+	 */
+	OwUInt32 size() const
+	{
+		return (OwUInt32)codeNo.size();
+	}
+
+	void clear();
+	void reserve( size_t aRows );
+	void swap( TransmissionColumns& aOther );
+
+	/**
+	 * @returns an estimate of the heap memory held by the columns, in bytes
+	 */
+	size_t memoryUsage() const;
+} TransmissionColumns;
+
+/**
+ * The rows of the EquipmentIDs sheet, one vector per column, and the transmissions of each
+ */
+typedef struct EquipmentColumns
+{
+	/**
+	 * @brief The 12 bit hexadecimal identifier for the equipment
+	 */
+	std::vector<OwInt16> id;
+	/**
+	 * @brief The type of the equipment
+	 */
+	std::vector<StringPool::Handle> type;
+	/**
+	 * @brief The line of the sheet each row starts on, or 0 if it isn't known
+	 */
+	std::vector<OwUInt32> line;
+	/**
+	 * @brief The first entry of links that belongs to each equipment
+	 */
+	std::vector<OwUInt32> firstLink;
+	/**
+	 * @brief The number of transmissions of each equipment, not counting the wildcards
+	 */
+	std::vector<OwUInt32> linkCount;
+	/**
+	 * @brief The transmission rows of every equipment, one equipment after another
+	 */
+	std::vector<OwUInt32> links;
+	/**
+	 * @brief The wildcard transmission rows in sheet order. Every equipment has them as well as its links,
+	 *        so they are kept once and merged with the links when the equipment's transmissions are asked for
+	 */
+	std::vector<OwUInt32> wildcardLinks;
+	/**
+	 * @brief The text of the type column. Not a column
+	 */
+	StringPool strings;
+
+	/**
+	 * @returns the number of rows
+	 */
+	OwUInt32 size() const
+	{
+		return (OwUInt32)id.size();
+	}
+
+	void clear();
+	void swap( EquipmentColumns& aOther );
+
+	/**
+	 * @returns an estimate of the heap memory held by the columns, in bytes
+	 */
+	size_t memoryUsage() const;
+} EquipmentColumns;
+
+/**
+ * Everything loaded from the specification sheets, held as dense columns that refer
+ * to each other by row number. Scans over a column are linear passes over contiguous
+ * memory, and the views give the row by row access the lists used to.
+ *
+ * Views are small values that point into the store. They stay valid until the store is modified.
+ */
+class SpecStore
+{
+public:
+
+	/**
+	 * What row references hold when there is no row
+	 */
+	static const OwUInt32 NONE = 0xFFFFFFFF;
+
+	/**
+	 * The equipment ID of wildcard transmissions, which belong to every equipment
+	 */
+	static const OwUInt16 WILDCARD_EQUIPMENT = 0xFFFF;
+
+	/**
+	 * The flags of TransmissionColumns::types
+	 */
+	enum TypeFlags
+	{
+		TYPE_BNR = 0x01,
+		TYPE_BCD = 0x02,
+		TYPE_DISC = 0x04,
+		TYPE_SAL = 0x08
+	};
+
+	/**
+	 * The units the units column is normalized to
+	 */
+	enum Unit
+	{
+		UNIT_NONE,
+		UNIT_UNKNOWN,
+		UNIT_DEGREES,
+		UNIT_SEMICIRCLES,
+		UNIT_DEGREES_PER_SECOND,
+		UNIT_DEGREES_PER_SECOND_SQUARED,
+		UNIT_DEGREES_C,
+		UNIT_FEET,
+		UNIT_FEET_PER_MINUTE,
+		UNIT_METERS,
+		UNIT_NAUTICAL_MILES,
+		UNIT_KNOTS,
+		UNIT_MACH,
+		UNIT_G,
+		UNIT_PERCENT,
+		UNIT_RPM,
+		UNIT_RATIO,
+		UNIT_PSI,
+		UNIT_MILLIBARS,
+		UNIT_INCHES_HG,
+		UNIT_POUNDS,
+		UNIT_POUNDS_PER_HOUR,
+		UNIT_KILOGRAMS,
+		UNIT_SECONDS,
+		UNIT_MILLISECONDS,
+		UNIT_MINUTES,
+		UNIT_HERTZ,
+		UNIT_VOLTS,
+		UNIT_AMPERES,
+		UNIT_COUNT
+	};
+
+	/**
+	 * A row of the BnrData or BcdData sheet
+	 */
+	class DataView
+	{
+	public:
+		DataView() : columns(NULL), row(NONE) {}
+		DataView( const DataColumns* aColumns, OwUInt32 aRow ) : columns(aColumns), row(aRow) {}
+
+		/**
+		 * @returns false if the view doesn't refer to a row
+		 */
+		bool isValid() const							{ return columns != NULL && row != NONE; }
+		OwUInt32 index() const							{ return row; }
+		OwUInt16 equipmentId() const					{ return columns->equipmentId[row]; }
+		OwUInt8 label() const							{ return columns->label[row]; }
+		PooledString units() const			{ return columns->strings.get( columns->units[row] ); }
+		PooledString range() const			{ return columns->strings.get( columns->range[row] ); }
+		OwUInt8 sigBits() const							{ return columns->sigBits[row]; }
+		PooledString posSense() const			{ return columns->strings.get( columns->posSense[row] ); }
+		PooledString resolution() const		{ return columns->strings.get( columns->resolution[row] ); }
+		PooledString minTransitInterval() const	{ return columns->strings.get( columns->minTransitInterval[row] ); }
+		double rate() const								{ return columns->rate[row]; }
+		bool isPeriod() const							{ return columns->isPeriod[row] != 0; }
+		PooledString maxTransitInterval() const	{ return columns->strings.get( columns->maxTransitInterval[row] ); }
+		OwUInt16 maxTransportDelay() const				{ return columns->maxTransportDelay[row]; }
+		OwUInt32 line() const							{ return columns->line[row]; }
+		double fullScale() const						{ return columns->fullScale[row]; }
+		double lsb() const								{ return columns->lsb[row]; }
+		bool isSigned() const							{ return columns->isSigned[row] != 0; }
+		OwUInt32 periodUs() const						{ return columns->periodUs[row]; }
+		Unit unit() const								{ return (Unit)columns->unit[row]; }
+
+	private:
+		const DataColumns* columns;
+		OwUInt32 row;
+	};
+
+	/**
+	 * A row of the LabelIDs sheet
+	 */
+	class TransmissionView
+	{
+	public:
+		TransmissionView() : store(NULL), row(NONE) {}
+		TransmissionView( const SpecStore* aStore, OwUInt32 aRow ) : store(aStore), row(aRow) {}
+
+		/**
+		 * @returns false if the view doesn't refer to a row
+		 */
+		bool isValid() const							{ return store != NULL && row != NONE; }
+		OwUInt32 index() const							{ return row; }
+		OwInt16 codeNo() const							{ return store->transmissions.codeNo[row]; }
+		OwUInt16 equipmentId() const					{ return store->transmissions.equipmentId[row]; }
+		bool isWildcard() const							{ return equipmentId() == WILDCARD_EQUIPMENT; }
+		OwUInt8 transmissionOrderBitPosition() const	{ return store->transmissions.transmissionOrderBitPosition[row]; }
+		PooledString parameter() const					{ return store->transmissions.strings.get( store->transmissions.parameter[row] ); }
+		OwUInt8 types() const							{ return store->transmissions.types[row]; }
+		bool bnr() const								{ return (types() & TYPE_BNR) != 0; }
+		bool bcd() const								{ return (types() & TYPE_BCD) != 0; }
+		bool disc() const								{ return (types() & TYPE_DISC) != 0; }
+		bool sal() const								{ return (types() & TYPE_SAL) != 0; }
+		OwUInt32 line() const							{ return store->transmissions.line[row]; }
+
+		/**
+		 * @returns the bnr data, or if there is none that given for the label for every equipment,
+		 * which isn't valid if there is neither
+		 */
+		DataView bnrData() const						{ return DataView( &store->bnr, dataRowOf( store->bnr, store->transmissions.bnrData[row], codeNo() ) ); }
+
+		/**
+		 * @returns the bcd data, or if there is none that given for the label for every equipment,
+		 * which isn't valid if there is neither
+		 */
+		DataView bcdData() const						{ return DataView( &store->bcd, dataRowOf( store->bcd, store->transmissions.bcdData[row], codeNo() ) ); }
+
+	private:
+		const SpecStore* store;
+		OwUInt32 row;
+	};
+
+	/**
+	 * A row of the EquipmentIDs sheet
+	 */
+	class EquipmentView
+	{
+	public:
+		EquipmentView() : store(NULL), row(NONE) {}
+		EquipmentView( const SpecStore* aStore, OwUInt32 aRow ) : store(aStore), row(aRow) {}
+
+		/**
+		 * @returns false if the view doesn't refer to a row
+		 */
+		bool isValid() const							{ return store != NULL && row != NONE; }
+		OwUInt32 index() const							{ return row; }
+		OwInt16 id() const								{ return store->equipment.id[row]; }
+		PooledString type() const						{ return store->equipment.strings.get( store->equipment.type[row] ); }
+		OwUInt32 line() const							{ return store->equipment.line[row]; }
+
+		/**
+		 * @returns the number of transmissions the equipment can produce, the wildcards included
+		 */
+		OwUInt32 transmissionCount() const				{ return store->equipment.linkCount[row] + (OwUInt32)store->equipment.wildcardLinks.size(); }
+
+		/**
+		 * @returns one of the transmissions the equipment can produce, in sheet order
+		 */
+		TransmissionView transmission( OwUInt32 aIndex ) const
+		{
+			return TransmissionView( store, store->linkAt( row, aIndex ) );
+		}
+
+	private:
+		const SpecStore* store;
+		OwUInt32 row;
+	};
+
+	OwUInt32 equipmentCount() const							{ return equipment.size(); }
+	OwUInt32 transmissionCount() const						{ return transmissions.size(); }
+	EquipmentView equipmentAt( OwUInt32 aRow ) const		{ return EquipmentView( this, aRow ); }
+	TransmissionView transmissionAt( OwUInt32 aRow ) const	{ return TransmissionView( this, aRow ); }
+	DataView bnrAt( OwUInt32 aRow ) const					{ return DataView( &bnr, aRow ); }
+	DataView bcdAt( OwUInt32 aRow ) const					{ return DataView( &bcd, aRow ); }
+
+	/**
+	 * @returns one of the transmission rows of an equipment, as EquipmentView::transmission does. The
+	 * equipment's links and the wildcards are each in sheet order, so this is a merge of the two
+	 */
+	OwUInt32 linkAt( OwUInt32 aEquipment, OwUInt32 aIndex ) const;
+
+	/**
+	 * @returns a transmission's BNR or BCD row, or if it has none that given for its label for every equipment, or NONE
+	 * @param aRow the row of the transmission's bnrData or bcdData column
+	 */
+	static OwUInt32 dataRowOf( const DataColumns& aColumns, OwUInt32 aRow, OwInt16 aCodeNo )
+	{
+		if( aRow != NONE || aColumns.wildcards.empty() )
+		{
+			return aRow;
+		}
+		return aColumns.wildcards[(OwUInt8)aCodeNo];
+	}
+
+	/**
+	 * Removes every row
+	 */
+	void clear();
+
+	/**
+	 * Works out the scaling columns of a row from its text columns, which must
+	 * already be filled in. What can't be worked out is added to the diagnostics
+	 * @param aRow the row, which must be the last one to have its scaling columns worked out
+	 * @param aFormat whether the columns are of the BNR or BCD sheet
+	 * @param aLine the line of the sheet the row starts on, or 0
+	 */
+	static void normalize( DataColumns& aColumns, OwUInt32 aRow, A429WordCodec::Format aFormat, OwUInt32 aLine );
+
+	/**
+	 * Converts a units column to a Unit. Case, spaces and dots are ignored
+	 * @returns UNIT_NONE for an empty column, or UNIT_UNKNOWN if it isn't recognized
+	 */
+	static Unit unitOf( const std::string& aUnits );
+
+	/**
+	 * @returns the name of a Unit, such as "knots"
+	 */
+	static const char* unitName( Unit aUnit );
+
+	/**
+	 * Finds the transmissions of the given types whose data is sent faster than a rate.
+	 * This is a single pass over the type and data columns
+	 * @param aTypes the TypeFlags to look for. Only BNR and BCD have rates
+	 * @param aMinRateHz the rate the data must exceed
+	 * @param aRows cleared, then filled with the matching transmission rows
+	 */
+	void selectByRate( OwUInt8 aTypes, double aMinRateHz, std::vector<OwUInt32>& aRows ) const;
+
+	/**
+	 * @returns an estimate of the heap memory held by the store, in bytes
+	 */
+	size_t memoryUsage() const;
+
+	EquipmentColumns equipment;
+	TransmissionColumns transmissions;
+	DataColumns bnr;
+	DataColumns bcd;
+};
+
+#endif
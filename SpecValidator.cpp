@@ -0,0 +1,471 @@
+/**
+ * @file SpecValidator.cpp
+ * @brief Checks the four specification sheets against each other.
+ */
+
+#include "SpecValidator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+#include "JsonWriter.hpp"
+
+namespace
+{
+	/**
+	 * The largest 12 bit equipment ID
+	 */
+	const OwUInt16 MAX_EQUIPMENT_ID = 0xFFF;
+
+	const char* const KIND_NAMES[SpecValidator::KIND_COUNT] =
+	{
+		"duplicateEquipment",
+		"orphanTransmission",
+		"duplicateTransmission",
+		"missingData",
+		"orphanData",
+		"duplicateData",
+		"typeMismatch",
+		"sharedData",
+		"rateConflict",
+		"rateOutOfRange"
+	};
+
+	const char* const SHEET_NAMES[SpecValidator::SHEET_COUNT] =
+	{
+		"EquipmentIDs",
+		"LabelIDs",
+		"BnrData",
+		"BcdData"
+	};
+
+	/**
+	 * Orders findings by sheet, then row, then kind
+	 */
+	bool earlierFinding( const SpecValidator::Finding& aFirst, const SpecValidator::Finding& aSecond )
+	{
+		if( aFirst.sheet != aSecond.sheet )
+		{
+			return aFirst.sheet < aSecond.sheet;
+		}
+		if( aFirst.row != aSecond.row )
+		{
+			return aFirst.row < aSecond.row;
+		}
+		return aFirst.kind < aSecond.kind;
+	}
+
+	/**
+	 * @returns a 12 bit equipment ID as 3 hex digits, or "every equipment" for wildcards
+	 */
+	std::string equipmentText( OwUInt16 aEquipmentId )
+	{
+		if( aEquipmentId == SpecStore::WILDCARD_EQUIPMENT )
+		{
+			return "every equipment";
+		}
+		char text[32];
+		sprintf( text, "equipment 0x%.3X", (unsigned)aEquipmentId );
+		return text;
+	}
+
+	std::string labelText( OwInt16 aLabel )
+	{
+		char text[32];
+		sprintf( text, "label %.3o", (unsigned)(OwUInt8)aLabel );
+		return text;
+	}
+}
+
+void SpecValidator::BlockTask::run()
+{
+	if( sheet == SHEET_TRANSMISSIONS )
+	{
+		validator->checkTransmissions( first, last, findings );
+	}
+	else
+	{
+		validator->checkData( sheet, first, last, findings );
+	}
+}
+
+SpecValidator::SpecValidator()
+	: store(NULL)
+{
+}
+
+void SpecValidator::validate( const SpecStore& aStore, std::vector<Finding>& aFindings, unsigned aThreadCount )
+{
+	aFindings.clear();
+	store = &aStore;
+	indexFindings.clear();
+
+	//The indexes, as loading builds them, so the rows are linked the same way here
+	indexEquipment();
+	indexTransmissions();
+
+	//Then the rows, a block per task
+	const OwUInt32 rows[] = { aStore.transmissionCount(), aStore.bnr.size(), aStore.bcd.size() };
+	const Sheet sheets[] = { SHEET_TRANSMISSIONS, SHEET_BNR, SHEET_BCD };
+	std::vector<BlockTask> tasks;
+	for( int i = 0; i < 3; ++i )
+	{
+		for( OwUInt32 first = 0; first < rows[i]; first += BLOCK_ROWS )
+		{
+			tasks.push_back( BlockTask( *this, sheets[i], first, std::min<OwUInt32>( first + BLOCK_ROWS, rows[i] ) ) );
+		}
+	}
+	TaskGraph graph;
+	for( size_t i = 0; i < tasks.size(); ++i )
+	{
+		graph.add( &tasks[i] );	//The tasks don't move once they are all added
+	}
+	unsigned threadCount = aThreadCount == 0 ? WorkerPool::hardwareConcurrency() : aThreadCount;
+	if( threadCount > tasks.size() )
+	{
+		threadCount = tasks.empty() ? 1 : (unsigned)tasks.size();
+	}
+	WorkerPool pool( threadCount );
+	pool.run( graph );
+
+	size_t total = indexFindings.size();
+	for( size_t i = 0; i < tasks.size(); ++i )
+	{
+		total += tasks[i].findings.size();
+	}
+	aFindings.reserve( total );
+	aFindings.insert( aFindings.end(), indexFindings.begin(), indexFindings.end() );
+	for( size_t i = 0; i < tasks.size(); ++i )
+	{
+		aFindings.insert( aFindings.end(), tasks[i].findings.begin(), tasks[i].findings.end() );
+	}
+	std::stable_sort( aFindings.begin(), aFindings.end(), earlierFinding );
+}
+
+void SpecValidator::indexEquipment()
+{
+	const EquipmentColumns& equipment = store->equipment;
+	equipmentIndex.assign( MAX_EQUIPMENT_ID + 1, (OwUInt32)SpecStore::NONE );
+	for( OwUInt32 i = 0; i < equipment.size(); ++i )
+	{
+		OwInt16 id = equipment.id[i];
+		if( id < 0 || id > MAX_EQUIPMENT_ID )
+		{
+			continue;	//Not an ID the other sheets can give
+		}
+		if( equipmentIndex[id] == SpecStore::NONE )
+		{
+			equipmentIndex[id] = i;	//The first entry for an ID wins
+		}
+		else
+		{
+			addFinding( indexFindings, DUPLICATE_EQUIPMENT, SHEET_EQUIPMENT, i, SHEET_EQUIPMENT, equipmentIndex[id] );
+		}
+	}
+}
+
+void SpecValidator::indexTransmissions()
+{
+	const TransmissionColumns& transmissions = store->transmissions;
+	transmissionIndex.clear();
+	transmissionIndex.reserve( transmissions.size() );
+	wildcardIndex.assign( 256, (OwUInt32)SpecStore::NONE );
+	for( OwUInt32 i = 0; i < transmissions.size(); ++i )
+	{
+		OwUInt16 id = transmissions.equipmentId[i];
+		OwUInt8 label = (OwUInt8)transmissions.codeNo[i];
+		if( id == SpecStore::WILDCARD_EQUIPMENT )
+		{
+			if( wildcardIndex[label] == SpecStore::NONE )
+			{
+				wildcardIndex[label] = i;
+			}
+			else
+			{
+				addFinding( indexFindings, DUPLICATE_TRANSMISSION, SHEET_TRANSMISSIONS, i, SHEET_TRANSMISSIONS, wildcardIndex[label] );
+			}
+		}
+		else if( id > MAX_EQUIPMENT_ID || equipmentIndex[id] == SpecStore::NONE )
+		{
+			addFinding( indexFindings, ORPHAN_TRANSMISSION, SHEET_TRANSMISSIONS, i, SHEET_EQUIPMENT, (OwUInt32)SpecStore::NONE );
+		}
+		else if( !transmissionIndex.insert( id, label, i ) )
+		{
+			OwUInt32 earlier = SpecStore::NONE;
+			transmissionIndex.find( id, label, earlier );
+			addFinding( indexFindings, DUPLICATE_TRANSMISSION, SHEET_TRANSMISSIONS, i, SHEET_TRANSMISSIONS, earlier );
+		}
+	}
+}
+
+OwUInt32 SpecValidator::transmissionOf( OwUInt16 aEquipmentId, OwUInt8 aLabel ) const
+{
+	//As LoadedCSV::findTransmissionRow: the equipment's own, then the one every equipment has
+	if( aEquipmentId > MAX_EQUIPMENT_ID || equipmentIndex[aEquipmentId] == SpecStore::NONE )
+	{
+		return SpecStore::NONE;
+	}
+	OwUInt32 row = SpecStore::NONE;
+	if( transmissionIndex.find( aEquipmentId, aLabel, row ) )
+	{
+		return row;
+	}
+	return wildcardIndex[aLabel];
+}
+
+void SpecValidator::checkTransmissions( OwUInt32 aFirst, OwUInt32 aLast, std::vector<Finding>& aFindings ) const
+{
+	const TransmissionColumns& transmissions = store->transmissions;
+	for( OwUInt32 i = aFirst; i < aLast; ++i )
+	{
+		//Only the transmissions the data is linked to; the orphans and those given twice are already found
+		OwUInt16 id = transmissions.equipmentId[i];
+		OwUInt8 label = (OwUInt8)transmissions.codeNo[i];
+		if( id == SpecStore::WILDCARD_EQUIPMENT ? wildcardIndex[label] != i : transmissionOf( id, label ) != i )
+		{
+			continue;
+		}
+
+		OwUInt8 types = transmissions.types[i];
+		OwUInt32 bnr = SpecStore::dataRowOf( store->bnr, transmissions.bnrData[i], transmissions.codeNo[i] );
+		OwUInt32 bcd = SpecStore::dataRowOf( store->bcd, transmissions.bcdData[i], transmissions.codeNo[i] );
+		if( (types & SpecStore::TYPE_BNR) != 0 && bnr == SpecStore::NONE )
+		{
+			addFinding( aFindings, MISSING_DATA, SHEET_TRANSMISSIONS, i, SHEET_BNR, (OwUInt32)SpecStore::NONE );
+		}
+		if( (types & SpecStore::TYPE_BCD) != 0 && bcd == SpecStore::NONE )
+		{
+			addFinding( aFindings, MISSING_DATA, SHEET_TRANSMISSIONS, i, SHEET_BCD, (OwUInt32)SpecStore::NONE );
+		}
+		if( (types & SpecStore::TYPE_BNR) != 0 && (types & SpecStore::TYPE_BCD) != 0 && bnr != SpecStore::NONE && bcd != SpecStore::NONE
+			&& store->bnr.periodUs[bnr] != store->bcd.periodUs[bcd] )
+		{
+			addFinding( aFindings, RATE_CONFLICT, SHEET_TRANSMISSIONS, i, SHEET_BCD, bcd );
+		}
+	}
+}
+
+void SpecValidator::checkData( Sheet aSheet, OwUInt32 aFirst, OwUInt32 aLast, std::vector<Finding>& aFindings ) const
+{
+	const TransmissionColumns& transmissions = store->transmissions;
+	const DataColumns& columns = aSheet == SHEET_BNR ? store->bnr : store->bcd;
+	const std::vector<OwUInt32>& linked = aSheet == SHEET_BNR ? transmissions.bnrData : transmissions.bcdData;
+	OwUInt8 type = aSheet == SHEET_BNR ? SpecStore::TYPE_BNR : SpecStore::TYPE_BCD;
+	for( OwUInt32 i = aFirst; i < aLast; ++i )
+	{
+		//The max transit interval is in milliseconds, when it is a number
+		PooledString maxText = columns.strings.get( columns.maxTransitInterval[i] );
+		char* end = NULL;
+		double maxInterval = strtod( maxText.c_str(), &end );
+		if( end != maxText.c_str() && maxInterval > 0 && columns.periodUs[i] > maxInterval * 1000 )
+		{
+			addFinding( aFindings, RATE_OUT_OF_RANGE, aSheet, i, aSheet, (OwUInt32)SpecStore::NONE );
+		}
+
+		OwUInt8 label = columns.label[i];
+		if( columns.equipmentId[i] == SpecStore::WILDCARD_EQUIPMENT )
+		{
+			//The first for a label is the one used
+			if( columns.wildcards.size() == 256 && columns.wildcards[label] != i )
+			{
+				addFinding( aFindings, DUPLICATE_DATA, aSheet, i, aSheet, columns.wildcards[label] );
+			}
+			continue;
+		}
+
+		OwUInt32 transmission = transmissionOf( columns.equipmentId[i], label );
+		if( transmission == SpecStore::NONE )
+		{
+			addFinding( aFindings, ORPHAN_DATA, aSheet, i, SHEET_TRANSMISSIONS, (OwUInt32)SpecStore::NONE );
+		}
+		else if( linked[transmission] != i )
+		{
+			addFinding( aFindings, DUPLICATE_DATA, aSheet, i, aSheet, linked[transmission] );	//The last for a transmission is the one used
+		}
+		else
+		{
+			if( (transmissions.types[transmission] & type) == 0 )
+			{
+				addFinding( aFindings, TYPE_MISMATCH, aSheet, i, SHEET_TRANSMISSIONS, transmission );
+			}
+			if( transmissions.equipmentId[transmission] == SpecStore::WILDCARD_EQUIPMENT )
+			{
+				addFinding( aFindings, SHARED_DATA, aSheet, i, SHEET_TRANSMISSIONS, transmission );
+			}
+		}
+	}
+}
+
+void SpecValidator::addFinding( std::vector<Finding>& aFindings, Kind aKind, Sheet aSheet, OwUInt32 aRow, Sheet aOtherSheet, OwUInt32 aOtherRow ) const
+{
+	Finding finding;
+	finding.kind = aKind;
+	finding.sheet = aSheet;
+	finding.row = aRow;
+	finding.line = lineOf( *store, aSheet, aRow );
+	finding.otherSheet = aOtherSheet;
+	finding.otherRow = aOtherRow;
+	finding.otherLine = aOtherRow == SpecStore::NONE ? 0 : lineOf( *store, aOtherSheet, aOtherRow );
+	aFindings.push_back( finding );
+}
+
+OwUInt32 SpecValidator::lineOf( const SpecStore& aStore, Sheet aSheet, OwUInt32 aRow )
+{
+	const std::vector<OwUInt32>* lines = NULL;
+	switch( aSheet )
+	{
+	case SHEET_EQUIPMENT:		lines = &aStore.equipment.line;		break;
+	case SHEET_TRANSMISSIONS:	lines = &aStore.transmissions.line;	break;
+	case SHEET_BNR:				lines = &aStore.bnr.line;			break;
+	default:					lines = &aStore.bcd.line;			break;
+	}
+	return aRow < lines->size() ? (*lines)[aRow] : 0;
+}
+
+std::string SpecValidator::placeOf( const SpecStore& aStore, Sheet aSheet, OwUInt32 aRow, Sheet aFrom )
+{
+	std::ostringstream place;
+	OwUInt32 line = lineOf( aStore, aSheet, aRow );
+	if( line != 0 )
+	{
+		place << "line " << line;
+	}
+	else
+	{
+		place << "row " << aRow;
+	}
+	if( aSheet != aFrom )
+	{
+		place << " of " << sheetName( aSheet );
+	}
+	return place.str();
+}
+
+void SpecValidator::countKinds( const std::vector<Finding>& aFindings, OwUInt32 aCounts[KIND_COUNT] )
+{
+	std::fill( aCounts, aCounts + KIND_COUNT, 0 );
+	for( size_t i = 0; i < aFindings.size(); ++i )
+	{
+		++aCounts[aFindings[i].kind];
+	}
+}
+
+const char* SpecValidator::kindName( Kind aKind )
+{
+	return aKind >= 0 && aKind < KIND_COUNT ? KIND_NAMES[aKind] : "unknown";
+}
+
+const char* SpecValidator::sheetName( Sheet aSheet )
+{
+	return aSheet >= 0 && aSheet < SHEET_COUNT ? SHEET_NAMES[aSheet] : "unknown";
+}
+
+std::string SpecValidator::describe( const SpecStore& aStore, const Finding& aFinding )
+{
+	std::ostringstream text;
+	text << sheetName( aFinding.sheet ) << " " << placeOf( aStore, aFinding.sheet, aFinding.row, aFinding.sheet ) << ": ";
+
+	//What the row is
+	if( aFinding.sheet == SHEET_EQUIPMENT )
+	{
+		SpecStore::EquipmentView equipment = aStore.equipmentAt( aFinding.row );
+		text << equipmentText( equipment.id() ) << " '" << equipment.type().c_str() << "'";
+	}
+	else if( aFinding.sheet == SHEET_TRANSMISSIONS )
+	{
+		SpecStore::TransmissionView transmission = aStore.transmissionAt( aFinding.row );
+		text << labelText( transmission.codeNo() ) << " of " << equipmentText( transmission.equipmentId() ) << " '" << transmission.parameter().c_str() << "'";
+	}
+	else
+	{
+		SpecStore::DataView data = aFinding.sheet == SHEET_BNR ? aStore.bnrAt( aFinding.row ) : aStore.bcdAt( aFinding.row );
+		text << labelText( data.label() ) << " of " << equipmentText( data.equipmentId() );
+	}
+
+	//And what is wrong with it
+	std::string other = aFinding.otherRow == SpecStore::NONE ? std::string() : placeOf( aStore, aFinding.otherSheet, aFinding.otherRow, aFinding.sheet );
+	const char* otherType = aFinding.otherSheet == SHEET_BNR ? "BNR" : "BCD";
+	const char* type = aFinding.sheet == SHEET_BNR ? "BNR" : "BCD";
+	switch( aFinding.kind )
+	{
+	case DUPLICATE_EQUIPMENT:
+		text << " has the ID of " << other << ", which is used instead";
+		break;
+	case ORPHAN_TRANSMISSION:
+		text << " has no equipment in " << sheetName( SHEET_EQUIPMENT );
+		break;
+	case DUPLICATE_TRANSMISSION:
+		text << " is given again after " << other << ", which is used instead";
+		break;
+	case MISSING_DATA:
+		text << " is marked " << otherType << " but has no " << sheetName( aFinding.otherSheet ) << " row";
+		break;
+	case ORPHAN_DATA:
+		text << " has no transmission in " << sheetName( SHEET_TRANSMISSIONS );
+		break;
+	case DUPLICATE_DATA:
+		text << " is replaced by " << other;
+		break;
+	case TYPE_MISMATCH:
+		text << " is linked to " << other << ", which isn't marked " << type;
+		break;
+	case SHARED_DATA:
+		text << " is linked to " << other << ", which every equipment has";
+		break;
+	case RATE_CONFLICT:
+		{
+			SpecStore::TransmissionView transmission = aStore.transmissionAt( aFinding.row );
+			text << " is sent every " << transmission.bnrData().periodUs() << " us by its BNR data but every "
+				<< transmission.bcdData().periodUs() << " us by its BCD data, " << other;
+		}
+		break;
+	case RATE_OUT_OF_RANGE:
+		{
+			SpecStore::DataView data = aFinding.sheet == SHEET_BNR ? aStore.bnrAt( aFinding.row ) : aStore.bcdAt( aFinding.row );
+			text << " is sent every " << data.periodUs() << " us, longer than its max transit interval of " << data.maxTransitInterval().c_str() << " ms";
+		}
+		break;
+	default:
+		text << " is " << kindName( aFinding.kind );
+		break;
+	}
+	return text.str();
+}
+
+void SpecValidator::writeJson( std::ostream& aStream, const SpecStore& aStore, const std::vector<Finding>& aFindings )
+{
+	OwUInt32 counts[KIND_COUNT];
+	countKinds( aFindings, counts );
+
+	JsonWriter json( aStream );
+	json.beginObject();
+	json.key( "counts" ).beginObject();
+	for( int kind = 0; kind < KIND_COUNT; ++kind )
+	{
+		json.key( KIND_NAMES[kind] ).value( counts[kind] );
+	}
+	json.endObject();
+	json.key( "findings" ).beginArray();
+	for( size_t i = 0; i < aFindings.size(); ++i )
+	{
+		const Finding& finding = aFindings[i];
+		json.beginObject();
+		json.key( "kind" ).value( kindName( finding.kind ) );
+		json.key( "sheet" ).value( sheetName( finding.sheet ) );
+		json.key( "row" ).value( finding.row );
+		json.key( "line" ).value( finding.line );
+		if( finding.otherRow != SpecStore::NONE )
+		{
+			json.key( "otherSheet" ).value( sheetName( finding.otherSheet ) );
+			json.key( "otherRow" ).value( finding.otherRow );
+			json.key( "otherLine" ).value( finding.otherLine );
+		}
+		json.key( "message" ).value( describe( aStore, finding ) );
+		json.endObject();
+	}
+	json.endArray();
+	json.endObject();
+	aStream << "\n";
+}
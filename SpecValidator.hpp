@@ -0,0 +1,260 @@
+/**
+ * @file SpecValidator.hpp
+ * @brief Checks the four specification sheets against each other.
+ */
+
+#ifndef A429_SPEC_VALIDATOR_HPP
+#define A429_SPEC_VALIDATOR_HPP
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include <Owl429/definitions>
+
+#include "LabelIndex.hpp"
+#include "SpecStore.hpp"
+#include "WorkerPool.hpp"
+
+/**
+ * Finds the rows of the sheets that don't fit together, which loading otherwise drops or
+ * resolves without saying so:
+ *
+ *  - equipment IDs given twice, of which only the first is used
+ *  - transmissions of an equipment that isn't in EquipmentIDs, or given twice for an
+ *    equipment and label, or twice for every equipment
+ *  - transmissions marked BNR or BCD without the data, which save() leaves out
+ *  - BNR and BCD rows with no transmission of their equipment and label (like HF COM
+ *    Frequency, whose equipment ID differs between LabelIDs and BcdData), replaced by a
+ *    later row for the same transmission, linked to a transmission not marked with their
+ *    type, or linked to a transmission every equipment has
+ *  - BNR and BCD data of one transmission with different rates, and rates slower than the
+ *    max transit interval allows
+ *
+ * Each finding has the row and the line of the sheet it is on, and the row it conflicts
+ * with, if any. The equipment and transmissions are indexed as loading indexes them, then
+ * the rows are checked in blocks on a WorkerPool, so a check is a few passes over the columns.
+ */
+class SpecValidator
+{
+public:
+
+	/**
+	 * The sheets the rows are from
+	 */
+	enum Sheet
+	{
+		SHEET_EQUIPMENT,
+		SHEET_TRANSMISSIONS,
+		SHEET_BNR,
+		SHEET_BCD,
+		SHEET_COUNT
+	};
+
+	/**
+	 * What is wrong with a row
+	 */
+	enum Kind
+	{
+		/**
+		 * @brief An equipment with the ID of an earlier one, the other row. It is left out of the lookups
+		 */
+		DUPLICATE_EQUIPMENT,
+		/**
+		 * @brief A transmission whose equipment ID isn't in EquipmentIDs, so no equipment has it
+		 */
+		ORPHAN_TRANSMISSION,
+		/**
+		 * @brief A transmission with the equipment ID and label of an earlier one, the other row. It is left out of the lookups
+		 */
+		DUPLICATE_TRANSMISSION,
+		/**
+		 * @brief A transmission marked BNR or BCD, the other sheet, without the data. It isn't exported
+		 */
+		MISSING_DATA,
+		/**
+		 * @brief A BNR or BCD row with no transmission of its equipment and label. It isn't used
+		 */
+		ORPHAN_DATA,
+		/**
+		 * @brief A BNR or BCD row replaced by a later one for the same transmission, the other row
+		 */
+		DUPLICATE_DATA,
+		/**
+		 * @brief A BNR or BCD row linked to a transmission, the other row, not marked with its type. It isn't used
+		 */
+		TYPE_MISMATCH,
+		/**
+		 * @brief A BNR or BCD row of one equipment linked to a wildcard transmission, the other row,
+		 *        so every equipment without its own data gets it
+		 */
+		SHARED_DATA,
+		/**
+		 * @brief A transmission whose BNR and BCD data, the other row, have different rates. save() uses the BCD rate
+		 */
+		RATE_CONFLICT,
+		/**
+		 * @brief A BNR or BCD row whose rate is slower than its max transit interval
+		 */
+		RATE_OUT_OF_RANGE,
+		KIND_COUNT
+	};
+
+	/**
+	 * A row that doesn't fit with the rest
+	 */
+	typedef struct Finding
+	{
+		Kind kind;
+		Sheet sheet;
+		/**
+		 * @brief The row in the columns of the sheet
+		 */
+		OwUInt32 row;
+		/**
+		 * @brief The line of the sheet the row starts on, or 0 if it isn't known
+		 */
+		OwUInt32 line;
+		/**
+		 * @brief The sheet of the row it conflicts with, or of the data it lacks
+		 */
+		Sheet otherSheet;
+		/**
+		 * @brief The row it conflicts with, or SpecStore::NONE
+		 */
+		OwUInt32 otherRow;
+		/**
+		 * @brief The line of that row, or 0
+		 */
+		OwUInt32 otherLine;
+	} Finding;
+
+	/**
+	 * The rows checked by each task
+	 */
+	enum { BLOCK_ROWS = 16384 };
+
+	SpecValidator();
+
+	/**
+	 * Checks the sheets of a store against each other
+	 * @param aFindings cleared, then filled with the findings in sheet then row order
+	 * @param aThreadCount the number of threads to use. 0 uses one per core, 1 checks on the calling thread
+	 */
+	void validate( const SpecStore& aStore, std::vector<Finding>& aFindings, unsigned aThreadCount = 0 );
+
+	/**
+	 * Counts the findings of each kind
+	 * @param aCounts KIND_COUNT counts, set
+	 */
+	static void countKinds( const std::vector<Finding>& aFindings, OwUInt32 aCounts[KIND_COUNT] );
+
+	/**
+	 * @returns a line of text about a finding, such as
+	 *          "BcdData line 512: label 206 of equipment 0x0A2 has no transmission"
+	 */
+	static std::string describe( const SpecStore& aStore, const Finding& aFinding );
+
+	/**
+	 * @returns the name of a kind, as written by writeJson
+	 */
+	static const char* kindName( Kind aKind );
+
+	/**
+	 * @returns the name of a sheet, as in its file name
+	 */
+	static const char* sheetName( Sheet aSheet );
+
+	/**
+	 * Writes findings as a JSON object with the count of each kind and the findings
+	 */
+	static void writeJson( std::ostream& aStream, const SpecStore& aStore, const std::vector<Finding>& aFindings );
+
+private:
+
+	/**
+	 * Checks a block of rows of one sheet, once the indexes are built
+	 */
+	class BlockTask : public WorkerTask
+	{
+	public:
+		BlockTask( const SpecValidator& aValidator, Sheet aSheet, OwUInt32 aFirst, OwUInt32 aLast )
+			: validator(&aValidator)
+			, sheet(aSheet)
+			, first(aFirst)
+			, last(aLast)
+		{
+		}
+
+		void run();
+
+		std::vector<Finding> findings;
+
+	private:
+		const SpecValidator* validator;
+		Sheet sheet;
+		OwUInt32 first;
+		OwUInt32 last;
+	};
+
+	//Not copyable
+	SpecValidator( const SpecValidator& );
+	SpecValidator& operator=( const SpecValidator& );
+
+	/**
+	 * Indexes the equipment by ID, finding those given twice
+	 */
+	void indexEquipment();
+
+	/**
+	 * Indexes the transmissions by equipment ID and label, finding the orphans and those given twice
+	 */
+	void indexTransmissions();
+
+	/**
+	 * Checks that transmissions have the data they are marked with, at matching rates
+	 */
+	void checkTransmissions( OwUInt32 aFirst, OwUInt32 aLast, std::vector<Finding>& aFindings ) const;
+
+	/**
+	 * Checks BNR or BCD rows against the transmissions
+	 */
+	void checkData( Sheet aSheet, OwUInt32 aFirst, OwUInt32 aLast, std::vector<Finding>& aFindings ) const;
+
+	/**
+	 * @returns the transmission a BNR or BCD row is linked to, as loading links it, or SpecStore::NONE
+	 */
+	OwUInt32 transmissionOf( OwUInt16 aEquipmentId, OwUInt8 aLabel ) const;
+
+	/**
+	 * @returns the line of a row of a sheet, or 0
+	 */
+	static OwUInt32 lineOf( const SpecStore& aStore, Sheet aSheet, OwUInt32 aRow );
+
+	/**
+	 * @returns where a row is, as "line 12" or "row 11" if its line isn't known, followed by its sheet if it isn't aSheet
+	 */
+	static std::string placeOf( const SpecStore& aStore, Sheet aSheet, OwUInt32 aRow, Sheet aFrom );
+
+	void addFinding( std::vector<Finding>& aFindings, Kind aKind, Sheet aSheet, OwUInt32 aRow, Sheet aOtherSheet, OwUInt32 aOtherRow ) const;
+
+	const SpecStore* store;
+	/**
+	 * @brief The first equipment row of each 12 bit ID, or SpecStore::NONE
+	 */
+	std::vector<OwUInt32> equipmentIndex;
+	/**
+	 * @brief The first transmission row of each equipment ID and label, of the equipment there are
+	 */
+	LabelIndex<OwUInt32> transmissionIndex;
+	/**
+	 * @brief The first wildcard transmission row of each label, or SpecStore::NONE
+	 */
+	std::vector<OwUInt32> wildcardIndex;
+	/**
+	 * @brief What the indexing found
+	 */
+	std::vector<Finding> indexFindings;
+};
+
+#endif
@@ -0,0 +1,204 @@
+/**
+ * @file SpscRing.hpp
+ * @brief A wait-free ring buffer between one producer thread and one consumer thread.
+ */
+
+#ifndef A429_SPSC_RING_HPP
+#define A429_SPSC_RING_HPP
+
+#include <vector>
+#include <cstddef>
+
+#ifdef _WIN32
+#include <intrin.h>
+#pragma intrinsic(_ReadWriteBarrier)
+#endif
+
+/**
+ * A fixed size queue for passing values from one thread to another without locks.
+ *
+ * Only one thread may push and only one other thread may pop. Each side owns one index and
+ * only reads the other's, so neither ever waits on the other: a push into a full ring or a
+ * pop from an empty one returns straight away. Each side also keeps a copy of the other's
+ * index and only reads the real one when the copy says the ring is full or empty, so the
+ * cache lines move between the cores as little as they can. The indexes are kept on
+ * separate cache lines for the same reason.
+ *
+ * The slots are allocated once, when the ring is made, so pushing and popping never allocate.
+ */
+template <typename T>
+class SpscRing
+{
+public:
+
+	/**
+	 * The size of a cache line, which the indexes are kept apart by
+	 */
+	enum { CACHE_LINE = 64 };
+
+	/**
+	 * @param aCapacity the most values the ring holds, rounded up to a power of 2
+	 */
+	explicit SpscRing( size_t aCapacity )
+		: head(0)
+		, cachedTail(0)
+		, tail(0)
+		, cachedHead(0)
+		, closed(0)
+	{
+		size_t capacity = 2;
+		while( capacity < aCapacity )
+		{
+			capacity *= 2;
+		}
+		slots.resize( capacity );
+		mask = capacity - 1;
+	}
+
+	/**
+	 * Adds a value. Only to be called by the producer
+	 * @returns false if the ring is full
+	 */
+	bool tryPush( const T& aValue )
+	{
+		size_t position = head;
+		if( position - cachedTail > mask )
+		{
+			cachedTail = loadAcquire( tail );
+			if( position - cachedTail > mask )
+			{
+				return false;
+			}
+		}
+		slots[position & mask] = aValue;
+		storeRelease( head, position + 1 );
+		return true;
+	}
+
+	/**
+	 * Takes the oldest values. Only to be called by the consumer
+	 * @param aValues where to put them
+	 * @param aMax the most to take
+	 * @returns the number taken, 0 if the ring is empty
+	 */
+	size_t tryPop( T* aValues, size_t aMax )
+	{
+		size_t position = tail;
+		if( cachedHead == position )
+		{
+			cachedHead = loadAcquire( head );
+			if( cachedHead == position )
+			{
+				return 0;
+			}
+		}
+		size_t count = cachedHead - position;
+		if( count > aMax )
+		{
+			count = aMax;
+		}
+		for( size_t i = 0; i < count; ++i )
+		{
+			aValues[i] = slots[(position + i) & mask];
+		}
+		storeRelease( tail, position + count );
+		return count;
+	}
+
+	/**
+	 * Tells the consumer nothing more will be pushed. Only to be called by the producer
+	 */
+	void close()
+	{
+		storeRelease( closed, 1 );
+	}
+
+	/**
+	 * @returns true once the producer has closed the ring. The values pushed before are
+	 *          still to be popped
+	 */
+	bool isClosed() const
+	{
+		return loadAcquire( closed ) != 0;
+	}
+
+	/**
+	 * Empties and reopens the ring. Neither thread may be using it
+	 */
+	void reset()
+	{
+		head = 0;
+		cachedTail = 0;
+		tail = 0;
+		cachedHead = 0;
+		closed = 0;
+	}
+
+	size_t capacity() const
+	{
+		return slots.size();
+	}
+
+private:
+
+	//Not copyable
+	SpscRing( const SpscRing& );
+	SpscRing& operator=( const SpscRing& );
+
+	/**
+	 * Reads an index written by the other thread, seeing everything it wrote before
+	 */
+	template <typename V>
+	static V loadAcquire( const volatile V& aValue )
+	{
+#ifdef _WIN32
+		V value = aValue;	//Volatile reads acquire with Visual C++
+		_ReadWriteBarrier();
+		return value;
+#else
+		return __atomic_load_n( &aValue, __ATOMIC_ACQUIRE );
+#endif
+	}
+
+	/**
+	 * Writes an index for the other thread, after everything written before it
+	 */
+	template <typename V>
+	static void storeRelease( volatile V& aValue, V aNew )
+	{
+#ifdef _WIN32
+		_ReadWriteBarrier();
+		aValue = aNew;	//Volatile writes release with Visual C++
+#else
+		__atomic_store_n( &aValue, aNew, __ATOMIC_RELEASE );
+#endif
+	}
+
+	std::vector<T> slots;
+	size_t mask;
+
+	char producerLine[CACHE_LINE];
+	/**
+	 * @brief The count of values pushed, written by the producer
+	 */
+	volatile size_t head;
+	/**
+	 * @brief The producer's copy of tail
+	 */
+	size_t cachedTail;
+
+	char consumerLine[CACHE_LINE];
+	/**
+	 * @brief The count of values popped, written by the consumer
+	 */
+	volatile size_t tail;
+	/**
+	 * @brief The consumer's copy of head
+	 */
+	size_t cachedHead;
+
+	char closedLine[CACHE_LINE];
+	volatile int closed;
+};
+
+#endif
@@ -0,0 +1,40 @@
+/**
+ * @file Stopwatch.cpp
+ * @brief A monotonic nanosecond timer.
+ */
+
+#include "Stopwatch.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef _WIN32
+
+OwUInt64 Stopwatch::now()
+{
+	static LARGE_INTEGER frequency = { 0 };
+	if( frequency.QuadPart == 0 )
+	{
+		QueryPerformanceFrequency( &frequency );	//Fixed at boot, so racing threads store the same value
+	}
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter( &counter );
+	//Split the conversion so the multiplication can't overflow
+	OwUInt64 ticks = (OwUInt64)counter.QuadPart;
+	OwUInt64 perSecond = (OwUInt64)frequency.QuadPart;
+	return (ticks / perSecond) * 1000000000 + (ticks % perSecond) * 1000000000 / perSecond;
+}
+
+#else
+
+OwUInt64 Stopwatch::now()
+{
+	timespec time;
+	clock_gettime( CLOCK_MONOTONIC, &time );
+	return (OwUInt64)time.tv_sec * 1000000000 + (OwUInt64)time.tv_nsec;
+}
+
+#endif
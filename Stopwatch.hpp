@@ -0,0 +1,51 @@
+/**
+ * @file Stopwatch.hpp
+ * @brief A monotonic nanosecond timer.
+ */
+
+#ifndef A429_STOPWATCH_HPP
+#define A429_STOPWATCH_HPP
+
+#include <Owl429/definitions>
+
+/**
+ * Measures elapsed time with the highest resolution monotonic clock of the platform
+ */
+class Stopwatch
+{
+public:
+
+	/**
+	 * Starts timing
+	 */
+	Stopwatch()
+		: started(now())
+	{
+	}
+
+	/**
+	 * Starts timing again
+	 */
+	void restart()
+	{
+		started = now();
+	}
+
+	/**
+	 * @returns the nanoseconds since the stopwatch was started
+	 */
+	OwUInt64 elapsed() const
+	{
+		return now() - started;
+	}
+
+	/**
+	 * @returns the current time in nanoseconds, from an arbitrary start
+	 */
+	static OwUInt64 now();
+
+private:
+	OwUInt64 started;
+};
+
+#endif
@@ -0,0 +1,190 @@
+/**
+ * @file StringPool.cpp
+ * @brief Interned strings, kept once each in arena blocks.
+ */
+
+#include "StringPool.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	/**
+	 * The strings std::string keeps inside the object rather than on the heap, for the estimate of savedBytes
+	 */
+	const size_t SHORT_STRING = 15;
+}
+
+StringPool::StringPool()
+	: current(NULL)
+	, currentUsed(BLOCK_SIZE)
+	, blockBytes(0)
+	, internCount(0)
+	, copyBytes(0)
+{
+	clear();
+}
+
+StringPool::~StringPool()
+{
+	for( size_t i = 0; i < blocks.size(); ++i )
+	{
+		delete[] blocks[i];
+	}
+}
+
+void StringPool::clear()
+{
+	for( size_t i = 0; i < blocks.size(); ++i )
+	{
+		delete[] blocks[i];
+	}
+	blocks.clear();
+	current = NULL;
+	currentUsed = BLOCK_SIZE;
+	blockBytes = 0;
+	internCount = 0;
+	copyBytes = 0;
+	entries.clear();
+	slots.assign( 64, (OwUInt32)NO_ENTRY );
+
+	//The empty string is always there, as EMPTY
+	Entry empty;
+	empty.text = "";
+	empty.length = 0;
+	empty.hash = hashOf( "", 0 );
+	entries.push_back( empty );
+	slots[slotOf( "", 0, empty.hash )] = EMPTY;
+}
+
+void StringPool::swap( StringPool& aOther )
+{
+	entries.swap( aOther.entries );
+	slots.swap( aOther.slots );
+	blocks.swap( aOther.blocks );
+	std::swap( current, aOther.current );
+	std::swap( currentUsed, aOther.currentUsed );
+	std::swap( blockBytes, aOther.blockBytes );
+	std::swap( internCount, aOther.internCount );
+	std::swap( copyBytes, aOther.copyBytes );
+}
+
+OwUInt32 StringPool::hashOf( const char* aText, size_t aLength )
+{
+	//32 bit FNV-1a
+	OwUInt32 hash = 2166136261u;
+	for( size_t i = 0; i < aLength; ++i )
+	{
+		hash = (hash ^ (OwUInt8)aText[i]) * 16777619u;
+	}
+	return hash;
+}
+
+size_t StringPool::slotOf( const char* aText, size_t aLength, OwUInt32 aHash ) const
+{
+	size_t mask = slots.size() - 1;
+	size_t slot = aHash & mask;
+	while( slots[slot] != NO_ENTRY )
+	{
+		const Entry& entry = entries[slots[slot]];
+		if( entry.hash == aHash && entry.length == aLength && memcmp( entry.text, aText, aLength ) == 0 )
+		{
+			break;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+const char* StringPool::store( const char* aText, size_t aLength )
+{
+	char* text = NULL;
+	if( aLength + 1 > BLOCK_SIZE / 4 )
+	{
+		//Too long to share a block without wasting much of it
+		text = new char[aLength + 1];
+		blocks.push_back( text );
+		blockBytes += aLength + 1;
+	}
+	else
+	{
+		if( currentUsed + aLength + 1 > BLOCK_SIZE )
+		{
+			current = new char[BLOCK_SIZE];
+			blocks.push_back( current );
+			blockBytes += BLOCK_SIZE;
+			currentUsed = 0;
+		}
+		text = current + currentUsed;
+		currentUsed += aLength + 1;
+	}
+	memcpy( text, aText, aLength );
+	text[aLength] = '\0';
+	return text;
+}
+
+void StringPool::grow()
+{
+	slots.assign( slots.size() * 2, (OwUInt32)NO_ENTRY );
+	size_t mask = slots.size() - 1;
+	for( OwUInt32 i = 0; i < (OwUInt32)entries.size(); ++i )
+	{
+		size_t slot = entries[i].hash & mask;
+		while( slots[slot] != NO_ENTRY )
+		{
+			slot = (slot + 1) & mask;
+		}
+		slots[slot] = i;
+	}
+}
+
+StringPool::Handle StringPool::intern( const char* aText, size_t aLength )
+{
+	++internCount;
+	copyBytes += sizeof(std::string) + (aLength > SHORT_STRING ? aLength + 1 : 0);
+
+	OwUInt32 hash = hashOf( aText, aLength );
+	size_t slot = slotOf( aText, aLength, hash );
+	if( slots[slot] != NO_ENTRY )
+	{
+		return slots[slot];
+	}
+
+	//Keep the table at most half full
+	if( (entries.size() + 1) * 2 > slots.size() )
+	{
+		grow();
+		slot = slotOf( aText, aLength, hash );
+	}
+	Entry entry;
+	entry.text = store( aText, aLength );
+	entry.length = (OwUInt32)aLength;
+	entry.hash = hash;
+	slots[slot] = (OwUInt32)entries.size();
+	entries.push_back( entry );
+	return slots[slot];
+}
+
+bool StringPool::find( const char* aText, size_t aLength, Handle& aHandle ) const
+{
+	size_t slot = slotOf( aText, aLength, hashOf( aText, aLength ) );
+	if( slots[slot] == NO_ENTRY )
+	{
+		return false;
+	}
+	aHandle = slots[slot];
+	return true;
+}
+
+OwInt64 StringPool::savedBytes() const
+{
+	return (OwInt64)copyBytes - (OwInt64)memoryUsage() - (OwInt64)(internCount * sizeof(Handle));
+}
+
+size_t StringPool::memoryUsage() const
+{
+	return entries.capacity() * sizeof(Entry)
+		+ slots.capacity() * sizeof(OwUInt32)
+		+ blocks.capacity() * sizeof(char*)
+		+ blockBytes;
+}
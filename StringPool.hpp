@@ -0,0 +1,224 @@
+/**
+ * @file StringPool.hpp
+ * @brief Interned strings, kept once each in arena blocks.
+ */
+
+#ifndef A429_STRING_POOL_HPP
+#define A429_STRING_POOL_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+
+#include <Owl429/definitions>
+
+/**
+ * A string held by a StringPool. It points into the pool, so it is only valid while
+ * the pool is, and it is null terminated so it can be handed to C functions.
+ */
+class PooledString
+{
+public:
+	PooledString()
+		: text("")
+		, textLength(0)
+	{
+	}
+
+	PooledString( const char* aText, size_t aLength )
+		: text(aText)
+		, textLength(aLength)
+	{
+	}
+
+	const char* data() const		{ return text; }
+	const char* c_str() const		{ return text; }
+	size_t size() const				{ return textLength; }
+	bool empty() const				{ return textLength == 0; }
+	char operator[]( size_t aIndex ) const	{ return text[aIndex]; }
+
+	/**
+	 * Copies the string out
+	 */
+	std::string str() const
+	{
+		return std::string( text, textLength );
+	}
+
+	bool operator==( const PooledString& aOther ) const
+	{
+		return textLength == aOther.textLength && memcmp( text, aOther.text, textLength ) == 0;
+	}
+
+	bool operator==( const std::string& aOther ) const
+	{
+		return textLength == aOther.size() && memcmp( text, aOther.data(), textLength ) == 0;
+	}
+
+	bool operator!=( const PooledString& aOther ) const	{ return !(*this == aOther); }
+	bool operator!=( const std::string& aOther ) const	{ return !(*this == aOther); }
+
+private:
+	const char* text;
+	size_t textLength;
+};
+
+/**
+ * Keeps each distinct string once, and hands out a small handle for it. The text is
+ * copied into large blocks, so interning a string that is already in the pool allocates
+ * nothing, and one that isn't allocates only when a block fills up. Everything is freed
+ * with the pool, a block at a time.
+ *
+ * Interning isn't thread safe. Looking strings up is, once nothing is being interned.
+ */
+class StringPool
+{
+public:
+
+	/**
+	 * Refers to a string of the pool
+	 */
+	typedef OwUInt32 Handle;
+
+	/**
+	 * The handle of the empty string, which every pool has
+	 */
+	static const Handle EMPTY = 0;
+
+	StringPool();
+	~StringPool();
+
+	/**
+	 * @returns the handle of a string, adding it to the pool if it isn't there yet
+	 */
+	Handle intern( const char* aText, size_t aLength );
+
+	Handle intern( const std::string& aText )
+	{
+		return intern( aText.data(), aText.size() );
+	}
+
+	Handle intern( const char* aText )
+	{
+		return intern( aText, strlen( aText ) );
+	}
+
+	/**
+	 * Looks a string up without adding it
+	 * @param aHandle set to its handle if it is in the pool
+	 * @returns false if it isn't
+	 */
+	bool find( const char* aText, size_t aLength, Handle& aHandle ) const;
+
+	/**
+	 * @returns the string of a handle
+	 */
+	PooledString get( Handle aHandle ) const
+	{
+		const Entry& entry = entries[aHandle];
+		return PooledString( entry.text, entry.length );
+	}
+
+	/**
+	 * @returns the number of distinct strings, and so one more than the largest handle
+	 */
+	OwUInt32 size() const
+	{
+		return (OwUInt32)entries.size();
+	}
+
+	/**
+	 * @returns the number of strings interned, whether they were already in the pool or not
+	 */
+	OwUInt64 requests() const
+	{
+		return internCount;
+	}
+
+	/**
+	 * @returns an estimate of the bytes saved by keeping the strings interned rather than as a
+	 * std::string each, less what the pool and the handles take
+	 */
+	OwInt64 savedBytes() const;
+
+	/**
+	 * Removes every string but the empty one, and frees the blocks
+	 */
+	void clear();
+
+	void swap( StringPool& aOther );
+
+	/**
+	 * @returns the heap memory held by the pool, in bytes
+	 */
+	size_t memoryUsage() const;
+
+private:
+
+	/**
+	 * The size of the blocks the text is copied into. Longer strings get a block of their own
+	 */
+	enum { BLOCK_SIZE = 16384 };
+
+	/**
+	 * A string of the pool
+	 */
+	typedef struct Entry
+	{
+		const char* text;
+		OwUInt32 length;
+		/**
+		 * @brief Its hash, to skip most compares when probing
+		 */
+		OwUInt32 hash;
+	} Entry;
+
+	/**
+	 * What the slots of the table hold when they are empty
+	 */
+	static const OwUInt32 NO_ENTRY = 0xFFFFFFFF;
+
+	StringPool( const StringPool& );
+	StringPool& operator=( const StringPool& );
+
+	static OwUInt32 hashOf( const char* aText, size_t aLength );
+
+	/**
+	 * @returns the slot of a string, or the empty slot it would go in
+	 */
+	size_t slotOf( const char* aText, size_t aLength, OwUInt32 aHash ) const;
+
+	/**
+	 * Copies a string into a block, with a null after it
+	 */
+	const char* store( const char* aText, size_t aLength );
+
+	/**
+	 * Doubles the table, and puts the strings back in it
+	 */
+	void grow();
+
+	std::vector<Entry> entries;
+	/**
+	 * @brief An open addressing table of entry numbers, a power of 2 in size
+	 */
+	std::vector<OwUInt32> slots;
+	std::vector<char*> blocks;
+	/**
+	 * @brief The block strings are being copied into, and how much of it is used
+	 */
+	char* current;
+	size_t currentUsed;
+	/**
+	 * @brief The bytes of all the blocks
+	 */
+	size_t blockBytes;
+	OwUInt64 internCount;
+	/**
+	 * @brief What the interned strings would take as a std::string each
+	 */
+	OwUInt64 copyBytes;
+};
+
+#endif
@@ -0,0 +1,291 @@
+/**
+ * @file SyntheticSpec.cpp
+ * @brief Writes scaled up copies of the specification sheets for benchmarking.
+ */
+
+#include "SyntheticSpec.hpp"
+
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+
+#include "CsvReader.hpp"
+#include "MappedFile.hpp"
+
+/**
+ * The number of 12 bit equipment IDs
+ */
+static const unsigned EQUIPMENT_IDS = 0x1000;
+
+/**
+ * The names of the four sheets, after the prefix
+ */
+static const char* const SHEET_NAMES[4] = { "EquipmentIDs.csv", "LabelIDs.csv", "BnrData.csv", "BcdData.csv" };
+
+bool SyntheticSpec::write( const std::string& aSourcePrefix, const std::string& aTargetPrefix, unsigned aScale )
+{
+	Sheets sheets;
+	IdMap ids;
+	if( aScale == 0 || !readSheets( aSourcePrefix, sheets ) || !mapIds( sheets, aScale, ids ) )
+	{
+		return false;
+	}
+	for( int i = 0; i < 4; ++i )
+	{
+		if( !writeSheet( sheets.rows[i], aTargetPrefix + SHEET_NAMES[i], sheetOf( i ), aScale, ids ) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+unsigned SyntheticSpec::maxScale( const std::string& aSourcePrefix )
+{
+	Sheets sheets;
+	IdMap ids;
+	if( !readSheets( aSourcePrefix, sheets ) || !mapIds( sheets, 1, ids ) || ids.empty() )
+	{
+		return 0;
+	}
+	return EQUIPMENT_IDS / (unsigned)ids.size();
+}
+
+SyntheticSpec::Sheet SyntheticSpec::sheetOf( int aFile )
+{
+	return aFile == 0 ? SHEET_EQUIPMENT : aFile == 1 ? SHEET_TRANSMISSIONS : SHEET_DATA;
+}
+
+bool SyntheticSpec::readSheets( const std::string& aSourcePrefix, Sheets& aSheets )
+{
+	for( int i = 0; i < 4; ++i )
+	{
+		if( !readSheet( aSourcePrefix + SHEET_NAMES[i], aSheets.rows[i] ) || aSheets.rows[i].size() < (sheetOf( i ) == SHEET_TRANSMISSIONS ? 2u : 1u) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SyntheticSpec::readSheet( const std::string& aSource, std::vector<Row>& aRows )
+{
+	MappedFile file;
+	if( !file.open( aSource ) )
+	{
+		return false;
+	}
+	CsvReader reader( file.data(), file.size() );
+	std::vector<CsvField> fields;
+	while( reader.nextRow( fields ) )
+	{
+		Row row( fields.size() );
+		for( size_t i = 0; i < fields.size(); ++i )
+		{
+			row[i] = fields[i].str();
+		}
+		aRows.push_back( row );
+	}
+	return true;
+}
+
+bool SyntheticSpec::mapIds( const Sheets& aSheets, unsigned aScale, IdMap& aIds )
+{
+	//Every real ID, whichever sheet it is in, so a row refers to the same equipment in each copy
+	std::vector<bool> used( EQUIPMENT_IDS, false );
+	for( int i = 0; i < 4; ++i )
+	{
+		for( size_t j = 0; j < aSheets.rows[i].size(); ++j )
+		{
+			unsigned id;
+			bool wildcard;
+			if( readId( aSheets.rows[i][j], sheetOf( i ), id, wildcard ) && !wildcard && id < EQUIPMENT_IDS )
+			{
+				used[id] = true;
+				aIds[id].assign( 1, id );
+			}
+		}
+	}
+
+	//Then hand out the unused IDs in order, a copy at a time
+	unsigned next = 0;
+	for( unsigned copy = 1; copy < aScale; ++copy )
+	{
+		for( IdMap::iterator it = aIds.begin(); it != aIds.end(); ++it )
+		{
+			while( next < EQUIPMENT_IDS && used[next] )
+			{
+				++next;
+			}
+			if( next == EQUIPMENT_IDS )
+			{
+				return false;
+			}
+			it->second.push_back( next++ );
+		}
+	}
+	return true;
+}
+
+bool SyntheticSpec::writeSheet( const std::vector<Row>& aRows, const std::string& aTarget, Sheet aSheet, unsigned aScale, const IdMap& aIds )
+{
+	std::ofstream target( aTarget.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+	if( !target )
+	{
+		return false;
+	}
+	std::string out;
+	size_t headerRows = aSheet == SHEET_TRANSMISSIONS ? 2 : 1;
+	for( size_t i = 0; i < headerRows; ++i )
+	{
+		appendRow( out, aRows[i] );
+	}
+
+	for( unsigned copy = 0; copy < aScale; ++copy )
+	{
+		//A row without a label takes the label of the row above, so when a wildcard
+		//row is left out its label has to be carried down to the next row written
+		std::string pendingLabel;
+		for( size_t i = headerRows; i < aRows.size(); ++i )
+		{
+			Row row = aRows[i];
+			unsigned id;
+			bool wildcard;
+			bool hasId = readId( row, aSheet, id, wildcard );
+			if( wildcard && copy > 0 )
+			{
+				if( !row.empty() && !row[0].empty() )
+				{
+					pendingLabel = row[0];
+				}
+				continue;
+			}
+			if( !row.empty() && aSheet != SHEET_EQUIPMENT )
+			{
+				if( row[0].empty() )
+				{
+					row[0] = pendingLabel;
+				}
+				pendingLabel.clear();
+			}
+			if( hasId && !wildcard && copy > 0 )
+			{
+				IdMap::const_iterator found = aIds.find( id );
+				if( found != aIds.end() )
+				{
+					writeId( row, aSheet, found->second[copy] );
+				}
+			}
+			appendRow( out, row );
+		}
+		target.write( out.data(), out.size() );
+		out.clear();
+	}
+	target.write( out.data(), out.size() );
+	target.close();
+	return !target.fail();
+}
+
+bool SyntheticSpec::readId( const Row& aRow, Sheet aSheet, unsigned& aId, bool& aWildcard )
+{
+	aId = 0;
+	aWildcard = false;
+	std::string digits;
+	if( aSheet == SHEET_EQUIPMENT )
+	{
+		if( aRow.empty() )
+		{
+			return false;
+		}
+		digits = aRow[0];
+	}
+	else if( aSheet == SHEET_TRANSMISSIONS )
+	{
+		if( aRow.size() < 6 )
+		{
+			return false;
+		}
+		digits = aRow[3] + aRow[4] + aRow[5];
+	}
+	else
+	{
+		if( aRow.size() < 2 )
+		{
+			return false;
+		}
+		digits = aRow[1];
+	}
+
+	//Keep the hex digits, and look for the wildcard ones
+	std::string hex;
+	for( size_t i = 0; i < digits.size(); ++i )
+	{
+		char c = digits[i];
+		if( c == 'X' || c == 'Y' )
+		{
+			aWildcard = true;
+		}
+		else if( (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f') )
+		{
+			hex.push_back( c );
+		}
+	}
+	if( hex.empty() || hex.size() > 3 )
+	{
+		return false;
+	}
+	aId = (unsigned)strtoul( hex.c_str(), NULL, 16 );
+	return aSheet != SHEET_TRANSMISSIONS || hex.size() == 3;
+}
+
+void SyntheticSpec::writeId( Row& aRow, Sheet aSheet, unsigned aId )
+{
+	char text[8];
+	if( aSheet == SHEET_EQUIPMENT )
+	{
+		sprintf( text, "%X", aId );
+		aRow[0] = text;
+	}
+	else if( aSheet == SHEET_TRANSMISSIONS )
+	{
+		//One digit per column
+		for( int digit = 0; digit < 3; ++digit )
+		{
+			sprintf( text, "%X", (aId >> (8 - 4 * digit)) & 0xF );
+			aRow[3 + digit] = text;
+		}
+	}
+	else
+	{
+		sprintf( text, "%X %X %X", (aId >> 8) & 0xF, (aId >> 4) & 0xF, aId & 0xF );
+		aRow[1] = text;
+	}
+}
+
+void SyntheticSpec::appendRow( std::string& aOut, const Row& aRow )
+{
+	for( size_t i = 0; i < aRow.size(); ++i )
+	{
+		if( i > 0 )
+		{
+			aOut.push_back( ',' );
+		}
+		const std::string& field = aRow[i];
+		if( field.empty() || field.find_first_not_of( "0123456789" ) == std::string::npos )
+		{
+			aOut.append( field );
+			continue;
+		}
+		aOut.push_back( '"' );
+		for( size_t j = 0; j < field.size(); ++j )
+		{
+			if( field[j] == '"' )
+			{
+				aOut.push_back( '"' );	//Quotes are escaped by doubling them
+			}
+			aOut.push_back( field[j] );
+		}
+		aOut.push_back( '"' );
+	}
+	aOut.push_back( '\n' );
+}
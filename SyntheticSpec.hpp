@@ -0,0 +1,102 @@
+/**
+ * @file SyntheticSpec.hpp
+ * @brief Writes scaled up copies of the specification sheets for benchmarking.
+ */
+
+#ifndef A429_SYNTHETIC_SPEC_HPP
+#define A429_SYNTHETIC_SPEC_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+
+/**
+ * Makes sheets aScale times the size of a real set by repeating their rows.
+ * The first copy keeps the real equipment IDs, and each further copy gives each of them one
+ * of the IDs no sheet uses, so every copy is loaded rather than rejected as duplicate rows.
+ * Equipment IDs are 12 bits, so this caps the scale at maxScale(), 9 for the P1-18 sheets.
+ * Wildcard rows apply to every equipment whatever the size of the sheets, so they are
+ * written once, as in the real set.
+ */
+class SyntheticSpec
+{
+public:
+
+	/**
+	 * Writes the four sheets
+	 * @param aSourcePrefix the path of the real sheets up to "EquipmentIDs.csv", "LabelIDs.csv"...
+	 * @param aTargetPrefix the same for the sheets to write
+	 * @param aScale the number of copies
+	 * @returns false if a sheet couldn't be read or written, or aScale is 0 or above maxScale()
+	 */
+	static bool write( const std::string& aSourcePrefix, const std::string& aTargetPrefix, unsigned aScale );
+
+	/**
+	 * @returns the most copies of a real set that can each have their own equipment IDs, or
+	 *          0 if a sheet couldn't be read. write fails for a larger scale
+	 */
+	static unsigned maxScale( const std::string& aSourcePrefix );
+
+private:
+
+	/**
+	 * The sheets, which keep their equipment IDs in different columns
+	 */
+	enum Sheet
+	{
+		SHEET_EQUIPMENT,
+		SHEET_TRANSMISSIONS,
+		SHEET_DATA
+	};
+
+	typedef std::vector<std::string> Row;
+
+	/**
+	 * The rows of the four sheets, in the order of Sheet with the BNR sheet then the BCD one
+	 */
+	typedef struct Sheets
+	{
+		std::vector<Row> rows[4];
+	} Sheets;
+
+	/**
+	 * The equipment ID each real ID has in each copy
+	 */
+	typedef std::map<unsigned, std::vector<unsigned> > IdMap;
+
+	/**
+	 * @returns the sheet each of the four files is read as
+	 */
+	static Sheet sheetOf( int aFile );
+
+	static bool readSheets( const std::string& aSourcePrefix, Sheets& aSheets );
+
+	static bool readSheet( const std::string& aSource, std::vector<Row>& aRows );
+
+	/**
+	 * Gives each real ID an unused ID in each copy after the first
+	 * @returns false if there aren't enough unused IDs
+	 */
+	static bool mapIds( const Sheets& aSheets, unsigned aScale, IdMap& aIds );
+
+	static bool writeSheet( const std::vector<Row>& aRows, const std::string& aTarget, Sheet aSheet, unsigned aScale, const IdMap& aIds );
+
+	/**
+	 * Reads the equipment ID of a row
+	 * @param aWildcard set if the ID is a wildcard, such as "X X X"
+	 * @returns false if the row has no ID
+	 */
+	static bool readId( const Row& aRow, Sheet aSheet, unsigned& aId, bool& aWildcard );
+
+	/**
+	 * Replaces the equipment ID of a row, in the form the sheet uses
+	 */
+	static void writeId( Row& aRow, Sheet aSheet, unsigned aId );
+
+	/**
+	 * Appends a row as CSV, quoting the fields that aren't numbers as the sheets do
+	 */
+	static void appendRow( std::string& aOut, const Row& aRow );
+};
+
+#endif
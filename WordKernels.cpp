@@ -0,0 +1,569 @@
+/**
+ * @file WordKernels.cpp
+ * @brief Parity, label bit order, field extraction and label masks over arrays of ARINC 429 words.
+ */
+
+#include "WordKernels.hpp"
+
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define A429_KERNELS_SSE2
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <emmintrin.h>
+#if _MSC_VER >= 1700	//Visual C++ 2012 brought the AVX2 intrinsics
+#define A429_KERNELS_AVX2
+#include <immintrin.h>
+#endif
+#define A429_TARGET_SSE2
+#define A429_TARGET_AVX2
+#elif defined(__GNUC__)
+#include <cpuid.h>
+#include <emmintrin.h>
+#if __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)	//GCC 4.9 allows the intrinsics in functions targeted at AVX2
+#define A429_KERNELS_AVX2
+#include <immintrin.h>
+#endif
+#define A429_TARGET_SSE2 __attribute__((target("sse2")))
+#define A429_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#undef A429_KERNELS_SSE2
+#endif
+#endif
+
+namespace
+{
+	/**
+	 * The path in use, or PATH_COUNT until the first kernel picks one
+	 */
+	volatile int selectedPath = WordKernels::PATH_COUNT;
+
+	/**
+	 * Each label with its bits reversed
+	 */
+	OwUInt8 reversedLabels[256];
+	volatile bool reversedLabelsReady = false;
+
+	/**
+	 * Words handled at a time by keepLabels
+	 */
+	const size_t KEEP_BLOCK = 256;
+
+	/**
+	 * @returns 1 if the word has odd parity, else 0
+	 */
+	inline OwUInt32 oddParity( OwUInt32 aWord )
+	{
+		aWord ^= aWord >> 16;
+		aWord ^= aWord >> 8;
+		aWord ^= aWord >> 4;
+		aWord ^= aWord >> 2;
+		aWord ^= aWord >> 1;
+		return aWord & 1;
+	}
+
+	void buildReversedLabels()
+	{
+		//Racing threads write the same values
+		for( int i = 0; i < 256; ++i )
+		{
+			reversedLabels[i] = WordKernels::reverseLabel( (OwUInt8)i );
+		}
+		reversedLabelsReady = true;
+	}
+
+	//The scalar kernels, which the others finish their last few words with
+
+	size_t checkParityScalar( const OwUInt32* aWords, size_t aCount, OwUInt8* aValid )
+	{
+		size_t errors = 0;
+		for( size_t i = 0; i < aCount; ++i )
+		{
+			OwUInt32 valid = oddParity( aWords[i] );
+			errors += valid ^ 1;
+			if( aValid != NULL )
+			{
+				aValid[i] = (OwUInt8)valid;
+			}
+		}
+		return errors;
+	}
+
+	void setParityScalar( OwUInt32* aWords, size_t aCount )
+	{
+		for( size_t i = 0; i < aCount; ++i )
+		{
+			OwUInt32 word = aWords[i] & 0x7FFFFFFF;
+			aWords[i] = word | ((oddParity( word ) ^ 1) << 31);
+		}
+	}
+
+	void reverseLabelsScalar( OwUInt32* aWords, size_t aCount )
+	{
+		if( !reversedLabelsReady )
+		{
+			buildReversedLabels();
+		}
+		for( size_t i = 0; i < aCount; ++i )
+		{
+			aWords[i] = (aWords[i] & 0xFFFFFF00) | reversedLabels[aWords[i] & 0xFF];
+		}
+	}
+
+	void extractFieldsScalar( const OwUInt32* aWords, size_t aCount, OwUInt8* aLabels, OwUInt8* aSdi, OwUInt8* aSsm, OwUInt32* aData )
+	{
+		for( size_t i = 0; i < aCount; ++i )
+		{
+			OwUInt32 word = aWords[i];
+			if( aLabels != NULL )	aLabels[i] = (OwUInt8)word;
+			if( aSdi != NULL )		aSdi[i] = (OwUInt8)((word >> 8) & 0x3);
+			if( aSsm != NULL )		aSsm[i] = (OwUInt8)((word >> 29) & 0x3);
+			if( aData != NULL )		aData[i] = (word >> 10) & 0x7FFFF;
+		}
+	}
+
+	size_t matchLabelsScalar( const OwUInt32* aWords, size_t aCount, const LabelSet& aLabels, OwUInt8* aMatches )
+	{
+		const OwUInt32* bits = aLabels.words();
+		size_t matches = 0;
+		for( size_t i = 0; i < aCount; ++i )
+		{
+			OwUInt32 label = aWords[i] & 0xFF;
+			OwUInt32 match = (bits[label >> 5] >> (label & 31)) & 1;
+			matches += match;
+			if( aMatches != NULL )
+			{
+				aMatches[i] = (OwUInt8)match;
+			}
+		}
+		return matches;
+	}
+
+#ifdef A429_KERNELS_SSE2
+
+	/**
+	 * @returns 1 in each lane with odd parity, else 0
+	 */
+	A429_TARGET_SSE2 inline __m128i oddParity4( __m128i aWords )
+	{
+		aWords = _mm_xor_si128( aWords, _mm_srli_epi32( aWords, 16 ) );
+		aWords = _mm_xor_si128( aWords, _mm_srli_epi32( aWords, 8 ) );
+		aWords = _mm_xor_si128( aWords, _mm_srli_epi32( aWords, 4 ) );
+		aWords = _mm_xor_si128( aWords, _mm_srli_epi32( aWords, 2 ) );
+		aWords = _mm_xor_si128( aWords, _mm_srli_epi32( aWords, 1 ) );
+		return _mm_and_si128( aWords, _mm_set1_epi32( 1 ) );
+	}
+
+	/**
+	 * Stores the low byte of each of 4 lanes that hold 0 to 255
+	 */
+	A429_TARGET_SSE2 inline void storeBytes4( OwUInt8* aTo, __m128i aValues )
+	{
+		__m128i bytes = _mm_packus_epi16( _mm_packs_epi32( aValues, aValues ), aValues );
+		int packed = _mm_cvtsi128_si32( bytes );
+		memcpy( aTo, &packed, 4 );
+	}
+
+	A429_TARGET_SSE2 size_t checkParitySse2( const OwUInt32* aWords, size_t aCount, OwUInt8* aValid )
+	{
+		__m128i valid = _mm_setzero_si128();
+		size_t i = 0;
+		for( ; i + 4 <= aCount; i += 4 )
+		{
+			__m128i parity = oddParity4( _mm_loadu_si128( (const __m128i*)(aWords + i) ) );
+			valid = _mm_add_epi32( valid, parity );
+			if( aValid != NULL )
+			{
+				storeBytes4( aValid + i, parity );
+			}
+		}
+		OwUInt32 lanes[4];
+		_mm_storeu_si128( (__m128i*)lanes, valid );
+		size_t errors = i - ((size_t)lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+		return errors + checkParityScalar( aWords + i, aCount - i, aValid == NULL ? NULL : aValid + i );
+	}
+
+	A429_TARGET_SSE2 void setParitySse2( OwUInt32* aWords, size_t aCount )
+	{
+		const __m128i data = _mm_set1_epi32( 0x7FFFFFFF );
+		const __m128i one = _mm_set1_epi32( 1 );
+		size_t i = 0;
+		for( ; i + 4 <= aCount; i += 4 )
+		{
+			__m128i words = _mm_and_si128( _mm_loadu_si128( (const __m128i*)(aWords + i) ), data );
+			__m128i parity = _mm_slli_epi32( _mm_xor_si128( oddParity4( words ), one ), 31 );
+			_mm_storeu_si128( (__m128i*)(aWords + i), _mm_or_si128( words, parity ) );
+		}
+		setParityScalar( aWords + i, aCount - i );
+	}
+
+	/**
+	 * Swaps the bits of each label selected by a mask with those aShift above them
+	 */
+	A429_TARGET_SSE2 inline __m128i swapBits4( __m128i aLabels, int aShift, __m128i aLowMask )
+	{
+		__m128i low = _mm_and_si128( aLabels, aLowMask );
+		__m128i high = _mm_andnot_si128( aLowMask, aLabels );
+		return _mm_or_si128( _mm_slli_epi32( low, aShift ), _mm_srli_epi32( high, aShift ) );
+	}
+
+	A429_TARGET_SSE2 void reverseLabelsSse2( OwUInt32* aWords, size_t aCount )
+	{
+		const __m128i labelMask = _mm_set1_epi32( 0xFF );
+		const __m128i nibbles = _mm_set1_epi32( 0x0F );
+		const __m128i pairs = _mm_set1_epi32( 0x33 );
+		const __m128i bits = _mm_set1_epi32( 0x55 );
+		size_t i = 0;
+		for( ; i + 4 <= aCount; i += 4 )
+		{
+			__m128i words = _mm_loadu_si128( (const __m128i*)(aWords + i) );
+			__m128i labels = _mm_and_si128( words, labelMask );
+			labels = swapBits4( labels, 4, nibbles );
+			labels = swapBits4( labels, 2, pairs );
+			labels = swapBits4( labels, 1, bits );
+			_mm_storeu_si128( (__m128i*)(aWords + i), _mm_or_si128( _mm_andnot_si128( labelMask, words ), labels ) );
+		}
+		reverseLabelsScalar( aWords + i, aCount - i );
+	}
+
+	A429_TARGET_SSE2 void extractFieldsSse2( const OwUInt32* aWords, size_t aCount, OwUInt8* aLabels, OwUInt8* aSdi, OwUInt8* aSsm, OwUInt32* aData )
+	{
+		const __m128i labelMask = _mm_set1_epi32( 0xFF );
+		const __m128i twoBits = _mm_set1_epi32( 0x3 );
+		const __m128i dataMask = _mm_set1_epi32( 0x7FFFF );
+		size_t i = 0;
+		for( ; i + 4 <= aCount; i += 4 )
+		{
+			__m128i words = _mm_loadu_si128( (const __m128i*)(aWords + i) );
+			if( aLabels != NULL )	storeBytes4( aLabels + i, _mm_and_si128( words, labelMask ) );
+			if( aSdi != NULL )		storeBytes4( aSdi + i, _mm_and_si128( _mm_srli_epi32( words, 8 ), twoBits ) );
+			if( aSsm != NULL )		storeBytes4( aSsm + i, _mm_and_si128( _mm_srli_epi32( words, 29 ), twoBits ) );
+			if( aData != NULL )		_mm_storeu_si128( (__m128i*)(aData + i), _mm_and_si128( _mm_srli_epi32( words, 10 ), dataMask ) );
+		}
+		extractFieldsScalar( aWords + i, aCount - i, aLabels == NULL ? NULL : aLabels + i, aSdi == NULL ? NULL : aSdi + i,
+			aSsm == NULL ? NULL : aSsm + i, aData == NULL ? NULL : aData + i );
+	}
+
+#endif
+
+#ifdef A429_KERNELS_AVX2
+
+	A429_TARGET_AVX2 inline __m256i oddParity8( __m256i aWords )
+	{
+		aWords = _mm256_xor_si256( aWords, _mm256_srli_epi32( aWords, 16 ) );
+		aWords = _mm256_xor_si256( aWords, _mm256_srli_epi32( aWords, 8 ) );
+		aWords = _mm256_xor_si256( aWords, _mm256_srli_epi32( aWords, 4 ) );
+		aWords = _mm256_xor_si256( aWords, _mm256_srli_epi32( aWords, 2 ) );
+		aWords = _mm256_xor_si256( aWords, _mm256_srli_epi32( aWords, 1 ) );
+		return _mm256_and_si256( aWords, _mm256_set1_epi32( 1 ) );
+	}
+
+	/**
+	 * Stores the low byte of each of 8 lanes that hold 0 to 255
+	 */
+	A429_TARGET_AVX2 inline void storeBytes8( OwUInt8* aTo, __m256i aValues )
+	{
+		//Packing works within each 128 bit half, so each half ends up with 4 of the bytes
+		__m256i bytes = _mm256_packus_epi16( _mm256_packs_epi32( aValues, aValues ), aValues );
+		int low = _mm_cvtsi128_si32( _mm256_castsi256_si128( bytes ) );
+		int high = _mm_cvtsi128_si32( _mm256_extracti128_si256( bytes, 1 ) );
+		memcpy( aTo, &low, 4 );
+		memcpy( aTo + 4, &high, 4 );
+	}
+
+	A429_TARGET_AVX2 inline OwUInt64 sumLanes8( __m256i aValues )
+	{
+		OwUInt32 lanes[8];
+		_mm256_storeu_si256( (__m256i*)lanes, aValues );
+		OwUInt64 sum = 0;
+		for( int i = 0; i < 8; ++i )
+		{
+			sum += lanes[i];
+		}
+		return sum;
+	}
+
+	A429_TARGET_AVX2 size_t checkParityAvx2( const OwUInt32* aWords, size_t aCount, OwUInt8* aValid )
+	{
+		__m256i valid = _mm256_setzero_si256();
+		size_t i = 0;
+		for( ; i + 8 <= aCount; i += 8 )
+		{
+			__m256i parity = oddParity8( _mm256_loadu_si256( (const __m256i*)(aWords + i) ) );
+			valid = _mm256_add_epi32( valid, parity );
+			if( aValid != NULL )
+			{
+				storeBytes8( aValid + i, parity );
+			}
+		}
+		size_t errors = i - (size_t)sumLanes8( valid );
+		return errors + checkParityScalar( aWords + i, aCount - i, aValid == NULL ? NULL : aValid + i );
+	}
+
+	A429_TARGET_AVX2 void setParityAvx2( OwUInt32* aWords, size_t aCount )
+	{
+		const __m256i data = _mm256_set1_epi32( 0x7FFFFFFF );
+		const __m256i one = _mm256_set1_epi32( 1 );
+		size_t i = 0;
+		for( ; i + 8 <= aCount; i += 8 )
+		{
+			__m256i words = _mm256_and_si256( _mm256_loadu_si256( (const __m256i*)(aWords + i) ), data );
+			__m256i parity = _mm256_slli_epi32( _mm256_xor_si256( oddParity8( words ), one ), 31 );
+			_mm256_storeu_si256( (__m256i*)(aWords + i), _mm256_or_si256( words, parity ) );
+		}
+		setParityScalar( aWords + i, aCount - i );
+	}
+
+	A429_TARGET_AVX2 void reverseLabelsAvx2( OwUInt32* aWords, size_t aCount )
+	{
+		//Look up each nibble of the label reversed, and swap them over
+		const __m256i reversedNibbles = _mm256_setr_epi8(
+			0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF,
+			0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF );
+		const __m256i nibbleMask = _mm256_set1_epi32( 0x0F );
+		const __m256i labelMask = _mm256_set1_epi32( 0xFF );
+		size_t i = 0;
+		for( ; i + 8 <= aCount; i += 8 )
+		{
+			__m256i words = _mm256_loadu_si256( (const __m256i*)(aWords + i) );
+			//The nibbles are put in the low byte of each lane, with zeros above, which the lookup leaves at 0
+			__m256i low = _mm256_shuffle_epi8( reversedNibbles, _mm256_and_si256( words, nibbleMask ) );
+			__m256i high = _mm256_shuffle_epi8( reversedNibbles, _mm256_and_si256( _mm256_srli_epi32( words, 4 ), nibbleMask ) );
+			__m256i labels = _mm256_or_si256( _mm256_slli_epi32( low, 4 ), high );
+			_mm256_storeu_si256( (__m256i*)(aWords + i), _mm256_or_si256( _mm256_andnot_si256( labelMask, words ), labels ) );
+		}
+		reverseLabelsScalar( aWords + i, aCount - i );
+	}
+
+	A429_TARGET_AVX2 void extractFieldsAvx2( const OwUInt32* aWords, size_t aCount, OwUInt8* aLabels, OwUInt8* aSdi, OwUInt8* aSsm, OwUInt32* aData )
+	{
+		const __m256i labelMask = _mm256_set1_epi32( 0xFF );
+		const __m256i twoBits = _mm256_set1_epi32( 0x3 );
+		const __m256i dataMask = _mm256_set1_epi32( 0x7FFFF );
+		size_t i = 0;
+		for( ; i + 8 <= aCount; i += 8 )
+		{
+			__m256i words = _mm256_loadu_si256( (const __m256i*)(aWords + i) );
+			if( aLabels != NULL )	storeBytes8( aLabels + i, _mm256_and_si256( words, labelMask ) );
+			if( aSdi != NULL )		storeBytes8( aSdi + i, _mm256_and_si256( _mm256_srli_epi32( words, 8 ), twoBits ) );
+			if( aSsm != NULL )		storeBytes8( aSsm + i, _mm256_and_si256( _mm256_srli_epi32( words, 29 ), twoBits ) );
+			if( aData != NULL )		_mm256_storeu_si256( (__m256i*)(aData + i), _mm256_and_si256( _mm256_srli_epi32( words, 10 ), dataMask ) );
+		}
+		extractFieldsScalar( aWords + i, aCount - i, aLabels == NULL ? NULL : aLabels + i, aSdi == NULL ? NULL : aSdi + i,
+			aSsm == NULL ? NULL : aSsm + i, aData == NULL ? NULL : aData + i );
+	}
+
+	A429_TARGET_AVX2 size_t matchLabelsAvx2( const OwUInt32* aWords, size_t aCount, const LabelSet& aLabels, OwUInt8* aMatches )
+	{
+		//The word of the mask each label is in, then its bit in that word
+		const __m256i mask = _mm256_loadu_si256( (const __m256i*)aLabels.words() );
+		const __m256i labelMask = _mm256_set1_epi32( 0xFF );
+		const __m256i bitMask = _mm256_set1_epi32( 31 );
+		const __m256i one = _mm256_set1_epi32( 1 );
+		__m256i matches = _mm256_setzero_si256();
+		size_t i = 0;
+		for( ; i + 8 <= aCount; i += 8 )
+		{
+			__m256i labels = _mm256_and_si256( _mm256_loadu_si256( (const __m256i*)(aWords + i) ), labelMask );
+			__m256i maskWords = _mm256_permutevar8x32_epi32( mask, _mm256_srli_epi32( labels, 5 ) );
+			__m256i match = _mm256_and_si256( _mm256_srlv_epi32( maskWords, _mm256_and_si256( labels, bitMask ) ), one );
+			matches = _mm256_add_epi32( matches, match );
+			if( aMatches != NULL )
+			{
+				storeBytes8( aMatches + i, match );
+			}
+		}
+		size_t count = (size_t)sumLanes8( matches );
+		return count + matchLabelsScalar( aWords + i, aCount - i, aLabels, aMatches == NULL ? NULL : aMatches + i );
+	}
+
+#endif
+
+	/**
+	 * @returns true if the processor and the operating system support AVX2
+	 */
+	bool hasAvx2()
+	{
+#if defined(A429_KERNELS_AVX2) && defined(_MSC_VER)
+		int info[4];
+		__cpuid( info, 0 );
+		if( info[0] < 7 )
+		{
+			return false;
+		}
+		__cpuid( info, 1 );
+		if( (info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 )	//OSXSAVE and AVX
+		{
+			return false;
+		}
+		if( (_xgetbv( 0 ) & 0x6) != 0x6 )	//The operating system saves the YMM registers
+		{
+			return false;
+		}
+		__cpuidex( info, 7, 0 );
+		return (info[1] & (1 << 5)) != 0;
+#elif defined(A429_KERNELS_AVX2) && defined(__GNUC__)
+		unsigned eax, ebx, ecx, edx;
+		if( __get_cpuid_max( 0, NULL ) < 7 || !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+		{
+			return false;
+		}
+		if( (ecx & (1u << 27)) == 0 || (ecx & (1u << 28)) == 0 )	//OSXSAVE and AVX
+		{
+			return false;
+		}
+		unsigned xcr0, xcr0High;
+		__asm__ __volatile__( "xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0) );
+		if( (xcr0 & 0x6) != 0x6 )	//The operating system saves the YMM registers
+		{
+			return false;
+		}
+		__cpuid_count( 7, 0, eax, ebx, ecx, edx );
+		return (ebx & (1u << 5)) != 0;
+#else
+		return false;
+#endif
+	}
+
+	/**
+	 * @returns true if the processor supports SSE2
+	 */
+	bool hasSse2()
+	{
+#if defined(A429_KERNELS_SSE2) && (defined(_M_X64) || defined(__x86_64__))
+		return true;	//Every 64 bit processor has it
+#elif defined(A429_KERNELS_SSE2) && defined(_MSC_VER)
+		int info[4];
+		__cpuid( info, 1 );
+		return (info[3] & (1 << 26)) != 0;
+#elif defined(A429_KERNELS_SSE2) && defined(__GNUC__)
+		unsigned eax, ebx, ecx, edx;
+		return __get_cpuid( 1, &eax, &ebx, &ecx, &edx ) && (edx & (1u << 26)) != 0;
+#else
+		return false;
+#endif
+	}
+}
+
+WordKernels::Path WordKernels::bestPath()
+{
+	if( hasAvx2() )
+	{
+		return PATH_AVX2;
+	}
+	return hasSse2() ? PATH_SSE2 : PATH_SCALAR;
+}
+
+WordKernels::Path WordKernels::path()
+{
+	int selected = selectedPath;
+	if( selected == PATH_COUNT )
+	{
+		selected = bestPath();
+		selectedPath = selected;	//Racing threads pick the same one
+	}
+	return (Path)selected;
+}
+
+void WordKernels::setPath( Path aPath )
+{
+	Path best = bestPath();
+	selectedPath = aPath < best ? aPath : best;
+}
+
+const char* WordKernels::pathName( Path aPath )
+{
+	switch( aPath )
+	{
+	case PATH_SCALAR:	return "scalar";
+	case PATH_SSE2:		return "sse2";
+	case PATH_AVX2:		return "avx2";
+	default:			return "unknown";
+	}
+}
+
+size_t WordKernels::checkParity( const OwUInt32* aWords, size_t aCount, OwUInt8* aValid )
+{
+	switch( path() )
+	{
+#ifdef A429_KERNELS_AVX2
+	case PATH_AVX2:		return checkParityAvx2( aWords, aCount, aValid );
+#endif
+#ifdef A429_KERNELS_SSE2
+	case PATH_SSE2:		return checkParitySse2( aWords, aCount, aValid );
+#endif
+	default:			return checkParityScalar( aWords, aCount, aValid );
+	}
+}
+
+void WordKernels::setParity( OwUInt32* aWords, size_t aCount )
+{
+	switch( path() )
+	{
+#ifdef A429_KERNELS_AVX2
+	case PATH_AVX2:		setParityAvx2( aWords, aCount );	break;
+#endif
+#ifdef A429_KERNELS_SSE2
+	case PATH_SSE2:		setParitySse2( aWords, aCount );	break;
+#endif
+	default:			setParityScalar( aWords, aCount );	break;
+	}
+}
+
+void WordKernels::reverseLabels( OwUInt32* aWords, size_t aCount )
+{
+	switch( path() )
+	{
+#ifdef A429_KERNELS_AVX2
+	case PATH_AVX2:		reverseLabelsAvx2( aWords, aCount );	break;
+#endif
+#ifdef A429_KERNELS_SSE2
+	case PATH_SSE2:		reverseLabelsSse2( aWords, aCount );	break;
+#endif
+	default:			reverseLabelsScalar( aWords, aCount );	break;
+	}
+}
+
+void WordKernels::extractFields( const OwUInt32* aWords, size_t aCount, OwUInt8* aLabels, OwUInt8* aSdi, OwUInt8* aSsm, OwUInt32* aData )
+{
+	switch( path() )
+	{
+#ifdef A429_KERNELS_AVX2
+	case PATH_AVX2:		extractFieldsAvx2( aWords, aCount, aLabels, aSdi, aSsm, aData );	break;
+#endif
+#ifdef A429_KERNELS_SSE2
+	case PATH_SSE2:		extractFieldsSse2( aWords, aCount, aLabels, aSdi, aSsm, aData );	break;
+#endif
+	default:			extractFieldsScalar( aWords, aCount, aLabels, aSdi, aSsm, aData );	break;
+	}
+}
+
+size_t WordKernels::matchLabels( const OwUInt32* aWords, size_t aCount, const LabelSet& aLabels, OwUInt8* aMatches )
+{
+	switch( path() )
+	{
+#ifdef A429_KERNELS_AVX2
+	case PATH_AVX2:		return matchLabelsAvx2( aWords, aCount, aLabels, aMatches );
+#endif
+	default:			return matchLabelsScalar( aWords, aCount, aLabels, aMatches );	//SSE2 can't shift each lane by its own amount
+	}
+}
+
+size_t WordKernels::keepLabels( OwUInt32* aWords, size_t aCount, const LabelSet& aLabels )
+{
+	//Match a block, then move the words kept down without branching
+	OwUInt8 matches[KEEP_BLOCK];
+	size_t kept = 0;
+	for( size_t first = 0; first < aCount; first += KEEP_BLOCK )
+	{
+		size_t count = aCount - first < KEEP_BLOCK ? aCount - first : KEEP_BLOCK;
+		matchLabels( aWords + first, count, aLabels, matches );
+		for( size_t i = 0; i < count; ++i )
+		{
+			aWords[kept] = aWords[first + i];
+			kept += matches[i];
+		}
+	}
+	return kept;
+}
@@ -0,0 +1,155 @@
+/**
+ * @file WordKernels.hpp
+ * @brief Parity, label bit order, field extraction and label masks over arrays of ARINC 429 words.
+ */
+
+#ifndef A429_WORD_KERNELS_HPP
+#define A429_WORD_KERNELS_HPP
+
+#include <cstddef>
+
+#include <Owl429/definitions>
+
+/**
+ * A set of labels, as a 256 bit mask
+ */
+class LabelSet
+{
+public:
+	LabelSet()
+	{
+		clear();
+	}
+
+	void clear()
+	{
+		for( int i = 0; i < 8; ++i )
+		{
+			bits[i] = 0;
+		}
+	}
+
+	void add( OwUInt8 aLabel )
+	{
+		bits[aLabel >> 5] |= (OwUInt32)1 << (aLabel & 31);
+	}
+
+	void remove( OwUInt8 aLabel )
+	{
+		bits[aLabel >> 5] &= ~((OwUInt32)1 << (aLabel & 31));
+	}
+
+	bool contains( OwUInt8 aLabel ) const
+	{
+		return ((bits[aLabel >> 5] >> (aLabel & 31)) & 1) != 0;
+	}
+
+	/**
+	 * @returns the 8 words of the mask, label 0 in bit 0 of the first
+	 */
+	const OwUInt32* words() const
+	{
+		return bits;
+	}
+
+private:
+	OwUInt32 bits[8];
+};
+
+/**
+ * The word level work done on whole captures, a block of words at a time: checking and
+ * setting odd parity, reversing the bit order of labels, splitting out the label, SDI, data
+ * and SSM, and picking out the words of a set of labels.
+ *
+ * Bits are numbered as in A429WordCodec. The label of a word is sent most significant bit
+ * first, the reverse of the rest, so a word read off the bus in the order its bits arrived,
+ * like the Transmission Order Bit Position column of LabelIDs, has its label reversed.
+ *
+ * Each kernel has a scalar, an SSE2 and an AVX2 path, and the best one the processor and the
+ * compiler support is picked the first time a kernel is called. The AVX2 path needs Visual
+ * C++ 2012 or GCC 4.9, and is left out when built with anything older. The SSE2 path of
+ * the label mask looks each label up one at a time, as SSE2 has no per-lane shifts.
+ */
+class WordKernels
+{
+public:
+
+	/**
+	 * The instruction sets the kernels are written for
+	 */
+	enum Path
+	{
+		PATH_SCALAR,
+		PATH_SSE2,
+		PATH_AVX2,
+		PATH_COUNT
+	};
+
+	/**
+	 * @returns the path the kernels use
+	 */
+	static Path path();
+
+	/**
+	 * @returns the best path the processor and the build support
+	 */
+	static Path bestPath();
+
+	/**
+	 * Makes the kernels use a path, for comparing them. A path that isn't supported falls back to the best one below it
+	 */
+	static void setPath( Path aPath );
+
+	/**
+	 * @returns the name of a path, such as "avx2"
+	 */
+	static const char* pathName( Path aPath );
+
+	/**
+	 * Checks the odd parity of words
+	 * @param aValid if not NULL, set to 1 for each word with odd parity and 0 for the others
+	 * @returns the number of words without odd parity
+	 */
+	static size_t checkParity( const OwUInt32* aWords, size_t aCount, OwUInt8* aValid );
+
+	/**
+	 * Sets bit 32 of each word so that it has odd parity, as A429WordCodec::withParity
+	 */
+	static void setParity( OwUInt32* aWords, size_t aCount );
+
+	/**
+	 * Reverses the bit order of the label of each word, leaving the other bits alone
+	 */
+	static void reverseLabels( OwUInt32* aWords, size_t aCount );
+
+	/**
+	 * Splits words into their fields. Any of the outputs may be NULL
+	 * @param aData the 19 bits 11-29, shifted down to bit 1
+	 */
+	static void extractFields( const OwUInt32* aWords, size_t aCount, OwUInt8* aLabels, OwUInt8* aSdi, OwUInt8* aSsm, OwUInt32* aData );
+
+	/**
+	 * Finds the words whose label is in a set
+	 * @param aMatches if not NULL, set to 1 for each word in the set and 0 for the others
+	 * @returns the number of words in the set
+	 */
+	static size_t matchLabels( const OwUInt32* aWords, size_t aCount, const LabelSet& aLabels, OwUInt8* aMatches );
+
+	/**
+	 * Keeps only the words whose label is in a set, in order
+	 * @returns the number of words kept, at the front of aWords
+	 */
+	static size_t keepLabels( OwUInt32* aWords, size_t aCount, const LabelSet& aLabels );
+
+	/**
+	 * @returns a label with its bits in the other order
+	 */
+	static OwUInt8 reverseLabel( OwUInt8 aLabel )
+	{
+		aLabel = (OwUInt8)(((aLabel & 0xF0) >> 4) | ((aLabel & 0x0F) << 4));
+		aLabel = (OwUInt8)(((aLabel & 0xCC) >> 2) | ((aLabel & 0x33) << 2));
+		return (OwUInt8)(((aLabel & 0xAA) >> 1) | ((aLabel & 0x55) << 1));
+	}
+};
+
+#endif
@@ -0,0 +1,308 @@
+/**
+ * @file WorkerPool.cpp
+ * @brief A fixed pool of worker threads that runs graphs of dependent tasks.
+ */
+
+#include "WorkerPool.hpp"
+
+#include <deque>
+
+#ifdef _WIN32
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0600	//Condition variables need Vista
+#endif
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/**
+ * A mutex and a pair of condition variables
+ */
+#ifdef _WIN32
+
+class PoolLock
+{
+public:
+	PoolLock()		{ InitializeCriticalSection( &section ); InitializeConditionVariable( &workReady ); InitializeConditionVariable( &workDone ); }
+	~PoolLock()		{ DeleteCriticalSection( &section ); }
+	void lock()		{ EnterCriticalSection( &section ); }
+	void unlock()	{ LeaveCriticalSection( &section ); }
+	void waitWork()	{ SleepConditionVariableCS( &workReady, &section, INFINITE ); }
+	void waitDone()	{ SleepConditionVariableCS( &workDone, &section, INFINITE ); }
+	void signalWork()	{ WakeAllConditionVariable( &workReady ); }
+	void signalDone()	{ WakeAllConditionVariable( &workDone ); }
+private:
+	CRITICAL_SECTION section;
+	CONDITION_VARIABLE workReady;
+	CONDITION_VARIABLE workDone;
+};
+
+typedef HANDLE PoolThread;
+
+#else
+
+class PoolLock
+{
+public:
+	PoolLock()		{ pthread_mutex_init( &mutex, NULL ); pthread_cond_init( &workReady, NULL ); pthread_cond_init( &workDone, NULL ); }
+	~PoolLock()		{ pthread_cond_destroy( &workDone ); pthread_cond_destroy( &workReady ); pthread_mutex_destroy( &mutex ); }
+	void lock()		{ pthread_mutex_lock( &mutex ); }
+	void unlock()	{ pthread_mutex_unlock( &mutex ); }
+	void waitWork()	{ pthread_cond_wait( &workReady, &mutex ); }
+	void waitDone()	{ pthread_cond_wait( &workDone, &mutex ); }
+	void signalWork()	{ pthread_cond_broadcast( &workReady ); }
+	void signalDone()	{ pthread_cond_broadcast( &workDone ); }
+private:
+	pthread_mutex_t mutex;
+	pthread_cond_t workReady;
+	pthread_cond_t workDone;
+};
+
+typedef pthread_t PoolThread;
+
+#endif
+
+struct WorkerPool::State
+{
+	/**
+	 * @brief Guards everything below
+	 */
+	PoolLock lock;
+	/**
+	 * @brief The worker threads
+	 */
+	std::vector<PoolThread> handles;
+	/**
+	 * @brief The graph being run, if any
+	 */
+	TaskGraph* graph;
+	/**
+	 * @brief The number of unfinished prerequisites of each task of the graph
+	 */
+	std::vector<size_t> waiting;
+	/**
+	 * @brief The tasks whose prerequisites have all finished
+	 */
+	std::deque<size_t> ready;
+	/**
+	 * @brief The number of tasks of the graph that haven't finished
+	 */
+	size_t unfinished;
+	/**
+	 * @brief Set when the workers should exit
+	 */
+	bool stopping;
+};
+
+size_t TaskGraph::add( WorkerTask* aTask )
+{
+	Node node;
+	node.task = aTask;
+	node.prerequisites = 0;
+	nodes.push_back( node );
+	return nodes.size() - 1;
+}
+
+void TaskGraph::addDependency( size_t aTask, size_t aPrerequisite )
+{
+	nodes[aPrerequisite].dependents.push_back( aTask );
+	++nodes[aTask].prerequisites;
+}
+
+WorkerPool::WorkerPool( unsigned aThreadCount )
+	: threads(aThreadCount == 0 ? hardwareConcurrency() : aThreadCount)
+	, state(new State)
+{
+	state->graph = NULL;
+	state->unfinished = 0;
+	state->stopping = false;
+	if( threads == 1 )	//Everything runs on the calling thread
+	{
+		return;
+	}
+	for( unsigned i = 0; i < threads; ++i )
+	{
+		PoolThread handle;
+#ifdef _WIN32
+		handle = (HANDLE)_beginthreadex( NULL, 0, &WorkerPool::threadMain, this, 0, NULL );
+		if( handle == 0 )
+		{
+			break;
+		}
+#else
+		if( pthread_create( &handle, NULL, &WorkerPool::threadMain, this ) != 0 )
+		{
+			break;
+		}
+#endif
+		state->handles.push_back( handle );
+	}
+	if( state->handles.empty() )	//Couldn't start any threads, so fall back to the calling thread
+	{
+		threads = 1;
+	}
+	else
+	{
+		threads = (unsigned)state->handles.size();	//The graphs run on the threads that did start
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	state->lock.lock();
+	state->stopping = true;
+	state->lock.signalWork();
+	state->lock.unlock();
+	for( size_t i = 0; i < state->handles.size(); ++i )
+	{
+#ifdef _WIN32
+		WaitForSingleObject( state->handles[i], INFINITE );
+		CloseHandle( state->handles[i] );
+#else
+		pthread_join( state->handles[i], NULL );
+#endif
+	}
+	delete state;
+}
+
+bool WorkerPool::run( TaskGraph& aGraph )
+{
+	std::vector<size_t> prerequisites( aGraph.nodes.size() );
+	for( size_t i = 0; i < aGraph.nodes.size(); ++i )
+	{
+		prerequisites[i] = aGraph.nodes[i].prerequisites;
+	}
+
+	//Refuse graphs that could never finish
+	std::vector<size_t> order;
+	if( !sortTasks( aGraph, prerequisites, order ) )
+	{
+		return false;
+	}
+
+	if( state->handles.empty() )	//Run them one after another on this thread
+	{
+		for( size_t i = 0; i < order.size(); ++i )
+		{
+			aGraph.nodes[order[i]].task->run();
+		}
+		return true;
+	}
+
+	state->lock.lock();
+	state->graph = &aGraph;
+	state->waiting.swap( prerequisites );
+	state->unfinished = aGraph.nodes.size();
+	for( size_t i = 0; i < aGraph.nodes.size(); ++i )
+	{
+		if( state->waiting[i] == 0 )
+		{
+			state->ready.push_back( i );
+		}
+	}
+	state->lock.signalWork();
+	while( state->unfinished != 0 )
+	{
+		state->lock.waitDone();
+	}
+	state->graph = NULL;
+	state->lock.unlock();
+	return true;
+}
+
+void WorkerPool::work()
+{
+	state->lock.lock();
+	while( true )
+	{
+		while( state->ready.empty() && !state->stopping )
+		{
+			state->lock.waitWork();
+		}
+		if( state->stopping )
+		{
+			break;
+		}
+
+		size_t id = state->ready.front();
+		state->ready.pop_front();
+		TaskGraph::Node& node = state->graph->nodes[id];
+		state->lock.unlock();
+
+		node.task->run();
+
+		state->lock.lock();
+		bool released = false;
+		for( size_t i = 0; i < node.dependents.size(); ++i )
+		{
+			size_t dependent = node.dependents[i];
+			if( --state->waiting[dependent] == 0 )
+			{
+				state->ready.push_back( dependent );
+				released = true;
+			}
+		}
+		if( released )
+		{
+			state->lock.signalWork();
+		}
+		if( --state->unfinished == 0 )
+		{
+			state->lock.signalDone();
+		}
+	}
+	state->lock.unlock();
+}
+
+#ifdef _WIN32
+unsigned __stdcall WorkerPool::threadMain( void* aPool )
+{
+	((WorkerPool*)aPool)->work();
+	return 0;
+}
+#else
+void* WorkerPool::threadMain( void* aPool )
+{
+	((WorkerPool*)aPool)->work();
+	return NULL;
+}
+#endif
+
+unsigned WorkerPool::hardwareConcurrency()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	return info.dwNumberOfProcessors > 0 ? (unsigned)info.dwNumberOfProcessors : 1;
+#else
+	long count = sysconf( _SC_NPROCESSORS_ONLN );
+	return count > 0 ? (unsigned)count : 1;
+#endif
+}
+
+bool WorkerPool::sortTasks( const TaskGraph& aGraph, std::vector<size_t> aPrerequisites, std::vector<size_t>& aOrder )
+{
+	aOrder.clear();
+	for( size_t i = 0; i < aGraph.nodes.size(); ++i )
+	{
+		if( aPrerequisites[i] == 0 )
+		{
+			aOrder.push_back( i );
+		}
+	}
+	for( size_t next = 0; next < aOrder.size(); ++next )	//aOrder doubles as the queue
+	{
+		const TaskGraph::Node& node = aGraph.nodes[aOrder[next]];
+		for( size_t i = 0; i < node.dependents.size(); ++i )
+		{
+			if( --aPrerequisites[node.dependents[i]] == 0 )
+			{
+				aOrder.push_back( node.dependents[i] );
+			}
+		}
+	}
+	return aOrder.size() == aGraph.nodes.size();
+}
@@ -0,0 +1,178 @@
+/**
+ * @file WorkerPool.hpp
+ * @brief A fixed pool of worker threads that runs graphs of dependent tasks.
+ */
+
+#ifndef A429_WORKER_POOL_HPP
+#define A429_WORKER_POOL_HPP
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * A unit of work for a WorkerPool. Tasks must not throw.
+ */
+class WorkerTask
+{
+public:
+	virtual ~WorkerTask() {}
+
+	/**
+	 * Does the work. Called once, on one of the pool's threads
+	 */
+	virtual void run() = 0;
+};
+
+/**
+ * A task that calls a method, taking no arguments, of an object
+ */
+template <typename T>
+class WorkerMethodTask : public WorkerTask
+{
+public:
+	WorkerMethodTask( T* aObject, void (T::*aMethod)() )
+		: object(aObject)
+		, method(aMethod)
+	{
+	}
+
+	void run()
+	{
+		(object->*method)();
+	}
+
+private:
+	T* object;
+	void (T::*method)();
+};
+
+/**
+ * A set of tasks, and the order some of them have to run in.
+ * The tasks are not owned by the graph.
+ */
+class TaskGraph
+{
+public:
+
+	/**
+	 * Adds a task to the graph
+	 * @returns the id of the task in the graph
+	 */
+	size_t add( WorkerTask* aTask );
+
+	/**
+	 * Makes one task wait for another to finish before it starts
+	 * @param aTask the id of the task that has to wait
+	 * @param aPrerequisite the id of the task to wait for
+	 */
+	void addDependency( size_t aTask, size_t aPrerequisite );
+
+	/**
+	 * @returns the number of tasks in the graph
+	 */
+	size_t size() const
+	{
+		return nodes.size();
+	}
+
+private:
+
+	friend class WorkerPool;
+
+	typedef struct Node
+	{
+		/**
+		 * @brief The work to do
+		 */
+		WorkerTask* task;
+		/**
+		 * @brief The tasks waiting on this one
+		 */
+		std::vector<size_t> dependents;
+		/**
+		 * @brief The number of tasks this one waits on
+		 */
+		size_t prerequisites;
+	} Node;
+
+	std::vector<Node> nodes;
+};
+
+/**
+ * A fixed number of threads that run the tasks of a TaskGraph as soon as
+ * everything they depend on has finished.
+ */
+class WorkerPool
+{
+public:
+
+	/**
+	 * Starts the worker threads
+	 * @param aThreadCount the number of threads to use. 0 uses one per core.
+	 * With 1, every graph runs on the calling thread and no threads are started.
+	 */
+	explicit WorkerPool( unsigned aThreadCount = 0 );
+
+	/**
+	 * Stops and joins the worker threads
+	 */
+	~WorkerPool();
+
+	/**
+	 * Runs every task of the graph and waits for all of them to finish.
+	 * Only one graph may run on a pool at a time.
+	 * @returns false if the graph has a cycle, in which case nothing was run
+	 */
+	bool run( TaskGraph& aGraph );
+
+	/**
+	 * @returns the number of threads the graphs run on. This is less than asked for if some
+	 *          couldn't be started, and 1 if none could, as the calling thread runs them
+	 */
+	unsigned threadCount() const
+	{
+		return threads;
+	}
+
+	/**
+	 * @returns the number of cores, or 1 if it can't be found
+	 */
+	static unsigned hardwareConcurrency();
+
+private:
+
+	//Not copyable
+	WorkerPool( const WorkerPool& );
+	WorkerPool& operator=( const WorkerPool& );
+
+	/**
+	 * The thread, lock and queue details, which depend on the platform
+	 */
+	struct State;
+
+	/**
+	 * Puts the tasks of a graph in an order that respects the dependencies
+	 * @param aPrerequisites the number of prerequisites of each task
+	 * @returns false if there is a cycle
+	 */
+	static bool sortTasks( const TaskGraph& aGraph, std::vector<size_t> aPrerequisites, std::vector<size_t>& aOrder );
+
+	/**
+	 * Runs tasks until the pool is stopped
+	 */
+	void work();
+
+	/**
+	 * The entry point of the worker threads
+	 */
+#ifdef _WIN32
+	static unsigned __stdcall threadMain( void* aPool );
+#else
+	static void* threadMain( void* aPool );
+#endif
+
+	unsigned threads;
+	State* state;
+};
+
+#endif
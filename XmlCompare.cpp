@@ -0,0 +1,168 @@
+/**
+ * @file XmlCompare.cpp
+ * @brief Checks that two Xml documents say the same thing, however they are formatted.
+ */
+
+#include "XmlCompare.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+#include "MappedFile.hpp"
+#include "XmlReader.hpp"
+
+namespace
+{
+	/**
+	 * @returns true for the attributes that only say where the schema is
+	 */
+	bool isSchemaAttribute( const std::string& aName )
+	{
+		return aName.compare( 0, 5, "xmlns" ) == 0 || aName.compare( 0, 4, "xsi:" ) == 0;
+	}
+}
+
+bool XmlCompare::parse( const char* aText, size_t aLength, std::vector<Event>& aEvents, std::string& aError )
+{
+	XmlReader reader( aText, aLength );
+	while( true )
+	{
+		XmlReader::Token token = reader.next();
+		if( token == XmlReader::DONE )
+		{
+			return true;
+		}
+		if( token == XmlReader::FAILED )
+		{
+			aError = reader.error();
+			return false;
+		}
+		Event event;
+		event.kind = token == XmlReader::START ? Event::START : token == XmlReader::END ? Event::END : Event::TEXT;
+		event.value = token == XmlReader::TEXT ? reader.text() : reader.name();
+		for( size_t i = 0; i < reader.attributeCount(); ++i )
+		{
+			if( !isSchemaAttribute( reader.attributeName( i ) ) )
+			{
+				event.attributes.push_back( std::make_pair( reader.attributeName( i ), reader.attributeValue( i ) ) );
+			}
+		}
+		std::sort( event.attributes.begin(), event.attributes.end() );
+		aEvents.push_back( event );
+	}
+}
+
+bool XmlCompare::sameValue( const std::string& aFirst, const std::string& aSecond )
+{
+	if( aFirst == aSecond )
+	{
+		return true;
+	}
+	if( aFirst.empty() || aSecond.empty() )
+	{
+		return false;
+	}
+	char* firstEnd = NULL;
+	char* secondEnd = NULL;
+	double first = strtod( aFirst.c_str(), &firstEnd );
+	double second = strtod( aSecond.c_str(), &secondEnd );
+	if( *firstEnd != '\0' || *secondEnd != '\0' )
+	{
+		return false;	//Not both numbers
+	}
+	double scale = fabs( first ) > 1 ? fabs( first ) : 1;
+	return fabs( first - second ) <= scale * 1e-9;
+}
+
+bool XmlCompare::equivalent( const char* aFirst, size_t aFirstLength, const char* aSecond, size_t aSecondLength, std::string& aDifference )
+{
+	std::vector<Event> first;
+	std::vector<Event> second;
+	std::string error;
+	if( !parse( aFirst, aFirstLength, first, error ) )
+	{
+		aDifference = "the first document can't be read: " + error;
+		return false;
+	}
+	if( !parse( aSecond, aSecondLength, second, error ) )
+	{
+		aDifference = "the second document can't be read: " + error;
+		return false;
+	}
+
+	//Walk them together, keeping the path for the report
+	std::vector<std::string> path;
+	for( size_t i = 0; i < first.size() || i < second.size(); ++i )
+	{
+		std::string where;
+		for( size_t j = 0; j < path.size(); ++j )
+		{
+			where += "/" + path[j];
+		}
+		if( i >= first.size() || i >= second.size() )
+		{
+			aDifference = (i >= first.size() ? "the first" : "the second") + std::string( " document ends early, at " ) + (where.empty() ? "/" : where);
+			return false;
+		}
+		const Event& a = first[i];
+		const Event& b = second[i];
+		std::stringstream difference;
+		if( a.kind != b.kind || a.value != b.value )
+		{
+			if( a.kind == Event::TEXT && b.kind == Event::TEXT && sameValue( a.value, b.value ) )
+			{
+				continue;
+			}
+			const char* const kinds[] = { "<", "</", "" };
+			difference << "at " << (where.empty() ? "/" : where) << ": " << kinds[a.kind] << a.value << " against " << kinds[b.kind] << b.value;
+			aDifference = difference.str();
+			return false;
+		}
+		if( a.kind == Event::START )
+		{
+			path.push_back( a.value );
+			where += "/" + a.value;
+			size_t count = a.attributes.size() > b.attributes.size() ? a.attributes.size() : b.attributes.size();
+			for( size_t j = 0; j < count; ++j )
+			{
+				if( j >= a.attributes.size() || j >= b.attributes.size() || a.attributes[j].first != b.attributes[j].first )
+				{
+					const std::string& name = j >= a.attributes.size() ? b.attributes[j].first : a.attributes[j].first;
+					difference << "at " << where << ": attribute " << name << " is only in one document";
+					aDifference = difference.str();
+					return false;
+				}
+				if( !sameValue( a.attributes[j].second, b.attributes[j].second ) )
+				{
+					difference << "at " << where << ": " << a.attributes[j].first << "=\"" << a.attributes[j].second << "\" against \"" << b.attributes[j].second << "\"";
+					aDifference = difference.str();
+					return false;
+				}
+			}
+		}
+		else if( a.kind == Event::END && !path.empty() )
+		{
+			path.pop_back();
+		}
+	}
+	return true;
+}
+
+bool XmlCompare::equivalentFiles( const std::string& aFirstFile, const std::string& aSecondFile, std::string& aDifference )
+{
+	MappedFile first;
+	MappedFile second;
+	if( !first.open( aFirstFile ) )
+	{
+		aDifference = aFirstFile + " could not be read";
+		return false;
+	}
+	if( !second.open( aSecondFile ) )
+	{
+		aDifference = aSecondFile + " could not be read";
+		return false;
+	}
+	return equivalent( first.data(), first.size(), second.data(), second.size(), aDifference );
+}
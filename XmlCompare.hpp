@@ -0,0 +1,73 @@
+/**
+ * @file XmlCompare.hpp
+ * @brief Checks that two Xml documents say the same thing, however they are formatted.
+ */
+
+#ifndef A429_XML_COMPARE_HPP
+#define A429_XML_COMPARE_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+/**
+ * Compares Xml documents by their elements, attributes and text rather than their bytes.
+ * These don't matter:
+ *  - the declaration, comments, processing instructions and the doctype
+ *  - whitespace between elements, and around text
+ *  - the order of attributes, and the namespace and schema location attributes
+ *  - how characters are escaped, and whether bytes are UTF-8 or Latin-1
+ *  - how numbers are formatted, so "25", "25.0" and "2.5e1" match
+ *
+ * This is for checking one writer against another, so it is neither validating nor fast.
+ */
+class XmlCompare
+{
+public:
+
+	/**
+	 * Compares two documents
+	 * @param aDifference set to where and how they first differ, if they do
+	 * @returns true if they are equivalent
+	 */
+	static bool equivalent( const char* aFirst, size_t aFirstLength, const char* aSecond, size_t aSecondLength, std::string& aDifference );
+
+	/**
+	 * Compares two files
+	 * @returns false if they differ or either couldn't be read, with aDifference saying which
+	 */
+	static bool equivalentFiles( const std::string& aFirstFile, const std::string& aSecondFile, std::string& aDifference );
+
+private:
+
+	/**
+	 * A start tag, end tag or text
+	 */
+	typedef struct Event
+	{
+		enum Kind { START, END, TEXT };
+		Kind kind;
+		/**
+		 * @brief The element name, or the text
+		 */
+		std::string value;
+		/**
+		 * @brief The attributes of a start tag, sorted by name
+		 */
+		std::vector< std::pair<std::string, std::string> > attributes;
+	} Event;
+
+	/**
+	 * Splits a document into events
+	 * @returns false, with aError set, if it isn't well formed enough to read
+	 */
+	static bool parse( const char* aText, size_t aLength, std::vector<Event>& aEvents, std::string& aError );
+
+	/**
+	 * @returns true if two values are the same text, or the same number
+	 */
+	static bool sameValue( const std::string& aFirst, const std::string& aSecond );
+};
+
+#endif
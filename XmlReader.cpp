@@ -0,0 +1,382 @@
+/**
+ * @file XmlReader.cpp
+ * @brief Reads an Xml document a tag or piece of text at a time.
+ */
+
+#include "XmlReader.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	bool isSpace( char aChar )
+	{
+		return aChar == ' ' || aChar == '\t' || aChar == '\n' || aChar == '\r';
+	}
+
+	bool isNameEnd( char aChar )
+	{
+		return isSpace( aChar ) || aChar == '>' || aChar == '/' || aChar == '=';
+	}
+
+	void appendUtf8( std::string& aText, unsigned long aCodePoint )
+	{
+		if( aCodePoint < 0x80 )
+		{
+			aText.push_back( (char)aCodePoint );
+		}
+		else if( aCodePoint < 0x800 )
+		{
+			aText.push_back( (char)(0xC0 | (aCodePoint >> 6)) );
+			aText.push_back( (char)(0x80 | (aCodePoint & 0x3F)) );
+		}
+		else if( aCodePoint < 0x10000 )
+		{
+			aText.push_back( (char)(0xE0 | (aCodePoint >> 12)) );
+			aText.push_back( (char)(0x80 | ((aCodePoint >> 6) & 0x3F)) );
+			aText.push_back( (char)(0x80 | (aCodePoint & 0x3F)) );
+		}
+		else
+		{
+			aText.push_back( (char)(0xF0 | (aCodePoint >> 18)) );
+			aText.push_back( (char)(0x80 | ((aCodePoint >> 12) & 0x3F)) );
+			aText.push_back( (char)(0x80 | ((aCodePoint >> 6) & 0x3F)) );
+			aText.push_back( (char)(0x80 | (aCodePoint & 0x3F)) );
+		}
+	}
+
+	/**
+	 * Appends a character in the encoding asked for
+	 */
+	void appendCharacter( std::string& aText, unsigned long aCodePoint, XmlReader::Encoding aEncoding )
+	{
+		if( aEncoding == XmlReader::LATIN1 && aCodePoint < 0x100 )
+		{
+			aText.push_back( (char)aCodePoint );
+		}
+		else
+		{
+			appendUtf8( aText, aCodePoint );
+		}
+	}
+
+	/**
+	 * @returns the length of the UTF-8 sequence at aText, or 0 if it isn't one
+	 */
+	size_t utf8Length( const unsigned char* aText, size_t aLength )
+	{
+		size_t length = aText[0] >= 0xF0 ? 4 : aText[0] >= 0xE0 ? 3 : aText[0] >= 0xC0 ? 2 : 0;
+		if( length == 0 || length > aLength )
+		{
+			return 0;
+		}
+		for( size_t i = 1; i < length; ++i )
+		{
+			if( (aText[i] & 0xC0) != 0x80 )
+			{
+				return 0;
+			}
+		}
+		return length;
+	}
+
+	/**
+	 * Removes the whitespace from both ends
+	 */
+	void trim( std::string& aText )
+	{
+		size_t last = aText.size();
+		while( last > 0 && isSpace( aText[last - 1] ) )
+		{
+			--last;
+		}
+		aText.resize( last );
+		size_t first = 0;
+		while( first < aText.size() && isSpace( aText[first] ) )
+		{
+			++first;
+		}
+		aText.erase( 0, first );
+	}
+
+	/**
+	 * @returns where aFind first is in [aStart, aEnd), or NULL
+	 */
+	const char* find( const char* aStart, const char* aEnd, const char* aFind )
+	{
+		size_t findLength = strlen( aFind );
+		for( const char* at = aStart; at + findLength <= aEnd; ++at )
+		{
+			at = (const char*)memchr( at, aFind[0], aEnd - at );
+			if( at == NULL || at + findLength > aEnd )
+			{
+				return NULL;
+			}
+			if( memcmp( at, aFind, findLength ) == 0 )
+			{
+				return at;
+			}
+		}
+		return NULL;
+	}
+}
+
+XmlReader::XmlReader( const char* aText, size_t aLength, Encoding aEncoding )
+	: document(aText)
+	, length(aLength)
+	, position(0)
+	, encoding(aEncoding)
+	, pendingEnd(false)
+	, attributesUsed(0)
+{
+	if( aLength >= 3 && memcmp( aText, "\xEF\xBB\xBF", 3 ) == 0 )
+	{
+		position = 3;	//The UTF-8 byte order mark
+	}
+}
+
+void XmlReader::decode( const char* aText, size_t aLength, std::string& aDecoded, Encoding aEncoding )
+{
+	const unsigned char* text = (const unsigned char*)aText;
+	for( size_t i = 0; i < aLength; )
+	{
+		if( text[i] == '&' )
+		{
+			const char* end = (const char*)memchr( aText + i, ';', aLength - i );
+			if( end != NULL )
+			{
+				const char* entity = aText + i + 1;
+				size_t entityLength = end - entity;
+				size_t next = end - aText + 1;
+				if( entityLength == 3 && memcmp( entity, "amp", 3 ) == 0 )			{ aDecoded.push_back( '&' ); i = next; continue; }
+				else if( entityLength == 2 && memcmp( entity, "lt", 2 ) == 0 )		{ aDecoded.push_back( '<' ); i = next; continue; }
+				else if( entityLength == 2 && memcmp( entity, "gt", 2 ) == 0 )		{ aDecoded.push_back( '>' ); i = next; continue; }
+				else if( entityLength == 4 && memcmp( entity, "quot", 4 ) == 0 )	{ aDecoded.push_back( '"' ); i = next; continue; }
+				else if( entityLength == 4 && memcmp( entity, "apos", 4 ) == 0 )	{ aDecoded.push_back( '\'' ); i = next; continue; }
+				else if( entityLength > 1 && entityLength < 16 && entity[0] == '#' )
+				{
+					char number[16];
+					memcpy( number, entity, entityLength );
+					number[entityLength] = '\0';
+					bool hex = number[1] == 'x' || number[1] == 'X';
+					appendCharacter( aDecoded, strtoul( number + (hex ? 2 : 1), NULL, hex ? 16 : 10 ), aEncoding );
+					i = next;
+					continue;
+				}
+			}
+			aDecoded.push_back( '&' );	//Not a reference, so keep it as it is
+			++i;
+		}
+		else if( text[i] >= 0x80 )
+		{
+			size_t sequence = utf8Length( text + i, aLength - i );
+			if( sequence == 0 )
+			{
+				//Not UTF-8, so take it as Latin-1
+				appendCharacter( aDecoded, text[i], aEncoding );
+				++i;
+			}
+			else if( aEncoding == LATIN1 && sequence == 2 && text[i] < 0xC4 )
+			{
+				aDecoded.push_back( (char)(((text[i] & 0x1F) << 6) | (text[i + 1] & 0x3F)) );
+				i += 2;
+			}
+			else
+			{
+				aDecoded.append( aText + i, sequence );
+				i += sequence;
+			}
+		}
+		else
+		{
+			aDecoded.push_back( aText[i] );
+			++i;
+		}
+	}
+}
+
+const std::string* XmlReader::attribute( const char* aName ) const
+{
+	for( size_t i = 0; i < attributesUsed; ++i )
+	{
+		if( attributes[i].first == aName )
+		{
+			return &attributes[i].second;
+		}
+	}
+	return NULL;
+}
+
+XmlReader::Token XmlReader::fail( const std::string& aError )
+{
+	errorText = aError;
+	position = length;
+	return FAILED;
+}
+
+bool XmlReader::skip( const char* aStart, const char* aEnd )
+{
+	size_t startLength = strlen( aStart );
+	const char* end = find( document + position + startLength, document + length, aEnd );
+	if( end == NULL )
+	{
+		return false;
+	}
+	position = end - document + strlen( aEnd );
+	return true;
+}
+
+XmlReader::Token XmlReader::next()
+{
+	attributesUsed = 0;
+	if( pendingEnd )
+	{
+		pendingEnd = false;
+		return END;
+	}
+
+	while( position < length )
+	{
+		const char* at = document + position;
+		size_t left = length - position;
+		if( *at != '<' )
+		{
+			//Text, up to the next tag
+			const char* tag = (const char*)memchr( at, '<', left );
+			size_t end = tag == NULL ? length : (size_t)(tag - document);
+			textValue.clear();
+			decode( at, end - position, textValue, encoding );
+			position = end;
+			trim( textValue );
+			if( !textValue.empty() )
+			{
+				return TEXT;
+			}
+			continue;
+		}
+
+		//Skip what says nothing about the content
+		if( left >= 2 && at[1] == '?' )
+		{
+			if( !skip( "<?", "?>" ) )
+			{
+				return fail( "unterminated <?" );
+			}
+			continue;
+		}
+		if( left >= 4 && memcmp( at, "<!--", 4 ) == 0 )
+		{
+			if( !skip( "<!--", "-->" ) )
+			{
+				return fail( "unterminated <!--" );
+			}
+			continue;
+		}
+		if( left >= 9 && memcmp( at, "<![CDATA[", 9 ) == 0 )
+		{
+			const char* end = find( at + 9, document + length, "]]>" );
+			if( end == NULL )
+			{
+				return fail( "unterminated CDATA section" );
+			}
+			textValue.assign( at + 9, end );
+			position = end - document + 3;
+			trim( textValue );
+			if( !textValue.empty() )
+			{
+				return TEXT;
+			}
+			continue;
+		}
+		if( left >= 2 && at[1] == '!' )
+		{
+			if( !skip( "<!", ">" ) )
+			{
+				return fail( "unterminated <!" );
+			}
+			continue;
+		}
+
+		//A tag
+		size_t i = position;
+		bool endTag = i + 1 < length && document[i + 1] == '/';
+		i += endTag ? 2 : 1;
+		size_t nameStart = i;
+		while( i < length && !isNameEnd( document[i] ) )
+		{
+			++i;
+		}
+		elementName.assign( document + nameStart, i - nameStart );
+		if( elementName.empty() )
+		{
+			return fail( "a tag without a name" );
+		}
+
+		while( true )
+		{
+			while( i < length && isSpace( document[i] ) )
+			{
+				++i;
+			}
+			if( i >= length )
+			{
+				return fail( "unterminated tag <" + elementName );
+			}
+			if( document[i] == '>' )
+			{
+				++i;
+				break;
+			}
+			if( document[i] == '/' && i + 1 < length && document[i + 1] == '>' )
+			{
+				pendingEnd = !endTag;
+				i += 2;
+				break;
+			}
+			if( endTag )
+			{
+				return fail( "an end tag with attributes </" + elementName );
+			}
+
+			//An attribute
+			size_t attributeStart = i;
+			while( i < length && !isNameEnd( document[i] ) )
+			{
+				++i;
+			}
+			if( attributesUsed == attributes.size() )
+			{
+				attributes.resize( attributesUsed + 1 );
+			}
+			std::pair<std::string, std::string>& attribute = attributes[attributesUsed];
+			attribute.first.assign( document + attributeStart, i - attributeStart );
+			while( i < length && isSpace( document[i] ) )
+			{
+				++i;
+			}
+			if( i + 1 >= length || document[i] != '=' )
+			{
+				return fail( "attribute " + attribute.first + " of <" + elementName + " has no value" );
+			}
+			++i;
+			while( i < length && isSpace( document[i] ) )
+			{
+				++i;
+			}
+			char quote = i < length ? document[i] : '\0';
+			const char* close = quote == '"' || quote == '\'' ? (const char*)memchr( document + i + 1, quote, length - i - 1 ) : NULL;
+			if( close == NULL )
+			{
+				return fail( "attribute " + attribute.first + " of <" + elementName + " isn't quoted" );
+			}
+			attribute.second.clear();
+			decode( document + i + 1, close - (document + i + 1), attribute.second, encoding );
+			i = close - document + 1;
+			++attributesUsed;
+		}
+		position = i;
+		return endTag ? END : START;
+	}
+	return DONE;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file XmlReader.hpp
+ * @brief Reads an Xml document a tag or piece of text at a time.
+ */
+
+#ifndef A429_XML_READER_HPP
+#define A429_XML_READER_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+/**
+ * A pull reader over an Xml document held in memory. next() moves to the next start tag,
+ * end tag or text, and the name, attributes or text of it can then be read. A self
+ * closing tag is read as a start tag followed by an end tag.
+ *
+ * The declaration, comments, processing instructions and the doctype are skipped, and
+ * text that is only whitespace isn't reported. It is not validating: it reads what the
+ * writers here and Xml429 write, and stops at what it can't read.
+ *
+ * The strings and the attribute list are kept from one token to the next, so reading a
+ * document doesn't allocate once they have grown to fit it.
+ */
+class XmlReader
+{
+public:
+
+	/**
+	 * What next() read
+	 */
+	enum Token
+	{
+		START,
+		END,
+		TEXT,
+		/**
+		 * The end of the document
+		 */
+		DONE,
+		/**
+		 * Something that couldn't be read, see error()
+		 */
+		FAILED
+	};
+
+	/**
+	 * What the names, values and text are decoded to
+	 */
+	enum Encoding
+	{
+		/**
+		 * UTF-8. Bytes that aren't UTF-8 are taken as Latin-1
+		 */
+		UTF8,
+		/**
+		 * Latin-1, as the sheets are. Characters past it are kept as UTF-8
+		 */
+		LATIN1
+	};
+
+	XmlReader( const char* aText, size_t aLength, Encoding aEncoding = UTF8 );
+
+	/**
+	 * Moves to the next token
+	 */
+	Token next();
+
+	/**
+	 * @returns the element name of a start or end tag
+	 */
+	const std::string& name() const
+	{
+		return elementName;
+	}
+
+	/**
+	 * @returns the text, without the whitespace around it
+	 */
+	const std::string& text() const
+	{
+		return textValue;
+	}
+
+	/**
+	 * @returns the number of attributes of a start tag
+	 */
+	size_t attributeCount() const
+	{
+		return attributesUsed;
+	}
+
+	const std::string& attributeName( size_t aIndex ) const
+	{
+		return attributes[aIndex].first;
+	}
+
+	const std::string& attributeValue( size_t aIndex ) const
+	{
+		return attributes[aIndex].second;
+	}
+
+	/**
+	 * @returns the value of an attribute of a start tag, or NULL if it doesn't have it
+	 */
+	const std::string* attribute( const char* aName ) const;
+
+	/**
+	 * @returns what couldn't be read, after next() returned FAILED
+	 */
+	const std::string& error() const
+	{
+		return errorText;
+	}
+
+	/**
+	 * Appends text with its references replaced
+	 */
+	static void decode( const char* aText, size_t aLength, std::string& aDecoded, Encoding aEncoding = UTF8 );
+
+private:
+
+	/**
+	 * Skips a section from aStart to aEnd
+	 * @returns false if it isn't terminated
+	 */
+	bool skip( const char* aStart, const char* aEnd );
+
+	Token fail( const std::string& aError );
+
+	const char* document;
+	size_t length;
+	size_t position;
+	Encoding encoding;
+	/**
+	 * @brief Whether the last start tag closed itself, so its end tag is next
+	 */
+	bool pendingEnd;
+	std::string elementName;
+	std::string textValue;
+	std::vector< std::pair<std::string, std::string> > attributes;
+	/**
+	 * @brief The entries of attributes that belong to the current tag
+	 */
+	size_t attributesUsed;
+	std::string errorText;
+};
+
+#endif
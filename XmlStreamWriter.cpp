@@ -0,0 +1,162 @@
+/**
+ * @file XmlStreamWriter.cpp
+ * @brief Writes Xml straight into a text buffer, without building a document first.
+ */
+
+#include "XmlStreamWriter.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+XmlStreamWriter::XmlStreamWriter( std::string& aBuffer, const char* aIndent )
+	: buffer(aBuffer)
+	, indent(aIndent)
+	, depth(0)
+	, startTagOpen(false)
+{
+}
+
+void XmlStreamWriter::declaration()
+{
+	buffer.append( "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" );
+	if( indent != NULL )
+	{
+		buffer.push_back( '\n' );
+	}
+}
+
+void XmlStreamWriter::newLine()
+{
+	if( indent == NULL )
+	{
+		return;
+	}
+	buffer.push_back( '\n' );
+	for( size_t i = 0; i < depth; ++i )
+	{
+		buffer.append( indent );
+	}
+}
+
+void XmlStreamWriter::closeStartTag()
+{
+	if( startTagOpen )
+	{
+		buffer.push_back( '>' );
+		startTagOpen = false;
+	}
+}
+
+void XmlStreamWriter::startElement( const char* aName )
+{
+	if( depth == MAX_DEPTH )
+	{
+		return;	//Too deep. Nothing this converter writes gets near it
+	}
+	closeStartTag();
+	if( depth > 0 )
+	{
+		newLine();
+	}
+	buffer.push_back( '<' );
+	buffer.append( aName );
+	names[depth++] = aName;
+	startTagOpen = true;
+}
+
+void XmlStreamWriter::attribute( const char* aName, const char* aValue, size_t aLength )
+{
+	if( !startTagOpen )
+	{
+		return;	//Attributes can only go in a start tag
+	}
+	buffer.push_back( ' ' );
+	buffer.append( aName );
+	buffer.append( "=\"" );
+	escape( buffer, aValue, aLength );
+	buffer.push_back( '"' );
+}
+
+void XmlStreamWriter::attribute( const char* aName, const std::string& aValue )
+{
+	attribute( aName, aValue.data(), aValue.size() );
+}
+
+void XmlStreamWriter::attribute( const char* aName, OwUInt32 aValue )
+{
+	char text[16];
+	sprintf( text, "%lu", (unsigned long)aValue );
+	attribute( aName, text, strlen( text ) );
+}
+
+void XmlStreamWriter::attribute( const char* aName, double aValue )
+{
+	//As short as reads back to the same value, so 12.5 stays 12.5 and nothing is lost
+	char text[32];
+	sprintf( text, "%.15g", aValue );
+	if( strtod( text, NULL ) != aValue )
+	{
+		sprintf( text, "%.17g", aValue );
+	}
+	attribute( aName, text, strlen( text ) );
+}
+
+void XmlStreamWriter::endElement()
+{
+	if( depth == 0 )
+	{
+		return;
+	}
+	--depth;
+	if( startTagOpen )
+	{
+		buffer.append( "/>" );
+		startTagOpen = false;
+	}
+	else
+	{
+		newLine();
+		buffer.append( "</" );
+		buffer.append( names[depth] );
+		buffer.push_back( '>' );
+	}
+	if( depth == 0 && indent != NULL )
+	{
+		buffer.push_back( '\n' );
+	}
+}
+
+void XmlStreamWriter::escape( std::string& aBuffer, const char* aText, size_t aLength )
+{
+	static const char HEX[] = "0123456789ABCDEF";
+	for( size_t i = 0; i < aLength; ++i )
+	{
+		unsigned char c = (unsigned char)aText[i];
+		switch( c )
+		{
+		case '&':	aBuffer.append( "&amp;" );	break;
+		case '<':	aBuffer.append( "&lt;" );	break;
+		case '>':	aBuffer.append( "&gt;" );	break;
+		case '"':	aBuffer.append( "&quot;" );	break;
+		case '\t':	aBuffer.append( "&#x9;" );	break;	//Attribute values would otherwise have them turned into spaces
+		case '\n':	aBuffer.append( "&#xA;" );	break;
+		case '\r':	aBuffer.append( "&#xD;" );	break;
+		default:
+			if( c >= 0x80 )
+			{
+				//Latin-1 maps straight onto the first 256 code points
+				aBuffer.append( "&#x" );
+				aBuffer.push_back( HEX[c >> 4] );
+				aBuffer.push_back( HEX[c & 0x0F] );
+				aBuffer.push_back( ';' );
+			}
+			else if( c >= 0x20 )
+			{
+				aBuffer.push_back( (char)c );
+			}
+			//The other control characters can't be written in Xml 1.0 at all, so they are dropped
+			break;
+		}
+	}
+}
@@ -0,0 +1,86 @@
+/**
+ * @file XmlStreamWriter.hpp
+ * @brief Writes Xml straight into a text buffer, without building a document first.
+ */
+
+#ifndef A429_XML_STREAM_WRITER_HPP
+#define A429_XML_STREAM_WRITER_HPP
+
+#include <string>
+#include <cstddef>
+
+#include <Owl429/definitions>
+
+/**
+ * Appends Xml to a buffer as it is written. Element names are kept by pointer, so they
+ * must outlive the element, which string literals do. Once the buffer has grown to the
+ * size of a document, writing another into it allocates nothing.
+ *
+ * Text is escaped for attributes and content. Bytes from 0x80 are taken as Latin-1,
+ * which the sheets are saved in, and written as character references so the document
+ * is valid whatever encoding it is read in.
+ */
+class XmlStreamWriter
+{
+public:
+
+	/**
+	 * The deepest elements can nest
+	 */
+	enum { MAX_DEPTH = 16 };
+
+	/**
+	 * @param aBuffer the buffer to append to. It is not cleared
+	 * @param aIndent the characters to indent each level with, or NULL to write everything on one line
+	 */
+	XmlStreamWriter( std::string& aBuffer, const char* aIndent = "\t" );
+
+	/**
+	 * Writes the Xml declaration, for UTF-8
+	 */
+	void declaration();
+
+	/**
+	 * Opens an element. Its attributes follow, then its children
+	 */
+	void startElement( const char* aName );
+
+	void attribute( const char* aName, const char* aValue, size_t aLength );
+	void attribute( const char* aName, const std::string& aValue );
+	void attribute( const char* aName, OwUInt32 aValue );
+	void attribute( const char* aName, double aValue );
+
+	/**
+	 * Closes the innermost open element, as an empty element tag if nothing was written in it
+	 */
+	void endElement();
+
+	/**
+	 * @returns the elements still open
+	 */
+	size_t openElements() const
+	{
+		return depth;
+	}
+
+	/**
+	 * Appends text escaped for Xml
+	 */
+	static void escape( std::string& aBuffer, const char* aText, size_t aLength );
+
+private:
+
+	void closeStartTag();
+	void newLine();
+
+	std::string& buffer;
+	const char* indent;
+	const char* names[MAX_DEPTH];
+	size_t depth;
+	/**
+	 * @brief True while attributes can still be added to the innermost element
+	 */
+	bool startTagOpen;
+};
+
+#endif
@@ -20,6 +20,8 @@
 #include <iostream>
 #include <Owl429/definitions>
 
+#include "BatchConverter.hpp"
+
 int sample_Acyclic(OwUInt64 aSerialNumber, OwUInt8 aTxChannelNum);
 int sample_Asynchronous(OwUInt64 aSerialNumber, OwUInt8 aTxChannelNum);
 int sample_BlockTransfer(OwUInt64 aSerialNumber, OwUInt8 aTxChannelNum);
@@ -31,6 +33,9 @@ int sample_ScheduledLabel(OwUInt64 aSerialNumber, OwUInt8 aTxChannelNum);
 int sample_DynamicScheduledLabel(OwUInt64 aSerialNumber, OwUInt8 aTxChannelNum);
 int sample_Discretes(OwUInt64 aSerialNumber);
 int sample_LoadedCSV();
+int sample_Benchmark();
+int sample_ReceivePipeline();
+int sample_WordCodec();
 
 /* Loopback samples need a loopback cable linking a Tx channel to an Rx channel */
 #define TX_CHAN 1
@@ -40,9 +45,15 @@ int sample_LoadedCSV();
  * This is a simple runner to run the samples.
  * The samples output error information so all this needs
  * to do is exit.
+ * Given arguments, it is the batch converter instead, see BatchConverter::main.
  */
-int main()
+int main(int argc, char* argv[])
 {
+    if (argc > 1)
+    {
+        return BatchConverter::main(argc, argv);
+    }
+
     //std::cout << "sample_Acyclic:        " << sample_Acyclic(0, TX_CHAN)               << std::endl;
     //std::cout << "sample_Asynchronous:   " << sample_Asynchronous(0, TX_CHAN)          << std::endl;
     //std::cout << "sample_BlockTransfer:  " << sample_BlockTransfer(0, TX_CHAN)         << std::endl;
@@ -54,5 +65,8 @@ int main()
     //std::cout << "sample_DynamicScheduledLabel: " << sample_DynamicScheduledLabel(0, TX_CHAN) << std::endl;
     //std::cout << "sample_Discretes:      " << sample_Discretes(0)                      << std::endl;
 	std::cout << "sample_LoadedCSV:        " << sample_LoadedCSV()                         << std::endl;
+    //std::cout << "sample_Benchmark:       " << sample_Benchmark()                         << std::endl;
+    //std::cout << "sample_ReceivePipeline: " << sample_ReceivePipeline()                   << std::endl;
+    //std::cout << "sample_WordCodec:       " << sample_WordCodec()                         << std::endl;
     return 0;
 }